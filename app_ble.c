@@ -214,6 +214,17 @@ static const uint8_t app_ble_gatt_server_db[]=
             CHARACTERISTIC_UUID128_WRITABLE(HANDLE_OTA_FW_UPGRADE_CHARACTERISTIC_DATA, HANDLE_OTA_FW_UPGRADE_DATA,
                 UUID_OTA_FW_UPGRADE_CHARACTERISTIC_DATA, LEGATTDB_CHAR_PROP_WRITE,
                 LEGATTDB_PERM_VARIABLE_LENGTH | LEGATTDB_PERM_WRITE_REQ /*| LEGATTDB_PERM_AUTH_WRITABLE */),
+#ifdef APP_OFU_SUPPORT
+            // Handle 0xff10: characteristic OFU Stream, handle 0xff11 characteristic value. Same as
+            // WS Data but written without response (the Client waits for Credits, notified)
+            CHARACTERISTIC_UUID128_WRITABLE(HANDLE_APP_OFU_BLE_CHARACTERISTIC_STREAM, HANDLE_APP_OFU_BLE_STREAM,
+                UUID_APP_OFU_BLE_CHARACTERISTIC_STREAM, LEGATTDB_CHAR_PROP_WRITE_NO_RESPONSE | LEGATTDB_CHAR_PROP_NOTIFY,
+                LEGATTDB_PERM_VARIABLE_LENGTH | LEGATTDB_PERM_WRITE_CMD /*| LEGATTDB_PERM_AUTH_WRITABLE */),
+
+                // Declare client characteristic configuration descriptor (Credits Notification)
+                CHAR_DESCRIPTOR_UUID16_WRITABLE(HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR, UUID_DESCRIPTOR_CLIENT_CHARACTERISTIC_CONFIGURATION,
+                    LEGATTDB_PERM_READABLE | LEGATTDB_PERM_WRITE_REQ /*| LEGATTDB_PERM_AUTH_WRITABLE */),
+#endif
 };
 
 char app_ble_device_name[APP_MAIN_BT_DEV_NAME_LEN] = {0};
@@ -631,8 +642,10 @@ static wiced_bt_gatt_status_t app_ble_gatt_attribute_read_request_handler(uint16
     {
 #if defined (OTA_FW_UPGRADE) && (APP_OFU_SUPPORT)
         /* if read request is for the OTA FW upgrade service, pass it to the library to process */
-        if ((p_read_data->handle > HANDLE_OTA_FW_UPGRADE_SERVICE) &&
-            (p_read_data->handle <= HANDLE_OTA_FW_UPGRADE_APP_INFO))
+        if (((p_read_data->handle > HANDLE_OTA_FW_UPGRADE_SERVICE) &&
+             (p_read_data->handle <= HANDLE_OTA_FW_UPGRADE_APP_INFO)) ||
+            ((p_read_data->handle >= HANDLE_APP_OFU_BLE_CHARACTERISTIC_STREAM) &&
+             (p_read_data->handle <= HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR)))
         {
             return app_ofu_ble_read_handler(conn_id, p_read_data);
         }
@@ -683,8 +696,10 @@ static wiced_bt_gatt_status_t app_ble_gatt_attribute_write_request_handler(uint1
 {
 #if defined (OTA_FW_UPGRADE) && (APP_OFU_SUPPORT)
     /* if read request is for the OTA FW upgrade service, pass it to the library to process */
-    if ((p_write_data->handle > HANDLE_OTA_FW_UPGRADE_SERVICE) &&
-        (p_write_data->handle <= HANDLE_OTA_FW_UPGRADE_APP_INFO))
+    if (((p_write_data->handle > HANDLE_OTA_FW_UPGRADE_SERVICE) &&
+         (p_write_data->handle <= HANDLE_OTA_FW_UPGRADE_APP_INFO)) ||
+        ((p_write_data->handle >= HANDLE_APP_OFU_BLE_CHARACTERISTIC_STREAM) &&
+         (p_write_data->handle <= HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR)))
     {
         return app_ofu_ble_write_handler(conn_id, p_write_data);
     }
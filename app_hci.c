@@ -36,9 +36,13 @@
 #include "wiced_hal_puart.h"
 #include "wiced_gki.h"
 #include "wiced_memory.h"
+#include "wiced_timer.h"
+#include "clock_timer.h"
 #include "hcidefs.h"
 #include "hci_control_api.h"
 #include "app_hci.h"
+#include "app_hci_ring.h"
+#include "app_memory.h"
 #include "app_trace.h"
 #include "app_nvram.h"
 #include "wiced_platform.h"
@@ -53,6 +57,24 @@
 #define HCI_VSC_LRAC_META_OPCODE            (HCI_GRP_VENDOR_SPECIFIC | 0x01CF)
 #define HCI_VSE_LRAC_META_EVENT             0x86
 
+#define APP_HCI_TX_BUFFER_SIZE              TRANS_UART_BUFFER_SIZE
+    /*
+     * Size of an HCI Tx burst. Small WICED HCI events (traces, command status, platform events)
+     * are packed, already framed, in a transport buffer which is sent in one UART transfer.
+     */
+#define APP_HCI_TX_BUFFER_NB                2
+    /* One burst being filled while the previous one is sent */
+#define APP_HCI_TX_FLUSH_DELAY              2       /* in ms */
+    /* Latency bound of a coalesced event */
+#define APP_HCI_TX_HEADER_SIZE              5
+    /* WICED HCI header: Packet Type, OpCode, Length */
+#define APP_HCI_TX_PACKET_TYPE              0x19
+
+#define APP_HCI_CMD_GROUP_NB                4
+    /* Maximum number of Command Groups with registered handlers */
+#define APP_HCI_CMD_ENTRY_NB                48
+    /* Maximum number of registered Command OpCodes (all groups) */
+
 /*
  * Local functions
  */
@@ -63,6 +85,11 @@ static void app_hci_handle_trace_enable(uint8_t *p_data);
 static void app_hci_handle_read_buffer_stats(void);
 static void app_hci_nvram_write(uint8_t *p_data, uint16_t length);
 static void app_hci_transport_status(wiced_transport_type_t type);
+static void app_hci_transport_tx_complete(wiced_transport_buffer_pool_t *p_pool);
+static uint8_t *app_hci_tx_reserve(uint16_t opcode, uint16_t length);
+static void app_hci_tx_flush_timer_callback(uint32_t param);
+static void app_hci_cmd_dispatch(uint16_t opcode, uint8_t *p_data, uint32_t length);
+static void app_hci_cmd_stats_send(uint16_t opcode, uint8_t *p_data, uint32_t length);
 static void app_hci_packet_decode(wiced_bt_hci_trace_type_t type, uint8_t *p_data, uint16_t length);
 static void app_hci_packet_decode_event(uint8_t *p_data, uint16_t length);
 static void app_hci_packet_decode_command(uint8_t *p_data, uint16_t length);
@@ -118,11 +145,74 @@ static const wiced_transport_cfg_t transport_cfg =
     },
     .p_status_handler = app_hci_transport_status,
     .p_data_handler = app_hci_proc_rx_cmd,
-    .p_tx_complete_cback = NULL,
+    .p_tx_complete_cback = app_hci_transport_tx_complete,
+};
+
+typedef struct
+{
+    wiced_transport_buffer_pool_t *p_pool;
+    uint8_t *p_burst;               /* Burst being filled (allocated from p_pool) */
+    uint16_t burst_len;
+    uint16_t burst_nb_packet;
+    wiced_timer_t flush_timer;
+    app_hci_tx_stats_t stats;
+} app_hci_tx_cb_t;
+
+static app_hci_tx_cb_t app_hci_tx_cb;
+
+/* Registered HCI Command */
+typedef struct
+{
+    uint16_t opcode;
+    app_hci_cmd_handler_t *p_handler;
+    uint32_t nb_cmd;
+    uint32_t total_latency;         /* in us */
+    uint32_t max_latency;           /* in us */
+} app_hci_cmd_entry_t;
+
+typedef struct
+{
+    app_hci_cmd_handler_t *p_default_handler;   /* Called for the non registered OpCodes */
+    uint8_t entry_map[256];         /* OpCode (LSB) => Entry index + 1 (0 if not registered) */
+} app_hci_cmd_group_t;
+
+/*
+ * HCI Command dispatch table. Handlers are looked up with two direct indexations (Group,
+ * then OpCode). Modules may register their handlers before app_hci_init.
+ */
+typedef struct
+{
+    uint8_t group_map[256];         /* Group => Group index + 1 (0 if not registered) */
+    uint8_t nb_group;
+    uint8_t nb_entry;
+    uint32_t nb_unregistered;
+    app_hci_cmd_group_t groups[APP_HCI_CMD_GROUP_NB];
+    app_hci_cmd_entry_t entries[APP_HCI_CMD_ENTRY_NB];
+} app_hci_cmd_cb_t;
+
+static app_hci_cmd_cb_t app_hci_cmd_cb;
+
+/* Device Group Commands handled by app_hci_device_handle_command */
+static const uint16_t app_hci_device_commands[] =
+{
+    HCI_CONTROL_COMMAND_TRACE_ENABLE,
+    HCI_CONTROL_COMMAND_PUSH_NVRAM_DATA,
+    HCI_CONTROL_COMMAND_RESET,
+    HCI_CONTROL_COMMAND_READ_BUFF_STATS,
+    HCI_CONTROL_COMMAND_SET_LOCAL_BDA,
+    HCI_CONTROL_COMMAND_DELETE_NVRAM_DATA,
+    HCI_CONTROL_COMMAND_INQUIRY,
+    HCI_CONTROL_COMMAND_SET_VISIBILITY,
+    HCI_CONTROL_COMMAND_SET_PAIRING_MODE,
 };
 
 static wiced_bool_t app_hci_lrac_switch_in_progress = WICED_FALSE;
 
+#ifdef APP_HCI_RING
+/* The HCI trace callback is shared with the HCI Ring: forward the packets or not */
+static wiced_bool_t app_hci_trace_forward = WICED_FALSE;
+#endif
+
 static const char *app_hci_events_desc[] =
 {
         "?? Unknown event (0x00)",              /* 0x00 */
@@ -234,8 +324,31 @@ static const char *app_hci_lrac_sub_opcode_desc[] =
  */
 wiced_result_t app_hci_init(void)
 {
+    uint8_t i;
+
     wiced_transport_init( &transport_cfg );
 
+    for (i = 0; i < NB_ELEMENT(app_hci_device_commands); i++)
+    {
+        app_hci_cmd_handler_register(app_hci_device_commands[i], app_hci_device_commands[i],
+                app_hci_device_handle_command);
+    }
+    app_hci_cmd_group_handler_register(HCI_CONTROL_GROUP_DEVICE, app_hci_device_handle_command);
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_HCI_CMD_STATS,
+            HCI_PLATFORM_COMMAND_HCI_CMD_STATS, app_hci_cmd_stats_send);
+
+    memset(&app_hci_tx_cb, 0, sizeof(app_hci_tx_cb));
+    wiced_init_timer(&app_hci_tx_cb.flush_timer, app_hci_tx_flush_timer_callback, 0,
+            WICED_MILLI_SECONDS_TIMER);
+
+    /* If the pool cannot be created, every event is sent on its own */
+    app_hci_tx_cb.p_pool = wiced_transport_create_buffer_pool(APP_HCI_TX_BUFFER_SIZE,
+            APP_HCI_TX_BUFFER_NB);
+    if (app_hci_tx_cb.p_pool == NULL)
+    {
+        APP_TRACE_ERR("HCI Tx Coalescer disabled (no transport pool)\n");
+    }
+
 #ifdef WICED_BT_TRACE_ENABLE
     /* Set the UART type as WICED_ROUTE_DEBUG_TO_PUART */
     wiced_hal_puart_init();
@@ -244,11 +357,346 @@ wiced_result_t app_hci_init(void)
     wiced_set_debug_uart(WICED_ROUTE_DEBUG_TO_PUART);
 #ifdef HCI_TRACE_OVER_TRANSPORT
     wiced_bt_dev_register_hci_trace(app_hci_packet_cback);
+#ifdef APP_HCI_RING
+    app_hci_trace_forward = WICED_TRUE;
+#endif
 #endif
 #endif
+
+#ifdef APP_HCI_RING
+    app_hci_ring_init();
+    app_hci_trace_register();
+#endif
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_hci_send
+ */
+wiced_result_t app_hci_send(uint16_t opcode, uint8_t *p_data, uint16_t length)
+{
+    uint8_t *p;
+
+    p = app_hci_tx_reserve(opcode, length);
+    if (p == NULL)
+    {
+        return wiced_transport_send_data(opcode, p_data, length);
+    }
+
+    if (length)
+    {
+        memcpy(p, p_data, length);
+    }
+
     return WICED_BT_SUCCESS;
 }
 
+/*
+ * app_hci_tx_reserve
+ * Reserve room for an event in the current burst and write its WICED HCI header.
+ * Returns a pointer on the payload or NULL if the event must be sent on its own (the pending
+ * burst is flushed first to keep the order).
+ */
+static uint8_t *app_hci_tx_reserve(uint16_t opcode, uint16_t length)
+{
+    uint8_t *p;
+
+    /* Coalescer disabled or event too large */
+    if ((app_hci_tx_cb.p_pool == NULL) ||
+        ((APP_HCI_TX_HEADER_SIZE + length) > APP_HCI_TX_BUFFER_SIZE))
+    {
+        app_hci_tx_flush();
+        app_hci_tx_cb.stats.nb_direct++;
+        return NULL;
+    }
+
+    /* Not enough room left in the current burst */
+    if ((app_hci_tx_cb.burst_len + APP_HCI_TX_HEADER_SIZE + length) > APP_HCI_TX_BUFFER_SIZE)
+    {
+        app_hci_tx_flush();
+    }
+
+    if (app_hci_tx_cb.p_burst == NULL)
+    {
+        app_hci_tx_cb.p_burst = wiced_transport_allocate_buffer(app_hci_tx_cb.p_pool);
+        if (app_hci_tx_cb.p_burst == NULL)
+        {
+            /* All the bursts are still being sent */
+            app_hci_tx_cb.stats.nb_no_buffer++;
+            app_hci_tx_cb.stats.nb_direct++;
+            return NULL;
+        }
+        app_hci_tx_cb.burst_len = 0;
+        app_hci_tx_cb.burst_nb_packet = 0;
+        wiced_start_timer(&app_hci_tx_cb.flush_timer, APP_HCI_TX_FLUSH_DELAY);
+    }
+
+    p = &app_hci_tx_cb.p_burst[app_hci_tx_cb.burst_len];
+    UINT8_TO_STREAM(p, APP_HCI_TX_PACKET_TYPE);
+    UINT16_TO_STREAM(p, opcode);
+    UINT16_TO_STREAM(p, length);
+
+    app_hci_tx_cb.burst_len += APP_HCI_TX_HEADER_SIZE + length;
+    app_hci_tx_cb.burst_nb_packet++;
+    app_hci_tx_cb.stats.nb_packet++;
+
+    if (app_hci_tx_cb.burst_nb_packet > app_hci_tx_cb.stats.max_burst_packets)
+    {
+        app_hci_tx_cb.stats.max_burst_packets = app_hci_tx_cb.burst_nb_packet;
+    }
+    if (app_hci_tx_cb.burst_len > app_hci_tx_cb.stats.max_burst_bytes)
+    {
+        app_hci_tx_cb.stats.max_burst_bytes = app_hci_tx_cb.burst_len;
+    }
+
+    return p;
+}
+
+/*
+ * app_hci_tx_flush
+ */
+void app_hci_tx_flush(void)
+{
+    wiced_result_t status;
+
+    if (app_hci_tx_cb.p_burst == NULL)
+    {
+        return;
+    }
+
+    wiced_stop_timer(&app_hci_tx_cb.flush_timer);
+
+    /* The packets are already framed: the burst is sent as is and freed by the transport */
+    status = wiced_transport_send_raw_buffer(app_hci_tx_cb.p_burst, app_hci_tx_cb.burst_len);
+    if (status == WICED_SUCCESS)
+    {
+        app_hci_tx_cb.stats.nb_burst++;
+        app_hci_tx_cb.stats.nb_in_flight++;
+        if (app_hci_tx_cb.stats.nb_in_flight > app_hci_tx_cb.stats.max_in_flight)
+        {
+            app_hci_tx_cb.stats.max_in_flight = app_hci_tx_cb.stats.nb_in_flight;
+        }
+    }
+    else
+    {
+        /* The transport frees the buffer only once sent: release it (the burst is lost) */
+        wiced_transport_free_buffer(app_hci_tx_cb.p_burst);
+        app_hci_tx_cb.stats.nb_error++;
+    }
+
+    app_hci_tx_cb.p_burst = NULL;
+    app_hci_tx_cb.burst_len = 0;
+    app_hci_tx_cb.burst_nb_packet = 0;
+}
+
+/*
+ * app_hci_tx_flush_timer_callback
+ */
+static void app_hci_tx_flush_timer_callback(uint32_t param)
+{
+    app_hci_tx_flush();
+}
+
+/*
+ * app_hci_transport_tx_complete
+ * Called by the transport once a buffer of one of our pools has been sent
+ */
+static void app_hci_transport_tx_complete(wiced_transport_buffer_pool_t *p_pool)
+{
+    if ((p_pool == app_hci_tx_cb.p_pool) && (app_hci_tx_cb.stats.nb_in_flight > 0))
+    {
+        app_hci_tx_cb.stats.nb_in_flight--;
+    }
+}
+
+/*
+ * app_hci_tx_stats_get
+ */
+void app_hci_tx_stats_get(app_hci_tx_stats_t *p_stats)
+{
+    memcpy(p_stats, &app_hci_tx_cb.stats, sizeof(app_hci_tx_stats_t));
+}
+
+/*
+ * app_hci_cmd_group_get
+ * Returns the dispatch entry of a Command Group (allocated if needed)
+ */
+static app_hci_cmd_group_t *app_hci_cmd_group_get(uint8_t group)
+{
+    if (app_hci_cmd_cb.group_map[group] == 0)
+    {
+        if (app_hci_cmd_cb.nb_group >= APP_HCI_CMD_GROUP_NB)
+        {
+            APP_TRACE_ERR("No more Command Group (group:0x%x)\n", group);
+            return NULL;
+        }
+        app_hci_cmd_cb.group_map[group] = ++app_hci_cmd_cb.nb_group;
+    }
+
+    return &app_hci_cmd_cb.groups[app_hci_cmd_cb.group_map[group] - 1];
+}
+
+/*
+ * app_hci_cmd_handler_register
+ */
+wiced_result_t app_hci_cmd_handler_register(uint16_t first_opcode, uint16_t last_opcode,
+        app_hci_cmd_handler_t *p_handler)
+{
+    app_hci_cmd_group_t *p_group;
+    app_hci_cmd_entry_t *p_entry;
+    uint32_t opcode;
+    uint8_t *p_index;
+
+    /* The range must be in a single group */
+    if ((p_handler == NULL) || (last_opcode < first_opcode) ||
+        ((first_opcode >> 8) != (last_opcode >> 8)))
+    {
+        return WICED_BT_BADARG;
+    }
+
+    p_group = app_hci_cmd_group_get((uint8_t)(first_opcode >> 8));
+    if (p_group == NULL)
+    {
+        return WICED_BT_NO_RESOURCES;
+    }
+
+    for (opcode = first_opcode; opcode <= last_opcode; opcode++)
+    {
+        p_index = &p_group->entry_map[opcode & 0xFF];
+
+        /* New OpCode (an already registered one keeps its statistics) */
+        if (*p_index == 0)
+        {
+            if (app_hci_cmd_cb.nb_entry >= APP_HCI_CMD_ENTRY_NB)
+            {
+                APP_TRACE_ERR("No more Command entry (opcode:0x%04x)\n", opcode);
+                return WICED_BT_NO_RESOURCES;
+            }
+            *p_index = ++app_hci_cmd_cb.nb_entry;
+        }
+
+        p_entry = &app_hci_cmd_cb.entries[*p_index - 1];
+        p_entry->opcode = (uint16_t)opcode;
+        p_entry->p_handler = p_handler;
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_hci_cmd_group_handler_register
+ */
+wiced_result_t app_hci_cmd_group_handler_register(uint8_t group, app_hci_cmd_handler_t *p_handler)
+{
+    app_hci_cmd_group_t *p_group;
+
+    p_group = app_hci_cmd_group_get(group);
+    if (p_group == NULL)
+    {
+        return WICED_BT_NO_RESOURCES;
+    }
+
+    p_group->p_default_handler = p_handler;
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_hci_cmd_dispatch
+ */
+static void app_hci_cmd_dispatch(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    app_hci_cmd_group_t *p_group;
+    app_hci_cmd_entry_t *p_entry;
+    uint8_t group_index;
+    uint8_t entry_index;
+    uint64_t start_time;
+    uint32_t latency;
+
+    group_index = app_hci_cmd_cb.group_map[opcode >> 8];
+    if (group_index == 0)
+    {
+        APP_TRACE_ERR("No handler for opcode:0x%04x\n", opcode);
+        app_hci_cmd_cb.nb_unregistered++;
+        return;
+    }
+    p_group = &app_hci_cmd_cb.groups[group_index - 1];
+
+    entry_index = p_group->entry_map[opcode & 0xFF];
+    if (entry_index == 0)
+    {
+        app_hci_cmd_cb.nb_unregistered++;
+        if (p_group->p_default_handler)
+        {
+            p_group->p_default_handler(opcode, p_data, length);
+        }
+        else
+        {
+            APP_TRACE_ERR("No handler for opcode:0x%04x\n", opcode);
+        }
+        return;
+    }
+    p_entry = &app_hci_cmd_cb.entries[entry_index - 1];
+
+    start_time = clock_SystemTimeMicroseconds64();
+    p_entry->p_handler(opcode, p_data, length);
+    latency = (uint32_t)(clock_SystemTimeMicroseconds64() - start_time);
+
+    p_entry->nb_cmd++;
+    p_entry->total_latency += latency;
+    if (latency > p_entry->max_latency)
+    {
+        p_entry->max_latency = latency;
+    }
+}
+
+/*
+ * app_hci_cmd_stats_send
+ * Event format: Nb Unregistered (4 bytes), Nb Entries (1 byte) followed by, for each OpCode
+ *               received at least once:
+ *               OpCode (2 bytes), Nb Command, Average Latency, Max Latency (4 bytes each, us)
+ */
+static void app_hci_cmd_stats_send(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    app_hci_cmd_entry_t *p_entry;
+    uint8_t *p_buffer;
+    uint8_t *p;
+    uint8_t nb_entries = 0;
+    uint8_t i;
+
+    p_buffer = wiced_bt_get_buffer(sizeof(uint32_t) + sizeof(uint8_t) +
+            APP_HCI_CMD_ENTRY_NB * (sizeof(uint16_t) + 3 * sizeof(uint32_t)));
+    if (p_buffer == NULL)
+    {
+        app_memory_alloc_failed(sizeof(uint32_t) + sizeof(uint8_t) +
+                APP_HCI_CMD_ENTRY_NB * (sizeof(uint16_t) + 3 * sizeof(uint32_t)));
+        i = HCI_CONTROL_STATUS_FAILED;
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &i, sizeof(i));
+        return;
+    }
+
+    p = p_buffer;
+    UINT32_TO_STREAM(p, app_hci_cmd_cb.nb_unregistered);
+    p++;                            /* Nb Entries, written below */
+    for (i = 0, p_entry = app_hci_cmd_cb.entries; i < app_hci_cmd_cb.nb_entry; i++, p_entry++)
+    {
+        if (p_entry->nb_cmd == 0)
+        {
+            continue;
+        }
+        UINT16_TO_STREAM(p, p_entry->opcode);
+        UINT32_TO_STREAM(p, p_entry->nb_cmd);
+        UINT32_TO_STREAM(p, p_entry->total_latency / p_entry->nb_cmd);
+        UINT32_TO_STREAM(p, p_entry->max_latency);
+        nb_entries++;
+    }
+    p_buffer[sizeof(uint32_t)] = nb_entries;
+
+    app_hci_send(HCI_PLATFORM_EVENT_HCI_CMD_STATS, p_buffer, (uint16_t)(p - p_buffer));
+
+    wiced_bt_free_buffer(p_buffer);
+}
+
 /*
  * app_hci_lrac_switch_in_progress_set
  */
@@ -275,8 +723,7 @@ void app_hci_lrac_switch_result(wiced_bt_lrac_switch_result_t status,
     evt.status = status;
     evt.local_abort = local_abort;
     evt.fatal_error = fatal_error;
-    wiced_transport_send_data(HCI_PLATFORM_EVENT_LRAC_SWITCH_RESULT, (uint8_t *)&evt,
-            sizeof(evt));
+    app_hci_send(HCI_PLATFORM_EVENT_LRAC_SWITCH_RESULT, (uint8_t *)&evt, sizeof(evt));
 
     app_hci_lrac_switch_in_progress = WICED_FALSE;
 }
@@ -287,13 +734,31 @@ void app_hci_lrac_switch_result(wiced_bt_lrac_switch_result_t status,
 static void app_hci_packet_cback( wiced_bt_hci_trace_type_t type, uint16_t length, uint8_t* p_data )
 {
     wiced_debug_uart_types_t debug_uart_route;
+    uint8_t *p;
+
+#ifdef APP_HCI_RING
+    app_hci_ring_add(type, p_data, length);
+    if (app_hci_trace_forward == WICED_FALSE)
+    {
+        return;
+    }
+#endif
 
     debug_uart_route = wiced_get_debug_uart();
 
     if (debug_uart_route == WICED_ROUTE_DEBUG_TO_WICED_UART)
     {
-        // send the trace over HCI
-        wiced_transport_send_hci_trace( NULL, type, length, p_data  );
+        // send the trace over HCI (Trace Type followed by the HCI packet)
+        p = app_hci_tx_reserve(HCI_CONTROL_EVENT_HCI_TRACE, 1 + length);
+        if (p == NULL)
+        {
+            wiced_transport_send_hci_trace( NULL, type, length, p_data  );
+        }
+        else
+        {
+            UINT8_TO_STREAM(p, type);
+            memcpy(p, p_data, length);
+        }
     }
     else if (debug_uart_route == WICED_ROUTE_DEBUG_TO_PUART)
     {
@@ -331,52 +796,17 @@ static uint32_t app_hci_proc_rx_cmd( uint8_t *p_buffer, uint32_t length )
 
     APP_TRACE_DBG("OpCode:0x%04X\n", opcode);
 
-    switch((opcode >> 8) & 0xff)
-    {
-    case HCI_CONTROL_GROUP_DEVICE:
-        app_hci_device_handle_command(opcode, p_data, payload_len);
-        break;
-
-    case HCI_PLATFORM_GROUP:
-        platform_handle_hci_command(opcode, p_data, payload_len);
-        break;
+    app_hci_cmd_dispatch(opcode, p_data, payload_len);
 
-#if 0
-    case HCI_CONTROL_GROUP_LE:
-    case HCI_CONTROL_GROUP_GATT:
-        app_hci_le_handle_command( opcode, p_data, payload_len );
-        break;
-
-    case HCI_CONTROL_GROUP_AUDIO_SINK:
-        app_hci_audio_handle_command( opcode, p_data, payload_len );
-        break;
-
-    case HCI_CONTROL_GROUP_AVRC_TARGET:
-        //app_hci_avrc_handle_command( opcode, p_data, payload_len );
-        break;
-
-    case HCI_CONTROL_GROUP_AVRC_CONTROLLER:
-        app_hci_avrc_handle_ctrlr_command(opcode, p_data, payload_len);
-        break;
-
-    case HCI_CONTROL_GROUP_HF:
-        app_hci_hf_handle_command ( opcode, p_data, payload_len );
-        break;
-
-    case HCI_CONTROL_GROUP_MISC:
-        app_hci_misc_handle_command( opcode, p_data, payload_len );
-        break;
-#endif
-
-    default:
-        break;
-    }
     if (buffer_processed)
     {
         // Freeing the buffer in which data is received
         wiced_transport_free_buffer( p_buffer );
     }
 
+    /* The Host is waiting for the response: do not wait for the flush timer */
+    app_hci_tx_flush();
+
     return HCI_CONTROL_STATUS_SUCCESS;
 }
 /*
@@ -401,9 +831,10 @@ static void app_hci_device_handle_command(uint16_t cmd_opcode, uint8_t* p_data,
         APP_TRACE_DBG("Reset!!!\n");
         {
             uint8_t status = HCI_CONTROL_STATUS_SUCCESS;
-            wiced_transport_send_data(HCI_CONTROL_EVENT_COMMAND_STATUS, &status,
-                    sizeof(status));
+            app_hci_send(HCI_CONTROL_EVENT_COMMAND_STATUS, &status, sizeof(status));
         }
+        app_hci_tx_flush();
+        app_nvram_cache_flush();
         /* Generate a watchdog Reset */
         wdog_generate_hw_reset();
         break;
@@ -437,6 +868,10 @@ static void app_hci_handle_trace_enable( uint8_t *p_data )
     APP_TRACE_DBG("HCI Traces:%d DebugRoute:%d\n", hci_trace_enable, route_debug);
 
 #ifdef HCI_TRACE_OVER_TRANSPORT
+#ifdef APP_HCI_RING
+    app_hci_trace_forward = hci_trace_enable ? WICED_TRUE : WICED_FALSE;
+    app_hci_trace_register();
+#else
     if (hci_trace_enable)
     {
         /* Register callback for receiving hci traces */
@@ -447,13 +882,31 @@ static void app_hci_handle_trace_enable( uint8_t *p_data )
     {
         wiced_bt_dev_register_hci_trace(NULL);
     }
+#endif
 #endif
 
     wiced_set_debug_uart(route_debug);
 
-    wiced_transport_send_data(HCI_CONTROL_EVENT_COMMAND_STATUS, &status, sizeof(status));
+    app_hci_send(HCI_CONTROL_EVENT_COMMAND_STATUS, &status, sizeof(status));
 }
 
+#ifdef APP_HCI_RING
+/*
+ * app_hci_trace_register
+ */
+void app_hci_trace_register(void)
+{
+    if ((app_hci_trace_forward != WICED_FALSE) || (app_hci_ring_is_enabled() != WICED_FALSE))
+    {
+        wiced_bt_dev_register_hci_trace(app_hci_packet_cback);
+    }
+    else
+    {
+        wiced_bt_dev_register_hci_trace(NULL);
+    }
+}
+#endif
+
 /*
  *  Handle read buffer statistics
  */
@@ -480,13 +933,13 @@ static void app_hci_handle_read_buffer_stats(void)
         }
 
         /* Return the statistics via WICED-HCI */
-        wiced_transport_send_data(HCI_CONTROL_EVENT_READ_BUFFER_STATS, (uint8_t *)&buff_stats,
+        app_hci_send(HCI_CONTROL_EVENT_READ_BUFFER_STATS, (uint8_t *)&buff_stats,
                 sizeof(buff_stats));
     }
     else
     {
         i = HCI_CONTROL_STATUS_FAILED;
-        wiced_transport_send_data(HCI_CONTROL_EVENT_COMMAND_STATUS, &i, 1);
+        app_hci_send(HCI_CONTROL_EVENT_COMMAND_STATUS, &i, 1);
     }
 }
 
@@ -503,7 +956,7 @@ static void app_hci_nvram_write(uint8_t *p_data, uint16_t length)
     {
         APP_TRACE_ERR("command to short");
         cmd_status = 1;
-        wiced_transport_send_data(HCI_CONTROL_EVENT_COMMAND_STATUS, &cmd_status, sizeof(cmd_status));
+        app_hci_send(HCI_CONTROL_EVENT_COMMAND_STATUS, &cmd_status, sizeof(cmd_status));
         return;
     }
     STREAM_TO_UINT16(nvram_id, p_data);
@@ -516,7 +969,7 @@ static void app_hci_nvram_write(uint8_t *p_data, uint16_t length)
     else
         cmd_status = 0;
 
-    wiced_transport_send_data(HCI_CONTROL_EVENT_COMMAND_STATUS, &cmd_status, sizeof(cmd_status));
+    app_hci_send(HCI_CONTROL_EVENT_COMMAND_STATUS, &cmd_status, sizeof(cmd_status));
 }
 
 /*
@@ -526,7 +979,7 @@ static void app_hci_nvram_write(uint8_t *p_data, uint16_t length)
 static void app_hci_transport_status( wiced_transport_type_t type )
 {
     APP_TRACE_DBG("app_hci_transport_status %x \n", type);
-    wiced_transport_send_data(HCI_CONTROL_EVENT_DEVICE_STARTED, NULL, 0);
+    app_hci_send(HCI_CONTROL_EVENT_DEVICE_STARTED, NULL, 0);
 }
 
 /*
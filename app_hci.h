@@ -69,6 +69,24 @@
 #define HCI_PLATFORM_COMMAND_EF_WRITE           ((HCI_PLATFORM_GROUP << 8) | 0x32)
 /* Audio Insertion Extended Simulation */
 #define HCI_PLATFORM_COMMAND_AUDIO_INSERT_EXT   ((HCI_PLATFORM_GROUP << 8) | 0x33)
+/* NVRAM Access Statistics Read */
+#define HCI_PLATFORM_COMMAND_NVRAM_STATS        ((HCI_PLATFORM_GROUP << 8) | 0x34)
+/* Embedded Flash CRC32 (read-back) */
+#define HCI_PLATFORM_COMMAND_EF_CRC             ((HCI_PLATFORM_GROUP << 8) | 0x35)
+/* HCI Tx Coalescer Statistics Read */
+#define HCI_PLATFORM_COMMAND_HCI_TX_STATS       ((HCI_PLATFORM_GROUP << 8) | 0x36)
+/* HCI Command Dispatch Statistics Read */
+#define HCI_PLATFORM_COMMAND_HCI_CMD_STATS      ((HCI_PLATFORM_GROUP << 8) | 0x37)
+/* HCI Ring Buffer Read */
+#define HCI_PLATFORM_COMMAND_HCI_RING_READ      ((HCI_PLATFORM_GROUP << 8) | 0x38)
+/* Memory (Buffer Pools and Heap) Trend Read */
+#define HCI_PLATFORM_COMMAND_MEMORY_TREND       ((HCI_PLATFORM_GROUP << 8) | 0x39)
+/* Memory Monitor Thresholds Set */
+#define HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD   ((HCI_PLATFORM_GROUP << 8) | 0x3A)
+/* HCI Ring Buffer Enable */
+#define HCI_PLATFORM_COMMAND_HCI_RING_ENABLE    ((HCI_PLATFORM_GROUP << 8) | 0x3B)
+/* Memory Trend Capture Enable */
+#define HCI_PLATFORM_COMMAND_MEMORY_CAPTURE     ((HCI_PLATFORM_GROUP << 8) | 0x3C)
 
 /*
  * Platform (Customer specific) Group Events
@@ -77,6 +95,18 @@
 #define HCI_PLATFORM_EVENT_LRAC_SWITCH_RESULT   ((HCI_PLATFORM_GROUP << 8) | 0x23)
 /* VSC Wrapper Command Complete event */
 #define HCI_PLATFORM_EVENT_VSC_CMD_CPLT         ((HCI_PLATFORM_GROUP << 8) | 0x25)
+/* NVRAM Access Statistics event */
+#define HCI_PLATFORM_EVENT_NVRAM_STATS          ((HCI_PLATFORM_GROUP << 8) | 0x34)
+/* Embedded Flash CRC32 event */
+#define HCI_PLATFORM_EVENT_EF_CRC               ((HCI_PLATFORM_GROUP << 8) | 0x35)
+/* HCI Tx Coalescer Statistics event */
+#define HCI_PLATFORM_EVENT_HCI_TX_STATS         ((HCI_PLATFORM_GROUP << 8) | 0x36)
+/* HCI Command Dispatch Statistics event */
+#define HCI_PLATFORM_EVENT_HCI_CMD_STATS        ((HCI_PLATFORM_GROUP << 8) | 0x37)
+/* HCI Ring Buffer event */
+#define HCI_PLATFORM_EVENT_HCI_RING_READ        ((HCI_PLATFORM_GROUP << 8) | 0x38)
+/* Memory Trend event */
+#define HCI_PLATFORM_EVENT_MEMORY_TREND         ((HCI_PLATFORM_GROUP << 8) | 0x39)
 /* Command status event for the requested operation */
 #define HCI_PLATFORM_EVENT_COMMAND_STATUS       ((HCI_PLATFORM_GROUP << 8) | 0xFF)
 
@@ -90,11 +120,46 @@ typedef struct __attribute__((packed)) app_hci_lrac_switch_result_evt
     uint8_t                         fatal_error;
 } app_hci_lrac_switch_result_evt_t;
 
+/*
+ * HCI Command handler
+ */
+typedef void (app_hci_cmd_handler_t)(uint16_t opcode, uint8_t *p_data, uint32_t length);
+
+/*
+ * HCI Tx Coalescer statistics
+ */
+typedef struct
+{
+    uint32_t nb_packet;             /* Packets queued in the Tx Coalescer */
+    uint32_t nb_burst;              /* Bursts (one or more packets) handed to the transport */
+    uint32_t nb_direct;             /* Packets sent without coalescing (too large, no buffer) */
+    uint32_t nb_no_buffer;          /* No transport buffer available to start a burst */
+    uint32_t nb_error;              /* Bursts rejected by the transport */
+    uint16_t max_burst_packets;     /* Coalescer queue depth high watermark (packets) */
+    uint16_t max_burst_bytes;       /* Coalescer queue depth high watermark (bytes) */
+    uint8_t  nb_in_flight;          /* Bursts currently queued in the transport */
+    uint8_t  max_in_flight;         /* Transport queue depth high watermark (bursts) */
+} app_hci_tx_stats_t;
+
 /*
  * app_hci_init
  */
 wiced_result_t app_hci_init(void);
 
+/*
+ * app_hci_cmd_handler_register
+ * Install the handler of an OpCode range (in a single Command Group). The handler, its call
+ * count and its latency are looked up in constant time when a Host command is received.
+ */
+wiced_result_t app_hci_cmd_handler_register(uint16_t first_opcode, uint16_t last_opcode,
+        app_hci_cmd_handler_t *p_handler);
+
+/*
+ * app_hci_cmd_group_handler_register
+ * Install the handler called for the OpCodes of a Command Group which are not registered
+ */
+wiced_result_t app_hci_cmd_group_handler_register(uint8_t group, app_hci_cmd_handler_t *p_handler);
+
 /*
  * app_hci_lrac_switch_in_progress_set
  */
@@ -105,3 +170,30 @@ void app_hci_lrac_switch_in_progress_set(void);
  */
 void app_hci_lrac_switch_result(wiced_bt_lrac_switch_result_t status,
         uint8_t local_abort, uint8_t fatal_error);
+
+/*
+ * app_hci_send
+ * Send a WICED HCI event. Small events are coalesced with the following ones and sent in
+ * a single UART burst (after APP_HCI_TX_FLUSH_DELAY ms at most).
+ */
+wiced_result_t app_hci_send(uint16_t opcode, uint8_t *p_data, uint16_t length);
+
+/*
+ * app_hci_tx_flush
+ * Send the pending burst immediately
+ */
+void app_hci_tx_flush(void);
+
+/*
+ * app_hci_tx_stats_get
+ */
+void app_hci_tx_stats_get(app_hci_tx_stats_t *p_stats);
+
+#ifdef APP_HCI_RING
+/*
+ * app_hci_trace_register
+ * Register the HCI trace callback only if the HCI traces are forwarded to the Host or if the
+ * HCI Ring is enabled (the callback is called for every HCI packet).
+ */
+void app_hci_trace_register(void);
+#endif
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#ifdef APP_HCI_RING
+#include "wiced.h"
+#include "wiced_bt_trace.h"
+#include "wiced_memory.h"
+#include "hci_control_api.h"
+#include "hcidefs.h"
+#include "clock_timer.h"
+#include "app_hci.h"
+#include "app_hci_ring.h"
+#include "app_memory.h"
+#include "app_trace.h"
+
+/*
+ * Definitions
+ */
+#define APP_HCI_RING_MAGIC                  0x48434952      /* 'HCIR' */
+
+#ifndef APP_HCI_RING_NOINIT
+#define APP_HCI_RING_NOINIT                 __attribute__((section(".noinit")))
+    /* The rings must be placed in a RAM section which is not cleared at startup */
+#endif
+
+#define APP_HCI_RING_U16(p)                 ((uint16_t)((p)[0] | ((p)[1] << 8)))
+
+#define APP_HCI_RING_NO_HANDLE              0xFFFF
+#define APP_HCI_RING_NO_STATUS              0xFF
+
+typedef struct
+{
+    uint16_t write_index;                   /* Next entry written */
+    uint16_t nb_entries;
+    app_hci_ring_entry_t entries[APP_HCI_RING_NB_ENTRIES];
+} app_hci_ring_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t current;                        /* Index of the ring of the current run */
+    wiced_bool_t previous_valid;
+    wiced_bool_t enabled;                   /* Survives a warm reset (disabled by the Host) */
+    app_hci_ring_t rings[2];
+} app_hci_ring_cb_t;
+
+/*
+ * Local functions
+ */
+static wiced_bool_t app_hci_ring_is_valid(app_hci_ring_t *p_ring);
+static app_hci_ring_t *app_hci_ring_get(app_hci_ring_id_t ring_id);
+static void app_hci_ring_send(uint16_t opcode, uint8_t *p_data, uint32_t length);
+static void app_hci_ring_enable(uint16_t opcode, uint8_t *p_data, uint32_t length);
+
+/*
+ * Global variables
+ */
+static app_hci_ring_cb_t app_hci_ring_cb APP_HCI_RING_NOINIT;
+
+/*
+ * app_hci_ring_init
+ */
+void app_hci_ring_init(void)
+{
+    if ((app_hci_ring_cb.magic == APP_HCI_RING_MAGIC) &&
+        (app_hci_ring_cb.current < 2) &&
+        (app_hci_ring_is_valid(&app_hci_ring_cb.rings[app_hci_ring_cb.current])))
+    {
+        /* Warm reset: the ring of the previous run becomes the Previous ring */
+        app_hci_ring_cb.current ^= 1;
+        app_hci_ring_cb.previous_valid = WICED_TRUE;
+    }
+    else
+    {
+        memset(&app_hci_ring_cb, 0, sizeof(app_hci_ring_cb));
+        app_hci_ring_cb.magic = APP_HCI_RING_MAGIC;
+        app_hci_ring_cb.previous_valid = WICED_FALSE;
+        app_hci_ring_cb.enabled = WICED_TRUE;
+    }
+
+    app_hci_ring_cb.rings[app_hci_ring_cb.current].write_index = 0;
+    app_hci_ring_cb.rings[app_hci_ring_cb.current].nb_entries = 0;
+
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_HCI_RING_READ,
+            HCI_PLATFORM_COMMAND_HCI_RING_READ, app_hci_ring_send);
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_HCI_RING_ENABLE,
+            HCI_PLATFORM_COMMAND_HCI_RING_ENABLE, app_hci_ring_enable);
+}
+
+/*
+ * app_hci_ring_is_enabled
+ */
+wiced_bool_t app_hci_ring_is_enabled(void)
+{
+    return app_hci_ring_cb.enabled;
+}
+
+/*
+ * app_hci_ring_add
+ * This function is called for every HCI packet: no trace, no formatting.
+ */
+void app_hci_ring_add(wiced_bt_hci_trace_type_t type, uint8_t *p_data, uint16_t length)
+{
+    app_hci_ring_t *p_ring;
+    app_hci_ring_entry_t *p_entry;
+
+    /* The HCI trace callback may be registered only to forward the packets to the Host */
+    if ((app_hci_ring_cb.enabled == WICED_FALSE) ||
+        ((type != HCI_TRACE_COMMAND) && (type != HCI_TRACE_EVENT)))
+    {
+        return;
+    }
+
+    /* Command: OpCode (2), Length (1). Event: Event Code (1), Length (1) */
+    if ((length < 3) ||
+        ((type == HCI_TRACE_EVENT) && (p_data[0] == HCI_NUM_COMPL_DATA_PKTS_EVT)))
+    {
+        return;
+    }
+
+    p_ring = &app_hci_ring_cb.rings[app_hci_ring_cb.current];
+    p_entry = &p_ring->entries[p_ring->write_index];
+
+    p_entry->timestamp = (uint32_t)clock_SystemTimeMicroseconds64();
+    p_entry->type = type;
+    p_entry->handle = APP_HCI_RING_NO_HANDLE;
+    p_entry->status = APP_HCI_RING_NO_STATUS;
+    p_entry->reserved = 0;
+
+    if (type == HCI_TRACE_COMMAND)
+    {
+        p_entry->event = 0;
+        p_entry->opcode = APP_HCI_RING_U16(&p_data[0]);
+        if (length >= (3 + 2))
+        {
+            p_entry->handle = APP_HCI_RING_U16(&p_data[3]);
+        }
+    }
+    else
+    {
+        p_entry->event = p_data[0];
+        p_entry->opcode = 0;
+        switch (p_data[0])
+        {
+        case HCI_COMMAND_COMPLETE_EVT:  /* Nb Cmd (1), OpCode (2), Status (1) */
+            if (length >= (2 + 4))
+            {
+                p_entry->opcode = APP_HCI_RING_U16(&p_data[3]);
+                p_entry->status = p_data[5];
+            }
+            break;
+
+        case HCI_COMMAND_STATUS_EVT:    /* Status (1), Nb Cmd (1), OpCode (2) */
+            if (length >= (2 + 4))
+            {
+                p_entry->status = p_data[2];
+                p_entry->opcode = APP_HCI_RING_U16(&p_data[4]);
+            }
+            break;
+
+        case HCI_BLE_EVENT:             /* Sub Event (1), Status (1), Handle (2) */
+            p_entry->opcode = p_data[2];
+            if (length >= (2 + 4))
+            {
+                p_entry->status = p_data[3];
+                p_entry->handle = APP_HCI_RING_U16(&p_data[4]);
+            }
+            break;
+
+        case HCI_VENDOR_SPECIFIC_EVT:   /* Sub Event (1) */
+            p_entry->opcode = p_data[2];
+            break;
+
+        default:                        /* Most of the events: Status (1), Handle (2) */
+            p_entry->status = p_data[2];
+            if (length >= (2 + 3))
+            {
+                p_entry->handle = APP_HCI_RING_U16(&p_data[3]);
+            }
+            break;
+        }
+    }
+
+    p_ring->write_index = (p_ring->write_index + 1) % APP_HCI_RING_NB_ENTRIES;
+    if (p_ring->nb_entries < APP_HCI_RING_NB_ENTRIES)
+    {
+        p_ring->nb_entries++;
+    }
+}
+
+/*
+ * app_hci_ring_dump
+ * Line format (decoded by lrac_config/hci-ring-decode.py):
+ *  HCI Ring <id>: <timestamp> <type> <event> <opcode> <handle> <status>
+ */
+void app_hci_ring_dump(app_hci_ring_id_t ring_id)
+{
+    app_hci_ring_t *p_ring;
+    app_hci_ring_entry_t *p_entry;
+    uint16_t index;
+    uint16_t i;
+
+    p_ring = app_hci_ring_get(ring_id);
+    if (p_ring == NULL)
+    {
+        WICED_BT_TRACE("No HCI Ring %d\n", ring_id);
+        return;
+    }
+
+    WICED_BT_TRACE("HCI Ring %d (%d entries):\n", ring_id, p_ring->nb_entries);
+
+    index = (p_ring->write_index + APP_HCI_RING_NB_ENTRIES - p_ring->nb_entries) %
+            APP_HCI_RING_NB_ENTRIES;
+    for (i = 0; i < p_ring->nb_entries; i++)
+    {
+        p_entry = &p_ring->entries[index];
+        WICED_BT_TRACE("HCI Ring %d: %08X %02X %02X %04X %04X %02X\n", ring_id,
+                p_entry->timestamp, p_entry->type, p_entry->event, p_entry->opcode,
+                p_entry->handle, p_entry->status);
+        index = (index + 1) % APP_HCI_RING_NB_ENTRIES;
+    }
+}
+
+/*
+ * app_hci_ring_is_valid
+ */
+static wiced_bool_t app_hci_ring_is_valid(app_hci_ring_t *p_ring)
+{
+    if ((p_ring->write_index >= APP_HCI_RING_NB_ENTRIES) ||
+        (p_ring->nb_entries > APP_HCI_RING_NB_ENTRIES))
+    {
+        return WICED_FALSE;
+    }
+    return WICED_TRUE;
+}
+
+/*
+ * app_hci_ring_get
+ */
+static app_hci_ring_t *app_hci_ring_get(app_hci_ring_id_t ring_id)
+{
+    switch (ring_id)
+    {
+    case APP_HCI_RING_CURRENT:
+        return &app_hci_ring_cb.rings[app_hci_ring_cb.current];
+
+    case APP_HCI_RING_PREVIOUS:
+        if (app_hci_ring_cb.previous_valid)
+        {
+            return &app_hci_ring_cb.rings[app_hci_ring_cb.current ^ 1];
+        }
+        break;
+
+    default:
+        break;
+    }
+    return NULL;
+}
+
+/*
+ * app_hci_ring_send
+ * Handle the HCI_PLATFORM_COMMAND_HCI_RING_READ command (Ring Id, 1 byte).
+ * Event format: Ring Id, Status (0: Success, 1: No Ring), Entry Size, Nb Entries (1 byte each)
+ *               followed by the entries (app_hci_ring_entry_t), oldest first.
+ */
+static void app_hci_ring_send(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    app_hci_ring_t *p_ring;
+    uint8_t *p_buffer;
+    uint8_t *p;
+    uint8_t ring_id = APP_HCI_RING_CURRENT;
+    uint8_t status;
+    uint16_t index;
+    uint16_t i;
+
+    if (length >= 1)
+    {
+        ring_id = p_data[0];
+    }
+
+    p_buffer = wiced_bt_get_buffer(4 + sizeof(app_hci_ring_entry_t) * APP_HCI_RING_NB_ENTRIES);
+    if (p_buffer == NULL)
+    {
+        app_memory_alloc_failed(4 + sizeof(app_hci_ring_entry_t) * APP_HCI_RING_NB_ENTRIES);
+        status = HCI_CONTROL_STATUS_FAILED;
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+        return;
+    }
+
+    p_ring = app_hci_ring_get((app_hci_ring_id_t)ring_id);
+
+    p = p_buffer;
+    UINT8_TO_STREAM(p, ring_id);
+    UINT8_TO_STREAM(p, (p_ring == NULL) ? 1 : 0);
+    UINT8_TO_STREAM(p, sizeof(app_hci_ring_entry_t));
+    UINT8_TO_STREAM(p, (p_ring == NULL) ? 0 : p_ring->nb_entries);
+
+    if (p_ring != NULL)
+    {
+        /* The entries are stored Little Endian */
+        index = (p_ring->write_index + APP_HCI_RING_NB_ENTRIES - p_ring->nb_entries) %
+                APP_HCI_RING_NB_ENTRIES;
+        for (i = 0; i < p_ring->nb_entries; i++)
+        {
+            ARRAY_TO_STREAM(p, &p_ring->entries[index], sizeof(app_hci_ring_entry_t));
+            index = (index + 1) % APP_HCI_RING_NB_ENTRIES;
+        }
+    }
+
+    app_hci_send(HCI_PLATFORM_EVENT_HCI_RING_READ, p_buffer, (uint16_t)(p - p_buffer));
+
+    wiced_bt_free_buffer(p_buffer);
+}
+
+/*
+ * app_hci_ring_enable
+ * Handle the HCI_PLATFORM_COMMAND_HCI_RING_ENABLE command (Enable, 1 byte).
+ * The current ring restarts empty when it is enabled.
+ */
+static void app_hci_ring_enable(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    uint8_t status = HCI_CONTROL_STATUS_SUCCESS;
+    wiced_bool_t enable;
+
+    if (length < 1)
+    {
+        status = HCI_CONTROL_STATUS_FAILED;
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+        return;
+    }
+
+    enable = p_data[0] ? WICED_TRUE : WICED_FALSE;
+    APP_TRACE_DBG("HCI Ring enable:%d\n", enable);
+
+    if ((enable != WICED_FALSE) && (app_hci_ring_cb.enabled == WICED_FALSE))
+    {
+        app_hci_ring_cb.rings[app_hci_ring_cb.current].write_index = 0;
+        app_hci_ring_cb.rings[app_hci_ring_cb.current].nb_entries = 0;
+    }
+    app_hci_ring_cb.enabled = enable;
+    app_hci_trace_register();
+
+    app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+}
+#endif /* APP_HCI_RING */
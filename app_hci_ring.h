@@ -0,0 +1,92 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#pragma once
+
+#include "wiced_bt_dev.h"
+
+/*
+ * HCI Ring Buffer.
+ * The last HCI Commands and Events exchanged with the Controller are recorded in RAM (without
+ * any formatting). The ring of the previous run survives a (crash) reset, it is printed with the
+ * CoreDump and both rings can be read over WICED HCI (see lrac_config/hci-ring-decode.py).
+ */
+#define APP_HCI_RING_NB_ENTRIES                 64
+
+typedef enum
+{
+    APP_HCI_RING_CURRENT = 0,           /* Ring of the current run */
+    APP_HCI_RING_PREVIOUS,              /* Ring of the run preceding the last reset */
+    APP_HCI_RING_MAX
+} app_hci_ring_id_t;
+
+/* Ring entry (12 bytes, Little Endian) */
+#pragma pack(1)
+typedef struct
+{
+    uint32_t timestamp;                 /* in us (clock_SystemTimeMicroseconds64 LSBs) */
+    uint16_t opcode;                    /* Command OpCode (Command, Command Complete/Status) or
+                                           LE/Vendor Sub-Event Code */
+    uint16_t handle;                    /* Connection Handle (first parameter), 0xFFFF if none */
+    uint8_t type;                       /* HCI_TRACE_COMMAND or HCI_TRACE_EVENT */
+    uint8_t event;                      /* HCI Event Code (0 for a Command) */
+    uint8_t status;                     /* HCI Status, 0xFF if none */
+    uint8_t reserved;
+} app_hci_ring_entry_t;
+#pragma pack()
+
+/*
+ * app_hci_ring_init
+ * Must be called once at startup (before the first HCI packet is recorded). If the ring of
+ * the previous run has survived the reset, it is kept as the APP_HCI_RING_PREVIOUS ring.
+ * The ring records from a power-on reset (no Host is needed in the field). If the Host has
+ * disabled it (HCI_PLATFORM_COMMAND_HCI_RING_ENABLE), it stays disabled after a warm reset.
+ */
+void app_hci_ring_init(void);
+
+/*
+ * app_hci_ring_is_enabled
+ */
+wiced_bool_t app_hci_ring_is_enabled(void);
+
+/*
+ * app_hci_ring_add
+ * Record an HCI packet (ACL data and Number Of Completed Packets events are ignored)
+ */
+void app_hci_ring_add(wiced_bt_hci_trace_type_t type, uint8_t *p_data, uint16_t length);
+
+/*
+ * app_hci_ring_dump
+ * Print a ring in the traces (one line per entry, oldest first)
+ */
+void app_hci_ring_dump(app_hci_ring_id_t ring_id);
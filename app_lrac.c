@@ -42,6 +42,8 @@
 #include "wiced_bt_lrac.h"
 #include "app_lrac.h"
 #include "app_lrac_quality.h"
+#include "app_lrac_link_keys.h"
+#include "app_memory.h"
 #include "app_nvram.h"
 #include "app_main.h"
 #include "app_trace.h"
@@ -63,6 +65,7 @@
 #include "bt_hs_spk_audio.h"
 #include "bt_hs_spk_handsfree.h"
 #include "bt_hs_spk_handsfree_utils.h"
+#include <wiced_utilities.h>
 
 /*
  * Definitions
@@ -93,21 +96,25 @@
      * rejected always.
      */
 
-/*
- * LRAC OTA Data Operation Code (app_lrac_data_opcode_t)
- */
-enum
-{
-    APP_LRAC_DATA_OPCODE_OFU = 1,
-    APP_LRAC_DATA_OPCODE_BUTTON,
-    APP_LRAC_DATA_OPCODE_VOLUME,
-    APP_LRAC_DATA_OPCODE_NVRAM_WRITE_REQ,
-    APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP,
-    APP_LRAC_DATA_OPCODE_QUALITY,
-    APP_LRAC_DATA_OPCODE_JITTER_BUFFER_TARGET,
-    /* Add other LRAC DATA OPCODE Here ... */
-};
-typedef uint8_t app_lrac_data_opcode_t;
+#define APP_LRAC_DATA_TX_BATCH_SIZE                         64
+    /*
+     * Maximum size of a batched LRAC Data PDU. Control messages (Button, Volume, Jitter Buffer
+     * Target, etc.) sent during the same application event are packed in one PDU to reduce
+     * the number of transmissions competing with the eavesdropped audio slots.
+     * Batched PDU format: BATCH OpCode, then (Length, OpCode + Payload) for each message.
+     */
+
+#define APP_LRAC_RELIABLE_WINDOW_SIZE                       4
+    /* Maximum number of Reliable messages sent but not yet acknowledged */
+#define APP_LRAC_RELIABLE_QUEUE_SIZE                        8
+    /* Maximum number of Reliable messages waiting for an acknowledgement (window included) */
+#define APP_LRAC_RELIABLE_RETX_TIMEOUT                      200     /* in ms */
+#define APP_LRAC_RELIABLE_RETX_MAX                          5
+    /*
+     * Unacknowledged messages are dropped after this number of retransmissions. The Sequence
+     * Numbers keep increasing and the next messages are preceded by a RELIABLE_SYNC (until it
+     * is acknowledged) so that the peer accepts them.
+     */
 
 /*
  * structures
@@ -127,13 +134,45 @@ typedef struct
     wiced_bool_t switch_in_progress;
     wiced_bool_t switch_prevent_glitch;
 
-    /* NVRAM */
-    wiced_bool_t nvram_update_in_progress;
-
     /* Local device LRAC version info. */
     wiced_bt_lrac_version_rsp_t version;
 } app_lrac_cb_t;
 
+typedef struct
+{
+    app_lrac_rx_data_handler_t *p_handler;
+    uint16_t min_length;
+} app_lrac_rx_data_entry_t;
+
+typedef struct
+{
+    uint8_t *p_buffer;          /* RELIABLE OpCode + Sequence Number + Message */
+    uint16_t length;
+} app_lrac_reliable_msg_t;
+
+/* LRAC Data control block. Not exchanged during PS-Switch */
+typedef struct
+{
+    app_lrac_rx_data_entry_t rx_handlers[APP_LRAC_DATA_OPCODE_MAX];
+
+    /* Tx Coalescer */
+    uint8_t tx_batch[APP_LRAC_DATA_TX_BATCH_SIZE];
+    uint16_t tx_batch_len;
+    uint8_t tx_batch_nb_msg;
+    wiced_bool_t tx_flush_scheduled;
+
+    /* Reliable channel (Go-Back-N) */
+    app_lrac_reliable_msg_t reliable_queue[APP_LRAC_RELIABLE_QUEUE_SIZE];
+    uint8_t reliable_first;         /* Queue index of the oldest unacknowledged message */
+    uint8_t reliable_nb_queued;
+    uint8_t reliable_nb_sent;       /* Number of queued messages sent (in the window) */
+    uint8_t reliable_base_seq;      /* Sequence Number of the oldest unacknowledged message */
+    uint8_t reliable_retx_count;
+    wiced_timer_t reliable_retx_timer;
+    wiced_bool_t reliable_sync_pending;     /* The peer must be told the next Sequence Number */
+    uint8_t reliable_rx_expected_seq;
+} app_lrac_data_cb_t;
+
 /*
  * External functions
  */
@@ -145,6 +184,24 @@ static void app_lrac_cback(wiced_bt_lrac_event_t event, wiced_bt_lrac_event_data
 
 static void app_lrac_configuration_start(void);
 static void app_lrac_rx_data_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_ofu_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_button_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_volume_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_jitter_buffer_target_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_batch_handler(uint8_t *p_data, uint16_t length);
+static wiced_result_t app_lrac_data_tx_send(uint8_t *p_data, uint16_t length);
+static wiced_result_t app_lrac_data_tx_flush(void);
+static int app_lrac_data_tx_flush_serialized(void *p_data);
+static void app_lrac_data_tx_reset(void);
+static void app_lrac_rx_data_reliable_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_ack_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_rx_data_reliable_sync_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_reliable_tx_pump(void);
+static void app_lrac_reliable_ack_send(uint8_t seq);
+static void app_lrac_reliable_retx_timer_callback(uint32_t param);
+static void app_lrac_reliable_reset(void);
+static void app_lrac_reliable_tx_drop(void);
+static void app_lrac_reliable_sync_send(void);
 
 static void app_lrac_switch_req_power_mode_callback(wiced_bt_device_address_t bdaddr,
         wiced_bt_dev_power_mgmt_status_t power_mode);
@@ -158,6 +215,35 @@ static int app_lrac_version_compare(const wiced_bt_lrac_version_rsp_t *p_peer_ve
  * Global variables
  */
 static app_lrac_cb_t app_lrac_cb;
+static app_lrac_data_cb_t app_lrac_data_cb;
+
+/* LRAC Data handlers installed at init time */
+static const struct
+{
+    app_lrac_data_opcode_t opcode;
+    uint16_t min_length;
+    app_lrac_rx_data_handler_t *p_handler;
+} app_lrac_rx_data_default_handlers[] =
+{
+    { APP_LRAC_DATA_OPCODE_OFU,                     0,
+            app_lrac_rx_data_ofu_handler },
+    { APP_LRAC_DATA_OPCODE_BUTTON,                  sizeof(uint8_t) + sizeof(uint32_t),
+            app_lrac_rx_data_button_handler },
+    { APP_LRAC_DATA_OPCODE_VOLUME,                  sizeof(uint32_t) + sizeof(uint8_t),
+            app_lrac_rx_data_volume_handler },
+    { APP_LRAC_DATA_OPCODE_QUALITY,                 0,
+            app_lrac_quality_peer_handler },
+    { APP_LRAC_DATA_OPCODE_JITTER_BUFFER_TARGET,    sizeof(uint8_t),
+            app_lrac_rx_data_jitter_buffer_target_handler },
+    { APP_LRAC_DATA_OPCODE_BATCH,                   0,
+            app_lrac_rx_data_batch_handler },
+    { APP_LRAC_DATA_OPCODE_RELIABLE,                sizeof(uint8_t) + sizeof(uint8_t),
+            app_lrac_rx_data_reliable_handler },
+    { APP_LRAC_DATA_OPCODE_ACK,                     sizeof(uint8_t),
+            app_lrac_rx_data_ack_handler },
+    { APP_LRAC_DATA_OPCODE_RELIABLE_SYNC,           sizeof(uint8_t),
+            app_lrac_rx_data_reliable_sync_handler },
+};
 
 /*
  * lrac_init
@@ -168,8 +254,24 @@ wiced_result_t app_lrac_init(app_lrac_callback_t *p_callback)
     wiced_result_t status;
     wiced_bt_lrac_lite_host_feature_t lite_host_lrac_feature;
     wiced_bt_lrac_lite_host_debug_mask_t lite_host_debug_mask;
+    uint32_t i;
 
     memset(&app_lrac_cb, 0, sizeof(app_lrac_cb));
+    memset(&app_lrac_data_cb, 0, sizeof(app_lrac_data_cb));
+
+    /* Install the LRAC Data handlers */
+    for (i = 0; i < _countof(app_lrac_rx_data_default_handlers); i++)
+    {
+        app_lrac_rx_data_handler_register(app_lrac_rx_data_default_handlers[i].opcode,
+                app_lrac_rx_data_default_handlers[i].min_length,
+                app_lrac_rx_data_default_handlers[i].p_handler);
+    }
+
+    wiced_init_timer(&app_lrac_data_cb.reliable_retx_timer,
+            app_lrac_reliable_retx_timer_callback, 0, WICED_MILLI_SECONDS_TIMER);
+
+    /* Link Keys synchronization (installs its own LRAC Data handlers) */
+    app_lrac_link_keys_init();
 
     /* Initialize NVRAM */
     status = app_nvram_init();
@@ -288,6 +390,8 @@ static void app_lrac_cback(wiced_bt_lrac_event_t event, wiced_bt_lrac_event_data
             else
             {
                 app_lrac_cb.connected = WICED_TRUE;
+                /* Both peers restart the Reliable channel sequence numbers */
+                app_lrac_reliable_reset();
                 /* Save this Bdaddr in the Dedicated Pairing Info NVRAM */
                 status = app_nvram_lrac_bdaddr_set(p_data->connected.bdaddr);
                 if (status != WICED_BT_SUCCESS)
@@ -320,6 +424,8 @@ static void app_lrac_cback(wiced_bt_lrac_event_t event, wiced_bt_lrac_event_data
         app_lrac_cb.initiator = WICED_FALSE;
         app_lrac_cb.connecting = WICED_FALSE;
         app_lrac_cb.switch_in_progress = WICED_FALSE;
+        app_lrac_data_tx_reset();
+        app_lrac_reliable_reset();
         app_lrac_cb.p_callback(APP_LRAC_DISCONNECTED, &event_data);
         break;
 
@@ -440,8 +546,8 @@ static void app_lrac_cback(wiced_bt_lrac_event_t event, wiced_bt_lrac_event_data
         else
         {
             APP_TRACE_DBG("Same Versions. No OFU needed\n");
-            /* Check if NVRAM entries must be updated */
-            app_lrac_nvram_update_req();
+            /* Check if NVRAM entries must be updated (repaired from the peer's digest) */
+            app_lrac_link_keys_digest_req();
         }
 
         /* LRAC is connected */
@@ -695,10 +801,6 @@ static void app_lrac_cback(wiced_bt_lrac_event_t event, wiced_bt_lrac_event_data
  */
 void app_lrac_nvram_update_req(void)
 {
-    uint8_t tx_data[sizeof(uint8_t) + (sizeof(wiced_bt_device_link_keys_t) * BT_HS_SPK_CONTROL_LINK_KEY_COUNT)];
-    wiced_bt_device_link_keys_t *p_link_keys = (wiced_bt_device_link_keys_t *) &tx_data[sizeof(uint8_t)];
-    wiced_result_t status;
-
     APP_TRACE_DBG("app_lrac_nvram_update_req (%d)\n", app_lrac_cb.role);
 
     /* Check LRAC role. */
@@ -707,76 +809,9 @@ void app_lrac_nvram_update_req(void)
         return;
     }
 
-    /* NVRAM can be updated to the peer device if connected only */
-    if (app_lrac_cb.connected == WICED_FALSE)
-    {
-        APP_TRACE_DBG("LRAC device not connected\n");
-        return;
-    }
-
-    /* If NVRAM processing ongoing */
-    if (app_lrac_cb.nvram_update_in_progress)
-    {
-        APP_TRACE_DBG("already processing\n");
-        return;
-    }
-
-    /* Get the NVRAM data to be updated */
-    memcpy((void *) p_link_keys,
-           (void *) bt_hs_spk_control_link_keys_get(),
-           sizeof(wiced_bt_device_link_keys_t) * BT_HS_SPK_CONTROL_LINK_KEY_COUNT);
-
-    /* Write to peer device. */
-    tx_data[0] = APP_LRAC_DATA_OPCODE_NVRAM_WRITE_REQ;
-
-    status = wiced_bt_lrac_tx_data(tx_data, sizeof(tx_data));
-    if (status != WICED_BT_SUCCESS)
-    {
-        APP_TRACE_ERR("wiced_bt_lrac_tx_data failed %d\n", status);
-    }
-    else
-    {
-        app_lrac_cb.nvram_update_in_progress = WICED_TRUE;
-    }
-}
-
-/*
- * app_lrac_nvram_send_write_rsp
- */
-#if 1
-static void app_lrac_nvram_send_write_rsp(wiced_result_t rsp_status)
-{
-    uint8_t tx_data[sizeof(uint8_t) + sizeof(uint16_t)];
-    uint8_t *p = &tx_data[0];
-    wiced_result_t status;
-
-    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP);
-    UINT16_TO_STREAM(p, rsp_status);
-
-    status = wiced_bt_lrac_tx_data(tx_data, p - tx_data);
-    if (status != WICED_BT_SUCCESS)
-    {
-        APP_TRACE_ERR("wiced_bt_lrac_tx_data failed %d\n", status);
-    }
+    /* Only the modified entries are sent (if connected) */
+    app_lrac_link_keys_sync();
 }
-#else
-static void app_lrac_nvram_send_write_rsp(uint16_t nvram_id, wiced_result_t rsp_status)
-{
-    uint8_t tx_data[sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint16_t)];
-    uint8_t *p = &tx_data[0];
-    wiced_result_t status;
-
-    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP);
-    UINT16_TO_STREAM(p, nvram_id);
-    UINT16_TO_STREAM(p, rsp_status);
-
-    status = wiced_bt_lrac_tx_data(tx_data, p - tx_data);
-    if (status != WICED_BT_SUCCESS)
-    {
-        APP_TRACE_ERR("wiced_bt_lrac_tx_data failed %d\n", status);
-    }
-}
-#endif
 
 /*
  * app_lrac_connect
@@ -1025,7 +1060,7 @@ wiced_result_t app_lrac_button_send(uint8_t button_id,uint32_t repeat_counter)
     UINT8_TO_STREAM(p, button_id);
     UINT32_TO_STREAM(p, repeat_counter);
 
-    return wiced_bt_lrac_tx_data(tx_data, p - tx_data);
+    return app_lrac_tx_data_reliable(tx_data, p - tx_data);
 }
 
 /*
@@ -1045,7 +1080,7 @@ wiced_result_t app_lrac_volume_send(int32_t am_vol_level, uint8_t am_vol_effect)
     UINT32_TO_STREAM(p, am_vol_level);
     UINT8_TO_STREAM(p, am_vol_effect);
 
-    return wiced_bt_lrac_tx_data(tx_data, p - tx_data);
+    return app_lrac_tx_data_reliable(tx_data, p - tx_data);
 }
 
 /*
@@ -1059,18 +1094,137 @@ wiced_result_t app_lrac_send_ofu(uint8_t *p_data, uint16_t length)
 
     UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_OFU);
 
-    return wiced_bt_lrac_tx_data(p_data, length);
+    return app_lrac_data_tx_send(p_data, length);
 }
 
 /*
  * app_lrac_tx_data
+ * Queue a small LRAC Data message in the Tx Coalescer. The batch is sent at the end of the
+ * current application event (or when it is full). Large messages are sent immediately.
  */
 wiced_result_t app_lrac_tx_data(uint8_t *p_data, uint16_t length)
 {
+    uint8_t *p;
+
     APP_TRACE_DBG("length:%d\n", length);
+
+    if ((p_data == NULL) || (length == 0))
+    {
+        return WICED_BT_BADARG;
+    }
+
+    /* Not connected: let the LRAC library report the error */
+    if (app_lrac_cb.connected == WICED_FALSE)
+    {
+        return wiced_bt_lrac_tx_data(p_data, length);
+    }
+
+    /* Too large to be batched (BATCH OpCode + Length + Message) */
+    if ((1 + 1 + length) > APP_LRAC_DATA_TX_BATCH_SIZE)
+    {
+        return app_lrac_data_tx_send(p_data, length);
+    }
+
+    /* Not enough room left in the current batch */
+    if ((app_lrac_data_cb.tx_batch_len + 1 + length) > APP_LRAC_DATA_TX_BATCH_SIZE)
+    {
+        app_lrac_data_tx_flush();
+    }
+
+    if (app_lrac_data_cb.tx_batch_len == 0)
+    {
+        app_lrac_data_cb.tx_batch[0] = APP_LRAC_DATA_OPCODE_BATCH;
+        app_lrac_data_cb.tx_batch_len = 1;
+    }
+
+    p = &app_lrac_data_cb.tx_batch[app_lrac_data_cb.tx_batch_len];
+    UINT8_TO_STREAM(p, length);
+    ARRAY_TO_STREAM(p, p_data, length);
+    app_lrac_data_cb.tx_batch_len += 1 + length;
+    app_lrac_data_cb.tx_batch_nb_msg++;
+
+    /* Send the batch once the current application event is handled */
+    if (app_lrac_data_cb.tx_flush_scheduled == WICED_FALSE)
+    {
+        if (wiced_app_event_serialize(&app_lrac_data_tx_flush_serialized, NULL) != WICED_SUCCESS)
+        {
+            return app_lrac_data_tx_flush();
+        }
+        app_lrac_data_cb.tx_flush_scheduled = WICED_TRUE;
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_lrac_data_tx_send
+ * Send an LRAC Data message immediately (after the pending batch to keep the order)
+ */
+static wiced_result_t app_lrac_data_tx_send(uint8_t *p_data, uint16_t length)
+{
+    app_lrac_data_tx_flush();
+
     return wiced_bt_lrac_tx_data(p_data, length);
 }
 
+/*
+ * app_lrac_data_tx_flush
+ * Send the pending batch. A single message is sent without the BATCH header.
+ */
+static wiced_result_t app_lrac_data_tx_flush(void)
+{
+    wiced_result_t status;
+
+    switch (app_lrac_data_cb.tx_batch_nb_msg)
+    {
+    case 0:
+        return WICED_BT_SUCCESS;
+
+    case 1:
+        status = wiced_bt_lrac_tx_data(&app_lrac_data_cb.tx_batch[2],
+                app_lrac_data_cb.tx_batch[1]);
+        break;
+
+    default:
+        status = wiced_bt_lrac_tx_data(app_lrac_data_cb.tx_batch,
+                app_lrac_data_cb.tx_batch_len);
+        break;
+    }
+
+    if (status != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("wiced_bt_lrac_tx_data failed %d (nb_msg:%d)\n", status,
+                app_lrac_data_cb.tx_batch_nb_msg);
+    }
+
+    app_lrac_data_cb.tx_batch_len = 0;
+    app_lrac_data_cb.tx_batch_nb_msg = 0;
+
+    return status;
+}
+
+/*
+ * app_lrac_data_tx_flush_serialized
+ */
+static int app_lrac_data_tx_flush_serialized(void *p_data)
+{
+    app_lrac_data_cb.tx_flush_scheduled = WICED_FALSE;
+
+    app_lrac_data_tx_flush();
+
+    return 0;
+}
+
+/*
+ * app_lrac_data_tx_reset
+ * Discard the pending batch (e.g. LRAC link lost)
+ */
+static void app_lrac_data_tx_reset(void)
+{
+    app_lrac_data_cb.tx_batch_len = 0;
+    app_lrac_data_cb.tx_batch_nb_msg = 0;
+}
+
 /*
  * app_lrac_configuration_start
  */
@@ -1132,17 +1286,338 @@ void app_lrac_config_peer_addr_get(wiced_bt_device_address_t peer_addr)
     memcpy((void *) peer_addr, (void *) app_lrac_cb.bdaddr, sizeof(wiced_bt_device_address_t));
 }
 
+/*
+ * app_lrac_tx_data_reliable
+ */
+wiced_result_t app_lrac_tx_data_reliable(uint8_t *p_data, uint16_t length)
+{
+    app_lrac_reliable_msg_t *p_msg;
+    uint8_t *p;
+
+    if ((p_data == NULL) || (length == 0))
+    {
+        return WICED_BT_BADARG;
+    }
+
+    if (app_lrac_cb.connected == WICED_FALSE)
+    {
+        return WICED_NOT_CONNECTED;
+    }
+
+    if (app_lrac_data_cb.reliable_nb_queued >= APP_LRAC_RELIABLE_QUEUE_SIZE)
+    {
+        APP_TRACE_ERR("Reliable queue full\n");
+        return WICED_BT_NO_RESOURCES;
+    }
+
+    p_msg = &app_lrac_data_cb.reliable_queue[(app_lrac_data_cb.reliable_first +
+            app_lrac_data_cb.reliable_nb_queued) % APP_LRAC_RELIABLE_QUEUE_SIZE];
+
+    p_msg->p_buffer = wiced_bt_get_buffer(sizeof(uint8_t) + sizeof(uint8_t) + length);
+    if (p_msg->p_buffer == NULL)
+    {
+        app_memory_alloc_failed(sizeof(uint8_t) + sizeof(uint8_t) + length);
+        APP_TRACE_ERR("No memory\n");
+        return WICED_BT_NO_RESOURCES;
+    }
+
+    p = p_msg->p_buffer;
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_RELIABLE);
+    UINT8_TO_STREAM(p, (uint8_t)(app_lrac_data_cb.reliable_base_seq +
+            app_lrac_data_cb.reliable_nb_queued));
+    ARRAY_TO_STREAM(p, p_data, length);
+    p_msg->length = p - p_msg->p_buffer;
+
+    app_lrac_data_cb.reliable_nb_queued++;
+
+    app_lrac_reliable_tx_pump();
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_lrac_reliable_tx_pump
+ * Send the queued Reliable messages which fit in the window
+ */
+static void app_lrac_reliable_tx_pump(void)
+{
+    app_lrac_reliable_msg_t *p_msg;
+
+    /* The SYNC precedes the first message of the window (same PDU order) */
+    if ((app_lrac_data_cb.reliable_sync_pending) &&
+        (app_lrac_data_cb.reliable_nb_sent == 0) &&
+        (app_lrac_data_cb.reliable_nb_queued > 0))
+    {
+        app_lrac_reliable_sync_send();
+    }
+
+    while ((app_lrac_data_cb.reliable_nb_sent < app_lrac_data_cb.reliable_nb_queued) &&
+           (app_lrac_data_cb.reliable_nb_sent < APP_LRAC_RELIABLE_WINDOW_SIZE))
+    {
+        p_msg = &app_lrac_data_cb.reliable_queue[(app_lrac_data_cb.reliable_first +
+                app_lrac_data_cb.reliable_nb_sent) % APP_LRAC_RELIABLE_QUEUE_SIZE];
+
+        /* A failed transmission is recovered by the retransmission timer */
+        app_lrac_tx_data(p_msg->p_buffer, p_msg->length);
+
+        app_lrac_data_cb.reliable_nb_sent++;
+    }
+
+    if ((app_lrac_data_cb.reliable_nb_sent > 0) &&
+        (wiced_is_timer_in_use(&app_lrac_data_cb.reliable_retx_timer) == WICED_FALSE))
+    {
+        wiced_start_timer(&app_lrac_data_cb.reliable_retx_timer, APP_LRAC_RELIABLE_RETX_TIMEOUT);
+    }
+}
+
+/*
+ * app_lrac_reliable_retx_timer_callback
+ * Retransmit every unacknowledged message of the window (Go-Back-N)
+ */
+static void app_lrac_reliable_retx_timer_callback(uint32_t param)
+{
+    app_lrac_reliable_msg_t *p_msg;
+    uint8_t i;
+
+    if (app_lrac_data_cb.reliable_nb_sent == 0)
+    {
+        return;
+    }
+
+    if (++app_lrac_data_cb.reliable_retx_count > APP_LRAC_RELIABLE_RETX_MAX)
+    {
+        APP_TRACE_ERR("Reliable seq:%d not acknowledged. Drop %d message(s)\n",
+                app_lrac_data_cb.reliable_base_seq, app_lrac_data_cb.reliable_nb_queued);
+        app_lrac_reliable_tx_drop();
+        return;
+    }
+
+    APP_TRACE_DBG("Reliable retx seq:%d nb:%d (%d)\n", app_lrac_data_cb.reliable_base_seq,
+            app_lrac_data_cb.reliable_nb_sent, app_lrac_data_cb.reliable_retx_count);
+
+    if (app_lrac_data_cb.reliable_sync_pending)
+    {
+        app_lrac_reliable_sync_send();
+    }
+
+    for (i = 0; i < app_lrac_data_cb.reliable_nb_sent; i++)
+    {
+        p_msg = &app_lrac_data_cb.reliable_queue[(app_lrac_data_cb.reliable_first + i) %
+                APP_LRAC_RELIABLE_QUEUE_SIZE];
+        app_lrac_tx_data(p_msg->p_buffer, p_msg->length);
+    }
+
+    wiced_start_timer(&app_lrac_data_cb.reliable_retx_timer, APP_LRAC_RELIABLE_RETX_TIMEOUT);
+}
+
+/*
+ * app_lrac_reliable_reset
+ * Drop the pending Reliable messages and restart the Sequence Numbers
+ * (keeps the Rx expected Sequence Number in sync with the peer's Tx)
+ */
+static void app_lrac_reliable_reset(void)
+{
+    uint8_t i;
+
+    wiced_stop_timer(&app_lrac_data_cb.reliable_retx_timer);
+
+    for (i = 0; i < app_lrac_data_cb.reliable_nb_queued; i++)
+    {
+        wiced_bt_free_buffer(app_lrac_data_cb.reliable_queue[(app_lrac_data_cb.reliable_first + i) %
+                APP_LRAC_RELIABLE_QUEUE_SIZE].p_buffer);
+    }
+
+    app_lrac_data_cb.reliable_first = 0;
+    app_lrac_data_cb.reliable_nb_queued = 0;
+    app_lrac_data_cb.reliable_nb_sent = 0;
+    app_lrac_data_cb.reliable_retx_count = 0;
+    app_lrac_data_cb.reliable_base_seq = 0;
+    app_lrac_data_cb.reliable_sync_pending = WICED_FALSE;
+    app_lrac_data_cb.reliable_rx_expected_seq = 0;
+}
+
+/*
+ * app_lrac_reliable_tx_drop
+ * Drop the pending Reliable messages (peer not responding). Unlike app_lrac_reliable_reset,
+ * the Sequence Numbers are not restarted (the peer's Rx state is unknown): the dropped ones are
+ * skipped and the peer is resynchronized with a RELIABLE_SYNC before the next message.
+ */
+static void app_lrac_reliable_tx_drop(void)
+{
+    wiced_stop_timer(&app_lrac_data_cb.reliable_retx_timer);
+
+    while (app_lrac_data_cb.reliable_nb_queued)
+    {
+        wiced_bt_free_buffer(app_lrac_data_cb.reliable_queue[app_lrac_data_cb.reliable_first].p_buffer);
+        app_lrac_data_cb.reliable_queue[app_lrac_data_cb.reliable_first].p_buffer = NULL;
+        app_lrac_data_cb.reliable_first = (app_lrac_data_cb.reliable_first + 1) %
+                APP_LRAC_RELIABLE_QUEUE_SIZE;
+        app_lrac_data_cb.reliable_nb_queued--;
+        app_lrac_data_cb.reliable_base_seq++;
+    }
+
+    app_lrac_data_cb.reliable_nb_sent = 0;
+    app_lrac_data_cb.reliable_retx_count = 0;
+    app_lrac_data_cb.reliable_sync_pending = WICED_TRUE;
+}
+
+/*
+ * app_lrac_reliable_sync_send
+ * Tell the peer the Sequence Number of the next Reliable message
+ */
+static void app_lrac_reliable_sync_send(void)
+{
+    uint8_t tx_data[1 + 1];
+    uint8_t *p = tx_data;
+
+    APP_TRACE_DBG("Reliable sync seq:%d\n", app_lrac_data_cb.reliable_base_seq);
+
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_RELIABLE_SYNC);
+    UINT8_TO_STREAM(p, app_lrac_data_cb.reliable_base_seq);
+
+    app_lrac_tx_data(tx_data, p - tx_data);
+}
+
+/*
+ * app_lrac_reliable_ack_send
+ */
+static void app_lrac_reliable_ack_send(uint8_t seq)
+{
+    uint8_t tx_data[1 + 1];
+    uint8_t *p = tx_data;
+
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_ACK);
+    UINT8_TO_STREAM(p, seq);
+
+    app_lrac_tx_data(tx_data, p - tx_data);
+}
+
+/*
+ * app_lrac_rx_data_reliable_handler
+ */
+static void app_lrac_rx_data_reliable_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t seq;
+
+    STREAM_TO_UINT8(seq, p_data);
+    length--;
+
+    if (seq != app_lrac_data_cb.reliable_rx_expected_seq)
+    {
+        /* Duplicate (our ACK was lost) or out of order (a previous message was lost).
+         * Drop it and acknowledge the last message received in sequence. */
+        APP_TRACE_DBG("Reliable seq:%d dropped (expected:%d)\n", seq,
+                app_lrac_data_cb.reliable_rx_expected_seq);
+        app_lrac_reliable_ack_send((uint8_t)(app_lrac_data_cb.reliable_rx_expected_seq - 1));
+        return;
+    }
+
+    app_lrac_data_cb.reliable_rx_expected_seq++;
+    app_lrac_reliable_ack_send(seq);
+
+    /* Nested Reliable messages are not allowed */
+    if ((p_data[0] == APP_LRAC_DATA_OPCODE_RELIABLE) ||
+        (p_data[0] == APP_LRAC_DATA_OPCODE_RELIABLE_SYNC) ||
+        (p_data[0] == APP_LRAC_DATA_OPCODE_BATCH))
+    {
+        APP_TRACE_ERR("Bad Reliable message OpCode:0x%x\n", p_data[0]);
+        return;
+    }
+
+    app_lrac_rx_data_handler(p_data, length);
+}
+
+/*
+ * app_lrac_rx_data_ack_handler
+ */
+static void app_lrac_rx_data_ack_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t ack_seq;
+    uint8_t nb_acked;
+
+    STREAM_TO_UINT8(ack_seq, p_data);
+
+    /* Any ACK tells the peer expects ack_seq + 1. It is in sync if this is not a dropped one */
+    if ((app_lrac_data_cb.reliable_sync_pending) &&
+        ((uint8_t)(ack_seq - app_lrac_data_cb.reliable_base_seq + 1) <=
+                app_lrac_data_cb.reliable_nb_sent))
+    {
+        APP_TRACE_DBG("Reliable sync acknowledged seq:%d\n", ack_seq);
+        app_lrac_data_cb.reliable_sync_pending = WICED_FALSE;
+    }
+
+    /* Number of messages acknowledged by this (cumulative) ACK */
+    nb_acked = (uint8_t)(ack_seq - app_lrac_data_cb.reliable_base_seq + 1);
+    if ((nb_acked == 0) || (nb_acked > app_lrac_data_cb.reliable_nb_sent))
+    {
+        /* Old or duplicate ACK */
+        return;
+    }
+
+    while (nb_acked--)
+    {
+        wiced_bt_free_buffer(app_lrac_data_cb.reliable_queue[app_lrac_data_cb.reliable_first].p_buffer);
+        app_lrac_data_cb.reliable_queue[app_lrac_data_cb.reliable_first].p_buffer = NULL;
+        app_lrac_data_cb.reliable_first = (app_lrac_data_cb.reliable_first + 1) %
+                APP_LRAC_RELIABLE_QUEUE_SIZE;
+        app_lrac_data_cb.reliable_nb_queued--;
+        app_lrac_data_cb.reliable_nb_sent--;
+        app_lrac_data_cb.reliable_base_seq++;
+    }
+
+    /* Progress: restart the retransmission timer for the remaining messages */
+    app_lrac_data_cb.reliable_retx_count = 0;
+    wiced_stop_timer(&app_lrac_data_cb.reliable_retx_timer);
+
+    app_lrac_reliable_tx_pump();
+}
+
+/*
+ * app_lrac_rx_data_reliable_sync_handler
+ * The peer dropped Reliable messages: the next one has this Sequence Number
+ */
+static void app_lrac_rx_data_reliable_sync_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t seq;
+
+    STREAM_TO_UINT8(seq, p_data);
+
+    if (seq != app_lrac_data_cb.reliable_rx_expected_seq)
+    {
+        APP_TRACE_ERR("Reliable sync seq:%d (expected:%d)\n", seq,
+                app_lrac_data_cb.reliable_rx_expected_seq);
+        app_lrac_data_cb.reliable_rx_expected_seq = seq;
+    }
+
+    /* Acknowledge (the peer stops sending the SYNC) */
+    app_lrac_reliable_ack_send((uint8_t)(seq - 1));
+}
+
+/*
+ * app_lrac_rx_data_handler_register
+ */
+wiced_result_t app_lrac_rx_data_handler_register(app_lrac_data_opcode_t opcode,
+        uint16_t min_length, app_lrac_rx_data_handler_t *p_handler)
+{
+    if ((opcode == 0) || (opcode >= APP_LRAC_DATA_OPCODE_MAX))
+    {
+        APP_TRACE_ERR("Bad LRAC Data OpCode:0x%x\n", opcode);
+        return WICED_BT_BADARG;
+    }
+
+    app_lrac_data_cb.rx_handlers[opcode].p_handler = p_handler;
+    app_lrac_data_cb.rx_handlers[opcode].min_length = min_length;
+
+    return WICED_BT_SUCCESS;
+}
+
 /*
  * app_lrac_rx_data_handler
  */
 static void app_lrac_rx_data_handler(uint8_t *p_data, uint16_t length)
 {
     uint8_t lrac_data_opcode;
-    uint8_t button_id;
-    app_lrac_event_data_t event_data;
-    uint16_t nvram_id;
-    wiced_result_t status;
-    uint8_t jitter_buffer_target;
+    app_lrac_rx_data_entry_t *p_entry;
 
     if (length < 1)
     {
@@ -1156,70 +1631,106 @@ static void app_lrac_rx_data_handler(uint8_t *p_data, uint16_t length)
 
     /* APP_TRACE_DBG("LRAC Data OpCode:0x%X len:%d\n", lrac_data_opcode, length); */
 
-    switch(lrac_data_opcode)
+    if ((lrac_data_opcode >= APP_LRAC_DATA_OPCODE_MAX) ||
+        (app_lrac_data_cb.rx_handlers[lrac_data_opcode].p_handler == NULL))
     {
-    case APP_LRAC_DATA_OPCODE_OFU:
+        APP_TRACE_ERR("Unknown LRAC Rx Data OpCode:0x%x\n", lrac_data_opcode);
+        return;
+    }
 
-#ifdef APP_OFU_SUPPORT
-#ifdef OTA_FW_UPGRADE
-        app_ofu_lrac_rx_handler(p_data, length);
-#endif
-#else
-        {
-            APP_TRACE_DBG("OFU Not Supported. Reject OFU\n");
-            uint8_t ofu_err_msg[2] = { 0x00, 0x3F};
-            app_lrac_send_ofu(ofu_err_msg, sizeof(ofu_err_msg));
-        }
-#endif
-        break;
+    p_entry = &app_lrac_data_cb.rx_handlers[lrac_data_opcode];
+    if (length < p_entry->min_length)
+    {
+        APP_TRACE_ERR("LRAC Rx Data OpCode:0x%x Bad Length:%d (min:%d)\n",
+                lrac_data_opcode, length, p_entry->min_length);
+        return;
+    }
 
-    case APP_LRAC_DATA_OPCODE_BUTTON:
-        STREAM_TO_UINT8(event_data.button.button_id, p_data);
-        STREAM_TO_UINT32(event_data.button.repeat_counter, p_data);
-        app_lrac_cb.p_callback(APP_LRAC_BUTTON, &event_data);
-        break;
+    p_entry->p_handler(p_data, length);
+}
 
-    case APP_LRAC_DATA_OPCODE_VOLUME:
-        STREAM_TO_UINT32(event_data.volume.am_vol_level, p_data);
-        STREAM_TO_UINT8(event_data.volume.am_vol_effect, p_data);
-        app_lrac_cb.p_callback(APP_LRAC_VOLUME, &event_data);
-        break;
+/*
+ * app_lrac_rx_data_batch_handler
+ * Split a batched PDU and dispatch each message
+ */
+static void app_lrac_rx_data_batch_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t msg_len;
+
+    while (length > 0)
+    {
+        STREAM_TO_UINT8(msg_len, p_data);
+        length--;
 
-    /* Peer device asks to update an NVRAM entry */
-    case APP_LRAC_DATA_OPCODE_NVRAM_WRITE_REQ:
-        /* Check LRAC role. */
-        if (app_lrac_cb.role != WICED_BT_LRAC_ROLE_SECONDARY)
+        if ((msg_len == 0) || (msg_len > length))
         {
-            break;
+            APP_TRACE_ERR("Bad batched message length:%d (remaining:%d)\n", msg_len, length);
+            return;
         }
 
-        /* Update the NVRAM with the received data */
-        status = bt_hs_spk_control_link_keys_set((wiced_bt_device_link_keys_t *) p_data);
+        /* Nested batches are not allowed */
+        if (p_data[0] == APP_LRAC_DATA_OPCODE_BATCH)
+        {
+            APP_TRACE_ERR("Nested LRAC Data batch\n");
+            return;
+        }
 
-        /* Reply to peer */
-        app_lrac_nvram_send_write_rsp(status);
-        break;
+        app_lrac_rx_data_handler(p_data, msg_len);
 
-    /* Peer device replies to an NVRAM entry update request */
-    case APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP:
-        STREAM_TO_UINT16(status, p_data);
-        APP_TRACE_DBG("LRAC Data OpCode:NVRAM_WRITE_RSP status:%d\n", status);
-        app_lrac_cb.nvram_update_in_progress = WICED_FALSE;
-        break;
+        p_data += msg_len;
+        length -= msg_len;
+    }
+}
 
-    case APP_LRAC_DATA_OPCODE_QUALITY:
-        app_lrac_quality_peer_handler(p_data, length);
-        break;
+/*
+ * app_lrac_rx_data_ofu_handler
+ */
+static void app_lrac_rx_data_ofu_handler(uint8_t *p_data, uint16_t length)
+{
+#ifdef APP_OFU_SUPPORT
+#ifdef OTA_FW_UPGRADE
+    app_ofu_lrac_rx_handler(p_data, length);
+#endif
+#else
+    APP_TRACE_DBG("OFU Not Supported. Reject OFU\n");
+    uint8_t ofu_err_msg[2] = { 0x00, 0x3F};
+    app_lrac_send_ofu(ofu_err_msg, sizeof(ofu_err_msg));
+#endif
+}
 
-    case APP_LRAC_DATA_OPCODE_JITTER_BUFFER_TARGET:
-        STREAM_TO_UINT8(jitter_buffer_target, p_data);
-        app_a2dp_sink_jitter_buffer_target_set(jitter_buffer_target);
-        break;
+/*
+ * app_lrac_rx_data_button_handler
+ */
+static void app_lrac_rx_data_button_handler(uint8_t *p_data, uint16_t length)
+{
+    app_lrac_event_data_t event_data;
 
-    default:
-        APP_TRACE_ERR("Unknown LRAC Rx Data OpCode:0x%x\n", lrac_data_opcode);
-        break;
-    }
+    STREAM_TO_UINT8(event_data.button.button_id, p_data);
+    STREAM_TO_UINT32(event_data.button.repeat_counter, p_data);
+    app_lrac_cb.p_callback(APP_LRAC_BUTTON, &event_data);
+}
+
+/*
+ * app_lrac_rx_data_volume_handler
+ */
+static void app_lrac_rx_data_volume_handler(uint8_t *p_data, uint16_t length)
+{
+    app_lrac_event_data_t event_data;
+
+    STREAM_TO_UINT32(event_data.volume.am_vol_level, p_data);
+    STREAM_TO_UINT8(event_data.volume.am_vol_effect, p_data);
+    app_lrac_cb.p_callback(APP_LRAC_VOLUME, &event_data);
+}
+
+/*
+ * app_lrac_rx_data_jitter_buffer_target_handler
+ */
+static void app_lrac_rx_data_jitter_buffer_target_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t jitter_buffer_target;
+
+    STREAM_TO_UINT8(jitter_buffer_target, p_data);
+    app_a2dp_sink_jitter_buffer_target_set(jitter_buffer_target);
 }
 
 /*
@@ -1610,6 +2121,7 @@ wiced_result_t app_lrac_send_quality(void *p_data, uint16_t length)
     p_buffer = wiced_bt_get_buffer(length + 1);
     if (p_buffer == NULL)
     {
+        app_memory_alloc_failed(length + 1);
         APP_TRACE_ERR("No memory\n");
         return WICED_BT_NO_RESOURCES;
     }
@@ -1623,7 +2135,7 @@ wiced_result_t app_lrac_send_quality(void *p_data, uint16_t length)
     memcpy(p, p_data, length);
 
     /* Send LRAC LRAC User Data to peer device. */
-    status = wiced_bt_lrac_tx_data(p_buffer, length + 1);
+    status = app_lrac_data_tx_send(p_buffer, length + 1);
     if (status != WICED_BT_SUCCESS)
     {
         APP_TRACE_ERR("Send LRAC User Data fail (%d).\n", status);
@@ -1648,7 +2160,7 @@ wiced_result_t app_lrac_jitter_buffer_target_send(uint8_t jitter_buffer_target)
     UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_JITTER_BUFFER_TARGET);
     UINT8_TO_STREAM(p, jitter_buffer_target);
 
-    return wiced_bt_lrac_tx_data(tx_data, p - tx_data);
+    return app_lrac_tx_data_reliable(tx_data, p - tx_data);
 }
 
 /*
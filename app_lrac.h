@@ -127,6 +127,34 @@ typedef union
 
 typedef void (app_lrac_callback_t)(app_lrac_event_t event, app_lrac_event_data_t *p_data);
 
+/*
+ * LRAC OTA Data Operation Code (app_lrac_data_opcode_t)
+ */
+enum
+{
+    APP_LRAC_DATA_OPCODE_OFU = 1,
+    APP_LRAC_DATA_OPCODE_BUTTON,
+    APP_LRAC_DATA_OPCODE_VOLUME,
+    APP_LRAC_DATA_OPCODE_NVRAM_WRITE_REQ,   /* Legacy. Whole Link Key table (Primary to Secondary) */
+    APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP,   /* Legacy. Status (Secondary to Primary) */
+    APP_LRAC_DATA_OPCODE_QUALITY,
+    APP_LRAC_DATA_OPCODE_JITTER_BUFFER_TARGET,
+    APP_LRAC_DATA_OPCODE_BATCH,             /* Several LRAC Data messages in one PDU */
+    APP_LRAC_DATA_OPCODE_RELIABLE,          /* Sequenced LRAC Data message (must be acknowledged) */
+    APP_LRAC_DATA_OPCODE_ACK,               /* Cumulative acknowledgement of Reliable messages */
+    APP_LRAC_DATA_OPCODE_RELIABLE_SYNC,     /* Next Reliable Sequence Number (after a give up) */
+    APP_LRAC_DATA_OPCODE_LINK_KEYS_UPDATE,  /* Modified Link Key entries (Primary to Secondary) */
+    APP_LRAC_DATA_OPCODE_LINK_KEYS_DIGEST,  /* Link Key table digest (Secondary to Primary) */
+    /* Add other LRAC DATA OPCODE Here ... */
+    APP_LRAC_DATA_OPCODE_MAX
+};
+typedef uint8_t app_lrac_data_opcode_t;
+
+/*
+ * LRAC Data Rx handler. p_data/length exclude the OpCode.
+ */
+typedef void (app_lrac_rx_data_handler_t)(uint8_t *p_data, uint16_t length);
+
 /*
  * lrac_init
  * Initializes the LRAC System (app and library)
@@ -209,9 +237,27 @@ wiced_result_t app_lrac_send_ofu(uint8_t *p_data, uint16_t length);
 
 /*
  * app_lrac_tx_data
+ * Send an LRAC Data message (OpCode + payload) to the peer device.
+ * Small messages sent during the same application event are coalesced in a single PDU.
  */
 wiced_result_t app_lrac_tx_data(uint8_t *p_data, uint16_t length);
 
+/*
+ * app_lrac_tx_data_reliable
+ * Send an LRAC Data message (OpCode + payload) to the peer device with acknowledged delivery.
+ * Messages are delivered in order and only once. They are retransmitted until acknowledged
+ * (or dropped after too many retries or if the LRAC link is lost).
+ */
+wiced_result_t app_lrac_tx_data_reliable(uint8_t *p_data, uint16_t length);
+
+/*
+ * app_lrac_rx_data_handler_register
+ * Install the handler of an LRAC Data OpCode.
+ * Messages whose payload is shorter than min_length are dropped before reaching the handler.
+ */
+wiced_result_t app_lrac_rx_data_handler_register(app_lrac_data_opcode_t opcode,
+        uint16_t min_length, app_lrac_rx_data_handler_t *p_handler);
+
 /*
  * app_lrac_switch_req
  */
@@ -302,5 +348,6 @@ void app_lrac_link_key_reset(void);
 
 /*
  * app_lrac_nvram_update_req
+ * Send the modified Link Key entries to the peer device (Primary only)
  */
 void app_lrac_nvram_update_req(void);
@@ -0,0 +1,465 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+
+/** @file
+ *
+ * This file implements the synchronization of the Link Keys between the LRAC devices.
+ *
+ * The Primary keeps a copy of the last synchronized Link Key table. When the table is updated,
+ * only the modified entries are sent (batched) to the Secondary which writes its NVRAM once
+ * per update and replies with a digest (hash of every entry).
+ * The Primary sends again the entries whose hash differs. The digest is also requested when the
+ * LRAC connection is established, to repair any divergence.
+ *
+ * The legacy NVRAM_WRITE_REQ (whole table) is still accepted from a Primary running an older
+ * firmware (e.g. during an OFU of the two devices).
+ */
+
+#include "wiced.h"
+#include "wiced_memory.h"
+#include "wiced_bt_lrac.h"
+#include "app_lrac.h"
+#include "app_lrac_link_keys.h"
+#include "app_memory.h"
+#include "app_trace.h"
+#include "bt_hs_spk_control.h"
+
+/*
+ * Definitions
+ */
+#define APP_LRAC_LINK_KEYS_NB                   BT_HS_SPK_CONTROL_LINK_KEY_COUNT
+
+#define APP_LRAC_LINK_KEYS_UPDATE_MAX_ENTRIES   4
+    /* Maximum number of entries per LINK_KEYS_UPDATE message (limited by the buffer pools) */
+
+#define APP_LRAC_LINK_KEYS_REPAIR_MAX           3
+    /* Maximum number of consecutive digest mismatches repaired. Prevents an endless loop if
+     * the Secondary fails to write its NVRAM */
+
+/*
+ * LINK_KEYS_UPDATE (Primary to Secondary):
+ *      Nb Entries (1 byte) then, for each entry:
+ *      Index (1 byte), wiced_bt_device_link_keys_t
+ *      An update without entry is a digest request.
+ * LINK_KEYS_DIGEST (Secondary to Primary):
+ *      Nb Entries (1 byte) then, for every entry of the table:
+ *      Hash (4 bytes)
+ */
+#define APP_LRAC_LINK_KEYS_UPDATE_ENTRY_SIZE    (1 + sizeof(wiced_bt_device_link_keys_t))
+#define APP_LRAC_LINK_KEYS_DIGEST_ENTRY_SIZE    4
+
+/*
+ * Structures
+ */
+typedef struct
+{
+    wiced_bt_device_link_keys_t link_keys[APP_LRAC_LINK_KEYS_NB];  /* Last synchronized table */
+    uint32_t dirty_mask;                /* Entries to send to the Secondary */
+    uint8_t repair_count;
+} app_lrac_link_keys_cb_t;
+
+/*
+ * Local functions
+ */
+static void app_lrac_link_keys_refresh(void);
+static void app_lrac_link_keys_update_send(void);
+static void app_lrac_link_keys_digest_send(void);
+static uint32_t app_lrac_link_keys_hash(wiced_bt_device_link_keys_t *p_link_keys);
+static void app_lrac_link_keys_update_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_link_keys_digest_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_link_keys_nvram_write_req_handler(uint8_t *p_data, uint16_t length);
+static void app_lrac_link_keys_nvram_write_rsp_handler(uint8_t *p_data, uint16_t length);
+
+/*
+ * Global variables
+ */
+static app_lrac_link_keys_cb_t app_lrac_link_keys_cb;
+
+/*
+ * app_lrac_link_keys_init
+ */
+wiced_result_t app_lrac_link_keys_init(void)
+{
+    memset(&app_lrac_link_keys_cb, 0, sizeof(app_lrac_link_keys_cb));
+
+    /* The current table is the reference. Divergences are detected with the peer's digest */
+    memcpy(app_lrac_link_keys_cb.link_keys, bt_hs_spk_control_link_keys_get(),
+            sizeof(app_lrac_link_keys_cb.link_keys));
+
+    app_lrac_rx_data_handler_register(APP_LRAC_DATA_OPCODE_LINK_KEYS_UPDATE,
+            sizeof(uint8_t), app_lrac_link_keys_update_handler);
+    app_lrac_rx_data_handler_register(APP_LRAC_DATA_OPCODE_LINK_KEYS_DIGEST,
+            sizeof(uint8_t), app_lrac_link_keys_digest_handler);
+    app_lrac_rx_data_handler_register(APP_LRAC_DATA_OPCODE_NVRAM_WRITE_REQ,
+            sizeof(app_lrac_link_keys_cb.link_keys), app_lrac_link_keys_nvram_write_req_handler);
+    app_lrac_rx_data_handler_register(APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP,
+            sizeof(uint16_t), app_lrac_link_keys_nvram_write_rsp_handler);
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_lrac_link_keys_sync
+ */
+void app_lrac_link_keys_sync(void)
+{
+    if (app_lrac_config_role_get() != WICED_BT_LRAC_ROLE_PRIMARY)
+    {
+        return;
+    }
+
+    app_lrac_link_keys_refresh();
+    app_lrac_link_keys_cb.repair_count = 0;
+
+    app_lrac_link_keys_update_send();
+}
+
+/*
+ * app_lrac_link_keys_digest_req
+ */
+void app_lrac_link_keys_digest_req(void)
+{
+    uint8_t tx_data[1 + 1];
+    uint8_t *p = tx_data;
+    wiced_result_t status;
+
+    if ((app_lrac_config_role_get() != WICED_BT_LRAC_ROLE_PRIMARY) ||
+        (app_lrac_is_connected() == WICED_FALSE))
+    {
+        return;
+    }
+
+    app_lrac_link_keys_refresh();
+    app_lrac_link_keys_cb.repair_count = 0;
+
+    /* Empty update */
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_LINK_KEYS_UPDATE);
+    UINT8_TO_STREAM(p, 0);
+
+    status = app_lrac_tx_data_reliable(tx_data, p - tx_data);
+    if (status != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("app_lrac_tx_data_reliable failed %d\n", status);
+    }
+}
+
+/*
+ * app_lrac_link_keys_refresh
+ * Compare the Link Key table with the last synchronized one and mark the modified entries
+ */
+static void app_lrac_link_keys_refresh(void)
+{
+    wiced_bt_device_link_keys_t *p_link_keys = bt_hs_spk_control_link_keys_get();
+    uint8_t i;
+
+    for (i = 0; i < APP_LRAC_LINK_KEYS_NB; i++)
+    {
+        if (memcmp(&app_lrac_link_keys_cb.link_keys[i], &p_link_keys[i],
+                sizeof(wiced_bt_device_link_keys_t)) != 0)
+        {
+            memcpy(&app_lrac_link_keys_cb.link_keys[i], &p_link_keys[i],
+                    sizeof(wiced_bt_device_link_keys_t));
+            app_lrac_link_keys_cb.dirty_mask |= 1 << i;
+        }
+    }
+}
+
+/*
+ * app_lrac_link_keys_update_send
+ * Send the modified entries to the Secondary
+ */
+static void app_lrac_link_keys_update_send(void)
+{
+    uint8_t *p_buffer;
+    uint8_t *p;
+    uint8_t i = 0;
+    uint8_t nb_entries;
+    uint32_t sent_mask;
+    wiced_result_t status;
+
+    if (app_lrac_is_connected() == WICED_FALSE)
+    {
+        /* The modified entries will be repaired with the digest on reconnection */
+        return;
+    }
+
+    while (app_lrac_link_keys_cb.dirty_mask != 0)
+    {
+        p_buffer = wiced_bt_get_buffer(1 + 1 + (APP_LRAC_LINK_KEYS_UPDATE_MAX_ENTRIES *
+                APP_LRAC_LINK_KEYS_UPDATE_ENTRY_SIZE));
+        if (p_buffer == NULL)
+        {
+            app_memory_alloc_failed(1 + 1 + (APP_LRAC_LINK_KEYS_UPDATE_MAX_ENTRIES *
+                    APP_LRAC_LINK_KEYS_UPDATE_ENTRY_SIZE));
+            APP_TRACE_ERR("No memory\n");
+            return;
+        }
+
+        p = p_buffer;
+        UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_LINK_KEYS_UPDATE);
+        p++;    /* Nb Entries written below */
+
+        nb_entries = 0;
+        sent_mask = 0;
+        for ( ; (i < APP_LRAC_LINK_KEYS_NB) &&
+                (nb_entries < APP_LRAC_LINK_KEYS_UPDATE_MAX_ENTRIES); i++)
+        {
+            if ((app_lrac_link_keys_cb.dirty_mask & (1 << i)) == 0)
+            {
+                continue;
+            }
+
+            UINT8_TO_STREAM(p, i);
+            ARRAY_TO_STREAM(p, (uint8_t *) &app_lrac_link_keys_cb.link_keys[i],
+                    sizeof(wiced_bt_device_link_keys_t));
+            nb_entries++;
+            sent_mask |= 1 << i;
+        }
+        p_buffer[1] = nb_entries;
+
+        APP_TRACE_DBG("LinkKeys update nb_entries:%d mask:0x%x\n", nb_entries, sent_mask);
+
+        status = app_lrac_tx_data_reliable(p_buffer, p - p_buffer);
+        wiced_bt_free_buffer(p_buffer);
+        if (status != WICED_BT_SUCCESS)
+        {
+            APP_TRACE_ERR("app_lrac_tx_data_reliable failed %d\n", status);
+            return;
+        }
+
+        app_lrac_link_keys_cb.dirty_mask &= ~sent_mask;
+    }
+}
+
+/*
+ * app_lrac_link_keys_digest_send
+ * Send the digest of the local Link Key table to the Primary
+ */
+static void app_lrac_link_keys_digest_send(void)
+{
+    uint8_t tx_data[1 + 1 + (APP_LRAC_LINK_KEYS_NB * APP_LRAC_LINK_KEYS_DIGEST_ENTRY_SIZE)];
+    uint8_t *p = tx_data;
+    wiced_bt_device_link_keys_t *p_link_keys = bt_hs_spk_control_link_keys_get();
+    uint8_t i;
+    wiced_result_t status;
+
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_LINK_KEYS_DIGEST);
+    UINT8_TO_STREAM(p, APP_LRAC_LINK_KEYS_NB);
+    for (i = 0; i < APP_LRAC_LINK_KEYS_NB; i++)
+    {
+        UINT32_TO_STREAM(p, app_lrac_link_keys_hash(&p_link_keys[i]));
+    }
+
+    status = app_lrac_tx_data_reliable(tx_data, p - tx_data);
+    if (status != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("app_lrac_tx_data_reliable failed %d\n", status);
+    }
+}
+
+/*
+ * app_lrac_link_keys_hash
+ * FNV-1a hash of a Link Key entry
+ */
+static uint32_t app_lrac_link_keys_hash(wiced_bt_device_link_keys_t *p_link_keys)
+{
+    uint8_t *p = (uint8_t *) p_link_keys;
+    uint32_t hash = 0x811C9DC5;
+    uint16_t i;
+
+    for (i = 0; i < sizeof(wiced_bt_device_link_keys_t); i++)
+    {
+        hash ^= p[i];
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+/*
+ * app_lrac_link_keys_update_handler
+ * Secondary. Apply the entries received from the Primary and reply with the digest.
+ */
+static void app_lrac_link_keys_update_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t nb_entries;
+    uint8_t index;
+    wiced_bool_t modified = WICED_FALSE;
+    wiced_result_t status;
+
+    if (app_lrac_config_role_get() != WICED_BT_LRAC_ROLE_SECONDARY)
+    {
+        return;
+    }
+
+    STREAM_TO_UINT8(nb_entries, p_data);
+    length--;
+
+    if (length < (nb_entries * APP_LRAC_LINK_KEYS_UPDATE_ENTRY_SIZE))
+    {
+        APP_TRACE_ERR("Bad Length:%d (nb_entries:%d)\n", length, nb_entries);
+        return;
+    }
+
+    /* Start from the current table */
+    memcpy(app_lrac_link_keys_cb.link_keys, bt_hs_spk_control_link_keys_get(),
+            sizeof(app_lrac_link_keys_cb.link_keys));
+
+    while (nb_entries--)
+    {
+        STREAM_TO_UINT8(index, p_data);
+        if (index >= APP_LRAC_LINK_KEYS_NB)
+        {
+            APP_TRACE_ERR("Bad index:%d\n", index);
+            return;
+        }
+
+        if (memcmp(&app_lrac_link_keys_cb.link_keys[index], p_data,
+                sizeof(wiced_bt_device_link_keys_t)) != 0)
+        {
+            memcpy(&app_lrac_link_keys_cb.link_keys[index], p_data,
+                    sizeof(wiced_bt_device_link_keys_t));
+            modified = WICED_TRUE;
+        }
+        p_data += sizeof(wiced_bt_device_link_keys_t);
+    }
+
+    /* Write the NVRAM once, if the content changed */
+    if (modified)
+    {
+        status = bt_hs_spk_control_link_keys_set(app_lrac_link_keys_cb.link_keys);
+        if (status != WICED_BT_SUCCESS)
+        {
+            APP_TRACE_ERR("bt_hs_spk_control_link_keys_set failed %d\n", status);
+        }
+    }
+
+    app_lrac_link_keys_digest_send();
+}
+
+/*
+ * app_lrac_link_keys_digest_handler
+ * Primary. Send again the entries which differ on the Secondary.
+ */
+static void app_lrac_link_keys_digest_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t nb_entries;
+    uint32_t hash;
+    uint32_t mismatch_mask = 0;
+    uint8_t i;
+
+    if (app_lrac_config_role_get() != WICED_BT_LRAC_ROLE_PRIMARY)
+    {
+        return;
+    }
+
+    STREAM_TO_UINT8(nb_entries, p_data);
+    length--;
+
+    if ((nb_entries != APP_LRAC_LINK_KEYS_NB) ||
+        (length < (nb_entries * APP_LRAC_LINK_KEYS_DIGEST_ENTRY_SIZE)))
+    {
+        APP_TRACE_ERR("Bad Digest Length:%d (nb_entries:%d)\n", length, nb_entries);
+        return;
+    }
+
+    for (i = 0; i < APP_LRAC_LINK_KEYS_NB; i++)
+    {
+        STREAM_TO_UINT32(hash, p_data);
+
+        if (hash != app_lrac_link_keys_hash(&app_lrac_link_keys_cb.link_keys[i]))
+        {
+            APP_TRACE_DBG("LinkKeys entry:%d differs\n", i);
+            mismatch_mask |= 1 << i;
+        }
+    }
+
+    if (mismatch_mask == 0)
+    {
+        app_lrac_link_keys_cb.repair_count = 0;
+        return;
+    }
+
+    if (++app_lrac_link_keys_cb.repair_count > APP_LRAC_LINK_KEYS_REPAIR_MAX)
+    {
+        APP_TRACE_ERR("LinkKeys still differ (mask:0x%x). Give up\n", mismatch_mask);
+        return;
+    }
+
+    app_lrac_link_keys_cb.dirty_mask |= mismatch_mask;
+    app_lrac_link_keys_update_send();
+}
+
+/*
+ * app_lrac_link_keys_nvram_write_req_handler
+ * Secondary. Legacy request: the Primary sends its whole Link Key table.
+ */
+static void app_lrac_link_keys_nvram_write_req_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t tx_data[sizeof(uint8_t) + sizeof(uint16_t)];
+    uint8_t *p = tx_data;
+    wiced_result_t status;
+
+    if (app_lrac_config_role_get() != WICED_BT_LRAC_ROLE_SECONDARY)
+    {
+        return;
+    }
+
+    APP_TRACE_DBG("LRAC Data OpCode:NVRAM_WRITE_REQ (legacy)\n");
+
+    memcpy(app_lrac_link_keys_cb.link_keys, p_data, sizeof(app_lrac_link_keys_cb.link_keys));
+    status = bt_hs_spk_control_link_keys_set(app_lrac_link_keys_cb.link_keys);
+
+    /* Reply to peer (a single message is sent without BATCH header) */
+    UINT8_TO_STREAM(p, APP_LRAC_DATA_OPCODE_NVRAM_WRITE_RSP);
+    UINT16_TO_STREAM(p, status);
+
+    status = app_lrac_tx_data(tx_data, p - tx_data);
+    if (status != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("app_lrac_tx_data failed %d\n", status);
+    }
+}
+
+/*
+ * app_lrac_link_keys_nvram_write_rsp_handler
+ * Primary. Legacy response (never requested by this firmware)
+ */
+static void app_lrac_link_keys_nvram_write_rsp_handler(uint8_t *p_data, uint16_t length)
+{
+    uint16_t status;
+
+    STREAM_TO_UINT16(status, p_data);
+    APP_TRACE_DBG("LRAC Data OpCode:NVRAM_WRITE_RSP status:%d\n", status);
+}
@@ -53,6 +53,7 @@
 #include "wiced_app_cfg.h"
 #include "app_lrac.h"
 #include "app_lrac_quality.h"
+#include "app_memory.h"
 #include "app_nvram.h"
 #include "app_trace.h"
 #include "app_a2dp_sink.h"
@@ -147,7 +148,7 @@ typedef struct
 #ifdef APP_OFU_SUPPORT
 typedef struct
 {
-    uint8_t ongoing;
+    uint8_t ongoing;            /* Bit mask of the OFU transports in use (1 << transport) */
 } app_main_ofu_cb_t;
 #endif
 
@@ -214,6 +215,7 @@ static wiced_bool_t app_main_button_secondary_handler(platform_button_id_t butto
         uint32_t repeat_counter);
 static void app_main_quality_callback(app_lrac_quality_event_t event,
         app_lrac_quality_event_data_t *p_data);
+static void app_main_memory_callback(app_memory_event_t event, app_memory_event_data_t *p_data);
 static void app_main_platform_charger_callback(platform_charger_event_t event);
 
 static wiced_result_t app_main_update_dev(void);
@@ -498,6 +500,13 @@ wiced_result_t app_main_post_init(void)
         APP_TRACE_ERR("app_lrac_quality_init failed status:%d\n", status);
     }
 
+    /* Initialize the Memory (Buffer Pools and Heap) monitor */
+    status = app_memory_init(app_main_memory_callback);
+    if (status != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("app_memory_init failed status:%d\n", status);
+    }
+
     /* Init LRAC eavesdropping recover timer */
     wiced_init_timer(&app_main_cb.lrac.eavesdropping_recover_timer,
         app_main_lrac_eavesdropping_recover_timer_callback, 0, WICED_MILLI_SECONDS_TIMER);
@@ -1018,6 +1027,7 @@ static void app_main_lrac_callback(app_lrac_event_t event, app_lrac_event_data_t
             if (p_data->switch_completed.fatal_error)
             {
                 APP_TRACE_ERR("SWITCH FATAL ERROR. REBOOT HIGHLY RECOMMENDED\n");
+                app_nvram_cache_flush();
                 /* Generate a watchdog Reset */
                 wdog_generate_hw_reset();
             }
@@ -1490,27 +1500,27 @@ static void app_main_ofu_callback(app_ofu_event_t event, app_ofu_event_data_t *p
         APP_TRACE_DBG("OFU Started transport:%s(%d)\n",
                 app_main_ofu_transport_get_desc(p_data->started.transport),
                 p_data->started.transport);
-        if (app_main_cb.ofu.ongoing)
+        if (app_main_cb.ofu.ongoing & (1 << p_data->started.transport))
             APP_TRACE_ERR("OFU already ongoing\n");
-        app_main_cb.ofu.ongoing = WICED_TRUE;
+        app_main_cb.ofu.ongoing |= 1 << p_data->started.transport;
         break;
 
     case APP_OFU_EVENT_COMPLETED:
         APP_TRACE_DBG("OFU Completed transport:%s(%d)\n",
                 app_main_ofu_transport_get_desc(p_data->completed.transport),
                 p_data->completed.transport);
-        if (app_main_cb.ofu.ongoing == WICED_FALSE)
+        if ((app_main_cb.ofu.ongoing & (1 << p_data->completed.transport)) == 0)
             APP_TRACE_ERR("OFU was not ongoing\n");
-        app_main_cb.ofu.ongoing = WICED_FALSE;
+        app_main_cb.ofu.ongoing &= ~(1 << p_data->completed.transport);
         break;
 
     case APP_OFU_EVENT_ABORTED:
         APP_TRACE_DBG("OFU Aborted transport:%s(%d)\n",
                 app_main_ofu_transport_get_desc(p_data->aborted.transport),
                 p_data->aborted.transport);
-        if (app_main_cb.ofu.ongoing == WICED_FALSE)
+        if ((app_main_cb.ofu.ongoing & (1 << p_data->aborted.transport)) == 0)
             APP_TRACE_ERR("OFU was not ongoing\n");
-        app_main_cb.ofu.ongoing = WICED_FALSE;
+        app_main_cb.ofu.ongoing &= ~(1 << p_data->aborted.transport);
         break;
 
     default:
@@ -1601,6 +1611,7 @@ static wiced_bool_t app_main_button_primary_handler(platform_button_id_t button_
     case PLATFORM_BUTTON_POWER_OFF:
         APP_TRACE_DBG("TODO: Check if PowerOff must be sent to Secondary\n");
         bt_hs_spk_control_disconnect(NULL);
+        app_nvram_cache_flush();
         platform_led_set(PLATFORM_LED_POWER_OFF, 0);
         return WICED_TRUE;
 
@@ -1832,6 +1843,32 @@ static void app_main_quality_callback(app_lrac_quality_event_t event,
         break;
     }
 }
+
+/*
+ * app_main_memory_callback
+ */
+static void app_main_memory_callback(app_memory_event_t event, app_memory_event_data_t *p_data)
+{
+    switch (event)
+    {
+    case APP_MEMORY_POOL_HIGH:
+        APP_TRACE_ERR("Pool %d (size:%d) high: %d/%d buffers allocated\n",
+                p_data->pool_high.pool_id, p_data->pool_high.pool_size,
+                p_data->pool_high.current_count, p_data->pool_high.total_count);
+        break;
+
+    case APP_MEMORY_HEAP_LOW:
+        APP_TRACE_ERR("Heap low: %d bytes free\n", p_data->heap_low.free_bytes);
+        /* Reboot (cleanly) before the memory is exhausted */
+        app_main_free_memory_check();
+        break;
+
+    default:
+        APP_TRACE_ERR("Unknown event:%d\n", event);
+        break;
+    }
+}
+
 /*
  * app_main_platform_charger_callback
  */
@@ -1855,6 +1892,7 @@ static void app_main_platform_charger_callback(platform_charger_event_t event)
     case PLATFORM_CHARGER_REMOVED:
         APP_TRACE_DBG("Charger Removed. Rebooting...\n");
         platform_led_set(PLATFORM_LED_CHARGER, event);
+        app_nvram_cache_flush();
         wdog_generate_hw_reset();   /* Generate a watchdog Reset */
         break;
 
@@ -2176,6 +2214,7 @@ void app_main_free_memory_check(void)
     if (wiced_memory_get_free_bytes() < MIN_FREE_MEMORY_BYTE)
     {
         WICED_BT_TRACE("ERR: Free Memory insufficient! Rebooting.\n");
+        app_nvram_cache_flush();
         wiced_hal_wdog_reset_system();
     }
 }
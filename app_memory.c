@@ -0,0 +1,455 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include "wiced.h"
+#include "wiced_timer.h"
+#include "wiced_memory.h"
+#include "wiced_bt_dev.h"
+#include "hci_control_api.h"
+#include "app_hci.h"
+#include "app_memory.h"
+#include "app_trace.h"
+
+/*
+ * Definitions
+ */
+#define APP_MEMORY_SAMPLE_PERIOD                1       /* in seconds */
+#define APP_MEMORY_TREND_NB                     32      /* Samples kept (oldest overwritten) */
+
+#define APP_MEMORY_POOL_THRESHOLD_DEFAULT       90      /* in % of the pool buffers */
+#define APP_MEMORY_POOL_HYSTERESIS              10      /* in % (re-arm below threshold - 10%) */
+#define APP_MEMORY_HEAP_THRESHOLD_DEFAULT       2048    /* in bytes */
+#define APP_MEMORY_HEAP_HYSTERESIS              512     /* in bytes */
+
+/* Header, per pool statistics and samples (see app_memory_trend_send) */
+#define APP_MEMORY_TREND_EVENT_SIZE             (1 + 4 + 1 + 1 + 1 +                            \
+                                                 APP_MEMORY_POOL_MAX * 6 * sizeof(uint16_t) +  \
+                                                 APP_MEMORY_TREND_NB *                          \
+                                                 (sizeof(uint32_t) + APP_MEMORY_POOL_MAX))
+
+typedef struct
+{
+    uint32_t free_bytes;
+    uint8_t pool_count[APP_MEMORY_POOL_MAX];    /* Buffers allocated (saturated to 255) */
+} app_memory_sample_t;
+
+typedef struct
+{
+    app_memory_callback_t *p_callback;
+    wiced_timer_t timer;
+    uint8_t nb_pools;
+    uint8_t nb_cfg_pools;                       /* Pools of wiced_app_cfg_buf_pools (the first) */
+    uint8_t pool_threshold;                     /* in % */
+    uint32_t heap_threshold;                    /* in bytes */
+    uint8_t pool_alert;                         /* Bit mask of the pools above their threshold */
+    wiced_bool_t heap_alert;
+    uint16_t pool_size[APP_MEMORY_POOL_MAX];
+    uint8_t pool_full;                          /* Bit mask of the pools exhausted */
+    uint16_t pool_nb_alerts[APP_MEMORY_POOL_MAX];
+    uint16_t pool_nb_exhausted[APP_MEMORY_POOL_MAX];
+    uint16_t pool_nb_alloc_failed[APP_MEMORY_POOL_MAX];
+    uint32_t min_free_bytes;
+    wiced_bool_t trend_capture;                 /* Samples recorded in the trend */
+    uint8_t trend_index;                        /* Next sample written */
+    uint8_t trend_nb;
+    app_memory_sample_t trend[APP_MEMORY_TREND_NB];
+} app_memory_cb_t;
+
+/*
+ * External functions
+ */
+extern uint8_t wiced_bt_get_number_of_buffer_pools(void);
+extern int wiced_app_cfg_buf_pools_get_num(void);
+
+/*
+ * Local functions
+ */
+static void app_memory_timer_callback(uint32_t param);
+static void app_memory_pool_check(wiced_bt_buffer_statistics_t *p_stats);
+static void app_memory_heap_check(uint32_t free_bytes);
+static void app_memory_trend_send(uint16_t opcode, uint8_t *p_data, uint32_t length);
+static void app_memory_threshold_handler(uint16_t opcode, uint8_t *p_data, uint32_t length);
+static void app_memory_capture_handler(uint16_t opcode, uint8_t *p_data, uint32_t length);
+
+/*
+ * Global variables
+ */
+static app_memory_cb_t app_memory_cb;
+
+/*
+ * app_memory_init
+ */
+wiced_result_t app_memory_init(app_memory_callback_t *p_callback)
+{
+    wiced_bt_buffer_statistics_t stats[APP_MEMORY_POOL_MAX];
+    uint8_t i;
+
+    memset(&app_memory_cb, 0, sizeof(app_memory_cb));
+
+    app_memory_cb.p_callback = p_callback;
+    app_memory_cb.pool_threshold = APP_MEMORY_POOL_THRESHOLD_DEFAULT;
+    app_memory_cb.heap_threshold = APP_MEMORY_HEAP_THRESHOLD_DEFAULT;
+    app_memory_cb.min_free_bytes = wiced_memory_get_free_bytes();
+    app_memory_cb.trend_capture = WICED_TRUE;
+
+    app_memory_cb.nb_pools = wiced_bt_get_number_of_buffer_pools();
+    if (app_memory_cb.nb_pools > APP_MEMORY_POOL_MAX)
+    {
+        APP_TRACE_ERR("Only %d pools (out of %d) monitored\n", APP_MEMORY_POOL_MAX,
+                app_memory_cb.nb_pools);
+        app_memory_cb.nb_pools = APP_MEMORY_POOL_MAX;
+    }
+
+    /* The pools created at runtime (e.g. transport pools) follow the configured ones */
+    app_memory_cb.nb_cfg_pools = (uint8_t)wiced_app_cfg_buf_pools_get_num();
+    if (app_memory_cb.nb_cfg_pools > app_memory_cb.nb_pools)
+    {
+        app_memory_cb.nb_cfg_pools = app_memory_cb.nb_pools;
+    }
+
+    /* The pool sizes are used to account the allocation failures */
+    if (wiced_bt_get_buffer_usage(stats, app_memory_cb.nb_pools * sizeof(stats[0])) ==
+            WICED_BT_SUCCESS)
+    {
+        for (i = 0; i < app_memory_cb.nb_pools; i++)
+        {
+            app_memory_cb.pool_size[i] = stats[i].pool_size;
+        }
+    }
+
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_MEMORY_TREND,
+            HCI_PLATFORM_COMMAND_MEMORY_TREND, app_memory_trend_send);
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD,
+            HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD, app_memory_threshold_handler);
+    app_hci_cmd_handler_register(HCI_PLATFORM_COMMAND_MEMORY_CAPTURE,
+            HCI_PLATFORM_COMMAND_MEMORY_CAPTURE, app_memory_capture_handler);
+
+    wiced_init_timer(&app_memory_cb.timer, app_memory_timer_callback, 0,
+            WICED_SECONDS_PERIODIC_TIMER);
+    wiced_start_timer(&app_memory_cb.timer, APP_MEMORY_SAMPLE_PERIOD);
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_memory_trend_capture
+ */
+void app_memory_trend_capture(wiced_bool_t enable)
+{
+    APP_TRACE_DBG("enable:%d\n", enable);
+
+    app_memory_cb.trend_capture = enable;
+}
+
+/*
+ * app_memory_alloc_failed
+ */
+void app_memory_alloc_failed(uint16_t size)
+{
+    uint8_t i;
+
+    if (app_memory_cb.nb_pools == 0)
+    {
+        return;
+    }
+
+    /* The stack uses the next pool when a pool is empty: all the pools able to hold the
+     * buffer were exhausted and the smallest of them is the one to enlarge */
+    for (i = 0; i < (app_memory_cb.nb_pools - 1); i++)
+    {
+        if (app_memory_cb.pool_size[i] >= size)
+        {
+            break;
+        }
+    }
+    if (app_memory_cb.pool_nb_alloc_failed[i] < 0xFFFF)
+    {
+        app_memory_cb.pool_nb_alloc_failed[i]++;
+    }
+}
+
+/*
+ * app_memory_threshold_set
+ */
+void app_memory_threshold_set(uint8_t pool_threshold, uint32_t heap_threshold)
+{
+    APP_TRACE_DBG("pool_threshold:%d%% heap_threshold:%d\n", pool_threshold, heap_threshold);
+
+    app_memory_cb.pool_threshold = pool_threshold;
+    app_memory_cb.heap_threshold = heap_threshold;
+
+    /* The new thresholds are checked from the next sample */
+    app_memory_cb.pool_alert = 0;
+    app_memory_cb.heap_alert = WICED_FALSE;
+}
+
+/*
+ * app_memory_timer_callback
+ * Sample the pools and the heap (no trace unless a threshold is crossed)
+ */
+static void app_memory_timer_callback(uint32_t param)
+{
+    wiced_bt_buffer_statistics_t stats[APP_MEMORY_POOL_MAX];
+    app_memory_sample_t *p_sample;
+    uint32_t free_bytes;
+    uint8_t i;
+
+    if (wiced_bt_get_buffer_usage(stats, app_memory_cb.nb_pools * sizeof(stats[0])) !=
+            WICED_BT_SUCCESS)
+    {
+        return;
+    }
+    free_bytes = wiced_memory_get_free_bytes();
+
+    if (app_memory_cb.trend_capture)
+    {
+        p_sample = &app_memory_cb.trend[app_memory_cb.trend_index];
+        p_sample->free_bytes = free_bytes;
+        for (i = 0; i < app_memory_cb.nb_pools; i++)
+        {
+            p_sample->pool_count[i] = (stats[i].current_allocated_count > 0xFF) ?
+                    0xFF : (uint8_t)stats[i].current_allocated_count;
+        }
+        app_memory_cb.trend_index = (app_memory_cb.trend_index + 1) % APP_MEMORY_TREND_NB;
+        if (app_memory_cb.trend_nb < APP_MEMORY_TREND_NB)
+        {
+            app_memory_cb.trend_nb++;
+        }
+    }
+
+    app_memory_pool_check(stats);
+    app_memory_heap_check(free_bytes);
+}
+
+/*
+ * app_memory_pool_check
+ * Raise APP_MEMORY_POOL_HIGH once per crossing (re-armed when the usage goes back below
+ * threshold - APP_MEMORY_POOL_HYSTERESIS)
+ */
+static void app_memory_pool_check(wiced_bt_buffer_statistics_t *p_stats)
+{
+    app_memory_event_data_t event_data;
+    uint32_t usage;
+    uint8_t i;
+
+    for (i = 0; i < app_memory_cb.nb_pools; i++, p_stats++)
+    {
+        if (p_stats->total_count == 0)
+        {
+            continue;
+        }
+        usage = (p_stats->current_allocated_count * 100) / p_stats->total_count;
+
+        /* Count the exhaustions (the next allocations use a larger pool or fail) */
+        if (p_stats->current_allocated_count >= p_stats->total_count)
+        {
+            if (((app_memory_cb.pool_full & (1 << i)) == 0) &&
+                (app_memory_cb.pool_nb_exhausted[i] < 0xFFFF))
+            {
+                app_memory_cb.pool_nb_exhausted[i]++;
+            }
+            app_memory_cb.pool_full |= (1 << i);
+        }
+        else
+        {
+            app_memory_cb.pool_full &= ~(1 << i);
+        }
+
+        if (app_memory_cb.pool_alert & (1 << i))
+        {
+            if ((usage + APP_MEMORY_POOL_HYSTERESIS) < app_memory_cb.pool_threshold)
+            {
+                app_memory_cb.pool_alert &= ~(1 << i);
+            }
+        }
+        else if (usage >= app_memory_cb.pool_threshold)
+        {
+            app_memory_cb.pool_alert |= (1 << i);
+            app_memory_cb.pool_nb_alerts[i]++;
+            if (app_memory_cb.p_callback)
+            {
+                event_data.pool_high.pool_id = p_stats->pool_id;
+                event_data.pool_high.pool_size = p_stats->pool_size;
+                event_data.pool_high.current_count = p_stats->current_allocated_count;
+                event_data.pool_high.total_count = p_stats->total_count;
+                app_memory_cb.p_callback(APP_MEMORY_POOL_HIGH, &event_data);
+            }
+        }
+    }
+}
+
+/*
+ * app_memory_heap_check
+ */
+static void app_memory_heap_check(uint32_t free_bytes)
+{
+    app_memory_event_data_t event_data;
+
+    if (free_bytes < app_memory_cb.min_free_bytes)
+    {
+        app_memory_cb.min_free_bytes = free_bytes;
+    }
+
+    if (app_memory_cb.heap_alert)
+    {
+        if (free_bytes > (app_memory_cb.heap_threshold + APP_MEMORY_HEAP_HYSTERESIS))
+        {
+            app_memory_cb.heap_alert = WICED_FALSE;
+        }
+    }
+    else if (free_bytes < app_memory_cb.heap_threshold)
+    {
+        app_memory_cb.heap_alert = WICED_TRUE;
+        if (app_memory_cb.p_callback)
+        {
+            event_data.heap_low.free_bytes = free_bytes;
+            app_memory_cb.p_callback(APP_MEMORY_HEAP_LOW, &event_data);
+        }
+    }
+}
+
+/*
+ * app_memory_trend_send
+ * Handle the HCI_PLATFORM_COMMAND_MEMORY_TREND command.
+ * Event format: Sample Period (1 byte, in s), Min Free Bytes (4 bytes), Nb Pools (1 byte),
+ *               Nb Samples (1 byte), Nb Configured Pools (1 byte, the first pools are the ones
+ *               of wiced_app_cfg_buf_pools, the others are created at runtime),
+ *               then for each pool:
+ *                  Buffer Size, Buffer Count, Max Allocated, Nb Threshold Alerts,
+ *                  Nb Exhausted, Nb Allocation Failures (2 bytes each)
+ *               then for each sample (oldest first):
+ *                  Free Bytes (4 bytes), Allocated Buffers of each pool (1 byte each)
+ */
+static void app_memory_trend_send(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    wiced_bt_buffer_statistics_t stats[APP_MEMORY_POOL_MAX];
+    app_memory_sample_t *p_sample;
+    uint8_t *p_buffer;
+    uint8_t *p;
+    uint8_t status;
+    uint8_t index;
+    uint8_t i, j;
+
+    p_buffer = wiced_bt_get_buffer(APP_MEMORY_TREND_EVENT_SIZE);
+    if (p_buffer == NULL)
+    {
+        app_memory_alloc_failed(APP_MEMORY_TREND_EVENT_SIZE);
+        status = HCI_CONTROL_STATUS_FAILED;
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+        return;
+    }
+    if (wiced_bt_get_buffer_usage(stats, app_memory_cb.nb_pools * sizeof(stats[0])) !=
+            WICED_BT_SUCCESS)
+    {
+        wiced_bt_free_buffer(p_buffer);
+        status = HCI_CONTROL_STATUS_FAILED;
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+        return;
+    }
+
+    p = p_buffer;
+    UINT8_TO_STREAM(p, APP_MEMORY_SAMPLE_PERIOD);
+    UINT32_TO_STREAM(p, app_memory_cb.min_free_bytes);
+    UINT8_TO_STREAM(p, app_memory_cb.nb_pools);
+    UINT8_TO_STREAM(p, app_memory_cb.trend_nb);
+    UINT8_TO_STREAM(p, app_memory_cb.nb_cfg_pools);
+    for (i = 0; i < app_memory_cb.nb_pools; i++)
+    {
+        UINT16_TO_STREAM(p, stats[i].pool_size);
+        UINT16_TO_STREAM(p, stats[i].total_count);
+        UINT16_TO_STREAM(p, stats[i].max_allocated_count);
+        UINT16_TO_STREAM(p, app_memory_cb.pool_nb_alerts[i]);
+        UINT16_TO_STREAM(p, app_memory_cb.pool_nb_exhausted[i]);
+        UINT16_TO_STREAM(p, app_memory_cb.pool_nb_alloc_failed[i]);
+    }
+
+    index = (app_memory_cb.trend_index + APP_MEMORY_TREND_NB - app_memory_cb.trend_nb) %
+            APP_MEMORY_TREND_NB;
+    for (i = 0; i < app_memory_cb.trend_nb; i++)
+    {
+        p_sample = &app_memory_cb.trend[index];
+        UINT32_TO_STREAM(p, p_sample->free_bytes);
+        for (j = 0; j < app_memory_cb.nb_pools; j++)
+        {
+            UINT8_TO_STREAM(p, p_sample->pool_count[j]);
+        }
+        index = (index + 1) % APP_MEMORY_TREND_NB;
+    }
+
+    app_hci_send(HCI_PLATFORM_EVENT_MEMORY_TREND, p_buffer, (uint16_t)(p - p_buffer));
+
+    wiced_bt_free_buffer(p_buffer);
+}
+
+/*
+ * app_memory_threshold_handler
+ * Handle the HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD command.
+ * Command format: Pool Threshold (1 byte, in %), Heap Threshold (4 bytes, in bytes)
+ */
+static void app_memory_threshold_handler(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    uint8_t pool_threshold;
+    uint32_t heap_threshold;
+    uint8_t status = HCI_CONTROL_STATUS_FAILED;
+
+    if (length >= (1 + 4))
+    {
+        STREAM_TO_UINT8(pool_threshold, p_data);
+        STREAM_TO_UINT32(heap_threshold, p_data);
+        if ((pool_threshold > 0) && (pool_threshold <= 100))
+        {
+            app_memory_threshold_set(pool_threshold, heap_threshold);
+            status = HCI_CONTROL_STATUS_SUCCESS;
+        }
+    }
+
+    app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+}
+
+/*
+ * app_memory_capture_handler
+ * Handle the HCI_PLATFORM_COMMAND_MEMORY_CAPTURE command.
+ * Command format: Enable (1 byte)
+ */
+static void app_memory_capture_handler(uint16_t opcode, uint8_t *p_data, uint32_t length)
+{
+    uint8_t status = HCI_CONTROL_STATUS_FAILED;
+
+    if (length >= 1)
+    {
+        app_memory_trend_capture(p_data[0] ? WICED_TRUE : WICED_FALSE);
+        status = HCI_CONTROL_STATUS_SUCCESS;
+    }
+
+    app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS, &status, sizeof(status));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#pragma once
+
+#include "wiced.h"
+
+/*
+ * Memory monitor.
+ * The Buffer Pools usage and the free Heap are sampled periodically. An event is sent to the
+ * application when a pool (or the heap) crosses its threshold and the last samples can be read
+ * over WICED HCI (HCI_PLATFORM_COMMAND_MEMORY_TREND) to size the pools of wiced_app_cfg.c.
+ * The Host can stop (and restart) the recording of the samples in the trend
+ * (HCI_PLATFORM_COMMAND_MEMORY_CAPTURE), the thresholds are always checked.
+ * The peak usage, the number of times each pool was exhausted and the allocation failures are
+ * also reported (see buffer-pool-tune.py in lrac_config).
+ */
+#define APP_MEMORY_POOL_MAX                     8       /* Maximum number of Buffer Pools */
+
+typedef enum
+{
+    APP_MEMORY_POOL_HIGH,           /* A Buffer Pool usage reached its threshold */
+    APP_MEMORY_HEAP_LOW,            /* The free Heap went below its threshold */
+} app_memory_event_t;
+
+typedef union
+{
+    struct
+    {
+        uint8_t pool_id;
+        uint16_t pool_size;
+        uint16_t current_count;     /* Buffers allocated */
+        uint16_t total_count;
+    } pool_high;
+    struct
+    {
+        uint32_t free_bytes;
+    } heap_low;
+} app_memory_event_data_t;
+
+typedef void (app_memory_callback_t)(app_memory_event_t event, app_memory_event_data_t *p_data);
+
+/*
+ * app_memory_init
+ * Start the periodic sampling (the samples are recorded in the trend)
+ */
+wiced_result_t app_memory_init(app_memory_callback_t *p_callback);
+
+/*
+ * app_memory_trend_capture
+ * Start (or stop) the recording of the samples in the trend
+ */
+void app_memory_trend_capture(wiced_bool_t enable);
+
+/*
+ * app_memory_alloc_failed
+ * Record a buffer allocation failure (wiced_bt_get_buffer returned NULL) of size bytes. The
+ * failure is counted against the smallest pool able to hold such a buffer.
+ */
+void app_memory_alloc_failed(uint16_t size);
+
+/*
+ * app_memory_threshold_set
+ * pool_threshold: Buffer Pool usage (in % of its buffers) raising APP_MEMORY_POOL_HIGH
+ * heap_threshold: free Heap (in bytes) raising APP_MEMORY_HEAP_LOW
+ */
+void app_memory_threshold_set(uint8_t pool_threshold, uint32_t heap_threshold);
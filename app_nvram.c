@@ -33,29 +33,362 @@
 
 #include "app_nvram.h"
 #include "wiced_hal_rand.h"
+#include "wiced_timer.h"
 #include "app_trace.h"
 #include "wiced_bt_dev.h"
 
 /*
  * Definitions
  */
+#define APP_NVRAM_CACHE_FLUSH_DELAY         500     /* in ms */
+    /* Writes of the cached NVRAM IDs are delayed (and coalesced) during this window.
+     * The cache is also flushed, on demand, before a reset (app_nvram_cache_flush). */
+
+typedef enum
+{
+    APP_NVRAM_CACHE_STATE_EMPTY = 0,        /* Content unknown (not read yet) */
+    APP_NVRAM_CACHE_STATE_ABSENT,           /* NVRAM ID not present in NVRAM */
+    APP_NVRAM_CACHE_STATE_VALID,            /* Same content as the NVRAM */
+    APP_NVRAM_CACHE_STATE_DIRTY,            /* Content not yet written in NVRAM */
+} app_nvram_cache_state_t;
+
+/* Content of the cached NVRAM IDs */
+typedef union
+{
+    wiced_bt_device_sec_keys_t pairing_info;
+    app_nvram_lrac_info_t lrac_info;
+    wiced_bt_device_address_t bdaddr;
+    app_nvram_sleep_t sleep;
+    uint8_t local_irk[BTM_SECURITY_LOCAL_KEY_DATA_LEN];
+#ifdef VOICE_PROMPT
+    wiced_bt_voice_prompt_config_t voice_prompt_config;
+#endif
+    app_nvram_ofu_checkpoint_t ofu_checkpoint;
+} app_nvram_cache_data_t;
+
+typedef struct
+{
+    app_nvram_cache_state_t state;
+    uint16_t length;
+    app_nvram_cache_data_t data;
+    app_nvram_stats_t stats;
+} app_nvram_cache_entry_t;
+
+typedef struct
+{
+    wiced_bool_t initialized;
+    wiced_timer_t flush_timer;
+    app_nvram_cache_entry_t entries[APP_NVRAM_CACHE_NB_ID];
+} app_nvram_cb_t;
 
 /*
  * Local functions
  */
+static app_nvram_cache_entry_t *app_nvram_cache_entry_get(uint16_t nvram_id);
+static wiced_result_t app_nvram_cache_write(uint16_t nvram_id, uint8_t *p_data, uint16_t length);
+static uint16_t app_nvram_cache_read(uint16_t nvram_id, uint8_t *p_data, uint16_t length,
+        wiced_result_t *p_status);
+static void app_nvram_cache_delete(uint16_t nvram_id, wiced_result_t *p_status);
+static wiced_result_t app_nvram_cache_entry_flush(uint16_t nvram_id,
+        app_nvram_cache_entry_t *p_entry);
+static void app_nvram_cache_flush_timer_callback(uint32_t param);
 
 /*
  * Global variables
  */
+static app_nvram_cb_t app_nvram_cb;
+
+/* NVRAM IDs handled by the cache (the others are written directly) */
+static const uint16_t app_nvram_cache_ids[APP_NVRAM_CACHE_NB_ID] =
+{
+    NVRAM_ID_LRAC_INFO,
+    NVRAM_ID_LOCAL_BDADDR,
+    NVRAM_ID_PEER_LRAC_BDADDR,
+    NVRAM_ID_SLEEP,
+    NVRAM_ID_VOICE_PROMPT_FS,
+    NVRAM_ID_PAIRING_INFO_LRAC,
+    NVRAM_ID_LOCAL_IRK,
+    NVRAM_ID_OFU_CHECKPOINT,
+};
 
 /*
  * app_nvram_init
  */
 wiced_result_t app_nvram_init(void)
 {
+    uint8_t i;
+
+    if (app_nvram_cb.initialized)
+    {
+        return WICED_BT_SUCCESS;
+    }
+
+    memset(&app_nvram_cb, 0, sizeof(app_nvram_cb));
+
+    for (i = 0; i < APP_NVRAM_CACHE_NB_ID; i++)
+    {
+        app_nvram_cb.entries[i].stats.nvram_id = app_nvram_cache_ids[i];
+    }
+
+    wiced_init_timer(&app_nvram_cb.flush_timer, app_nvram_cache_flush_timer_callback, 0,
+            WICED_MILLI_SECONDS_TIMER);
+
+    app_nvram_cb.initialized = WICED_TRUE;
+
     return WICED_BT_SUCCESS;
 }
 
+/*
+ * app_nvram_cache_entry_get
+ * Returns the cache entry of an NVRAM ID (NULL if this ID is not cached)
+ */
+static app_nvram_cache_entry_t *app_nvram_cache_entry_get(uint16_t nvram_id)
+{
+    uint8_t i;
+
+    /* Before initialization, the NVRAM is accessed directly */
+    if (app_nvram_cb.initialized == WICED_FALSE)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < APP_NVRAM_CACHE_NB_ID; i++)
+    {
+        if (app_nvram_cache_ids[i] == nvram_id)
+        {
+            return &app_nvram_cb.entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * app_nvram_cache_write
+ * Write an NVRAM ID through the cache. The write is skipped if the content is unchanged and
+ * delayed (to be coalesced with the following ones) otherwise.
+ */
+static wiced_result_t app_nvram_cache_write(uint16_t nvram_id, uint8_t *p_data, uint16_t length)
+{
+    app_nvram_cache_entry_t *p_entry = app_nvram_cache_entry_get(nvram_id);
+    uint16_t nb_bytes;
+    wiced_result_t status;
+
+    if ((p_entry == NULL) ||
+        (length > sizeof(p_entry->data)))
+    {
+        nb_bytes = wiced_hal_write_nvram(nvram_id, length, p_data, &status);
+        if ((nb_bytes != length) ||
+            (status != WICED_BT_SUCCESS))
+        {
+            return WICED_BT_ERROR;
+        }
+        if (p_entry != NULL)
+        {
+            p_entry->state = APP_NVRAM_CACHE_STATE_EMPTY;
+            p_entry->stats.nb_write++;
+        }
+        return WICED_BT_SUCCESS;
+    }
+
+    /* Same content as the NVRAM (or as the pending write) */
+    if (((p_entry->state == APP_NVRAM_CACHE_STATE_VALID) ||
+         (p_entry->state == APP_NVRAM_CACHE_STATE_DIRTY)) &&
+        (p_entry->length == length) &&
+        (memcmp(&p_entry->data, p_data, length) == 0))
+    {
+        p_entry->stats.nb_write_skipped++;
+        return WICED_BT_SUCCESS;
+    }
+
+    if (p_entry->state == APP_NVRAM_CACHE_STATE_DIRTY)
+    {
+        p_entry->stats.nb_write_coalesced++;
+    }
+
+    memcpy(&p_entry->data, p_data, length);
+    p_entry->length = length;
+    p_entry->state = APP_NVRAM_CACHE_STATE_DIRTY;
+
+    if (wiced_is_timer_in_use(&app_nvram_cb.flush_timer) == WICED_FALSE)
+    {
+        wiced_start_timer(&app_nvram_cb.flush_timer, APP_NVRAM_CACHE_FLUSH_DELAY);
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_nvram_cache_read
+ * Read an NVRAM ID through the cache. The NVRAM is read only the first time (or after a failed
+ * read or write); the following reads are served from the cache (including pending writes).
+ */
+static uint16_t app_nvram_cache_read(uint16_t nvram_id, uint8_t *p_data, uint16_t length,
+        wiced_result_t *p_status)
+{
+    app_nvram_cache_entry_t *p_entry = app_nvram_cache_entry_get(nvram_id);
+    uint16_t nb_bytes;
+
+    if ((p_entry == NULL) ||
+        (length > sizeof(p_entry->data)))
+    {
+        return wiced_hal_read_nvram(nvram_id, length, p_data, p_status);
+    }
+
+    if (p_entry->state == APP_NVRAM_CACHE_STATE_EMPTY)
+    {
+        p_entry->stats.nb_read_miss++;
+
+        /* Populate the cache with the whole NVRAM ID (the following reads may be longer) */
+        nb_bytes = wiced_hal_read_nvram(nvram_id, sizeof(p_entry->data),
+                (uint8_t *) &p_entry->data, p_status);
+        if (nb_bytes == 0)
+        {
+            /* NVRAM ID not present: do not read it again until it is written */
+            p_entry->state = APP_NVRAM_CACHE_STATE_ABSENT;
+            *p_status = WICED_BT_ERROR;
+            return 0;
+        }
+        if (*p_status != WICED_BT_SUCCESS)
+        {
+            /* Read failure: the entry stays EMPTY and will be read again */
+            APP_TRACE_ERR("wiced_hal_read_nvram (0x%x) failed %d\n", nvram_id, *p_status);
+            return 0;
+        }
+        p_entry->length = nb_bytes;
+        p_entry->state = APP_NVRAM_CACHE_STATE_VALID;
+    }
+    else
+    {
+        p_entry->stats.nb_read_hit++;
+    }
+
+    if (p_entry->state == APP_NVRAM_CACHE_STATE_ABSENT)
+    {
+        *p_status = WICED_BT_ERROR;
+        return 0;
+    }
+
+    if (length > p_entry->length)
+    {
+        length = p_entry->length;
+    }
+    memcpy(p_data, &p_entry->data, length);
+    *p_status = WICED_BT_SUCCESS;
+    return length;
+}
+
+/*
+ * app_nvram_cache_delete
+ */
+static void app_nvram_cache_delete(uint16_t nvram_id, wiced_result_t *p_status)
+{
+    app_nvram_cache_entry_t *p_entry = app_nvram_cache_entry_get(nvram_id);
+
+    wiced_hal_delete_nvram(nvram_id, p_status);
+
+    /* Drop the pending write (if any) */
+    if (p_entry != NULL)
+    {
+        if (*p_status == WICED_BT_SUCCESS)
+        {
+            p_entry->state = APP_NVRAM_CACHE_STATE_ABSENT;
+        }
+        else
+        {
+            p_entry->state = APP_NVRAM_CACHE_STATE_EMPTY;
+        }
+    }
+}
+
+/*
+ * app_nvram_cache_entry_flush
+ */
+static wiced_result_t app_nvram_cache_entry_flush(uint16_t nvram_id,
+        app_nvram_cache_entry_t *p_entry)
+{
+    uint16_t nb_bytes;
+    wiced_result_t status;
+
+    if (p_entry->state != APP_NVRAM_CACHE_STATE_DIRTY)
+    {
+        return WICED_BT_SUCCESS;
+    }
+
+    nb_bytes = wiced_hal_write_nvram(nvram_id, p_entry->length, (uint8_t *) &p_entry->data,
+            &status);
+    p_entry->stats.nb_write++;
+
+    if ((nb_bytes != p_entry->length) ||
+        (status != WICED_BT_SUCCESS))
+    {
+        APP_TRACE_ERR("wiced_hal_write_nvram (0x%x) failed %d nb_bytes: %d\n", nvram_id,
+                status, nb_bytes);
+        /* Content of the NVRAM unknown */
+        p_entry->state = APP_NVRAM_CACHE_STATE_EMPTY;
+        return WICED_BT_ERROR;
+    }
+
+    p_entry->state = APP_NVRAM_CACHE_STATE_VALID;
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_nvram_cache_flush
+ */
+wiced_result_t app_nvram_cache_flush(void)
+{
+    wiced_result_t status = WICED_BT_SUCCESS;
+    uint8_t i;
+
+    if (app_nvram_cb.initialized == WICED_FALSE)
+    {
+        return WICED_BT_SUCCESS;
+    }
+
+    wiced_stop_timer(&app_nvram_cb.flush_timer);
+
+    for (i = 0; i < APP_NVRAM_CACHE_NB_ID; i++)
+    {
+        if (app_nvram_cache_entry_flush(app_nvram_cache_ids[i],
+                &app_nvram_cb.entries[i]) != WICED_BT_SUCCESS)
+        {
+            status = WICED_BT_ERROR;
+        }
+    }
+
+    return status;
+}
+
+/*
+ * app_nvram_cache_flush_timer_callback
+ */
+static void app_nvram_cache_flush_timer_callback(uint32_t param)
+{
+    app_nvram_cache_flush();
+}
+
+/*
+ * app_nvram_stats_get
+ */
+uint8_t app_nvram_stats_get(app_nvram_stats_t *p_stats, uint8_t max_nb)
+{
+    uint8_t i;
+
+    if (app_nvram_cb.initialized == WICED_FALSE)
+    {
+        return 0;
+    }
+
+    for (i = 0; (i < APP_NVRAM_CACHE_NB_ID) && (i < max_nb); i++)
+    {
+        memcpy(&p_stats[i], &app_nvram_cb.entries[i].stats, sizeof(app_nvram_stats_t));
+    }
+
+    return i;
+}
+
 /*
  * app_nvram_pairing_info_read
  */
@@ -67,7 +400,7 @@ wiced_result_t app_nvram_pairing_info_read(wiced_bt_device_sec_keys_t *p_data)
     if (p_data == NULL)
         return WICED_BT_BADARG;
 
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_PAIRING_INFO_LRAC,
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_PAIRING_INFO_LRAC,
                                     sizeof(wiced_bt_device_sec_keys_t),
                                     (uint8_t *) p_data,
                                     &status);
@@ -86,20 +419,15 @@ wiced_result_t app_nvram_pairing_info_read(wiced_bt_device_sec_keys_t *p_data)
  */
 void app_nvram_pairing_info_write(wiced_bt_device_sec_keys_t *p_data)
 {
-    uint16_t nb_bytes;
     wiced_result_t status;
 
-    nb_bytes = wiced_hal_write_nvram(NVRAM_ID_PAIRING_INFO_LRAC,
-                                     sizeof(wiced_bt_device_sec_keys_t),
-                                     (uint8_t *) p_data,
-                                     &status);
+    status = app_nvram_cache_write(NVRAM_ID_PAIRING_INFO_LRAC,
+                                   (uint8_t *) p_data,
+                                   sizeof(wiced_bt_device_sec_keys_t));
 
-    if ((nb_bytes != sizeof(wiced_bt_device_sec_keys_t)) ||
-        (status != WICED_BT_SUCCESS))
+    if (status != WICED_BT_SUCCESS)
     {
-        APP_TRACE_ERR("wiced_hal_write_nvram failed %d nb_bytes: %d\n",
-                      status,
-                      nb_bytes);
+        APP_TRACE_ERR("app_nvram_cache_write failed %d\n", status);
     }
 }
 
@@ -110,7 +438,7 @@ void app_nvram_pairing_info_delete(void)
 {
     wiced_result_t status;
 
-    wiced_hal_delete_nvram(NVRAM_ID_PAIRING_INFO_LRAC, &status);
+    app_nvram_cache_delete(NVRAM_ID_PAIRING_INFO_LRAC, &status);
 
     if (status != WICED_BT_SUCCESS)
     {
@@ -130,7 +458,7 @@ wiced_result_t app_nvram_lrac_info_read(app_nvram_lrac_info_t *p_data)
         return WICED_BT_BADARG;
 
     /* Read the NVRAM ID */
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_LRAC_INFO, sizeof(app_nvram_lrac_info_t),
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_LRAC_INFO, sizeof(app_nvram_lrac_info_t),
             (uint8_t *)p_data, &status);
 
     if ((nb_bytes != sizeof(app_nvram_lrac_info_t)) ||
@@ -147,15 +475,13 @@ wiced_result_t app_nvram_lrac_info_read(app_nvram_lrac_info_t *p_data)
  */
 wiced_result_t app_nvram_lrac_info_write(app_nvram_lrac_info_t *p_data)
 {
-    uint16_t nb_bytes;
     wiced_result_t status;
 
-    nb_bytes = wiced_hal_write_nvram(NVRAM_ID_LRAC_INFO, sizeof(app_nvram_lrac_info_t),
-            (uint8_t *)p_data, &status);
-    if ((nb_bytes != sizeof(app_nvram_lrac_info_t)) ||
-        (status != WICED_BT_SUCCESS))
+    status = app_nvram_cache_write(NVRAM_ID_LRAC_INFO, (uint8_t *)p_data,
+            sizeof(app_nvram_lrac_info_t));
+    if (status != WICED_BT_SUCCESS)
     {
-        APP_TRACE_ERR("wiced_hal_write_nvram failed %d\n", status);
+        APP_TRACE_ERR("app_nvram_cache_write failed %d\n", status);
         return WICED_BT_ERROR;
     }
 
@@ -169,7 +495,6 @@ wiced_result_t app_nvram_lrac_info_write(app_nvram_lrac_info_t *p_data)
 wiced_result_t app_nvram_lrac_bdaddr_set(wiced_bt_device_address_t bdaddr)
 {
     wiced_bt_device_address_t addr_in_nvram;
-    uint16_t nb_bytes;
     wiced_result_t status;
 
     /* Check if the NVRAM shall be updated. */
@@ -184,15 +509,11 @@ wiced_result_t app_nvram_lrac_bdaddr_set(wiced_bt_device_address_t bdaddr)
     }
 
     /* Write The Peer's LRAC device address */
-   nb_bytes = wiced_hal_write_nvram(NVRAM_ID_PEER_LRAC_BDADDR,
-                                    BD_ADDR_LEN,
-                                    bdaddr,
-                                    &status);
+   status = app_nvram_cache_write(NVRAM_ID_PEER_LRAC_BDADDR, bdaddr, BD_ADDR_LEN);
 
-   if ((nb_bytes != BD_ADDR_LEN) ||
-       (status != WICED_BT_SUCCESS))
+   if (status != WICED_BT_SUCCESS)
    {
-       APP_TRACE_ERR("wiced_hal_write_nvram (Peer LRAC BdAddr) failed (%d, %d)\n", nb_bytes, status);
+       APP_TRACE_ERR("app_nvram_cache_write (Peer LRAC BdAddr) failed (%d)\n", status);
        return WICED_BT_ERROR;
    }
 
@@ -209,7 +530,7 @@ wiced_result_t app_nvram_lrac_bdaddr_get(uint8_t *p_bdaddr)
     uint16_t nvram_id;
 
     /* Read this NVRAM ID */
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_PEER_LRAC_BDADDR, BD_ADDR_LEN, p_bdaddr, &status);
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_PEER_LRAC_BDADDR, BD_ADDR_LEN, p_bdaddr, &status);
 
     if ((nb_bytes == BD_ADDR_LEN) &&
         (status == WICED_BT_SUCCESS))
@@ -249,7 +570,7 @@ void app_nvram_local_bdaddr_read(uint8_t *p_bdaddr)
     uint16_t nb_bytes;
     wiced_result_t result;
 
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_LOCAL_BDADDR,
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_LOCAL_BDADDR,
                 sizeof(wiced_bt_device_address_t), p_bdaddr, &result);
 
     if ((nb_bytes != sizeof(wiced_bt_device_address_t)) ||
@@ -259,10 +580,8 @@ void app_nvram_local_bdaddr_read(uint8_t *p_bdaddr)
         app_nvram_create_random_bdaddr(p_bdaddr);
 
         /* Write it in NVRAM */
-         wiced_hal_write_nvram(NVRAM_ID_LOCAL_BDADDR,
-                               sizeof(wiced_bt_device_address_t),
-                               p_bdaddr,
-                               &result);
+        app_nvram_cache_write(NVRAM_ID_LOCAL_BDADDR, p_bdaddr,
+                              sizeof(wiced_bt_device_address_t));
     }
 }
 
@@ -274,9 +593,14 @@ wiced_result_t app_nvram_write(uint16_t nvram_id, uint8_t *p_data, uint16_t leng
 {
     wiced_result_t result;
 
-    wiced_hal_write_nvram(nvram_id, length, p_data, &result);
+    result = app_nvram_cache_write(nvram_id, p_data, length);
+    if (result != WICED_BT_SUCCESS)
+    {
+        return result;
+    }
 
-    return result;
+    /* Manufacturing configuration is written immediately */
+    return app_nvram_cache_flush();
 }
 
 /*
@@ -289,7 +613,7 @@ wiced_result_t app_nvram_sleep_get(app_nvram_sleep_t *p_sleep)
     uint16_t nvram_id;
 
     /* Read this NVRAM ID */
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_SLEEP, sizeof(app_nvram_sleep_t), (uint8_t *)p_sleep,
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_SLEEP, sizeof(app_nvram_sleep_t), (uint8_t *)p_sleep,
             &status);
     if ((nb_bytes != sizeof(app_nvram_sleep_t)) ||
         (status != WICED_BT_SUCCESS))
@@ -307,15 +631,13 @@ wiced_result_t app_nvram_sleep_get(app_nvram_sleep_t *p_sleep)
  */
 void app_nvram_local_irk_update(uint8_t *p_key)
 {
-    uint16_t nb_bytes;
     wiced_result_t result;
 
-    nb_bytes = wiced_hal_write_nvram(NVRAM_ID_LOCAL_IRK,
-                                     BTM_SECURITY_LOCAL_KEY_DATA_LEN,
-                                     p_key,
-                                     &result);
+    result = app_nvram_cache_write(NVRAM_ID_LOCAL_IRK,
+                                   p_key,
+                                   BTM_SECURITY_LOCAL_KEY_DATA_LEN);
 
-    WICED_BT_TRACE("irk_update (result: %d, nb_bytes: %d)\n", result, nb_bytes);
+    WICED_BT_TRACE("irk_update (result: %d)\n", result);
 }
 
 /*
@@ -328,7 +650,7 @@ wiced_bool_t app_nvram_local_irk_get(uint8_t *p_key)
     uint16_t nb_bytes;
     wiced_result_t result;
 
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_LOCAL_IRK,
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_LOCAL_IRK,
                                     BTM_SECURITY_LOCAL_KEY_DATA_LEN,
                                     p_key,
                                     &result);
@@ -341,20 +663,17 @@ wiced_bool_t app_nvram_local_irk_get(uint8_t *p_key)
     return WICED_FALSE;
 }
 
-#ifdef VOICE_PROMPT
 /*
- * app_nvram_voice_prompt_config_get
+ * app_nvram_ofu_checkpoint_get
  */
-wiced_result_t app_nvram_voice_prompt_config_get(wiced_bt_voice_prompt_config_t *p_vpfs)
+wiced_result_t app_nvram_ofu_checkpoint_get(app_nvram_ofu_checkpoint_t *p_checkpoint)
 {
     uint16_t nb_bytes;
     wiced_result_t status;
 
-    /* Read this NVRAM ID */
-    nb_bytes = wiced_hal_read_nvram(NVRAM_ID_VOICE_PROMPT_FS,
-            sizeof(wiced_bt_voice_prompt_config_t), (uint8_t *)p_vpfs,
-            &status);
-    if ((nb_bytes != sizeof(wiced_bt_voice_prompt_config_t)) ||
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_OFU_CHECKPOINT, sizeof(app_nvram_ofu_checkpoint_t),
+            (uint8_t *)p_checkpoint, &status);
+    if ((nb_bytes != sizeof(app_nvram_ofu_checkpoint_t)) ||
         (status != WICED_BT_SUCCESS))
     {
         return WICED_BT_ERROR;
@@ -364,15 +683,43 @@ wiced_result_t app_nvram_voice_prompt_config_get(wiced_bt_voice_prompt_config_t
 }
 
 /*
- * app_nvram_voice_prompt_config_set
+ * app_nvram_ofu_checkpoint_set
+ * The checkpoint is written in NVRAM by the cache (i.e. updates are coalesced)
  */
-wiced_result_t app_nvram_voice_prompt_config_set(wiced_bt_voice_prompt_config_t *p_vpfs)
+wiced_result_t app_nvram_ofu_checkpoint_set(app_nvram_ofu_checkpoint_t *p_checkpoint)
+{
+    return app_nvram_cache_write(NVRAM_ID_OFU_CHECKPOINT, (uint8_t *)p_checkpoint,
+            sizeof(app_nvram_ofu_checkpoint_t));
+}
+
+/*
+ * app_nvram_ofu_checkpoint_delete
+ */
+void app_nvram_ofu_checkpoint_delete(void)
+{
+    app_nvram_ofu_checkpoint_t checkpoint;
+    wiced_result_t status;
+
+    /* Nothing to delete */
+    if (app_nvram_ofu_checkpoint_get(&checkpoint) != WICED_BT_SUCCESS)
+    {
+        return;
+    }
+
+    app_nvram_cache_delete(NVRAM_ID_OFU_CHECKPOINT, &status);
+}
+
+#ifdef VOICE_PROMPT
+/*
+ * app_nvram_voice_prompt_config_get
+ */
+wiced_result_t app_nvram_voice_prompt_config_get(wiced_bt_voice_prompt_config_t *p_vpfs)
 {
     uint16_t nb_bytes;
     wiced_result_t status;
 
-    /* Write this NVRAM ID */
-    nb_bytes = wiced_hal_write_nvram(NVRAM_ID_VOICE_PROMPT_FS,
+    /* Read this NVRAM ID */
+    nb_bytes = app_nvram_cache_read(NVRAM_ID_VOICE_PROMPT_FS,
             sizeof(wiced_bt_voice_prompt_config_t), (uint8_t *)p_vpfs,
             &status);
     if ((nb_bytes != sizeof(wiced_bt_voice_prompt_config_t)) ||
@@ -383,4 +730,14 @@ wiced_result_t app_nvram_voice_prompt_config_set(wiced_bt_voice_prompt_config_t
 
     return WICED_BT_SUCCESS;
 }
+
+/*
+ * app_nvram_voice_prompt_config_set
+ */
+wiced_result_t app_nvram_voice_prompt_config_set(wiced_bt_voice_prompt_config_t *p_vpfs)
+{
+    /* Write this NVRAM ID */
+    return app_nvram_cache_write(NVRAM_ID_VOICE_PROMPT_FS, (uint8_t *)p_vpfs,
+            sizeof(wiced_bt_voice_prompt_config_t));
+}
 #endif /* VOICE_PROMPT */
@@ -60,6 +60,7 @@ enum
     NVRAM_ID_PAIRING_INFO_LRAC,         /* Peer LRAC Device Pairing Info. */
     NVRAM_ID_LOCAL_IRK,
     NVRAM_ID_GFPS_ACCOUNT_KEY,
+    NVRAM_ID_OFU_CHECKPOINT,            /* OFU Download progress (for Resume) */
 };
 
 enum
@@ -70,6 +71,9 @@ enum
 };
 typedef uint8_t app_nvram_sleep_mode_t;
 
+/* Number of NVRAM IDs handled by the NVRAM Cache */
+#define APP_NVRAM_CACHE_NB_ID               8
+
 /*
  * Structures
  */
@@ -84,11 +88,46 @@ typedef struct
     app_nvram_sleep_mode_t sleep_mode;
 } app_nvram_sleep_t;
 
+/* OFU Download progress (last committed block) */
+typedef struct
+{
+    uint32_t download_len;              /* Image length received in the Download command */
+    uint32_t total_len;                 /* Image length */
+    uint32_t offset;                    /* Data committed in Flash */
+    uint32_t crc32;                     /* Running CRC32 of the committed data */
+    uint32_t image_crc32;               /* CRC32 of the whole Image (Image Info), 0 if unknown */
+} app_nvram_ofu_checkpoint_t;
+
+/* Access statistics of a cached NVRAM ID */
+#pragma pack(1)
+typedef struct
+{
+    uint16_t nvram_id;
+    uint16_t nb_write;                  /* Number of NVRAM (Flash) writes */
+    uint16_t nb_write_skipped;          /* Writes skipped (content unchanged) */
+    uint16_t nb_write_coalesced;        /* Writes merged with a pending write */
+    uint16_t nb_read_hit;               /* Reads served from the cache */
+    uint16_t nb_read_miss;              /* Reads from NVRAM (Flash) */
+} app_nvram_stats_t;
+#pragma pack()
+
 /*
  * app_nvram_init
  */
 wiced_result_t app_nvram_init(void);
 
+/*
+ * app_nvram_cache_flush
+ * Write all the pending (cached) NVRAM IDs. Must be called before any reset.
+ */
+wiced_result_t app_nvram_cache_flush(void);
+
+/*
+ * app_nvram_stats_get
+ * Get the access statistics of the cached NVRAM IDs. Returns the number of entries copied.
+ */
+uint8_t app_nvram_stats_get(app_nvram_stats_t *p_stats, uint8_t max_nb);
+
 /*
  * app_nvram_local_bdaddr_read
  * This function returns the Local BdAddr stored in NVRAM.
@@ -155,6 +194,21 @@ void app_nvram_local_irk_update(uint8_t *p_key);
  */
 wiced_bool_t app_nvram_local_irk_get(uint8_t *p_key);
 
+/*
+ * app_nvram_ofu_checkpoint_get
+ */
+wiced_result_t app_nvram_ofu_checkpoint_get(app_nvram_ofu_checkpoint_t *p_checkpoint);
+
+/*
+ * app_nvram_ofu_checkpoint_set
+ */
+wiced_result_t app_nvram_ofu_checkpoint_set(app_nvram_ofu_checkpoint_t *p_checkpoint);
+
+/*
+ * app_nvram_ofu_checkpoint_delete
+ */
+void app_nvram_ofu_checkpoint_delete(void);
+
 #ifdef VOICE_PROMPT
 /*
  * app_nvram_voice_prompt_config_get
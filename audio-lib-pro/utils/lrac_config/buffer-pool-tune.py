@@ -0,0 +1,277 @@
+#!/usr/bin/python -tt
+#
+# Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+# an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+#
+# This software, including source code, documentation and related
+# materials ("Software") is owned by Cypress Semiconductor Corporation
+# or one of its affiliates ("Cypress") and is protected by and subject to
+# worldwide patent protection (United States and foreign),
+# United States copyright laws and international treaty provisions.
+# Therefore, you may use this Software only as provided in the license
+# agreement accompanying the software package from which you
+# obtained this Software ("EULA").
+# If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+# non-transferable license to copy, modify, and compile the Software
+# source code solely for use in connection with Cypress's
+# integrated circuit products.  Any reproduction, modification, translation,
+# compilation, or representation of this Software except as specified
+# above is prohibited without the express written permission of Cypress.
+#
+# Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+# reserves the right to make changes to the Software without notice. Cypress
+# does not assume any liability arising out of the application or use of the
+# Software or any product or circuit described in the Software. Cypress does
+# not authorize its products for use in any products where a malfunction or
+# failure of the Cypress product may reasonably be expected to result in
+# significant property damage, injury or death ("High Risk Product"). By
+# including Cypress's product in a High Risk Product, the manufacturer
+# of such system or application assumes all risk of such use and in doing
+# so agrees to indemnify Cypress against all liability.
+#
+# Buffer Pool configuration generator
+# This program recommends the Buffer Pool table of wiced_app_cfg.c (wiced_app_cfg_buf_pools)
+# from the memory usage recorded by the device during representative sessions (e.g. AAC
+# streaming, HFP call, OFU, PS Switch stress). For every session, the memory usage (peak usage,
+# exhaustions and allocation failures of every pool) is saved by lrac_config (-mem_save option).
+# The recommended buffer count of each pool is its peak usage (over all the sessions) plus a
+# safety margin.
+# A pool which was exhausted is under-sized: its peak usage is only a lower bound (the next
+# allocations used a larger pool, which inflated its peak usage, or failed). Such a pool is
+# enlarged and the sessions must be run again with the new table.
+# Only the pools of wiced_app_cfg_buf_pools are tuned (the pools created at runtime, e.g. by the
+# transport, are ignored). With -c, the table of wiced_app_cfg.c is printed back with the new
+# counts: the count of every entry is changed by the recommended delta and the conditional
+# entries (#ifdef) and the symbolic terms (e.g. OFU_BLE_STREAM_BUF_COUNT) are kept.
+
+# To record the sessions (the device must not be reset between a session and its save)
+#$./lrac_config.exe -d COM18 -b 3000000 -mem_save aac.bin
+#$./lrac_config.exe -d COM18 -b 3000000 -mem_save hfp.bin
+# To generate the table (25% margin, at least 1 spare buffer per pool)
+#$./buffer-pool-tune.py -m 25 -s 1 aac.bin hfp.bin
+# To update the table of wiced_app_cfg.c
+#$./buffer-pool-tune.py -c ../../../wiced_app_cfg.c aac.bin hfp.bin
+
+import math
+import re
+import struct
+import sys
+
+DEFAULT_MARGIN=25
+DEFAULT_SPARE=1
+
+# Memory Trend event (see app_memory_trend_send in app_memory.c)
+HEADER_FORMAT='<BIBBB'
+HEADER_SIZE=struct.calcsize(HEADER_FORMAT)
+POOL_FORMAT='<HHHHHH'
+POOL_SIZE=struct.calcsize(POOL_FORMAT)
+
+# Read a binary file
+def file_read(name):
+    with open(name, 'rb') as f:
+        return bytearray(f.read())
+
+# Decode a session saved by lrac_config. Returns the Min Free Bytes, the number of samples and
+# the configured pools (size, count, peak, alerts, exhausted, alloc_failed)
+def session_decode(data):
+    if len(data)<HEADER_SIZE:
+        raise ValueError('File too short (%d bytes)' % len(data))
+    period, min_free_bytes, nb_pools, nb_samples, nb_cfg_pools=struct.unpack_from(HEADER_FORMAT,
+            data, 0)
+    if len(data)!=HEADER_SIZE+nb_pools*POOL_SIZE+nb_samples*(4+nb_pools):
+        raise ValueError('Wrong file length (%d bytes)' % len(data))
+    if nb_cfg_pools>nb_pools:
+        raise ValueError('Wrong number of configured pools (%d/%d)' % (nb_cfg_pools, nb_pools))
+    pools=[]
+    for i in range(nb_cfg_pools):
+        pools.append(struct.unpack_from(POOL_FORMAT, data, HEADER_SIZE+i*POOL_SIZE))
+    return min_free_bytes, nb_samples, pools
+
+# Merge the sessions. Returns the Min Free Bytes and, for each pool, its size, count, peak usage,
+# number of exhaustions and allocation failures
+def sessions_merge(names):
+    merged=None
+    min_free_bytes=None
+    for name in names:
+        free_bytes, nb_samples, pools=session_decode(file_read(name))
+        if nb_samples==0:
+            # The exhaustions are counted when the device samples its pools
+            print('Warning: %s has no sample (saved too early?), its exhaustions may be missing'
+                  % name)
+        layout=[(size, count) for (size, count, peak, alerts, exhausted, failed) in pools]
+        if merged is None:
+            merged=[[size, count, 0, 0, 0] for (size, count) in layout]
+            min_free_bytes=free_bytes
+        elif layout!=[(pool[0], pool[1]) for pool in merged]:
+            raise ValueError('%s was recorded with another Buffer Pool table' % name)
+        min_free_bytes=min(min_free_bytes, free_bytes)
+        for pool, (size, count, peak, alerts, exhausted, failed) in zip(merged, pools):
+            pool[2]=max(pool[2], peak)
+            pool[3]+=exhausted
+            pool[4]+=failed
+    return min_free_bytes, merged
+
+# Recommend a buffer count for a pool. Returns the count and whether the pool was exhausted
+def pool_recommend(count, peak, exhausted, failed, margin, spare):
+    if count==0:
+        return 0, False
+    recommended=max(peak+spare, int(math.ceil(peak*(100+margin)/100.0)), 1)
+    saturated=(peak>=count) or (exhausted>0) or (failed>0)
+    if saturated:
+        # The peak usage is a lower bound: enlarge the pool
+        recommended=max(recommended, count+max(spare, int(math.ceil(count*margin/100.0)), failed))
+    return recommended, saturated
+
+# Print the analysis. Returns the recommendations (size, recommended, peak, saturated)
+def analysis_print(min_free_bytes, pools, margin, spare):
+    print('%4s %6s %6s %6s %9s %8s %11s %12s' % ('Pool', 'Size', 'Count', 'Peak', 'Exhausted',
+          'Failures', 'Recommended', 'Delta(bytes)'))
+    recommendations=[]
+    delta_total=0
+    any_saturated=False
+    for i, (size, count, peak, exhausted, failed) in enumerate(pools):
+        recommended, saturated=pool_recommend(count, peak, exhausted, failed, margin, spare)
+        delta=(recommended-count)*size
+        delta_total+=delta
+        any_saturated=any_saturated or saturated
+        recommendations.append((size, recommended, peak, saturated))
+        print('%4d %6d %6d %6d %9d %8d %10d%s %12d' % (i, size, count, peak, exhausted, failed,
+              recommended, '*' if saturated else ' ', delta))
+    print('Min Free Bytes: %d' % min_free_bytes)
+    if delta_total<=0:
+        print('RAM saved: %d bytes (buffer payloads only)' % -delta_total)
+    else:
+        print('RAM needed: %d bytes (buffer payloads only)' % delta_total)
+    if any_saturated:
+        print('* Pool exhausted during a session: its peak usage is a lower bound and the next')
+        print('  pool peak may include buffers which overflowed. Run the sessions again with')
+        print('  the recommended table.')
+    return recommendations
+
+# Print the recommended table
+def table_print(recommendations):
+    print('const wiced_bt_cfg_buf_pool_t wiced_app_cfg_buf_pools[] =')
+    print('{')
+    print('/*  { buf_size, buf_count } */')
+    for size, recommended, peak, saturated in recommendations:
+        entry='    { %d,' % size
+        entry=entry.ljust(16)+'%d' % recommended
+        entry=entry.ljust(20)+'},'
+        print('%s/* Peak usage: %d%s */' % (entry.ljust(28), peak,
+              ' (exhausted)' if saturated else ''))
+    print('};')
+
+# Print the table of wiced_app_cfg.c with the recommended counts. The entries of the alternative
+# branches of a #if share the same pool index. The (first) number of the count of an entry is
+# changed by the difference between the recommended and the recorded counts.
+def cfg_table_print(name, pools, recommendations):
+    with open(name, 'r') as f:
+        lines=f.read().splitlines()
+    start=None
+    for i, line in enumerate(lines):
+        if re.search(r'wiced_app_cfg_buf_pools\[\]\s*=', line):
+            start=i
+            break
+    if start is None:
+        raise ValueError('wiced_app_cfg_buf_pools not found in %s' % name)
+    end=start
+    while end<len(lines) and not lines[end].startswith('};'):
+        end=end+1
+    if end==len(lines):
+        raise ValueError('End of wiced_app_cfg_buf_pools not found in %s' % name)
+
+    entry_re=re.compile(r'^(\s*\{\s*)(\d+)(\s*,\s*)(\d+)(.*)$')
+    index=0
+    branches=[]                 # (index at the #if, highest index at the end of a branch)
+    output=[]
+    for line in lines[start:end+1]:
+        directive=line.strip()
+        if directive.startswith('#if'):
+            branches.append([index, index])
+        elif directive.startswith('#el') and branches:
+            branches[-1][1]=max(branches[-1][1], index)
+            index=branches[-1][0]
+        elif directive.startswith('#endif') and branches:
+            index=max(branches.pop()[1], index)
+        match=entry_re.match(line)
+        if match:
+            size=int(match.group(2))
+            if index>=len(pools) or pools[index][0]!=size:
+                raise ValueError('%s does not match the recorded Buffer Pools (entry %d, size %d)'
+                                 % (name, index, size))
+            count=max(int(match.group(4))+recommendations[index][1]-pools[index][1], 0)
+            line='%s%d%s%d%s' % (match.group(1), size, match.group(3), count, match.group(5))
+            index=index+1
+        output.append(line)
+    if index!=len(pools):
+        raise ValueError('%s has %d pools instead of %d' % (name, index, len(pools)))
+    for line in output:
+        print(line)
+
+# Check the parameters (passed on the Command Line)
+def check_parameter(param):
+    try:
+        sys.argv.index(param)
+        return True
+    except:
+        return False
+
+# Get a parameter value (passed on the Command Line)
+def get_parameter(param):
+    if not check_parameter(param):
+        print('Missing parameter %s' % param)
+        sys.exit(1)
+    return sys.argv[sys.argv.index(param)+1]
+
+# Get the session files (the Command Line arguments which are not options)
+def get_files():
+    files=[]
+    args=sys.argv[1:]
+    while args:
+        if args[0] in ('-m', '-s', '-c'):
+            args=args[2:]
+        else:
+            files.append(args[0])
+            args=args[1:]
+    return files
+
+# Main function
+margin=DEFAULT_MARGIN
+spare=DEFAULT_SPARE
+try:
+    if check_parameter('-m'):
+        margin=int(get_parameter('-m'))
+    if check_parameter('-s'):
+        spare=int(get_parameter('-s'))
+except ValueError as e:
+    print('Wrong parameter: %s' % e)
+    sys.exit(1)
+if margin<0 or spare<0:
+    print('The margin and the spare buffers must be positive')
+    sys.exit(1)
+
+files=get_files()
+if not files:
+    print('Usage: %s [-m <margin in %%>] [-s <spare buffers>] [-c <wiced_app_cfg.c>] '
+          '<session file>...' % sys.argv[0])
+    sys.exit(1)
+
+try:
+    min_free_bytes, pools=sessions_merge(files)
+except (IOError, ValueError) as e:
+    print('Cannot decode the sessions: %s' % e)
+    sys.exit(1)
+
+print('%d session(s), margin:%d%% spare:%d' % (len(files), margin, spare))
+recommendations=analysis_print(min_free_bytes, pools, margin, spare)
+print('')
+if check_parameter('-c'):
+    try:
+        cfg_table_print(get_parameter('-c'), pools, recommendations)
+    except (IOError, ValueError) as e:
+        print('Cannot update the table: %s' % e)
+        sys.exit(1)
+else:
+    table_print(recommendations)
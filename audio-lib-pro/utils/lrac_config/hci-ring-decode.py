@@ -0,0 +1,207 @@
+#!/usr/bin/python -tt
+#
+# Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+# an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+#
+# This software, including source code, documentation and related
+# materials ("Software") is owned by Cypress Semiconductor Corporation
+# or one of its affiliates ("Cypress") and is protected by and subject to
+# worldwide patent protection (United States and foreign),
+# United States copyright laws and international treaty provisions.
+# Therefore, you may use this Software only as provided in the license
+# agreement accompanying the software package from which you
+# obtained this Software ("EULA").
+# If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+# non-transferable license to copy, modify, and compile the Software
+# source code solely for use in connection with Cypress's
+# integrated circuit products.  Any reproduction, modification, translation,
+# compilation, or representation of this Software except as specified
+# above is prohibited without the express written permission of Cypress.
+#
+# Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+# reserves the right to make changes to the Software without notice. Cypress
+# does not assume any liability arising out of the application or use of the
+# Software or any product or circuit described in the Software. Cypress does
+# not authorize its products for use in any products where a malfunction or
+# failure of the Cypress product may reasonably be expected to result in
+# significant property damage, injury or death ("High Risk Product"). By
+# including Cypress's product in a High Risk Product, the manufacturer
+# of such system or application assumes all risk of such use and in doing
+# so agrees to indemnify Cypress against all liability.
+#
+# HCI Ring Buffer decoder
+# This program decodes the HCI Ring Buffer of the device (last HCI Commands and Events exchanged
+# with the Controller). The ring is either read over WICED HCI by lrac_config (-hci_ring or
+# -hci_ring_prev options) or printed in the device traces after a crash (with the CoreDump).
+
+# To decode a ring saved by lrac_config
+#$./lrac_config.exe -d COM18 -b 3000000 -hci_ring_prev ring.bin
+#$./hci-ring-decode.py -i ring.bin
+# To decode the 'HCI Ring' lines of a trace log
+#$./hci-ring-decode.py -t trace.log
+
+import re
+import struct
+import sys
+
+# HCI Trace Types (wiced_bt_hci_trace_type_t)
+TYPE_EVENT=0
+TYPE_COMMAND=1
+
+# Ring entry (must match app_hci_ring_entry_t)
+ENTRY_FORMAT='<IHHBBBB'
+ENTRY_SIZE=struct.calcsize(ENTRY_FORMAT)
+
+NO_HANDLE=0xFFFF
+NO_STATUS=0xFF
+
+EVENTS={
+    0x03:'Connection Complete',
+    0x04:'Connection Request',
+    0x05:'Disconnection Complete',
+    0x06:'Authentication Complete',
+    0x07:'Remote Name Request Complete',
+    0x08:'Encryption Change',
+    0x0E:'Command Complete',
+    0x0F:'Command Status',
+    0x10:'Hardware Error',
+    0x12:'Role Change',
+    0x14:'Mode Change',
+    0x17:'Link Key Request',
+    0x18:'Link Key Notification',
+    0x1A:'Data Buffer Overflow',
+    0x2C:'Synchronous Connection Complete',
+    0x2D:'Synchronous Connection Changed',
+    0x30:'Encryption Key Refresh Complete',
+    0x31:'IO Capability Request',
+    0x32:'IO Capability Response',
+    0x33:'User Confirmation Request',
+    0x36:'Simple Pairing Complete',
+    0x38:'Link Supervision Timeout Changed',
+    0x3E:'LE Meta',
+    0xFF:'Vendor Specific',
+}
+
+COMMANDS={
+    0x0401:'Inquiry',
+    0x0405:'Create Connection',
+    0x0406:'Disconnect',
+    0x0409:'Accept Connection Request',
+    0x040A:'Reject Connection Request',
+    0x040B:'Link Key Request Reply',
+    0x040C:'Link Key Request Negative Reply',
+    0x0411:'Authentication Requested',
+    0x0413:'Set Connection Encryption',
+    0x0419:'Remote Name Request',
+    0x0428:'Setup Synchronous Connection',
+    0x0429:'Accept Synchronous Connection',
+    0x043D:'Enhanced Setup Synchronous Connection',
+    0x0803:'Sniff Mode',
+    0x0804:'Exit Sniff Mode',
+    0x080B:'Switch Role',
+    0x080D:'Write Link Policy Settings',
+    0x0C03:'Reset',
+    0x0C13:'Write Local Name',
+    0x0C1A:'Write Scan Enable',
+    0x0C37:'Write Link Supervision Timeout',
+    0x1405:'Read RSSI',
+    0x200A:'LE Set Advertising Enable',
+    0x200C:'LE Set Scan Enable',
+    0xFDCF:'LRAC',
+}
+
+# Read a binary file
+def file_read(name):
+    with open(name, 'rb') as f:
+        return bytearray(f.read())
+
+# Decode a ring saved by lrac_config (HCI Ring Read event: Ring Id, Status, Entry Size,
+# Nb Entries, Entries)
+def entries_from_binary(data):
+    if len(data)<4:
+        raise ValueError('File too short (%d bytes)' % len(data))
+    ring_id, status, entry_size, nb_entries=struct.unpack_from('<BBBB', data, 0)
+    if status!=0:
+        raise ValueError('Ring %d not available' % ring_id)
+    if entry_size!=ENTRY_SIZE:
+        raise ValueError('Unsupported entry size %d' % entry_size)
+    if len(data)<4+nb_entries*entry_size:
+        raise ValueError('File truncated (%d/%d entries)' % ((len(data)-4)//entry_size, nb_entries))
+    entries=[]
+    for i in range(nb_entries):
+        entries.append(struct.unpack_from(ENTRY_FORMAT, data, 4+i*entry_size))
+    return entries
+
+# Decode the 'HCI Ring <id>: <timestamp> <type> <event> <opcode> <handle> <status>' trace lines
+def entries_from_trace(name):
+    line_re=re.compile(r'HCI Ring \d+: ([0-9A-Fa-f]{8}) ([0-9A-Fa-f]{2}) ([0-9A-Fa-f]{2}) '
+                       r'([0-9A-Fa-f]{4}) ([0-9A-Fa-f]{4}) ([0-9A-Fa-f]{2})')
+    entries=[]
+    with open(name, 'r', errors='replace') as f:
+        for line in f:
+            m=line_re.search(line)
+            if m:
+                timestamp, type, event, opcode, handle, status=[int(v, 16) for v in m.groups()]
+                entries.append((timestamp, opcode, handle, type, event, status, 0))
+    return entries
+
+# Describe an entry
+def entry_describe(opcode, type, event):
+    if type==TYPE_COMMAND:
+        return 'CMD %s (0x%04X)' % (COMMANDS.get(opcode, '?'), opcode)
+    desc='EVT %s (0x%02X)' % (EVENTS.get(event, '?'), event)
+    if event in (0x0E, 0x0F):
+        desc+=' %s (0x%04X)' % (COMMANDS.get(opcode, '?'), opcode)
+    elif event in (0x3E, 0xFF):
+        desc+=' Sub:0x%02X' % opcode
+    return desc
+
+# Print the entries (oldest first). The timestamps are 32 bits us counters (wrapping)
+def entries_print(entries):
+    if not entries:
+        print('Empty HCI Ring')
+        return
+    last=entries[-1][0]
+    prev=entries[0][0]
+    print('%6s %12s %10s  %-6s %-4s %s' % ('Index', 'Age(ms)', 'Delta(ms)', 'Handle', 'Stat', 'Packet'))
+    for i, (timestamp, opcode, handle, type, event, status, reserved) in enumerate(entries):
+        to_last=((last-timestamp) & 0xFFFFFFFF)/1000.0
+        delta=((timestamp-prev) & 0xFFFFFFFF)/1000.0
+        prev=timestamp
+        print('%6d %12.3f %10.3f  %-6s %-4s %s' % (i, to_last, delta,
+              '-' if handle==NO_HANDLE else '0x%03X' % handle,
+              '-' if status==NO_STATUS else '0x%02X' % status,
+              entry_describe(opcode, type, event)))
+    print('%d entries (%.3f ms)' % (len(entries), ((last-entries[0][0]) & 0xFFFFFFFF)/1000.0))
+
+# Check the parameters (passed on the Command Line)
+def check_parameter(param):
+    try:
+        sys.argv.index(param)
+        return True
+    except:
+        return False
+
+# Get a parameter value (passed on the Command Line)
+def get_parameter(param):
+    if not check_parameter(param):
+        print('Missing parameter %s' % param)
+        sys.exit(1)
+    return sys.argv[sys.argv.index(param)+1]
+
+# Main function
+try:
+    if check_parameter('-i'):
+        entries=entries_from_binary(file_read(get_parameter('-i')))
+    elif check_parameter('-t'):
+        entries=entries_from_trace(get_parameter('-t'))
+    else:
+        print('Usage: %s -i <ring file> | -t <trace log>' % sys.argv[0])
+        sys.exit(1)
+except (IOError, ValueError) as e:
+    print('Cannot decode the HCI Ring: %s' % e)
+    sys.exit(1)
+
+entries_print(entries)
@@ -0,0 +1,232 @@
+#!/usr/bin/python -tt
+#
+# Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+# an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+#
+# This software, including source code, documentation and related
+# materials ("Software") is owned by Cypress Semiconductor Corporation
+# or one of its affiliates ("Cypress") and is protected by and subject to
+# worldwide patent protection (United States and foreign),
+# United States copyright laws and international treaty provisions.
+# Therefore, you may use this Software only as provided in the license
+# agreement accompanying the software package from which you
+# obtained this Software ("EULA").
+# If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+# non-transferable license to copy, modify, and compile the Software
+# source code solely for use in connection with Cypress's
+# integrated circuit products.  Any reproduction, modification, translation,
+# compilation, or representation of this Software except as specified
+# above is prohibited without the express written permission of Cypress.
+#
+# Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+# reserves the right to make changes to the Software without notice. Cypress
+# does not assume any liability arising out of the application or use of the
+# Software or any product or circuit described in the Software. Cypress does
+# not authorize its products for use in any products where a malfunction or
+# failure of the Cypress product may reasonably be expected to result in
+# significant property damage, injury or death ("High Risk Product"). By
+# including Cypress's product in a High Risk Product, the manufacturer
+# of such system or application assumes all risk of such use and in doing
+# so agrees to indemnify Cypress against all liability.
+#
+# OFU Compressed Image tool
+# This program packages a FW Image for the OFU Compressed Download command (the Image is
+# decompressed by the OFU Server while it is received) and benchmarks the compression.
+# The package is made of a 16 bytes header followed by the compressed stream:
+#   'OFUZ' (4 bytes), Version (4 bytes), Image length (4 bytes), Image CRC32 (4 bytes)
+# The OFU application sends the Image length in the Compressed Download command, the compressed
+# stream in the Data packets and the Image CRC32 in the Verify command.
+
+# To package an Image
+#$./ofu-compress.py -c -i fw.ota.bin -o fw.ota.ofuz
+# To benchmark the compression (optional: transfer throughput in kbps, default 100)
+#$./ofu-compress.py -b -i fw.ota.bin [-t 100]
+
+import struct
+import sys
+import time
+import zlib
+
+# Compressed stream format (must match ofu/app_ofu_lz.h)
+OFFSET_BITS=12
+LENGTH_BITS=4
+MATCH_MIN=3
+MATCH_MAX=MATCH_MIN+(1<<LENGTH_BITS)-1
+WINDOW_SIZE=1<<OFFSET_BITS
+
+# Package header
+HEADER_MAGIC=b'OFUZ'
+# Version 1: 1 KB Window (10 bits Offset), Version 2: 4 KB Window (12 bits Offset)
+HEADER_VERSION=2
+HEADER_LEN=16
+
+# Maximum number of Window positions compared for each Match
+CHAIN_MAX=64
+
+# Read a binary file
+def file_read(name):
+    with open(name, 'rb') as f:
+        return bytearray(f.read())
+
+# Write a binary file
+def file_write(name, data):
+    with open(name, 'wb') as f:
+        f.write(data)
+
+# CRC32 (as computed by the OFU Server)
+def crc32(data):
+    return zlib.crc32(bytes(data)) & 0xFFFFFFFF
+
+# Find the longest Match (in the Window) of the data at position i
+def match_find(image, i, chains):
+    best_len=0
+    best_offset=0
+    max_len=min(MATCH_MAX, len(image)-i)
+    if max_len<MATCH_MIN:
+        return 0, 0
+    positions=chains.get(bytes(image[i:i+MATCH_MIN]))
+    if positions is None:
+        return 0, 0
+    for position in reversed(positions[-CHAIN_MAX:]):
+        if i-position>WINDOW_SIZE:
+            break
+        length=MATCH_MIN
+        while length<max_len and image[position+length]==image[i+length]:
+            length=length+1
+        if length>best_len:
+            best_len=length
+            best_offset=i-position
+            if length==max_len:
+                break
+    return best_offset, best_len
+
+# Add the position i to the Match chains
+def chains_add(image, i, chains):
+    key=bytes(image[i:i+MATCH_MIN])
+    positions=chains.get(key)
+    if positions is None:
+        chains[key]=[i]
+    else:
+        positions.append(i)
+        if len(positions)>2*CHAIN_MAX:
+            del positions[:CHAIN_MAX]
+
+# Compress an Image (LZSS)
+def compress(image):
+    stream=bytearray()
+    chains={}
+    items=bytearray()
+    flags=0
+    nb_items=0
+    i=0
+    while i<len(image):
+        offset, length=match_find(image, i, chains)
+        if length>=MATCH_MIN:
+            token=((length-MATCH_MIN)<<OFFSET_BITS)|(offset-1)
+            items+=struct.pack('<H', token)
+        else:
+            length=1
+            flags|=1<<nb_items
+            items.append(image[i])
+        for j in range(i, i+length):
+            chains_add(image, j, chains)
+        i=i+length
+        nb_items=nb_items+1
+        if nb_items==8:
+            stream.append(flags)
+            stream+=items
+            items=bytearray()
+            flags=0
+            nb_items=0
+    if nb_items:
+        stream.append(flags)
+        stream+=items
+    return stream
+
+# Decompress a stream (as the OFU Server does)
+def decompress(stream):
+    image=bytearray()
+    i=0
+    nb_flags=0
+    while i<len(stream):
+        if nb_flags==0:
+            flags=stream[i]
+            nb_flags=8
+            i=i+1
+            continue
+        if flags&1:
+            image.append(stream[i])
+            i=i+1
+        else:
+            if i+2>len(stream):
+                raise ValueError('Truncated Match')
+            token=struct.unpack_from('<H', bytes(stream[i:i+2]))[0]
+            offset=(token&(WINDOW_SIZE-1))+1
+            length=(token>>OFFSET_BITS)+MATCH_MIN
+            if offset>len(image):
+                raise ValueError('Bad Match offset:%d position:%d' % (offset, len(image)))
+            for j in range(length):
+                image.append(image[-offset])
+            i=i+2
+        flags>>=1
+        nb_flags=nb_flags-1
+    return image
+
+# Build the package
+def package(image, stream):
+    return struct.pack('<4sIII', HEADER_MAGIC, HEADER_VERSION, len(image), crc32(image))+stream
+
+# Check the parameters (passed on the Command Line)
+def check_parameter(param):
+    try:
+        sys.argv.index(param)
+        return True
+    except:
+        return False
+
+# Get a parameter value (passed on the Command Line)
+def get_parameter(param, default=None):
+    if not check_parameter(param):
+        if default is not None:
+            return default
+        print('Missing parameter %s' % param)
+        sys.exit(1)
+    return sys.argv[sys.argv.index(param)+1]
+
+# Main function
+image=file_read(get_parameter('-i'))
+
+if check_parameter('-c'):
+    stream=compress(image)
+    # Always check the stream before writing it
+    if decompress(stream)!=image:
+        print('Compression failed')
+        sys.exit(1)
+    file_write(get_parameter('-o'), package(image, stream))
+    print('Image       len:%d CRC32:0x%08X' % (len(image), crc32(image)))
+    print('Compressed  len:%d (%d%% of the Image)' % (len(stream), len(stream)*100//max(len(image), 1)))
+    sys.exit(0)
+elif check_parameter('-b'):
+    throughput=int(get_parameter('-t', '100'))
+    start=time.time()
+    stream=compress(image)
+    compress_time=time.time()-start
+    start=time.time()
+    decompressed=decompress(stream)
+    decompress_time=time.time()-start
+    if decompressed!=image:
+        print('Compression failed')
+        sys.exit(1)
+    print('Image       len:%d CRC32:0x%08X' % (len(image), crc32(image)))
+    print('Compressed  len:%d (%d%% of the Image, %d%% saved)' % (len(stream),
+            len(stream)*100//max(len(image), 1), 100-len(stream)*100//max(len(image), 1)))
+    print('Window      %d bytes' % WINDOW_SIZE)
+    print('Host time   compress:%.2fs decompress:%.2fs' % (compress_time, decompress_time))
+    print('Transfer    %.1fs instead of %.1fs at %d kbps' % (len(stream)*8.0/(throughput*1000),
+            len(image)*8.0/(throughput*1000), throughput))
+    sys.exit(0)
+else:
+    print('Usage: %s -c -i <image> -o <package> | -b -i <image> [-t <kbps>]' % sys.argv[0])
+    sys.exit(1)
@@ -0,0 +1,213 @@
+#!/usr/bin/python -tt
+#
+# Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+# an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+#
+# This software, including source code, documentation and related
+# materials ("Software") is owned by Cypress Semiconductor Corporation
+# or one of its affiliates ("Cypress") and is protected by and subject to
+# worldwide patent protection (United States and foreign),
+# United States copyright laws and international treaty provisions.
+# Therefore, you may use this Software only as provided in the license
+# agreement accompanying the software package from which you
+# obtained this Software ("EULA").
+# If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+# non-transferable license to copy, modify, and compile the Software
+# source code solely for use in connection with Cypress's
+# integrated circuit products.  Any reproduction, modification, translation,
+# compilation, or representation of this Software except as specified
+# above is prohibited without the express written permission of Cypress.
+#
+# Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+# reserves the right to make changes to the Software without notice. Cypress
+# does not assume any liability arising out of the application or use of the
+# Software or any product or circuit described in the Software. Cypress does
+# not authorize its products for use in any products where a malfunction or
+# failure of the Cypress product may reasonably be expected to result in
+# significant property damage, injury or death ("High Risk Product"). By
+# including Cypress's product in a High Risk Product, the manufacturer
+# of such system or application assumes all risk of such use and in doing
+# so agrees to indemnify Cypress against all liability.
+#
+# OFU Delta (differential) Image tool
+# This program generates the Patch used by the OFU Delta Download command (the new FW Image is
+# reconstructed by the OFU Server from its Active Partition, the Base Image, and the Patch).
+# It also replays a Patch (as the OFU Server does) to verify it before it is used.
+
+# To generate a Patch (Base Image: old.ota.bin, new Image: new.ota.bin)
+#$./ofu-delta.py -g -o old.ota.bin -n new.ota.bin -p delta.bin
+# To verify a Patch
+#$./ofu-delta.py -v -o old.ota.bin -n new.ota.bin -p delta.bin
+
+import struct
+import sys
+import zlib
+
+# Patch operations (must match ofu/app_ofu_delta.h)
+OP_COPY=0x01
+OP_LITERAL=0x02
+COPY_MAX=4096
+LITERAL_MAX=4096
+
+# Minimum match length (a Copy operation is 7 bytes long)
+MATCH_MIN=16
+# Length of the key used to index the Base Image
+KEY_LEN=8
+# Maximum number of Base Image positions compared for each key
+CANDIDATES_MAX=16
+
+# Read a binary file
+def file_read(name):
+    with open(name, 'rb') as f:
+        return bytearray(f.read())
+
+# Write a binary file
+def file_write(name, data):
+    with open(name, 'wb') as f:
+        f.write(data)
+
+# CRC32 (as computed by the OFU Server)
+def crc32(data):
+    return zlib.crc32(bytes(data)) & 0xFFFFFFFF
+
+# Index the Base Image (positions of every KEY_LEN bytes sequence)
+def base_index(base):
+    index={}
+    for i in range(len(base)-KEY_LEN+1):
+        key=bytes(base[i:i+KEY_LEN])
+        positions=index.get(key)
+        if positions is None:
+            index[key]=[i]
+        elif len(positions)<CANDIDATES_MAX:
+            positions.append(i)
+    return index
+
+# Length of the match between the Base Image (at base_offset) and the new Image (at new_offset)
+def match_len(base, base_offset, new, new_offset):
+    length=0
+    max_len=min(len(base)-base_offset, len(new)-new_offset)
+    while length<max_len and base[base_offset+length]==new[new_offset+length]:
+        length=length+1
+    return length
+
+# Append Copy operation(s)
+def patch_copy(patch, offset, length):
+    while length:
+        chunk=min(length, COPY_MAX)
+        patch+=struct.pack('<BIH', OP_COPY, offset, chunk)
+        offset=offset+chunk
+        length=length-chunk
+
+# Append Literal operation(s)
+def patch_literal(patch, data):
+    while len(data):
+        chunk=data[:LITERAL_MAX]
+        patch+=struct.pack('<BH', OP_LITERAL, len(chunk))
+        patch+=chunk
+        data=data[LITERAL_MAX:]
+
+# Generate the Patch
+def patch_generate(base, new):
+    index=base_index(base)
+    patch=bytearray()
+    literal_start=0
+    next_base_offset=None
+    i=0
+    while i<len(new):
+        best_offset=None
+        best_len=0
+        # Try first to continue the previous Copy (most of the Image is usually unchanged)
+        candidates=index.get(bytes(new[i:i+KEY_LEN]), [])
+        if next_base_offset is not None and next_base_offset<len(base):
+            candidates=[next_base_offset]+candidates
+        for offset in candidates:
+            length=match_len(base, offset, new, i)
+            if length>best_len:
+                best_offset=offset
+                best_len=length
+        if best_len>=MATCH_MIN:
+            patch_literal(patch, new[literal_start:i])
+            patch_copy(patch, best_offset, best_len)
+            i=i+best_len
+            literal_start=i
+            next_base_offset=best_offset+best_len
+        else:
+            i=i+1
+    patch_literal(patch, new[literal_start:])
+    return patch
+
+# Replay the Patch (as the OFU Server does)
+def patch_apply(base, patch):
+    image=bytearray()
+    i=0
+    while i<len(patch):
+        op=patch[i]
+        if op==OP_COPY:
+            offset, length=struct.unpack_from('<IH', bytes(patch[i+1:i+7]))
+            if length>COPY_MAX or offset+length>len(base):
+                raise ValueError('Bad Copy offset:%d length:%d' % (offset, length))
+            image+=base[offset:offset+length]
+            i=i+7
+        elif op==OP_LITERAL:
+            length=struct.unpack_from('<H', bytes(patch[i+1:i+3]))[0]
+            if i+3+length>len(patch):
+                raise ValueError('Truncated Literal')
+            image+=patch[i+3:i+3+length]
+            i=i+3+length
+        else:
+            raise ValueError('Unknown op:%d at %d' % (op, i))
+    return image
+
+# Print the Delta Download Command parameters
+def print_parameters(base, new, patch):
+    print('Base Image  len:%d CRC32:0x%08X' % (len(base), crc32(base)))
+    print('New Image   len:%d CRC32:0x%08X (Verify Command)' % (len(new), crc32(new)))
+    print('Patch       len:%d (%d%% of the new Image)' % (len(patch), len(patch)*100//max(len(new), 1)))
+
+# Check the parameters (passed on the Command Line)
+def check_parameter(param):
+    try:
+        sys.argv.index(param)
+        return True
+    except:
+        return False
+
+# Get a parameter value (passed on the Command Line)
+def get_parameter(param):
+    if not check_parameter(param):
+        print('Missing parameter %s' % param)
+        sys.exit(1)
+    return sys.argv[sys.argv.index(param)+1]
+
+# Main function
+base=file_read(get_parameter('-o'))
+new=file_read(get_parameter('-n'))
+patch_name=get_parameter('-p')
+
+if check_parameter('-g'):
+    patch=patch_generate(base, new)
+    # Always check the Patch before writing it
+    if patch_apply(base, patch)!=new:
+        print('Patch generation failed')
+        sys.exit(1)
+    file_write(patch_name, patch)
+    print_parameters(base, new, patch)
+    sys.exit(0)
+elif check_parameter('-v'):
+    patch=file_read(patch_name)
+    try:
+        image=patch_apply(base, patch)
+    except ValueError as e:
+        print('Patch replay failed: %s' % e)
+        sys.exit(1)
+    print_parameters(base, new, patch)
+    if image!=new:
+        print('Patch does not reconstruct the new Image (len:%d CRC32:0x%08X)' % (len(image), crc32(image)))
+        sys.exit(1)
+    print('Patch verified')
+    sys.exit(0)
+else:
+    print('Usage: %s -g|-v -o <base image> -n <new image> -p <patch>' % sys.argv[0])
+    sys.exit(1)
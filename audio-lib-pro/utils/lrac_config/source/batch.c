@@ -0,0 +1,678 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "batch.h"
+#include "utils.h"
+#include "protocol.h"
+#include "loop.h"
+#include "wiced.h"
+#include "lrac.h"
+
+/*
+ * Definitions
+ */
+#define BATCH_LINE_SIZE                     256
+#define BATCH_ARGS_MAX                      8
+#define BATCH_LOOP_DEPTH_MAX                8
+
+/* Events kept for wait_event (the oldest ones are dropped) */
+#define BATCH_EVENT_QUEUE_SIZE              16
+#define BATCH_EVENT_DATA_SIZE               32
+
+/* Default wait_event timeout (ms) */
+#define BATCH_WAIT_EVENT_TIMEOUT            5000
+
+/* Trace events (not kept for wait_event) */
+#define BATCH_EVENT_WICED_TRACE             0x0002
+#define BATCH_EVENT_HCI_TRACE               0x0003
+
+typedef int (batch_cmd_handler_t)(int argc, char **argv);
+
+typedef struct
+{
+    char *p_name;
+    int nb_args_min;                /* Without the command name */
+    int nb_args_max;
+    batch_cmd_handler_t *p_handler;
+    char *p_help;
+} batch_cmd_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t nb_failed;
+    uint64_t total_us;
+    uint64_t min_us;
+    uint64_t max_us;
+} batch_cmd_stats_t;
+
+typedef struct
+{
+    uint16_t opcode;
+    uint16_t length;                /* Received length (only BATCH_EVENT_DATA_SIZE bytes kept) */
+    uint8_t data[BATCH_EVENT_DATA_SIZE];
+} batch_event_t;
+
+typedef struct
+{
+    int start;                      /* First line of the loop */
+    uint32_t remaining;             /* Remaining iterations */
+} batch_loop_t;
+
+typedef struct
+{
+    FILE *p_file;
+    int interactive;
+    int eof;
+    char **pp_lines;                /* Lines read so far (needed by the loops) */
+    int nb_lines;
+    int lines_size;
+    batch_loop_t loops[BATCH_LOOP_DEPTH_MAX];
+    int loop_depth;
+    int continue_on_error;
+    int quit;
+    uint32_t nb_failed;
+    batch_event_t events[BATCH_EVENT_QUEUE_SIZE];
+    int nb_events;
+    uint16_t wait_opcode;
+} batch_cb_t;
+
+/*
+ * Local functions
+ */
+static char *batch_line_get(int index);
+static int batch_line_execute(int index, char *p_line);
+static int batch_loop_skip(int index);
+static void batch_monitor(protocol_event_t event, uint16_t id, uint8_t *p_data, int data_len);
+static int batch_event_find(uint16_t opcode);
+static int batch_event_received(void *p_opaque);
+static void batch_stats_print(void);
+static uint64_t batch_time_us(void);
+
+static int batch_cmd_button(int argc, char **argv);
+static int batch_cmd_audio_insert(int argc, char **argv);
+static int batch_cmd_audio_insert_ext(int argc, char **argv);
+static int batch_cmd_ble_adv(int argc, char **argv);
+static int batch_cmd_switch(int argc, char **argv);
+static int batch_cmd_buf_stat(int argc, char **argv);
+static int batch_cmd_lrac_trace(int argc, char **argv);
+static int batch_cmd_fw_spi_logging(int argc, char **argv);
+static int batch_cmd_sleep(int argc, char **argv);
+static int batch_cmd_jitter_target(int argc, char **argv);
+static int batch_cmd_elna(int argc, char **argv);
+static int batch_cmd_reset(int argc, char **argv);
+static int batch_cmd_wait(int argc, char **argv);
+static int batch_cmd_wait_event(int argc, char **argv);
+static int batch_cmd_flush(int argc, char **argv);
+static int batch_cmd_echo(int argc, char **argv);
+static int batch_cmd_onerror(int argc, char **argv);
+static int batch_cmd_stats(int argc, char **argv);
+static int batch_cmd_help(int argc, char **argv);
+static int batch_cmd_quit(int argc, char **argv);
+
+/*
+ * Global variables
+ */
+static batch_cb_t batch_cb;
+
+static const batch_cmd_t batch_cmds[] =
+{
+    {"button",          1, 1, batch_cmd_button,         "id               Simulate Button Press"},
+    {"audio_insert",    1, 1, batch_cmd_audio_insert,   "id               Audio Insert"},
+    {"audio_insert_ext",1, 1, batch_cmd_audio_insert_ext, "cmd              Audio Insert Extended"},
+    {"ble_adv",         1, 1, batch_cmd_ble_adv,        "mode             Set LE Adv Mode"},
+    {"switch",          1, 1, batch_cmd_switch,         "prevent_glitch   LRAC Switch"},
+    {"buf_stat",        0, 0, batch_cmd_buf_stat,       "                 Print buffer statistics"},
+    {"lrac_trace",      1, 1, batch_cmd_lrac_trace,     "level            Set LRAC Trace Level"},
+    {"fw_spi_logging",  1, 1, batch_cmd_fw_spi_logging, "0/1              Enable/Disable SPI logging"},
+    {"sleep",           1, 1, batch_cmd_sleep,          "0/1/2            PDS Sleep disable/transport/no-transport"},
+    {"jitter_target",   1, 1, batch_cmd_jitter_target,  "t                Set the Jitter Buffer Target depth"},
+    {"elna",            1, 1, batch_cmd_elna,           "gain             Set the eLNA Gain"},
+    {"reset",           0, 0, batch_cmd_reset,          "                 Reset the device"},
+    {"wait",            1, 1, batch_cmd_wait,           "ms               Handle the received events during ms"},
+    {"wait_event",      1, 3, batch_cmd_wait_event,
+            "op [ms [status]] Wait for a WICED event (hex opcode) and check its status"},
+    {"flush",           0, 0, batch_cmd_flush,          "                 Discard the events received so far"},
+    {"echo",            0, BATCH_ARGS_MAX - 1, batch_cmd_echo, "text...          Print text"},
+    {"onerror",         1, 1, batch_cmd_onerror,        "stop/continue    Behavior when a command fails"},
+    {"stats",           0, 0, batch_cmd_stats,          "                 Print the commands statistics"},
+    {"help",            0, 0, batch_cmd_help,           "                 Print this help"},
+    {"quit",            0, 0, batch_cmd_quit,           "                 Exit"},
+};
+
+#define BATCH_NB_CMDS       (sizeof(batch_cmds) / sizeof(batch_cmds[0]))
+
+static batch_cmd_stats_t batch_stats[BATCH_NB_CMDS];
+
+/*
+ * batch_run
+ */
+int batch_run(char *p_file)
+{
+    char *p_line;
+    int index = 0;
+    int i;
+
+    memset(&batch_cb, 0, sizeof(batch_cb));
+    memset(batch_stats, 0, sizeof(batch_stats));
+
+    if (strcmp(p_file, "-") == 0)
+    {
+        batch_cb.p_file = stdin;
+        batch_cb.interactive = isatty(fileno(stdin));
+    }
+    else
+    {
+        batch_cb.p_file = fopen(p_file, "r");
+        if (batch_cb.p_file == NULL)
+        {
+            TRACE_ERR("Cannot open %s", p_file);
+            return -1;
+        }
+    }
+
+    /* Stop at the first error, unless interactive */
+    batch_cb.continue_on_error = batch_cb.interactive;
+
+    protocol_monitor_set(batch_monitor);
+
+    while ((batch_cb.quit == 0) && (index >= 0))
+    {
+        p_line = batch_line_get(index);
+        if (p_line == NULL)
+            break;
+        index = batch_line_execute(index, p_line);
+    }
+
+    if ((index >= 0) && (batch_cb.quit == 0) && (batch_cb.loop_depth > 0))
+    {
+        TRACE_ERR("'end' missing (%d loop(s) not terminated)", batch_cb.loop_depth);
+        batch_cb.nb_failed++;
+    }
+
+    protocol_monitor_set(NULL);
+
+    if (batch_cb.interactive == 0)
+        batch_stats_print();
+
+    if (batch_cb.p_file != stdin)
+        fclose(batch_cb.p_file);
+    for (i = 0; i < batch_cb.nb_lines; i++)
+        free(batch_cb.pp_lines[i]);
+    free(batch_cb.pp_lines);
+
+    return batch_cb.nb_failed;
+}
+
+/*
+ * batch_line_get
+ * Returns the line 'index' (read from the file if needed) or NULL at the end of the file.
+ */
+static char *batch_line_get(int index)
+{
+    char line[BATCH_LINE_SIZE];
+    char **pp_lines;
+    int len;
+
+    while ((index >= batch_cb.nb_lines) && (batch_cb.eof == 0))
+    {
+        if (batch_cb.interactive)
+        {
+            printf(batch_cb.loop_depth ? "... " : "> ");
+            fflush(stdout);
+        }
+
+        if (fgets(line, sizeof(line), batch_cb.p_file) == NULL)
+        {
+            batch_cb.eof = 1;
+            break;
+        }
+        len = strlen(line);
+        while ((len > 0) && ((line[len - 1] == '\n') || (line[len - 1] == '\r')))
+            line[--len] = '\0';
+
+        if (batch_cb.nb_lines >= batch_cb.lines_size)
+        {
+            pp_lines = realloc(batch_cb.pp_lines,
+                    (batch_cb.lines_size + 64) * sizeof(batch_cb.pp_lines[0]));
+            if (pp_lines == NULL)
+            {
+                TRACE_ERR("realloc failed");
+                batch_cb.eof = 1;
+                break;
+            }
+            batch_cb.pp_lines = pp_lines;
+            batch_cb.lines_size += 64;
+        }
+        batch_cb.pp_lines[batch_cb.nb_lines++] = strdup(line);
+    }
+
+    if (index >= batch_cb.nb_lines)
+        return NULL;
+    return batch_cb.pp_lines[index];
+}
+
+/*
+ * batch_line_execute
+ * Returns the index of the next line to execute (-1 to stop).
+ */
+static int batch_line_execute(int index, char *p_line)
+{
+    char line[BATCH_LINE_SIZE];
+    char *argv[BATCH_ARGS_MAX];
+    int argc = 0;
+    char *p;
+    const batch_cmd_t *p_cmd;
+    batch_cmd_stats_t *p_stats;
+    batch_loop_t *p_loop;
+    uint64_t start_us, duration_us;
+    int status;
+    int i;
+
+    /* Split the line (a '#' starts a comment) */
+    strncpy(line, p_line, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    p = strchr(line, '#');
+    if (p != NULL)
+        *p = '\0';
+    for (p = strtok(line, " \t"); (p != NULL) && (argc < BATCH_ARGS_MAX); p = strtok(NULL, " \t"))
+        argv[argc++] = p;
+    if (argc == 0)
+        return index + 1;
+
+    /* Loops */
+    if (strcmp(argv[0], "loop") == 0)
+    {
+        if ((argc != 2) || (batch_cb.loop_depth >= BATCH_LOOP_DEPTH_MAX))
+        {
+            TRACE_ERR("line %d: usage 'loop count' (up to %d nested loops)", index + 1,
+                    BATCH_LOOP_DEPTH_MAX);
+            batch_cb.nb_failed++;
+            return -1;
+        }
+        if (atoi(argv[1]) <= 0)
+            return batch_loop_skip(index);
+        p_loop = &batch_cb.loops[batch_cb.loop_depth++];
+        p_loop->start = index + 1;
+        p_loop->remaining = atoi(argv[1]);
+        return index + 1;
+    }
+    if (strcmp(argv[0], "end") == 0)
+    {
+        if (batch_cb.loop_depth == 0)
+        {
+            TRACE_ERR("line %d: 'end' without 'loop'", index + 1);
+            batch_cb.nb_failed++;
+            return -1;
+        }
+        p_loop = &batch_cb.loops[batch_cb.loop_depth - 1];
+        if (--p_loop->remaining > 0)
+            return p_loop->start;
+        batch_cb.loop_depth--;
+        return index + 1;
+    }
+
+    for (i = 0; i < BATCH_NB_CMDS; i++)
+    {
+        if (strcmp(argv[0], batch_cmds[i].p_name) == 0)
+            break;
+    }
+    if (i >= BATCH_NB_CMDS)
+    {
+        TRACE_ERR("line %d: unknown command '%s' (see help)", index + 1, argv[0]);
+        batch_cb.nb_failed++;
+        return batch_cb.continue_on_error ? index + 1 : -1;
+    }
+    p_cmd = &batch_cmds[i];
+    p_stats = &batch_stats[i];
+
+    if ((argc - 1 < p_cmd->nb_args_min) || (argc - 1 > p_cmd->nb_args_max))
+    {
+        TRACE_ERR("line %d: usage '%s %s'", index + 1, p_cmd->p_name, p_cmd->p_help);
+        batch_cb.nb_failed++;
+        return batch_cb.continue_on_error ? index + 1 : -1;
+    }
+
+    start_us = batch_time_us();
+    status = p_cmd->p_handler(argc, argv);
+    duration_us = batch_time_us() - start_us;
+
+    /* Print the line without its indentation */
+    p_line += strspn(p_line, " \t");
+
+    p_stats->count++;
+    p_stats->total_us += duration_us;
+    if ((p_stats->min_us == 0) || (duration_us < p_stats->min_us))
+        p_stats->min_us = duration_us;
+    if (duration_us > p_stats->max_us)
+        p_stats->max_us = duration_us;
+
+    if (status < 0)
+    {
+        p_stats->nb_failed++;
+        batch_cb.nb_failed++;
+        printf("[%10.3f ms] %s: FAILED (%d)\n", duration_us / 1000.0, p_line, status);
+        return batch_cb.continue_on_error ? index + 1 : -1;
+    }
+    printf("[%10.3f ms] %s: OK\n", duration_us / 1000.0, p_line);
+    return index + 1;
+}
+
+/*
+ * batch_loop_skip
+ * Returns the index of the line following the 'end' of the loop starting at 'index'.
+ */
+static int batch_loop_skip(int index)
+{
+    char *p_line;
+    char word[8];
+    int depth = 0;
+
+    while ((p_line = batch_line_get(++index)) != NULL)
+    {
+        if (sscanf(p_line, "%7s", word) != 1)
+            continue;
+        if (strcmp(word, "loop") == 0)
+            depth++;
+        else if ((strcmp(word, "end") == 0) && (depth-- == 0))
+            return index + 1;
+    }
+    TRACE_ERR("'end' missing");
+    batch_cb.nb_failed++;
+    return -1;
+}
+
+/*
+ * batch_monitor
+ * Keep the WICED events (except the traces) for wait_event
+ */
+static void batch_monitor(protocol_event_t event, uint16_t id, uint8_t *p_data, int data_len)
+{
+    batch_event_t *p_event;
+
+    if ((event != PROTOCOL_EVENT_RX_WICED_EVENT) ||
+        (id == BATCH_EVENT_WICED_TRACE) ||
+        (id == BATCH_EVENT_HCI_TRACE))
+        return;
+
+    /* Drop the oldest event if the queue is full */
+    if (batch_cb.nb_events >= BATCH_EVENT_QUEUE_SIZE)
+    {
+        memmove(&batch_cb.events[0], &batch_cb.events[1],
+                (BATCH_EVENT_QUEUE_SIZE - 1) * sizeof(batch_cb.events[0]));
+        batch_cb.nb_events--;
+    }
+
+    p_event = &batch_cb.events[batch_cb.nb_events++];
+    p_event->opcode = id;
+    p_event->length = data_len;
+    if (data_len > BATCH_EVENT_DATA_SIZE)
+        data_len = BATCH_EVENT_DATA_SIZE;
+    if (data_len > 0)
+        memcpy(p_event->data, p_data, data_len);
+}
+
+/*
+ * batch_event_find
+ * Returns the index of the first event received with this opcode (or -1)
+ */
+static int batch_event_find(uint16_t opcode)
+{
+    int i;
+
+    for (i = 0; i < batch_cb.nb_events; i++)
+    {
+        if (batch_cb.events[i].opcode == opcode)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * batch_event_received
+ */
+static int batch_event_received(void *p_opaque)
+{
+    return (batch_event_find(batch_cb.wait_opcode) >= 0);
+}
+
+/*
+ * batch_stats_print
+ */
+static void batch_stats_print(void)
+{
+    batch_cmd_stats_t *p_stats;
+    uint32_t count = 0;
+    uint64_t total_us = 0;
+    int i;
+
+    printf("%-18s %8s %8s %10s %10s %10s\n", "Command", "Count", "Failed", "Min(ms)",
+            "Avg(ms)", "Max(ms)");
+    for (i = 0; i < BATCH_NB_CMDS; i++)
+    {
+        p_stats = &batch_stats[i];
+        if (p_stats->count == 0)
+            continue;
+        printf("%-18s %8u %8u %10.3f %10.3f %10.3f\n", batch_cmds[i].p_name, p_stats->count,
+                p_stats->nb_failed, p_stats->min_us / 1000.0,
+                p_stats->total_us / 1000.0 / p_stats->count, p_stats->max_us / 1000.0);
+        count += p_stats->count;
+        total_us += p_stats->total_us;
+    }
+    printf("%u commands, %u failed, %.3f s\n", count, batch_cb.nb_failed, total_us / 1000000.0);
+}
+
+/*
+ * batch_time_us
+ */
+static uint64_t batch_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Device commands
+ */
+static int batch_cmd_button(int argc, char **argv)
+{
+    return lrac_button_sent(atoi(argv[1]));
+}
+
+static int batch_cmd_audio_insert(int argc, char **argv)
+{
+    return lrac_audio_insert_sent(atoi(argv[1]));
+}
+
+static int batch_cmd_audio_insert_ext(int argc, char **argv)
+{
+    return lrac_audio_insert_ext_sent(atoi(argv[1]));
+}
+
+static int batch_cmd_ble_adv(int argc, char **argv)
+{
+    return lrac_ble_adv_sent(atoi(argv[1]));
+}
+
+static int batch_cmd_switch(int argc, char **argv)
+{
+    return lrac_switch_sent(atoi(argv[1]));
+}
+
+static int batch_cmd_buf_stat(int argc, char **argv)
+{
+    return lrac_read_buffer_stat();
+}
+
+static int batch_cmd_lrac_trace(int argc, char **argv)
+{
+    return lrac_trace_level_set(atoi(argv[1]));
+}
+
+static int batch_cmd_fw_spi_logging(int argc, char **argv)
+{
+    return wiced_cmd_fw_spi_debug_enable(atoi(argv[1]));
+}
+
+static int batch_cmd_sleep(int argc, char **argv)
+{
+    return lrac_sleep_config(atoi(argv[1]));
+}
+
+static int batch_cmd_jitter_target(int argc, char **argv)
+{
+    return wiced_cmd_jitter_buffer_target_set(atoi(argv[1]));
+}
+
+static int batch_cmd_elna(int argc, char **argv)
+{
+    return wiced_cmd_elna_gain_set(atoi(argv[1]));
+}
+
+static int batch_cmd_reset(int argc, char **argv)
+{
+    return wiced_cmd_reset();
+}
+
+/*
+ * Script commands
+ */
+static int batch_cmd_wait(int argc, char **argv)
+{
+    loop_wait(atoi(argv[1]));
+    return 0;
+}
+
+static int batch_cmd_wait_event(int argc, char **argv)
+{
+    batch_event_t event;
+    int timeout_ms = BATCH_WAIT_EVENT_TIMEOUT;
+    int expected;
+    int index;
+    int i;
+
+    batch_cb.wait_opcode = strtol(argv[1], NULL, 16);
+    if (argc > 2)
+        timeout_ms = atoi(argv[2]);
+
+    if (loop_run_until(batch_event_received, NULL, timeout_ms) < 0)
+    {
+        TRACE_ERR("Event 0x%04X not received", batch_cb.wait_opcode);
+        return -1;
+    }
+
+    /* Consume the event */
+    index = batch_event_find(batch_cb.wait_opcode);
+    event = batch_cb.events[index];
+    memmove(&batch_cb.events[index], &batch_cb.events[index + 1],
+            (batch_cb.nb_events - index - 1) * sizeof(batch_cb.events[0]));
+    batch_cb.nb_events--;
+
+    printf("Event 0x%04X len:%d data:", event.opcode, event.length);
+    for (i = 0; (i < event.length) && (i < BATCH_EVENT_DATA_SIZE); i++)
+        printf(" %02X", event.data[i]);
+    printf("\n");
+
+    if (argc > 3)
+    {
+        expected = strtol(argv[3], NULL, 0);
+        if ((event.length < 1) || (event.data[0] != expected))
+        {
+            TRACE_ERR("Event 0x%04X status:0x%02X (expected 0x%02X)", event.opcode,
+                    event.length ? event.data[0] : 0, expected);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int batch_cmd_flush(int argc, char **argv)
+{
+    /* Handle the data already received first */
+    loop_run(0);
+    batch_cb.nb_events = 0;
+    return 0;
+}
+
+static int batch_cmd_echo(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+        printf("%s%s", argv[i], (i < argc - 1) ? " " : "");
+    printf("\n");
+    return 0;
+}
+
+static int batch_cmd_onerror(int argc, char **argv)
+{
+    if (strcmp(argv[1], "continue") == 0)
+        batch_cb.continue_on_error = 1;
+    else if (strcmp(argv[1], "stop") == 0)
+        batch_cb.continue_on_error = 0;
+    else
+        return -1;
+    return 0;
+}
+
+static int batch_cmd_stats(int argc, char **argv)
+{
+    batch_stats_print();
+    return 0;
+}
+
+static int batch_cmd_help(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < BATCH_NB_CMDS; i++)
+        printf("    %-16s %s\n", batch_cmds[i].p_name, batch_cmds[i].p_help);
+    printf("    %-16s %s\n", "loop", "count            Repeat the commands until 'end'");
+    printf("    %-16s %s\n", "end", "                 End of a loop");
+    printf("    # starts a comment\n");
+    return 0;
+}
+
+static int batch_cmd_quit(int argc, char **argv)
+{
+    batch_cb.quit = 1;
+    return 0;
+}
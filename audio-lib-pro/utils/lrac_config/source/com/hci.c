@@ -31,12 +31,12 @@
  * so agrees to indemnify Cypress against all liability.
  */
 
-#include <pthread.h>
 #include <string.h>
 
 #include "hci.h"
 #include "utils.h"
 #include "protocol.h"
+#include "loop.h"
 
 /*
  * Definitions
@@ -47,6 +47,9 @@
 
 #define HCI_CHIP_ID_ROM_ADDRESS     0xD21C
 
+/* Maximum time to wait for a Command Complete (ms) */
+#define HCI_CMD_TIMEOUT             2000
+
 /*
  * Structures
  */
@@ -55,8 +58,6 @@ typedef struct
     uint8_t num_cmd;
     uint16_t wait_opcode;
     uint16_t received_opcode;
-    pthread_cond_t cond;
-    pthread_mutex_t mutex;
     uint8_t rx_data[HCI_DATA_SIZE_MAX];
     uint16_t rx_data_len;
 } hci_protocol_cb_t;
@@ -83,6 +84,7 @@ hci_chip_id_t hci_chip_id_table[] =
  */
 static int hci_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint8_t tx_length,
         uint8_t *p_rx_data, uint8_t rx_length);
+static int hci_cmd_complete_received(void *p_opaque);
 static char *hci_get_opcode_desc(uint16_t opcode);
 
 /*
@@ -92,8 +94,6 @@ int hci_init(void)
 {
     TRACE_DBG("");
     memset(&hci_cb, 0, sizeof(hci_cb));
-    pthread_cond_init(&hci_cb.cond, NULL);
-    pthread_mutex_init(&hci_cb.mutex, NULL);
     return 0;
 }
 
@@ -407,7 +407,6 @@ static int hci_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint8_t tx_
 {
     int status;
     int cpy_len;
-    struct timespec ts;
 
     TRACE_DBG("opcode:0x%x (%s) tl:%d rl:%d", opcode, hci_get_opcode_desc(opcode), tx_length, rx_length);
 
@@ -434,15 +433,8 @@ static int hci_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint8_t tx_
         return status;
     }
 
-    pthread_mutex_lock(&hci_cb.mutex);
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += 2;
-    status = 0;
-    while ((hci_cb.wait_opcode != hci_cb.received_opcode) && (status == 0))
-    {
-        status = pthread_cond_timedwait(&hci_cb.cond, &hci_cb.mutex, &ts);
-    }
-    pthread_mutex_unlock(&hci_cb.mutex);
+    /* Handle the received data until the Command Complete is received */
+    status = loop_run_until(hci_cmd_complete_received, NULL, HCI_CMD_TIMEOUT);
     if (status != 0)
     {
         TRACE_ERR("Command timeout");
@@ -469,6 +461,14 @@ static int hci_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint8_t tx_
 
 
 
+/*
+ * hci_cmd_complete_received
+ */
+static int hci_cmd_complete_received(void *p_opaque)
+{
+    return (hci_cb.wait_opcode == hci_cb.received_opcode);
+}
+
 /*
  * hci_event_handler
  *
@@ -496,10 +496,7 @@ int hci_event_handler(uint8_t event, uint8_t *p_data, uint16_t length)
             handled = 1;
             memcpy(hci_cb.rx_data, p_data, length - 1 - 2);
             hci_cb.rx_data_len = length - 1 - 2;
-            pthread_mutex_lock(&hci_cb.mutex);
             hci_cb.received_opcode = hci_opcode;
-            pthread_cond_signal(&hci_cb.cond);
-            pthread_mutex_unlock(&hci_cb.mutex);
         }
         else
         {
@@ -0,0 +1,464 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include "loop.h"
+#include "utils.h"
+
+/*
+ * Definitions
+ */
+typedef struct
+{
+    int fd;
+    uint32_t events;
+    loop_callback_t *p_callback;
+    void *p_opaque;
+} loop_fd_t;
+
+typedef struct
+{
+#if defined(__linux__)
+    int epoll_fd;
+#endif
+    loop_fd_t fds[LOOP_FD_MAX];
+    loop_timer_t *p_timers;         /* Running timers (sorted by expiry time) */
+} loop_cb_t;
+
+/*
+ * Global variables
+ */
+static loop_cb_t loop_cb;
+
+/*
+ * Local functions
+ */
+static loop_fd_t *loop_fd_get(int fd);
+static void loop_fd_dispatch(loop_fd_t *p_loop_fd, uint32_t events);
+static int loop_timeout_get(int timeout_ms);
+static int loop_timers_expire(void);
+
+/*
+ * loop_init
+ */
+int loop_init(void)
+{
+    int i;
+
+    TRACE_DBG("");
+
+#if defined(__linux__)
+    if (loop_cb.epoll_fd > 0)
+        close(loop_cb.epoll_fd);
+#endif
+
+    memset(&loop_cb, 0, sizeof(loop_cb));
+    for (i = 0; i < LOOP_FD_MAX; i++)
+        loop_cb.fds[i].fd = -1;
+
+#if defined(__linux__)
+    loop_cb.epoll_fd = epoll_create1(0);
+    if (loop_cb.epoll_fd < 0)
+    {
+        TRACE_ERR("epoll_create1 failed errno:%d", errno);
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/*
+ * loop_fd_add
+ */
+int loop_fd_add(int fd, uint32_t events, loop_callback_t *p_callback, void *p_opaque)
+{
+    loop_fd_t *p_loop_fd;
+#if defined(__linux__)
+    struct epoll_event epoll_event;
+#endif
+
+    TRACE_DBG("fd:%d events:0x%x", fd, events);
+
+    if (loop_fd_get(fd) != NULL)
+    {
+        TRACE_ERR("fd:%d already registered", fd);
+        return -1;
+    }
+
+    p_loop_fd = loop_fd_get(-1);
+    if (p_loop_fd == NULL)
+    {
+        TRACE_ERR("no more fd (%d)", LOOP_FD_MAX);
+        return -1;
+    }
+
+#if defined(__linux__)
+    memset(&epoll_event, 0, sizeof(epoll_event));
+    if (events & LOOP_EVENT_IN)
+        epoll_event.events |= EPOLLIN;
+    if (events & LOOP_EVENT_OUT)
+        epoll_event.events |= EPOLLOUT;
+    epoll_event.data.ptr = p_loop_fd;
+    if (epoll_ctl(loop_cb.epoll_fd, EPOLL_CTL_ADD, fd, &epoll_event) < 0)
+    {
+        TRACE_ERR("epoll_ctl failed errno:%d", errno);
+        return -1;
+    }
+#endif
+
+    p_loop_fd->fd = fd;
+    p_loop_fd->events = events;
+    p_loop_fd->p_callback = p_callback;
+    p_loop_fd->p_opaque = p_opaque;
+
+    return 0;
+}
+
+/*
+ * loop_fd_modify
+ */
+int loop_fd_modify(int fd, uint32_t events)
+{
+    loop_fd_t *p_loop_fd;
+#if defined(__linux__)
+    struct epoll_event epoll_event;
+#endif
+
+    p_loop_fd = loop_fd_get(fd);
+    if ((fd < 0) || (p_loop_fd == NULL))
+    {
+        TRACE_ERR("fd:%d not registered", fd);
+        return -1;
+    }
+
+    if (p_loop_fd->events == events)
+        return 0;
+
+#if defined(__linux__)
+    memset(&epoll_event, 0, sizeof(epoll_event));
+    if (events & LOOP_EVENT_IN)
+        epoll_event.events |= EPOLLIN;
+    if (events & LOOP_EVENT_OUT)
+        epoll_event.events |= EPOLLOUT;
+    epoll_event.data.ptr = p_loop_fd;
+    if (epoll_ctl(loop_cb.epoll_fd, EPOLL_CTL_MOD, fd, &epoll_event) < 0)
+    {
+        TRACE_ERR("epoll_ctl failed errno:%d", errno);
+        return -1;
+    }
+#endif
+
+    p_loop_fd->events = events;
+
+    return 0;
+}
+
+/*
+ * loop_fd_remove
+ */
+int loop_fd_remove(int fd)
+{
+    loop_fd_t *p_loop_fd;
+
+    TRACE_DBG("fd:%d", fd);
+
+    p_loop_fd = loop_fd_get(fd);
+    if ((fd < 0) || (p_loop_fd == NULL))
+    {
+        TRACE_DBG("fd:%d not registered", fd);
+        return -1;
+    }
+
+#if defined(__linux__)
+    epoll_ctl(loop_cb.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+
+    /* The entry may still be referenced by an event being dispatched */
+    p_loop_fd->fd = -1;
+    p_loop_fd->p_callback = NULL;
+
+    return 0;
+}
+
+/*
+ * loop_timer_start
+ */
+void loop_timer_start(loop_timer_t *p_timer, int timeout_ms, loop_timer_callback_t *p_callback,
+        void *p_opaque)
+{
+    loop_timer_t **pp_timer;
+
+    loop_timer_stop(p_timer);
+
+    p_timer->expiry_ms = loop_time_ms() + timeout_ms;
+    p_timer->p_callback = p_callback;
+    p_timer->p_opaque = p_opaque;
+
+    /* Insert it after the timers expiring before (or at the same time) */
+    pp_timer = &loop_cb.p_timers;
+    while ((*pp_timer != NULL) && ((*pp_timer)->expiry_ms <= p_timer->expiry_ms))
+        pp_timer = &(*pp_timer)->p_next;
+    p_timer->p_next = *pp_timer;
+    *pp_timer = p_timer;
+}
+
+/*
+ * loop_timer_stop
+ */
+void loop_timer_stop(loop_timer_t *p_timer)
+{
+    loop_timer_t **pp_timer;
+
+    for (pp_timer = &loop_cb.p_timers; *pp_timer != NULL; pp_timer = &(*pp_timer)->p_next)
+    {
+        if (*pp_timer == p_timer)
+        {
+            *pp_timer = p_timer->p_next;
+            break;
+        }
+    }
+    p_timer->p_next = NULL;
+}
+
+/*
+ * loop_run_until
+ */
+int loop_run_until(loop_cond_t *p_cond, void *p_opaque, int timeout_ms)
+{
+    uint64_t deadline_ms;
+    uint64_t now_ms;
+
+    deadline_ms = loop_time_ms() + timeout_ms;
+    while (p_cond(p_opaque) == 0)
+    {
+        now_ms = loop_time_ms();
+        if (now_ms >= deadline_ms)
+            return -1;
+        if (loop_run((int)(deadline_ms - now_ms)) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * loop_wait
+ */
+void loop_wait(int duration_ms)
+{
+    uint64_t deadline_ms;
+    uint64_t now_ms;
+
+    TRACE_DBG("Wait for %d ms", duration_ms);
+
+    deadline_ms = loop_time_ms() + duration_ms;
+    for (now_ms = loop_time_ms(); now_ms < deadline_ms; now_ms = loop_time_ms())
+    {
+        if (loop_run((int)(deadline_ms - now_ms)) < 0)
+            break;
+    }
+}
+
+/*
+ * loop_time_ms
+ */
+uint64_t loop_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * loop_run
+ */
+int loop_run(int timeout_ms)
+{
+#if defined(__linux__)
+    struct epoll_event epoll_events[LOOP_FD_MAX];
+    uint32_t events;
+    int nb_events;
+    int i;
+
+    nb_events = epoll_wait(loop_cb.epoll_fd, epoll_events, LOOP_FD_MAX,
+            loop_timeout_get(timeout_ms));
+    if (nb_events < 0)
+    {
+        if (errno == EINTR)
+            return loop_timers_expire();
+        TRACE_ERR("epoll_wait failed errno:%d", errno);
+        return -1;
+    }
+
+    for (i = 0; i < nb_events; i++)
+    {
+        events = 0;
+        if (epoll_events[i].events & EPOLLIN)
+            events |= LOOP_EVENT_IN;
+        if (epoll_events[i].events & EPOLLOUT)
+            events |= LOOP_EVENT_OUT;
+        if (epoll_events[i].events & (EPOLLERR | EPOLLHUP))
+            events |= LOOP_EVENT_ERR;
+        loop_fd_dispatch(epoll_events[i].data.ptr, events);
+    }
+    return nb_events + loop_timers_expire();
+#else
+    struct pollfd poll_fds[LOOP_FD_MAX];
+    loop_fd_t *p_loop_fds[LOOP_FD_MAX];
+    uint32_t events;
+    int nb_fds = 0;
+    int nb_events;
+    int i;
+
+    for (i = 0; i < LOOP_FD_MAX; i++)
+    {
+        if (loop_cb.fds[i].fd < 0)
+            continue;
+        poll_fds[nb_fds].fd = loop_cb.fds[i].fd;
+        poll_fds[nb_fds].events = 0;
+        if (loop_cb.fds[i].events & LOOP_EVENT_IN)
+            poll_fds[nb_fds].events |= POLLIN;
+        if (loop_cb.fds[i].events & LOOP_EVENT_OUT)
+            poll_fds[nb_fds].events |= POLLOUT;
+        poll_fds[nb_fds].revents = 0;
+        p_loop_fds[nb_fds] = &loop_cb.fds[i];
+        nb_fds++;
+    }
+
+    nb_events = poll(poll_fds, nb_fds, loop_timeout_get(timeout_ms));
+    if (nb_events < 0)
+    {
+        if (errno == EINTR)
+            return loop_timers_expire();
+        TRACE_ERR("poll failed errno:%d", errno);
+        return -1;
+    }
+
+    for (i = 0; i < nb_fds; i++)
+    {
+        events = 0;
+        if (poll_fds[i].revents & POLLIN)
+            events |= LOOP_EVENT_IN;
+        if (poll_fds[i].revents & POLLOUT)
+            events |= LOOP_EVENT_OUT;
+        if (poll_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+            events |= LOOP_EVENT_ERR;
+        if (events)
+            loop_fd_dispatch(p_loop_fds[i], events);
+    }
+    return nb_events + loop_timers_expire();
+#endif
+}
+
+/*
+ * loop_fd_get
+ */
+static loop_fd_t *loop_fd_get(int fd)
+{
+    int i;
+
+    for (i = 0; i < LOOP_FD_MAX; i++)
+    {
+        if (loop_cb.fds[i].fd == fd)
+            return &loop_cb.fds[i];
+    }
+    return NULL;
+}
+
+/*
+ * loop_fd_dispatch
+ */
+static void loop_fd_dispatch(loop_fd_t *p_loop_fd, uint32_t events)
+{
+    /* Ignore the events of a file descriptor removed by a previous callback */
+    if ((p_loop_fd->fd < 0) ||
+        (p_loop_fd->p_callback == NULL))
+        return;
+
+    p_loop_fd->p_callback(p_loop_fd->fd, events, p_loop_fd->p_opaque);
+}
+
+/*
+ * loop_timeout_get
+ * Reduce the wait timeout if a timer expires before.
+ */
+static int loop_timeout_get(int timeout_ms)
+{
+    uint64_t now_ms;
+    int timer_ms;
+
+    if (loop_cb.p_timers == NULL)
+        return timeout_ms;
+
+    now_ms = loop_time_ms();
+    if (loop_cb.p_timers->expiry_ms <= now_ms)
+        return 0;
+
+    timer_ms = (int)(loop_cb.p_timers->expiry_ms - now_ms);
+    if ((timeout_ms < 0) || (timer_ms < timeout_ms))
+        return timer_ms;
+    return timeout_ms;
+}
+
+/*
+ * loop_timers_expire
+ * Call the callback of the expired timers.
+ * Returns the number of expired timers.
+ */
+static int loop_timers_expire(void)
+{
+    loop_timer_t *p_timer;
+    uint64_t now_ms;
+    int nb_expired = 0;
+
+    now_ms = loop_time_ms();
+    while ((loop_cb.p_timers != NULL) && (loop_cb.p_timers->expiry_ms <= now_ms))
+    {
+        /* Remove it first (the callback may restart it) */
+        p_timer = loop_cb.p_timers;
+        loop_cb.p_timers = p_timer->p_next;
+        p_timer->p_next = NULL;
+        p_timer->p_callback(p_timer->p_opaque);
+        nb_expired++;
+    }
+    return nb_expired;
+}
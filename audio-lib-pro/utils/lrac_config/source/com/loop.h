@@ -0,0 +1,126 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Event Loop. It waits (epoll on Linux, poll otherwise) for events on the registered file
+ * descriptors (e.g. serial ports) and for the timers and calls their callback.
+ */
+
+/* Events */
+#define LOOP_EVENT_IN           0x01        /* Data can be read */
+#define LOOP_EVENT_OUT          0x02        /* Data can be written */
+#define LOOP_EVENT_ERR          0x04        /* Error or Hang-up */
+
+/* Maximum number of file descriptors */
+#define LOOP_FD_MAX             64
+
+typedef void (loop_callback_t)(int fd, uint32_t events, void *p_opaque);
+
+typedef void (loop_timer_callback_t)(void *p_opaque);
+
+/* Condition checked by loop_run_until (returns 1 when the wait is over) */
+typedef int (loop_cond_t)(void *p_opaque);
+
+/* Timer. Allocated by the caller (it must remain valid until it expires or is stopped) */
+typedef struct loop_timer
+{
+    struct loop_timer *p_next;
+    uint64_t expiry_ms;
+    loop_timer_callback_t *p_callback;
+    void *p_opaque;
+} loop_timer_t;
+
+/*
+ * loop_init
+ */
+int loop_init(void);
+
+/*
+ * loop_fd_add
+ * Register a file descriptor. The callback is called when one of the events occurs (errors
+ * are always reported).
+ */
+int loop_fd_add(int fd, uint32_t events, loop_callback_t *p_callback, void *p_opaque);
+
+/*
+ * loop_fd_modify
+ * Change the events of a registered file descriptor.
+ */
+int loop_fd_modify(int fd, uint32_t events);
+
+/*
+ * loop_fd_remove
+ */
+int loop_fd_remove(int fd);
+
+/*
+ * loop_timer_start
+ * Start (or restart) a one-shot timer.
+ */
+void loop_timer_start(loop_timer_t *p_timer, int timeout_ms, loop_timer_callback_t *p_callback,
+        void *p_opaque);
+
+/*
+ * loop_timer_stop
+ */
+void loop_timer_stop(loop_timer_t *p_timer);
+
+/*
+ * loop_run
+ * Wait for events (up to timeout_ms, -1 for infinite) and call the callbacks.
+ * Returns the number of events handled.
+ */
+int loop_run(int timeout_ms);
+
+/*
+ * loop_run_until
+ * Run the Event Loop until the condition is met or until timeout_ms elapsed.
+ * Returns 0 if the condition is met, -1 otherwise.
+ */
+int loop_run_until(loop_cond_t *p_cond, void *p_opaque, int timeout_ms);
+
+/*
+ * loop_wait
+ * Run the Event Loop during duration_ms (i.e. the received data are handled while waiting).
+ */
+void loop_wait(int duration_ms);
+
+/*
+ * loop_time_ms
+ * Monotonic time in milliseconds.
+ */
+uint64_t loop_time_ms(void);
@@ -32,8 +32,9 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
+#include <time.h>
 
 #include "protocol.h"
 
@@ -54,7 +55,9 @@
 #define PROTOCOL_WICED_PKT                  0x19
 
 #define PROTOCOL_HEADER_SIZE                (1 + 2 + 2)
-#define PROTOCOL_PAYLOAD_SIZE               1024
+
+#define PROTOCOL_BENCH_READ_SIZE            1024        /* Same as serial.c read buffer */
+#define PROTOCOL_BENCH_DURATION_US          (1 * 1000 * 1000)
 
 #define PROTOCOL_CMD_MAX_LEN                (PROTOCOL_HEADER_SIZE + PROTOCOL_PAYLOAD_SIZE)
 #define PROTOCOL_EVT_MAX_LEN                (PROTOCOL_HEADER_SIZE + PROTOCOL_PAYLOAD_SIZE)
@@ -92,14 +95,10 @@ typedef enum
 
 typedef struct
 {
+    protocol_conn_t conn;                   /* Default connection */
     protocol_callback_t *p_callback;
-    protocol_state_t rx_state;
-    uint8_t rx_data[PROTOCOL_PAYLOAD_SIZE];
-    uint16_t opcode;
-    uint8_t event;
-    uint16_t con_hdl;
-    uint16_t length;
-    uint16_t data_counter;
+    protocol_callback_t *p_monitor;         /* Called for every received packet */
+    FILE *p_capture_file;                   /* Received bytes capture */
 } protocol_cb_t;
 
 /*
@@ -110,9 +109,13 @@ static protocol_cb_t protocol_cb;
 /*
  * Local functions
  */
-static void protocol_cback (protocol_event_t event, uint16_t id, uint8_t *p_data,
-        int data_len);
-static void protocol_serial_cback(serial_event_t event, uint8_t *p_data, int data_len);
+static void protocol_cback (void *p_opaque, protocol_event_t event, uint16_t id,
+        uint8_t *p_data, int data_len);
+static void protocol_serial_cback(serial_event_t event, uint8_t *p_data, int data_len,
+        void *p_opaque);
+static void protocol_rx_bulk(protocol_conn_t *p_conn, uint8_t *p_data, int data_len);
+static int protocol_rx_state_machine(protocol_conn_t *p_conn, uint8_t *p_data, int data_len,
+        int one_packet);
 
 /*
  * protocol_init
@@ -121,7 +124,7 @@ int protocol_init(void)
 {
     memset(&protocol_cb, 0, sizeof(protocol_cb));
 
-    return serial_init();
+    return serial_init(&protocol_cb.conn.port);
 }
 
 /*
@@ -137,14 +140,18 @@ int protocol_open(char *p_device, int baudrate, int flow_control, protocol_callb
         return -1;
     }
 
-    status = serial_open(p_device, baudrate, flow_control, protocol_serial_cback);
+    protocol_cb.conn.p_callback = protocol_cback;
+    protocol_cb.conn.p_opaque = NULL;
+    protocol_cb.conn.rx_state = IDLE;
+
+    status = serial_open(&protocol_cb.conn.port, p_device, baudrate, flow_control,
+            protocol_serial_cback, &protocol_cb.conn);
     if (status < 0)
     {
         TRACE_ERR("serial_open failed");
         return -1;
     }
     protocol_cb.p_callback = p_callback;
-    protocol_cb.rx_state = IDLE;
 
     return 0;
 
@@ -155,7 +162,7 @@ int protocol_open(char *p_device, int baudrate, int flow_control, protocol_callb
  */
 int protocol_set_baudrate(int baudrate, int flow_control)
 {
-    return (serial_set_baudrate(baudrate, flow_control));
+    return (serial_set_baudrate(&protocol_cb.conn.port, baudrate, flow_control));
 }
 
 /*
@@ -169,16 +176,97 @@ int protocol_close(void)
         return -1;
     }
 
-    serial_close();
+    serial_close(&protocol_cb.conn.port);
+
+    if (protocol_cb.p_capture_file != NULL)
+    {
+        fclose(protocol_cb.p_capture_file);
+    }
 
     return protocol_init();
 }
 
+/*
+ * protocol_monitor_set
+ */
+void protocol_monitor_set(protocol_callback_t *p_monitor)
+{
+    protocol_cb.p_monitor = p_monitor;
+}
+
+/*
+ * protocol_capture_open
+ */
+int protocol_capture_open(char *p_file)
+{
+    if (protocol_cb.p_capture_file != NULL)
+    {
+        TRACE_ERR("capture already opened");
+        return -1;
+    }
+
+    protocol_cb.p_capture_file = fopen(p_file, "wb");
+    if (protocol_cb.p_capture_file == NULL)
+    {
+        TRACE_ERR("Cannot open %s", p_file);
+        return -1;
+    }
+    return 0;
+}
+
 /*
  * protocol_send
  */
 int protocol_send(protocol_type_t protocol, uint16_t id, uint8_t *p_data,
         int data_len)
+{
+    return protocol_conn_send(&protocol_cb.conn, protocol, id, p_data, data_len);
+}
+
+/*
+ * protocol_conn_open
+ */
+int protocol_conn_open(protocol_conn_t *p_conn, char *p_device, int baudrate, int flow_control,
+        protocol_conn_callback_t *p_callback, void *p_opaque)
+{
+    int status;
+
+    memset(p_conn, 0, sizeof(*p_conn));
+    serial_init(&p_conn->port);
+    p_conn->p_callback = p_callback;
+    p_conn->p_opaque = p_opaque;
+    p_conn->rx_state = IDLE;
+
+    status = serial_open(&p_conn->port, p_device, baudrate, flow_control,
+            protocol_serial_cback, p_conn);
+    if (status < 0)
+    {
+        TRACE_ERR("serial_open failed");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * protocol_conn_close
+ */
+int protocol_conn_close(protocol_conn_t *p_conn)
+{
+    if (p_conn->port.fd < 0)
+    {
+        TRACE_ERR("not opened");
+        return -1;
+    }
+
+    return serial_close(&p_conn->port);
+}
+
+/*
+ * protocol_conn_send
+ */
+int protocol_conn_send(protocol_conn_t *p_conn, protocol_type_t protocol, uint16_t id,
+        uint8_t *p_data, int data_len)
 {
     uint8_t cmd[PROTOCOL_CMD_MAX_LEN];
     uint8_t *p = cmd;
@@ -231,7 +319,7 @@ int protocol_send(protocol_type_t protocol, uint16_t id, uint8_t *p_data,
         ARRAY_TO_STREAM(p, p_data, data_len);
     }
 
-    rv = serial_write(cmd, p - cmd);
+    rv = serial_write(&p_conn->port, cmd, p - cmd);
     if (rv < 0)
     {
         return rv;
@@ -243,13 +331,18 @@ int protocol_send(protocol_type_t protocol, uint16_t id, uint8_t *p_data,
 /*
  * protocol_cback
  */
-static void protocol_cback (protocol_event_t event, uint16_t id, uint8_t *p_data,
-        int data_len)
+static void protocol_cback (void *p_opaque, protocol_event_t event, uint16_t id,
+        uint8_t *p_data, int data_len)
 {
     uint16_t hci_opcode;
     uint8_t *p = p_data;
     int handled = 0;
 
+    if (protocol_cb.p_monitor)
+    {
+        protocol_cb.p_monitor(event, id, p_data, data_len);
+    }
+
     switch(event)
     {
     case PROTOCOL_EVENT_RX_HCI_EVENT:
@@ -266,6 +359,9 @@ static void protocol_cback (protocol_event_t event, uint16_t id, uint8_t *p_data
         handled = wiced_event_handler(id, p_data, data_len);
         break;
 
+    case PROTOCOL_EVENT_DISCONNECT:
+        break;
+
     default:
         TRACE_ERR("unknown event:%d", event);
         break;
@@ -281,51 +377,166 @@ static void protocol_cback (protocol_event_t event, uint16_t id, uint8_t *p_data
 /*
  * protocol_serial_cback
  */
-static void protocol_serial_cback(serial_event_t event, uint8_t *p_data, int data_len)
+static void protocol_serial_cback(serial_event_t event, uint8_t *p_data, int data_len,
+        void *p_opaque)
 {
-    uint16_t cpy_len;
+    protocol_conn_t *p_conn = p_opaque;
+
+    if (event == WICED_SERIAL_EVENT_DISCONNECT)
+    {
+        p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_DISCONNECT, 0, NULL, 0);
+        return;
+    }
 
     //TRACE_DBG_FULL("len:%d", data_len);
     if (data_len == 0)
         return;
 
+    if ((p_conn == &protocol_cb.conn) && (protocol_cb.p_capture_file != NULL))
+    {
+        fwrite(p_data, 1, data_len, protocol_cb.p_capture_file);
+    }
+
+    protocol_rx_bulk(p_conn, p_data, data_len);
+}
+
+/*
+ * protocol_rx_bulk
+ * Scan the packet headers in the received buffer and dispatch every complete packet in place
+ * (without copying it). The State Machine is only used for the packets which straddle two
+ * buffers (beginning of a packet at the end of the buffer or end of a packet at the
+ * beginning of the buffer).
+ */
+static void protocol_rx_bulk(protocol_conn_t *p_conn, uint8_t *p_data, int data_len)
+{
+    protocol_event_t event;
+    uint16_t id;
+    int header_len;
+    int length;
+    int used;
+
+    while (data_len > 0)
+    {
+        /* End of a packet started in the previous buffer */
+        if (p_conn->rx_state != IDLE)
+        {
+            used = protocol_rx_state_machine(p_conn, p_data, data_len, 1);
+            p_data += used;
+            data_len -= used;
+            continue;
+        }
+
+        switch (p_data[0])
+        {
+        case PROTOCOL_WICED_PKT:
+            header_len = 1 + 2 + 2;
+            if (data_len < header_len)
+                break;
+            event = PROTOCOL_EVENT_RX_WICED_EVENT;
+            id = p_data[1] | (p_data[2] << 8);
+            length = p_data[3] | (p_data[4] << 8);
+            break;
+
+        case PROTOCOL_HCI_EVT_PKT:
+            header_len = 1 + 1 + 1;
+            if (data_len < header_len)
+                break;
+            event = PROTOCOL_EVENT_RX_HCI_EVENT;
+            id = p_data[1];
+            length = p_data[2];
+            break;
+
+        case PROTOCOL_HCI_ACL_PKT:
+            header_len = 1 + 2 + 2;
+            if (data_len < header_len)
+                break;
+            event = PROTOCOL_EVENT_RX_HCI_ACL;
+            id = p_data[1] | (p_data[2] << 8);
+            length = p_data[3] | (p_data[4] << 8);
+            break;
+
+        case PROTOCOL_HCI_SCO_PKT:
+            header_len = 1 + 2 + 1;
+            if (data_len < header_len)
+                break;
+            event = PROTOCOL_EVENT_RX_HCI_SCO;
+            id = p_data[1] | (p_data[2] << 8);
+            length = p_data[3];
+            break;
+
+        default:
+            /* HCI Commands (ignored) and unknown bytes are handled by the State Machine */
+            header_len = 0;
+            break;
+        }
+
+        /* Unknown/ignored packet, or truncated header/payload: use the State Machine */
+        if ((header_len == 0) ||
+            (data_len < header_len) ||
+            (data_len < header_len + length))
+        {
+            used = protocol_rx_state_machine(p_conn, p_data, data_len, 1);
+            p_data += used;
+            data_len -= used;
+            continue;
+        }
+
+        p_conn->p_callback(p_conn->p_opaque, event, id,
+                length ? &p_data[header_len] : NULL, length);
+        p_data += header_len + length;
+        data_len -= header_len + length;
+    }
+}
+
+/*
+ * protocol_rx_state_machine
+ * Byte per byte parser. If one_packet is set, it returns as soon as a packet (or an unknown
+ * byte) has been consumed.
+ * Returns the number of bytes consumed.
+ */
+static int protocol_rx_state_machine(protocol_conn_t *p_conn, uint8_t *p_data, int data_len,
+        int one_packet)
+{
+    int data_len_start = data_len;
+    uint16_t cpy_len;
+
     while(data_len > 0)
     {
         //TRACE_DBG_FULL("byte:%x length:%d", *p_data, data_len);
 
-        switch (protocol_cb.rx_state)
+        switch (p_conn->rx_state)
         {
         case IDLE:
             data_len--;
             switch (*p_data++)
             {
             case PROTOCOL_HCI_CMD_PKT:
-                protocol_cb.rx_state = HCI_CMD_W4_OP_L;
+                p_conn->rx_state = HCI_CMD_W4_OP_L;
                 //TRACE_DBG_FULL("HCI_CMD");
                 break;
 
             case PROTOCOL_HCI_ACL_PKT:
-                protocol_cb.rx_state = HCI_ACL_W4_CH_L;
+                p_conn->rx_state = HCI_ACL_W4_CH_L;
                 //TRACE_DBG_FULL("HCI_ACL");
                 break;
 
             case PROTOCOL_HCI_SCO_PKT:
-                protocol_cb.rx_state = HCI_SCO_W4_CH_L;
+                p_conn->rx_state = HCI_SCO_W4_CH_L;
                 //TRACE_DBG_FULL("HCI_SCO");
                 break;
 
             case PROTOCOL_HCI_EVT_PKT:
-                protocol_cb.rx_state = HCI_EVT_W4_EVT;
+                p_conn->rx_state = HCI_EVT_W4_EVT;
                 //TRACE_DBG_FULL("HCI_EVT");
                 break;
 
             case PROTOCOL_WICED_PKT:
-                protocol_cb.rx_state = WICED_W4_CMD;
+                p_conn->rx_state = WICED_W4_CMD;
                 //TRACE_DBG_FULL("WICED_EVT");
                 break;
 
             default:
-                protocol_cb.rx_state = IDLE;
+                p_conn->rx_state = IDLE;
                 break;
             }
         break;
@@ -333,242 +544,375 @@ static void protocol_serial_cback(serial_event_t event, uint8_t *p_data, int dat
         // HCI command Packet
         case HCI_CMD_W4_OP_L:
             data_len--;
-            protocol_cb.opcode = *p_data++;
-            protocol_cb.rx_state = HCI_CMD_W4_OP_H;
+            p_conn->opcode = *p_data++;
+            p_conn->rx_state = HCI_CMD_W4_OP_H;
             break;
         case HCI_CMD_W4_OP_H:
             data_len--;
-            protocol_cb.opcode |= *p_data++ << 8;
-            protocol_cb.rx_state = HCI_CMD_W4_LEN;
-            //TRACE_DBG_FULL("HCI Opcode:0x%04X", protocol_cb.opcode);
+            p_conn->opcode |= *p_data++ << 8;
+            p_conn->rx_state = HCI_CMD_W4_LEN;
+            //TRACE_DBG_FULL("HCI Opcode:0x%04X", p_conn->opcode);
             break;
         case HCI_CMD_W4_LEN:
             data_len--;
-            protocol_cb.length = *p_data++;
-            //TRACE_DBG_FULL("HCI CmdLen:%02X", protocol_cb.opcode);
-            if (protocol_cb.length == 0)
+            p_conn->length = *p_data++;
+            //TRACE_DBG_FULL("HCI CmdLen:%02X", p_conn->opcode);
+            if (p_conn->length == 0)
             {
-                protocol_cb.rx_state = IDLE;
+                p_conn->rx_state = IDLE;
                 TRACE_ERR("Err: HCI Cmd Received (len:0). Ignored");
             }
             else
             {
-                protocol_cb.data_counter = 0;
-                protocol_cb.rx_state = HCI_CMD_W4_DATA;
+                p_conn->data_counter = 0;
+                p_conn->rx_state = HCI_CMD_W4_DATA;
             }
             break;
         case HCI_CMD_W4_DATA:
-            cpy_len = MIN(protocol_cb.length, data_len);
-            memcpy(&protocol_cb.rx_data[protocol_cb.data_counter], p_data, cpy_len);
-            protocol_cb.data_counter += cpy_len;
+            cpy_len = MIN(p_conn->length - p_conn->data_counter, data_len);
+            memcpy(&p_conn->rx_data[p_conn->data_counter], p_data, cpy_len);
+            p_conn->data_counter += cpy_len;
             p_data += cpy_len;
             data_len -= cpy_len;
 
-            if (protocol_cb.data_counter >= protocol_cb.length)
+            if (p_conn->data_counter >= p_conn->length)
             {
-                protocol_cb.rx_state = IDLE;
+                p_conn->rx_state = IDLE;
                 TRACE_ERR("Err: HCI Cmd Received (len:%d. Ignored",
-                        protocol_cb.length);
+                        p_conn->length);
             }
             break;
 
         // HCI ACL Packet
         case HCI_ACL_W4_CH_L:
             data_len--;
-            protocol_cb.con_hdl = *p_data++;
-            protocol_cb.rx_state = HCI_ACL_W4_CH_H;
+            p_conn->con_hdl = *p_data++;
+            p_conn->rx_state = HCI_ACL_W4_CH_H;
             break;
 
         case HCI_ACL_W4_CH_H:
             data_len--;
-            protocol_cb.con_hdl |= *p_data++ << 8;
-            //TRACE_DBG_FULL("HCI_ACL_CON_HDL:0x%04x", protocol_cb.con_hdl);
-            protocol_cb.rx_state = HCI_ACL_W4_LEN_L;
+            p_conn->con_hdl |= *p_data++ << 8;
+            //TRACE_DBG_FULL("HCI_ACL_CON_HDL:0x%04x", p_conn->con_hdl);
+            p_conn->rx_state = HCI_ACL_W4_LEN_L;
             break;
 
         case HCI_ACL_W4_LEN_L:
             data_len--;
-            protocol_cb.length = *p_data++;
-            protocol_cb.rx_state = HCI_ACL_W4_LEN_H;
+            p_conn->length = *p_data++;
+            p_conn->rx_state = HCI_ACL_W4_LEN_H;
             break;
 
         case HCI_ACL_W4_LEN_H:
             data_len--;
-            protocol_cb.length |= *p_data++ << 8;
-            //TRACE_DBG_FULL("HCI_ACL Len:%d", protocol_cb.length);
-            if (protocol_cb.length == 0)
+            p_conn->length |= *p_data++ << 8;
+            //TRACE_DBG_FULL("HCI_ACL Len:%d", p_conn->length);
+            if (p_conn->length == 0)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_ACL,
-                        protocol_cb.con_hdl, NULL, 0);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_ACL,
+                        p_conn->con_hdl, NULL, 0);
             }
             else
             {
-                protocol_cb.data_counter = 0;
-                protocol_cb.rx_state = HCI_ACL_W4_DATA;
+                p_conn->data_counter = 0;
+                p_conn->rx_state = HCI_ACL_W4_DATA;
             }
             break;
 
         case HCI_ACL_W4_DATA:
-            cpy_len = MIN(protocol_cb.length, data_len);
-            memcpy(&protocol_cb.rx_data[protocol_cb.data_counter], p_data, cpy_len);
-            protocol_cb.data_counter += cpy_len;
+            cpy_len = MIN(p_conn->length - p_conn->data_counter, data_len);
+            memcpy(&p_conn->rx_data[p_conn->data_counter], p_data, cpy_len);
+            p_conn->data_counter += cpy_len;
             p_data += cpy_len;
             data_len -= cpy_len;
 
-            if (protocol_cb.data_counter >= protocol_cb.length)
+            if (p_conn->data_counter >= p_conn->length)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_ACL,
-                        protocol_cb.con_hdl,
-                        protocol_cb.rx_data,
-                        protocol_cb.length);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_ACL,
+                        p_conn->con_hdl,
+                        p_conn->rx_data,
+                        p_conn->length);
             }
             break;
 
         // HCI SCO Packet
         case HCI_SCO_W4_CH_L:
             data_len--;
-            protocol_cb.con_hdl = *p_data++;
-            protocol_cb.rx_state = HCI_SCO_W4_CH_H;
+            p_conn->con_hdl = *p_data++;
+            p_conn->rx_state = HCI_SCO_W4_CH_H;
             break;
 
         case HCI_SCO_W4_CH_H:
             data_len--;
-            protocol_cb.con_hdl |= *p_data++ << 8;
-            //TRACE_DBG_FULL("HCI_SCO_CON_HDL:0x%04x", protocol_cb.con_hdl);
-            protocol_cb.rx_state = HCI_SCO_W4_LEN;
+            p_conn->con_hdl |= *p_data++ << 8;
+            //TRACE_DBG_FULL("HCI_SCO_CON_HDL:0x%04x", p_conn->con_hdl);
+            p_conn->rx_state = HCI_SCO_W4_LEN;
             break;
 
         case HCI_SCO_W4_LEN:
             data_len--;
-            protocol_cb.length = *p_data++;
-            //TRACE_DBG_FULL("HCI_SCO Len:%d", protocol_cb.length);
-            if (protocol_cb.length == 0)
+            p_conn->length = *p_data++;
+            //TRACE_DBG_FULL("HCI_SCO Len:%d", p_conn->length);
+            if (p_conn->length == 0)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_SCO,
-                        protocol_cb.con_hdl, NULL, 0);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_SCO,
+                        p_conn->con_hdl, NULL, 0);
             }
             else
             {
-                protocol_cb.data_counter = 0;
-                protocol_cb.rx_state = HCI_SCO_W4_DATA;
+                p_conn->data_counter = 0;
+                p_conn->rx_state = HCI_SCO_W4_DATA;
             }
             break;
 
         case HCI_SCO_W4_DATA:
-            cpy_len = MIN(protocol_cb.length, data_len);
-            memcpy(&protocol_cb.rx_data[protocol_cb.data_counter], p_data, cpy_len);
-            protocol_cb.data_counter += cpy_len;
+            cpy_len = MIN(p_conn->length - p_conn->data_counter, data_len);
+            memcpy(&p_conn->rx_data[p_conn->data_counter], p_data, cpy_len);
+            p_conn->data_counter += cpy_len;
             p_data += cpy_len;
             data_len -= cpy_len;
 
-            if (protocol_cb.data_counter >= protocol_cb.length)
+            if (p_conn->data_counter >= p_conn->length)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_SCO,
-                        protocol_cb.con_hdl,
-                        protocol_cb.rx_data,
-                        protocol_cb.length);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_SCO,
+                        p_conn->con_hdl,
+                        p_conn->rx_data,
+                        p_conn->length);
             }
             break;
 
         // HCI Event Packet
         case HCI_EVT_W4_EVT:
             data_len--;
-            protocol_cb.event = *p_data++;
-            //TRACE_DBG_FULL("HCI EVT:0x%x", protocol_cb.event);
-            protocol_cb.rx_state = HCI_EVT_W4_LEN;
+            p_conn->event = *p_data++;
+            //TRACE_DBG_FULL("HCI EVT:0x%x", p_conn->event);
+            p_conn->rx_state = HCI_EVT_W4_LEN;
             break;
         case HCI_EVT_W4_LEN:
             data_len--;
-            protocol_cb.length = *p_data++;
-            //TRACE_DBG_FULL("HCI EVT len:0x%x", protocol_cb.length);
-            if (protocol_cb.length == 0)
+            p_conn->length = *p_data++;
+            //TRACE_DBG_FULL("HCI EVT len:0x%x", p_conn->length);
+            if (p_conn->length == 0)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_EVENT,
-                        protocol_cb.event, NULL, 0);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_EVENT,
+                        p_conn->event, NULL, 0);
             }
             else
             {
-                protocol_cb.data_counter = 0;
-                protocol_cb.rx_state = HCI_EVT_W4_DATA;
+                p_conn->data_counter = 0;
+                p_conn->rx_state = HCI_EVT_W4_DATA;
             }
             break;
         case HCI_EVT_W4_DATA:
-            cpy_len = MIN(protocol_cb.length, data_len);
+            cpy_len = MIN(p_conn->length - p_conn->data_counter, data_len);
             //TRACE_DBG_FULL("evt cpy_len:%d", cpy_len);
-            memcpy(&protocol_cb.rx_data[protocol_cb.data_counter], p_data, cpy_len);
-            protocol_cb.data_counter += cpy_len;
+            memcpy(&p_conn->rx_data[p_conn->data_counter], p_data, cpy_len);
+            p_conn->data_counter += cpy_len;
             p_data += cpy_len;
             data_len -= cpy_len;
 
-            if (protocol_cb.data_counter >= protocol_cb.length)
+            if (p_conn->data_counter >= p_conn->length)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_HCI_EVENT,
-                        protocol_cb.event,
-                        protocol_cb.rx_data,
-                        protocol_cb.length);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_HCI_EVENT,
+                        p_conn->event,
+                        p_conn->rx_data,
+                        p_conn->length);
             }
             break;
 
         // WICED Packet
         case WICED_W4_CMD:
             data_len--;
-            protocol_cb.opcode = *p_data++;
-            protocol_cb.rx_state = WICED_W4_GROUP;
+            p_conn->opcode = *p_data++;
+            p_conn->rx_state = WICED_W4_GROUP;
             break;
         case WICED_W4_GROUP:
             data_len--;
-            protocol_cb.opcode |= *p_data++ << 8;
-            TRACE_DBG_FULL("Wiced Opcode:0x%04X ", protocol_cb.opcode);
-            protocol_cb.rx_state = WICED_W4_LEN_L;
+            p_conn->opcode |= *p_data++ << 8;
+            TRACE_DBG_FULL("Wiced Opcode:0x%04X ", p_conn->opcode);
+            p_conn->rx_state = WICED_W4_LEN_L;
             break;
         case WICED_W4_LEN_L:
             data_len--;
-            protocol_cb.length = *p_data++;
-            protocol_cb.rx_state = WICED_W4_LEN_H;
+            p_conn->length = *p_data++;
+            p_conn->rx_state = WICED_W4_LEN_H;
             break;
         case WICED_W4_LEN_H:
             data_len--;
-            protocol_cb.length |= *p_data++ << 8;
-            //TRACE_DBG_FULL("Wiced CMD Len:%d ", protocol_cb.length);
-            if (protocol_cb.length == 0)
+            p_conn->length |= *p_data++ << 8;
+            //TRACE_DBG_FULL("Wiced CMD Len:%d ", p_conn->length);
+            if (p_conn->length == 0)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_WICED_EVENT,
-                        protocol_cb.opcode, NULL, 0);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_WICED_EVENT,
+                        p_conn->opcode, NULL, 0);
             }
             else
             {
-                protocol_cb.data_counter = 0;
-                protocol_cb.rx_state = WICED_W4_DATA;
+                p_conn->data_counter = 0;
+                p_conn->rx_state = WICED_W4_DATA;
             }
             break;
         case WICED_W4_DATA:
-            cpy_len = MIN(protocol_cb.length, data_len);
-            memcpy(&protocol_cb.rx_data[protocol_cb.data_counter], p_data, cpy_len);
-            protocol_cb.data_counter += cpy_len;
+            cpy_len = MIN(p_conn->length - p_conn->data_counter, data_len);
+            memcpy(&p_conn->rx_data[p_conn->data_counter], p_data, cpy_len);
+            p_conn->data_counter += cpy_len;
             p_data += cpy_len;
             data_len -= cpy_len;
 
-            if (protocol_cb.data_counter >= protocol_cb.length)
+            if (p_conn->data_counter >= p_conn->length)
             {
-                protocol_cb.rx_state = IDLE;
-                protocol_cback(PROTOCOL_EVENT_RX_WICED_EVENT,
-                        protocol_cb.opcode,
-                        protocol_cb.rx_data,
-                        protocol_cb.length);
+                p_conn->rx_state = IDLE;
+                p_conn->p_callback(p_conn->p_opaque, PROTOCOL_EVENT_RX_WICED_EVENT,
+                        p_conn->opcode,
+                        p_conn->rx_data,
+                        p_conn->length);
             }
             break;
 
         default:
-            TRACE_ERR("Unknown state:%d", protocol_cb.rx_state);
-            protocol_cb.rx_state = IDLE;
+            TRACE_ERR("Unknown state:%d", p_conn->rx_state);
+            p_conn->rx_state = IDLE;
             break;
         }
+
+        if (one_packet && (p_conn->rx_state == IDLE))
+            break;
     }
+    return data_len_start - data_len;
+}
+
+/*
+ * protocol_bench_callback
+ */
+static void protocol_bench_callback(void *p_opaque, protocol_event_t event, uint16_t id,
+        uint8_t *p_data, int data_len)
+{
+    uint32_t *p_nb_packets = p_opaque;
+
+    (*p_nb_packets)++;
+}
+
+/*
+ * protocol_bench_time_us
+ */
+static uint64_t protocol_bench_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * protocol_bench_run
+ * Feed the capture, in PROTOCOL_BENCH_READ_SIZE chunks (size of the serial read buffer), to
+ * one of the parsers.
+ * Returns the throughput in MB/s (and the number of packets per pass).
+ */
+static double protocol_bench_run(uint8_t *p_capture, int capture_len, int bulk,
+        uint32_t *p_nb_packets)
+{
+    protocol_conn_t *p_conn;
+    uint64_t start, elapsed;
+    uint64_t total = 0;
+    uint32_t nb_passes = 0;
+    int offset;
+    int len;
+
+    p_conn = calloc(1, sizeof(*p_conn));
+    if (p_conn == NULL)
+        return 0;
+    p_conn->p_callback = protocol_bench_callback;
+    p_conn->p_opaque = p_nb_packets;
+    p_conn->rx_state = IDLE;
+    *p_nb_packets = 0;
+
+    start = protocol_bench_time_us();
+    do
+    {
+        for (offset = 0; offset < capture_len; offset += len)
+        {
+            len = MIN(PROTOCOL_BENCH_READ_SIZE, capture_len - offset);
+            if (bulk)
+                protocol_rx_bulk(p_conn, &p_capture[offset], len);
+            else
+                protocol_rx_state_machine(p_conn, &p_capture[offset], len, 0);
+        }
+        total += capture_len;
+        nb_passes++;
+        elapsed = protocol_bench_time_us() - start;
+    } while (elapsed < PROTOCOL_BENCH_DURATION_US);
+
+    free(p_conn);
+    *p_nb_packets /= nb_passes;
+
+    return (double)total / elapsed;
+}
+
+/*
+ * protocol_rx_bench
+ */
+int protocol_rx_bench(char *p_file)
+{
+    FILE *p_fd;
+    uint8_t *p_capture;
+    long capture_len;
+    uint32_t nb_packets_sm, nb_packets_bulk;
+    double mbps_sm, mbps_bulk;
+
+    p_fd = fopen(p_file, "rb");
+    if (p_fd == NULL)
+    {
+        TRACE_ERR("Cannot open %s", p_file);
+        return -1;
+    }
+    fseek(p_fd, 0, SEEK_END);
+    capture_len = ftell(p_fd);
+    fseek(p_fd, 0, SEEK_SET);
+    if (capture_len <= 0)
+    {
+        TRACE_ERR("%s is empty", p_file);
+        fclose(p_fd);
+        return -1;
+    }
+
+    p_capture = malloc(capture_len);
+    if (p_capture == NULL)
+    {
+        TRACE_ERR("malloc(%ld) failed", capture_len);
+        fclose(p_fd);
+        return -1;
+    }
+    if (fread(p_capture, 1, capture_len, p_fd) != capture_len)
+    {
+        TRACE_ERR("Cannot read %s", p_file);
+        free(p_capture);
+        fclose(p_fd);
+        return -1;
+    }
+    fclose(p_fd);
+
+    mbps_sm = protocol_bench_run(p_capture, capture_len, 0, &nb_packets_sm);
+    mbps_bulk = protocol_bench_run(p_capture, capture_len, 1, &nb_packets_bulk);
+    free(p_capture);
+
+    printf("Capture: %ld bytes, %d packets/pass\n", capture_len, nb_packets_bulk);
+    printf("State Machine parser: %8.1f MB/s\n", mbps_sm);
+    printf("Bulk parser:          %8.1f MB/s (x%.1f)\n", mbps_bulk,
+            mbps_sm > 0 ? mbps_bulk / mbps_sm : 0);
+
+    if (nb_packets_sm != nb_packets_bulk)
+    {
+        TRACE_ERR("Packet count mismatch (State Machine:%d Bulk:%d)",
+                nb_packets_sm, nb_packets_bulk);
+        return -1;
+    }
+    return 0;
 }
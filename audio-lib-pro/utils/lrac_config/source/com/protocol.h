@@ -35,6 +35,10 @@
 
 #include <stdint.h>
 
+#include "serial.h"
+
+#define PROTOCOL_PAYLOAD_SIZE               1024
+
 typedef enum
 {
     PROTOCOL_EVENT_DISCONNECT = 0,
@@ -57,9 +61,65 @@ typedef enum
 typedef void (protocol_callback_t)(protocol_event_t event,
         uint16_t id, uint8_t *p_data, int data_len);
 
+typedef void (protocol_conn_callback_t)(void *p_opaque, protocol_event_t event,
+        uint16_t id, uint8_t *p_data, int data_len);
+
+/*
+ * Connection (one per serial port)
+ */
+typedef struct
+{
+    serial_port_t port;
+    protocol_conn_callback_t *p_callback;
+    void *p_opaque;
+    /* Receive state */
+    int rx_state;
+    uint8_t rx_data[PROTOCOL_PAYLOAD_SIZE];
+    uint16_t opcode;
+    uint8_t event;
+    uint16_t con_hdl;
+    uint16_t length;
+    uint16_t data_counter;
+} protocol_conn_t;
+
+/*
+ * All the connections are driven by the Event Loop (see loop.h): the received packets are
+ * only handled while the loop runs (loop_run, loop_run_until or loop_wait).
+ */
+
+/*
+ * Default connection. The received packets are handled by the HCI and WICED command modules
+ * (hci.c and wiced.c) and the other ones are passed to the callback.
+ */
 int protocol_init(void);
 int protocol_open(char *p_device, int baudrate, int flow_control, protocol_callback_t *p_callback);
 int protocol_set_baudrate(int baudrate, int flow_control);
 int protocol_close(void);
 int protocol_send(protocol_type_t type, uint16_t id, uint8_t *p_data,
         int data_len);
+
+/*
+ * Call p_monitor for every packet received on the default connection (before it is handled).
+ * NULL to stop.
+ */
+void protocol_monitor_set(protocol_callback_t *p_monitor);
+
+/*
+ * Write all the bytes received on the default connection to a file (which can be used
+ * with protocol_rx_bench).
+ */
+int protocol_capture_open(char *p_file);
+
+/*
+ * Measure the throughput of the receive parsers (State Machine and Bulk) with a capture file.
+ */
+int protocol_rx_bench(char *p_file);
+
+/*
+ * Other connections. All the received packets are passed to their callback.
+ */
+int protocol_conn_open(protocol_conn_t *p_conn, char *p_device, int baudrate, int flow_control,
+        protocol_conn_callback_t *p_callback, void *p_opaque);
+int protocol_conn_close(protocol_conn_t *p_conn);
+int protocol_conn_send(protocol_conn_t *p_conn, protocol_type_t type, uint16_t id,
+        uint8_t *p_data, int data_len);
@@ -38,23 +38,18 @@
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
-#include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <termios.h>
 #include <string.h>
+#include <errno.h>
 
 #include "utils.h"
+#include "loop.h"
 
 /*
  * Definitions
  */
-typedef struct
-{
-    int fd;
-    serial_callback_t *p_callback;
-    pthread_t thread;
-} serial_cb_t;
-
 typedef struct
 {
     unsigned short sco_handle;
@@ -64,45 +59,49 @@ typedef struct
 #define IOCTL_BTWUSB_ADD_VOICE_CHANNEL    0x1009
 #define IOCTL_BTWUSB_REMOVE_VOICE_CHANNEL 0x100a
 
-/*
- * Globals
- */
-static serial_cb_t serial_cb;
+/* Maximum time to wait for the UART to send the pending data when the port is closed */
+#define SERIAL_FLUSH_TIMEOUT    1000
 
 /*
  * Local functions
  */
-static void *serial_thread(void *);
+static void serial_loop_callback(int fd, uint32_t events, void *p_opaque);
+static void serial_read(serial_port_t *p_port);
+static int serial_tx_send(serial_port_t *p_port);
+static int serial_tx_flushed(void *p_opaque);
 
 /*
  * serial_init
  */
-int serial_init(void)
+int serial_init(serial_port_t *p_port)
 {
     TRACE_DBG("");
-    memset(&serial_cb, 0, sizeof(serial_cb));
-    serial_cb.fd = -1;
+    memset(p_port, 0, sizeof(*p_port));
+    p_port->fd = -1;
     return 0;
 }
 
 /*
  * serial_open
+ * The port is opened in non-blocking mode. The data are read, and the data which could not be
+ * written immediately are sent, by the Event Loop (loop_run).
  */
-int serial_open(char *p_device, int baudrate, int flow_control, serial_callback_t *p_callback)
+int serial_open(serial_port_t *p_port, char *p_device, int baudrate, int flow_control,
+        serial_callback_t *p_callback, void *p_opaque)
 {
     int status = 0;
     int fd;
 
     TRACE_DBG("Port %s", p_device);
 
-    if (serial_cb.fd >= 0)
+    if (p_port->fd >= 0)
     {
         TRACE_ERR("Port already opened");
         return -1;
     }
 
     /* Open the Bluetooth controller device */
-    fd = open(p_device, O_RDWR | O_NOCTTY);
+    fd = open(p_device, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (fd < 0)
     {
         TRACE_ERR("serial_open open(%s) failed", p_device);
@@ -110,24 +109,28 @@ int serial_open(char *p_device, int baudrate, int flow_control, serial_callback_
         return -1;
     }
 
-    serial_cb.fd = fd;
-    serial_cb.p_callback = p_callback;
+    p_port->fd = fd;
+    p_port->p_callback = p_callback;
+    p_port->p_opaque = p_opaque;
 
     /* Change Baudrate for UART device (containing 'tty') only */
     if (strstr(p_device, "tty"))
     {
-        status = serial_set_baudrate(baudrate, flow_control);
+        status = serial_set_baudrate(p_port, baudrate, flow_control);
         if (status < 0)
         {
-            serial_init();
+            close(fd);
+            serial_init(p_port);
             return -1;
         }
     }
 
-    if (pthread_create(&serial_cb.thread, NULL, serial_thread, NULL) < 0)
+    status = loop_fd_add(fd, LOOP_EVENT_IN, serial_loop_callback, p_port);
+    if (status < 0)
     {
-        TRACE_ERR("pthread_create failed");
-        serial_init();
+        TRACE_ERR("loop_fd_add failed");
+        close(fd);
+        serial_init(p_port);
         return -1;
     }
 
@@ -137,25 +140,32 @@ int serial_open(char *p_device, int baudrate, int flow_control, serial_callback_
 /*
  * serial_close
  */
-int serial_close(void)
+int serial_close(serial_port_t *p_port)
 {
     TRACE_DBG("serial_close");
 
-    if (serial_cb.fd < 0)
+    if (p_port->fd < 0)
     {
         TRACE_ERR("serial_close Port not opened");
         return -1;
     }
 
-    if (close(serial_cb.fd) < 0)
+    /* Send the data not written yet */
+    if (serial_flush(p_port, SERIAL_FLUSH_TIMEOUT) < 0)
+    {
+        TRACE_ERR("serial_close %d bytes not sent", p_port->tx_len);
+    }
+
+    loop_fd_remove(p_port->fd);
+
+    if (close(p_port->fd) < 0)
     {
         TRACE_ERR("serial_close close failed");
         return -1;
     }
 
-    serial_init();
-
-    pthread_cancel(serial_cb.thread);
+    free(p_port->p_tx_buf);
+    serial_init(p_port);
 
     return 0;
 }
@@ -163,7 +173,7 @@ int serial_close(void)
 /*
  * serial_set_baudrate
  */
-int serial_set_baudrate(int baudrate, int flow_control)
+int serial_set_baudrate(serial_port_t *p_port, int baudrate, int flow_control)
 {
     uint32_t baud;
     uint8_t data_bits;
@@ -173,7 +183,7 @@ int serial_set_baudrate(int baudrate, int flow_control)
 
     TRACE_DBG("serial_set_baudrate baudrate:%d HW-FlowControl:%d", baudrate, flow_control);
 
-    if (serial_cb.fd < 0)
+    if (p_port->fd < 0)
     {
         TRACE_ERR("serial_set_baudrate Port not opened");
         return -1;
@@ -242,9 +252,9 @@ int serial_set_baudrate(int baudrate, int flow_control)
     parity = 0;         /* No Parity */
     stop_bits = 0;      /* 1 Stop bit */
 
-    tcflush(serial_cb.fd, TCIOFLUSH);
+    tcflush(p_port->fd, TCIOFLUSH);
 
-    tcgetattr(serial_cb.fd, &termios);
+    tcgetattr(p_port->fd, &termios);
 
     /* Configure in default raw mode */
     cfmakeraw(&termios);
@@ -258,87 +268,193 @@ int serial_set_baudrate(int baudrate, int flow_control)
         termios.c_cflag |= CRTSCTS;
     }
 
-    tcsetattr(serial_cb.fd, TCSANOW, &termios);
+    tcsetattr(p_port->fd, TCSANOW, &termios);
 
-    tcflush(serial_cb.fd, TCIOFLUSH);
+    tcflush(p_port->fd, TCIOFLUSH);
 
-    tcsetattr(serial_cb.fd, TCSANOW, &termios);
+    tcsetattr(p_port->fd, TCSANOW, &termios);
 
-    tcflush(serial_cb.fd, TCIOFLUSH);
-    tcflush(serial_cb.fd, TCIOFLUSH);
+    tcflush(p_port->fd, TCIOFLUSH);
+    tcflush(p_port->fd, TCIOFLUSH);
 
     cfsetospeed(&termios, baud);
     cfsetispeed(&termios, baud);
-    tcsetattr(serial_cb.fd, TCSANOW, &termios);
+    tcsetattr(p_port->fd, TCSANOW, &termios);
     return 0;
 
 }
 
 /*
  * serial_write
+ * Write the data immediately if possible. The remaining data are buffered and sent by the
+ * Event Loop (in order) as soon as the UART can accept them.
  */
-int serial_write(uint8_t *p_data, int data_len)
+int serial_write(serial_port_t *p_port, uint8_t *p_data, int data_len)
 {
-    ssize_t size;
+    ssize_t size = 0;
+    uint8_t *p_tx_buf;
+    int tx_size;
 
     TRACE_DUMP_DBG_FULL("HCI TX >> ", p_data, data_len);
 
-    if (serial_cb.fd < 0)
+    if (p_port->fd < 0)
     {
         TRACE_ERR("serial_write Port not opened");
         return -1;
     }
 
-    size = write(serial_cb.fd, p_data, data_len);
-    if (size < 0)
+    /* Nothing buffered: try to write directly */
+    if (p_port->tx_len == 0)
     {
-        TRACE_ERR("serial_write write failed");
-        return -1;
+        size = write(p_port->fd, p_data, data_len);
+        if (size < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            {
+                TRACE_ERR("serial_write write failed");
+                return -1;
+            }
+            size = 0;
+        }
+        if (size == data_len)
+            return data_len;
     }
-    else if (size < data_len)
+
+    /* Buffer the remaining data */
+    if ((p_port->tx_len + data_len - size) > p_port->tx_size)
     {
-        TRACE_ERR("serial_write write partial write (%d instread of %d",
-                (int)size, data_len);
+        tx_size = p_port->tx_len + data_len - size;
+        if (tx_size < SERIAL_TX_BUF_SIZE)
+            tx_size = SERIAL_TX_BUF_SIZE;
+        p_tx_buf = realloc(p_port->p_tx_buf, tx_size);
+        if (p_tx_buf == NULL)
+        {
+            TRACE_ERR("serial_write realloc(%d) failed", tx_size);
+            return -1;
+        }
+        p_port->p_tx_buf = p_tx_buf;
+        p_port->tx_size = tx_size;
+    }
+    memcpy(&p_port->p_tx_buf[p_port->tx_len], p_data + size, data_len - size);
+    p_port->tx_len += data_len - size;
+
+    /* Wait for the UART to accept more data */
+    if (loop_fd_modify(p_port->fd, LOOP_EVENT_IN | LOOP_EVENT_OUT) < 0)
         return -1;
+
+    return data_len;
+}
+
+/*
+ * serial_flush
+ */
+int serial_flush(serial_port_t *p_port, int timeout_ms)
+{
+    if (p_port->tx_len == 0)
+        return 0;
+
+    return loop_run_until(serial_tx_flushed, p_port, timeout_ms);
+}
+
+/*
+ * serial_loop_callback
+ */
+static void serial_loop_callback(int fd, uint32_t events, void *p_opaque)
+{
+    serial_port_t *p_port = p_opaque;
+
+    if ((events & LOOP_EVENT_OUT) &&
+        (serial_tx_send(p_port) < 0))
+    {
+        events = LOOP_EVENT_ERR;
     }
 
-    return (int)size;
+    if (events & LOOP_EVENT_IN)
+    {
+        serial_read(p_port);
+    }
+    else if (events & LOOP_EVENT_ERR)
+    {
+        TRACE_ERR("fd:%d error", fd);
+        loop_fd_remove(fd);
+        if (p_port->p_callback)
+            p_port->p_callback(WICED_SERIAL_EVENT_DISCONNECT, NULL, 0, p_port->p_opaque);
+    }
 }
 
 /*
- * serial_thread
+ * serial_read
+ * Read all the data available (non-blocking port)
  */
-static void *serial_thread(void *arg)
+static void serial_read(serial_port_t *p_port)
 {
     uint8_t buffer[1024];
     ssize_t size;
 
-    TRACE_DBG("started");
-
     do
     {
-        size = read(serial_cb.fd, &buffer, sizeof(buffer));
+        size = read(p_port->fd, &buffer, sizeof(buffer));
         if (size < 0)
         {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+                break;
             TRACE_ERR("read failed");
-            if (serial_cb.p_callback)
-                serial_cb.p_callback(WICED_SERIAL_EVENT_DISCONNECT, NULL, 0);
+            loop_fd_remove(p_port->fd);
+            if (p_port->p_callback)
+                p_port->p_callback(WICED_SERIAL_EVENT_DISCONNECT, NULL, 0, p_port->p_opaque);
             break;
         }
-        if (serial_cb.p_callback)
+        if ((size > 0) && (p_port->p_callback))
         {
             TRACE_DUMP_DBG_FULL("HCI RX << ", buffer, (int)size);
-            serial_cb.p_callback(WICED_SERIAL_EVENT_RX_DATA, buffer, (int)size);
+            p_port->p_callback(WICED_SERIAL_EVENT_RX_DATA, buffer, (int)size, p_port->p_opaque);
         }
-    } while(1);
-    TRACE_DBG("exit");
-    return NULL;
+    } while (size == sizeof(buffer));
+}
+
+/*
+ * serial_tx_send
+ * Send the buffered data (the UART can accept data)
+ */
+static int serial_tx_send(serial_port_t *p_port)
+{
+    ssize_t size;
+
+    size = write(p_port->fd, p_port->p_tx_buf, p_port->tx_len);
+    if (size < 0)
+    {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+            return 0;
+        TRACE_ERR("write failed");
+        p_port->tx_len = 0;
+        return -1;
+    }
+
+    p_port->tx_len -= size;
+    if (p_port->tx_len > 0)
+    {
+        memmove(p_port->p_tx_buf, &p_port->p_tx_buf[size], p_port->tx_len);
+        return 0;
+    }
+
+    /* Everything sent: stop waiting for the UART */
+    return loop_fd_modify(p_port->fd, LOOP_EVENT_IN);
+}
+
+/*
+ * serial_tx_flushed
+ */
+static int serial_tx_flushed(void *p_opaque)
+{
+    serial_port_t *p_port = p_opaque;
+
+    return (p_port->tx_len == 0);
 }
 
 /*
  * wiced_ioctl
  */
-int wiced_ioctl(wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data)
+int wiced_ioctl(serial_port_t *p_port, wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data)
 {
     wiced_ioctl_sco_ctrl_t ioctl_data;
     int rv;
@@ -352,7 +468,7 @@ int wiced_ioctl(wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data)
         {
             ioctl_data.sco_handle = p_data->sco_handle;
             ioctl_data.burst = 48;
-            rv = ioctl(serial_cb.fd, IOCTL_BTWUSB_ADD_VOICE_CHANNEL, &ioctl_data);
+            rv = ioctl(p_port->fd, IOCTL_BTWUSB_ADD_VOICE_CHANNEL, &ioctl_data);
             if (rv < 0)
             {
                 TRACE_DBG("USERIAL_Ioctl: USERIAL_OP_SCO_UP failed");
@@ -367,7 +483,7 @@ int wiced_ioctl(wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data)
         {
             ioctl_data.sco_handle = p_data->sco_handle;
             ioctl_data.burst = 0;
-            rv = ioctl(serial_cb.fd, IOCTL_BTWUSB_REMOVE_VOICE_CHANNEL, &ioctl_data);
+            rv = ioctl(p_port->fd, IOCTL_BTWUSB_REMOVE_VOICE_CHANNEL, &ioctl_data);
             if (rv < 0)
             {
                 TRACE_DBG("USERIAL_Ioctl: USERIAL_OP_SCO_DOWN failed");
@@ -54,13 +54,29 @@ typedef union
 } wiced_ioctl_data_t;
 
 
-typedef void (serial_callback_t)(serial_event_t event, uint8_t *p_data, int data_len);
+/* Initial size of the buffer of the data waiting for the UART */
+#define SERIAL_TX_BUF_SIZE      4096
 
-int serial_init(void);
-int serial_open(char *p_device, int baudrate, int flow_control, serial_callback_t *p_callback);
-int serial_close(void);
-int serial_set_baudrate(int baudrate, int flow_control);
-int serial_write(uint8_t *p_data, int data_len);
-int wiced_ioctl(wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data);
+typedef void (serial_callback_t)(serial_event_t event, uint8_t *p_data, int data_len,
+        void *p_opaque);
+
+typedef struct
+{
+    int fd;
+    serial_callback_t *p_callback;
+    void *p_opaque;
+    uint8_t *p_tx_buf;          /* Data waiting for the UART (sent by the Event Loop) */
+    int tx_len;
+    int tx_size;
+} serial_port_t;
+
+int serial_init(serial_port_t *p_port);
+int serial_open(serial_port_t *p_port, char *p_device, int baudrate, int flow_control,
+        serial_callback_t *p_callback, void *p_opaque);
+int serial_close(serial_port_t *p_port);
+int serial_set_baudrate(serial_port_t *p_port, int baudrate, int flow_control);
+int serial_write(serial_port_t *p_port, uint8_t *p_data, int data_len);
+int serial_flush(serial_port_t *p_port, int timeout_ms);
+int wiced_ioctl(serial_port_t *p_port, wiced_ioctl_cmd_t op, wiced_ioctl_data_t *p_data);
 
 #endif /* WICED_SERIAL_H_ */
@@ -32,17 +32,19 @@
  */
 
 #include <stdlib.h>
-#include <pthread.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <time.h>
 
 #include "wiced.h"
 #include "utils.h"
 #include "hci.h"
 #include "protocol.h"
+#include "loop.h"
 
 /*
  * Group codes
@@ -70,6 +72,13 @@
 #define HCI_PLATFORM_COMMAND_EF_ERASE           ((HCI_PLATFORM_GROUP << 8) | 0x30)          /* Embedded Flash Erase */
 #define HCI_PLATFORM_COMMAND_EF_WRITE           ((HCI_PLATFORM_GROUP << 8) | 0x32)          /* Embedded Flash Write */
 #define HCI_PLATFORM_COMMAND_AUDIO_INSERT_EXT   ((HCI_PLATFORM_GROUP << 8) | 0x33)          /* Audio Insertion Extended Simulation */
+#define HCI_PLATFORM_COMMAND_NVRAM_STATS        ((HCI_PLATFORM_GROUP << 8) | 0x34)          /* NVRAM Access Statistics Read */
+#define HCI_PLATFORM_COMMAND_EF_CRC             ((HCI_PLATFORM_GROUP << 8) | 0x35)          /* Embedded Flash CRC32 */
+#define HCI_PLATFORM_COMMAND_HCI_RING_READ      ((HCI_PLATFORM_GROUP << 8) | 0x38)          /* HCI Ring Buffer Read */
+#define HCI_PLATFORM_COMMAND_MEMORY_TREND       ((HCI_PLATFORM_GROUP << 8) | 0x39)          /* Memory Trend Read */
+#define HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD   ((HCI_PLATFORM_GROUP << 8) | 0x3A)          /* Memory Monitor Thresholds */
+#define HCI_PLATFORM_COMMAND_HCI_RING_ENABLE    ((HCI_PLATFORM_GROUP << 8) | 0x3B)          /* HCI Ring Buffer Enable */
+#define HCI_PLATFORM_COMMAND_MEMORY_CAPTURE     ((HCI_PLATFORM_GROUP << 8) | 0x3C)          /* Memory Trend Capture */
 
 /*
  * Device Group Events
@@ -84,6 +93,10 @@
  * Platform (Customer specific) Group Events
  */
 #define HCI_PLATFORM_EVENT_VSC_CMD_CPLT         ((HCI_PLATFORM_GROUP << 8) | 0x25)          /* VSC Wrapper Command Complete event */
+#define HCI_PLATFORM_EVENT_NVRAM_STATS          ((HCI_PLATFORM_GROUP << 8) | 0x34)          /* NVRAM Access Statistics event */
+#define HCI_PLATFORM_EVENT_EF_CRC               ((HCI_PLATFORM_GROUP << 8) | 0x35)          /* Embedded Flash CRC32 event */
+#define HCI_PLATFORM_EVENT_HCI_RING_READ        ((HCI_PLATFORM_GROUP << 8) | 0x38)          /* HCI Ring Buffer event */
+#define HCI_PLATFORM_EVENT_MEMORY_TREND         ((HCI_PLATFORM_GROUP << 8) | 0x39)          /* Memory Trend event */
 #define HCI_PLATFORM_EVENT_COMMAND_STATUS       ((HCI_PLATFORM_GROUP << 8) | 0xFF)          /* Command status event for the requested operation */
 
 
@@ -92,15 +105,40 @@
 /* Embedded Flash Page Size */
 #define EF_PAGE_SIZE                            (4 * 1024)
 
+/* Embedded Flash Write size (per command) */
+#define EF_WRITE_SIZE                           512
+
+/* Maximum number of Embedded Flash commands sent without waiting for their status */
+#define EF_WRITE_WINDOW_MAX                     16
+
+/* Maximum time to wait for the status of a command (ms) */
+#define WICED_CMD_TIMEOUT                       2000
+
+/* Command Queue: maximum time to wait for a status (ms) */
+#define WICED_QUEUE_TIMEOUT                     2000
+
 typedef struct
 {
     int cmd_pending;
-    pthread_cond_t cond;
-    pthread_mutex_t mutex;
     uint8_t rx_data[WICED_DATA_SIZE_MAX];
     uint16_t rx_data_len;
+    int async_pending;      /* Number of commands waiting for their status (not waited for) */
+    int async_status;       /* First error reported by these commands */
 } wiced_cb_t;
 
+typedef int (wiced_queue_callback_t)(wiced_queue_t *p_queue, wiced_queue_cmd_t *p_cmd,
+        uint8_t *p_data, uint16_t length);
+
+struct wiced_queue_cmd
+{
+    wiced_queue_cmd_t *p_next;
+    uint16_t opcode;
+    uint16_t length;
+    wiced_queue_callback_t *p_callback;     /* Status handler (NULL for a 1 byte status) */
+    uint32_t param;
+    uint8_t data[];
+};
+
 /*
  * Local functions
  */
@@ -108,6 +146,23 @@ static int wiced_cmd_vsc_wrapper(uint16_t opcode, uint8_t *p_tx_param, uint16_t
         uint8_t *p_rx_param, uint16_t rx_param_len);
 static int wiced_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint16_t tx_length,
         uint8_t *p_rx_data, uint16_t rx_length);
+static int wiced_cmd_send_async(uint16_t opcode, uint8_t *p_tx_data, uint16_t tx_length,
+        int window);
+static int wiced_cmd_async_wait(int max_pending);
+static uint8_t *wiced_page_get(uint8_t *p_map, uint32_t file_len, uint32_t page_offset,
+        uint8_t *p_page_buf, uint32_t *p_page_len);
+static uint32_t wiced_crc32(const uint8_t *p_data, uint32_t length);
+static int wiced_queue_cmd_add(wiced_queue_t *p_queue, uint16_t opcode, uint8_t *p_data,
+        uint16_t length, wiced_queue_callback_t *p_callback, uint32_t param);
+static int wiced_queue_cmd_add_to_list(wiced_queue_list_t *p_list, uint16_t opcode,
+        uint8_t *p_data, uint16_t length, wiced_queue_callback_t *p_callback, uint32_t param);
+static wiced_queue_cmd_t *wiced_queue_list_pop(wiced_queue_list_t *p_list);
+static void wiced_queue_send(wiced_queue_t *p_queue);
+static int wiced_queue_flash_crc_callback(wiced_queue_t *p_queue, wiced_queue_cmd_t *p_cmd,
+        uint8_t *p_data, uint16_t length);
+static void wiced_queue_timeout(void *p_opaque);
+static int wiced_cmd_status_received(void *p_opaque);
+static int wiced_cmd_async_received(void *p_opaque);
 
 /*
  * Global variables
@@ -123,9 +178,6 @@ int wiced_init(void)
 
     memset(&wiced_cb, 0, sizeof(wiced_cb));
 
-    pthread_cond_init(&wiced_cb.cond, NULL);
-    pthread_mutex_init(&wiced_cb.mutex, NULL);
-
     return 0;
 }
 
@@ -140,7 +192,7 @@ int wiced_event_handler(uint16_t opcode, uint8_t *p_data, uint16_t length)
     {
     case HCI_CONTROL_EVENT_WICED_TRACE:
         handled = 1;
-        TRACE_INFO("WICED TRACE:%s", p_data);
+        TRACE_INFO("WICED TRACE:%.*s", length, p_data);
         break;
     case HCI_CONTROL_EVENT_HCI_TRACE:
         handled = 1;
@@ -152,19 +204,30 @@ int wiced_event_handler(uint16_t opcode, uint8_t *p_data, uint16_t length)
         TRACE_INFO("WICED DEVICE STARTED");
         break;
 
+    case HCI_PLATFORM_EVENT_COMMAND_STATUS:
+        /* Status of a command sent by wiced_cmd_send_async (the status are received in order) */
+        if (wiced_cb.async_pending > 0)
+        {
+            handled = 1;
+            wiced_cb.async_pending--;
+            if ((length >= 1) && (p_data[0] != 0) && (wiced_cb.async_status == 0))
+                wiced_cb.async_status = p_data[0];
+            break;
+        }
+        /* no break */
     case HCI_PLATFORM_EVENT_VSC_CMD_CPLT:
+    case HCI_PLATFORM_EVENT_NVRAM_STATS:
+    case HCI_PLATFORM_EVENT_EF_CRC:
+    case HCI_PLATFORM_EVENT_HCI_RING_READ:
+    case HCI_PLATFORM_EVENT_MEMORY_TREND:
     case HCI_CONTROL_EVENT_READ_BUFFER_STATS:
-    case HCI_PLATFORM_EVENT_COMMAND_STATUS:
     case HCI_CONTROL_EVENT_COMMAND_STATUS:
         handled = 1;
         TRACE_DBG("Wiced Device Cmd Status OpCode:0x%x", opcode);
         handled = 1;
         memcpy(wiced_cb.rx_data, p_data, length);
         wiced_cb.rx_data_len = length;
-        pthread_mutex_lock(&wiced_cb.mutex);
         wiced_cb.cmd_pending = 0;
-        pthread_cond_signal(&wiced_cb.cond);
-        pthread_mutex_unlock(&wiced_cb.mutex);
         break;
 
     default:
@@ -771,26 +834,292 @@ int wiced_cmd_emb_flash_write(uint32_t offset, uint8_t *p_data, uint32_t length)
     return (int)status;
 }
 
+/*
+ * wiced_cmd_emb_flash_crc
+ * Ask the device to read back an Embedded Flash area and to return its CRC32.
+ */
+int wiced_cmd_emb_flash_crc(uint32_t offset, uint32_t length, uint32_t *p_crc32)
+{
+    int status;
+    uint8_t tx_param[8];
+    uint8_t rx_param[1 + sizeof(uint32_t)];
+    uint8_t *p;
+
+    TRACE_DBG("CRC offset:0x%x len:%d", offset, length);
+
+    p = tx_param;
+    UINT32_TO_STREAM(p, offset);
+    UINT32_TO_STREAM(p, length);
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_EF_CRC, tx_param, p - tx_param,
+            rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    /* Older FW answer with a regular (1 byte) Command Status */
+    if (status != sizeof(rx_param))
+    {
+        TRACE_DBG("wrong length received (%d/%d)", status, (int)sizeof(rx_param));
+        return -1;
+    }
+    p = rx_param;
+    STREAM_TO_UINT8(status, p);
+    if (status != 0)
+    {
+        TRACE_ERR("failed hci_status:%d", status);
+        return (0 - status);
+    }
+    STREAM_TO_UINT32(*p_crc32, p);
+
+    return 0;
+}
+
+/*
+ * wiced_cmd_hci_ring_read
+ * Read one of the HCI Ring Buffers of the device. Returns the event length (see
+ * app_hci_ring.c for its format).
+ */
+int wiced_cmd_hci_ring_read(uint8_t ring_id, uint8_t *p_data, uint16_t max_length)
+{
+    int status;
+    uint8_t tx_param[1];
+    uint8_t *p;
+
+    TRACE_DBG("ring_id:%d", ring_id);
+
+    p = tx_param;
+    UINT8_TO_STREAM(p, ring_id);
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_HCI_RING_READ, tx_param, p - tx_param,
+            p_data, max_length);
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    /* Older FW answer with a regular (1 byte) Command Status */
+    if (status < 4)
+    {
+        TRACE_ERR("wrong length received (%d)", status);
+        return -1;
+    }
+
+    return status;
+}
+
+/*
+ * wiced_cmd_hci_ring_enable
+ */
+int wiced_cmd_hci_ring_enable(uint8_t enable)
+{
+    int status;
+    uint8_t tx_param[1];
+    uint8_t rx_param[1];
+    uint8_t *p;
+
+    TRACE_DBG("enable:%d", enable);
+
+    p = tx_param;
+    UINT8_TO_STREAM(p, enable);
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_HCI_RING_ENABLE, tx_param,
+            p - tx_param, rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    if (status != sizeof(rx_param))
+    {
+        TRACE_ERR("wrong length received (%d/%d)", status, (int)sizeof(rx_param));
+        return -1;
+    }
+    p = rx_param;
+    STREAM_TO_UINT8(status, p);
+    if (status != 0)
+    {
+        TRACE_ERR("failed hci_status:%d", status);
+        return (0 - status);
+    }
+
+    return 0;
+}
+
+/*
+ * wiced_cmd_memory_trend_read
+ * Read the Memory (Buffer Pools and Heap) Trend of the device. Returns the event length (see
+ * app_memory.c for its format).
+ */
+int wiced_cmd_memory_trend_read(uint8_t *p_data, uint16_t max_length)
+{
+    int status;
+
+    TRACE_DBG("");
+
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_MEMORY_TREND, NULL, 0,
+            p_data, max_length);
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    /* A regular (1 byte) Command Status is received if the command failed */
+    if (status < (1 + 4 + 1 + 1))
+    {
+        TRACE_ERR("wrong length received (%d)", status);
+        return -1;
+    }
+
+    return status;
+}
+
+/*
+ * wiced_cmd_nvram_stats_read
+ * Read the NVRAM access statistics of the device. Returns the event length (see
+ * platform_nvram_stats_send for its format).
+ */
+int wiced_cmd_nvram_stats_read(uint8_t *p_data, uint16_t max_length)
+{
+    int status;
+
+    TRACE_DBG("");
+
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_NVRAM_STATS, NULL, 0,
+            p_data, max_length);
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    /* Nb Entries followed by 12 bytes per entry */
+    if ((status < 1) || (status != (1 + p_data[0] * 6 * 2)))
+    {
+        TRACE_ERR("wrong length received (%d)", status);
+        return -1;
+    }
+
+    return status;
+}
+
+/*
+ * wiced_cmd_memory_capture
+ */
+int wiced_cmd_memory_capture(uint8_t enable)
+{
+    int status;
+    uint8_t tx_param[1];
+    uint8_t rx_param[1];
+    uint8_t *p;
+
+    TRACE_DBG("enable:%d", enable);
+
+    p = tx_param;
+    UINT8_TO_STREAM(p, enable);
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_MEMORY_CAPTURE, tx_param,
+            p - tx_param, rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    if (status != sizeof(rx_param))
+    {
+        TRACE_ERR("wrong length received (%d/%d)", status, (int)sizeof(rx_param));
+        return -1;
+    }
+    p = rx_param;
+    STREAM_TO_UINT8(status, p);
+    if (status != 0)
+    {
+        TRACE_ERR("failed hci_status:%d", status);
+        return (0 - status);
+    }
+
+    return 0;
+}
+
+/*
+ * wiced_cmd_memory_threshold_set
+ */
+int wiced_cmd_memory_threshold_set(uint8_t pool_threshold, uint32_t heap_threshold)
+{
+    int status;
+    uint8_t tx_param[1 + 4];
+    uint8_t rx_param[1];
+    uint8_t *p;
+
+    TRACE_DBG("pool_threshold:%d%% heap_threshold:%d", pool_threshold, heap_threshold);
+
+    p = tx_param;
+    UINT8_TO_STREAM(p, pool_threshold);
+    UINT32_TO_STREAM(p, heap_threshold);
+    status = wiced_cmd_send_receive(HCI_PLATFORM_COMMAND_MEMORY_THRESHOLD, tx_param,
+            p - tx_param, rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+    {
+        TRACE_ERR("wiced_cmd_send_receive failed");
+        return status;
+    }
+
+    if (status != sizeof(rx_param))
+    {
+        TRACE_ERR("wrong length received (%d/%d)", status, (int)sizeof(rx_param));
+        return -1;
+    }
+    p = rx_param;
+    STREAM_TO_UINT8(status, p);
+    if (status != 0)
+    {
+        TRACE_ERR("failed hci_status:%d", status);
+        return (0 - status);
+    }
+
+    return 0;
+}
+
 /*
  * wiced_cmd_write_binary_file_to_flash
+ * The file is written page per page. The pages already containing the right data (checked
+ * with the CRC32 read back by the device) are skipped. The Erase and Write commands of the
+ * other pages are pipelined: up to 'window' commands are sent without waiting for their status.
  */
-int wiced_cmd_write_binary_file_to_flash(char *p_bin_file, uint32_t offset)
+int wiced_cmd_write_binary_file_to_flash(char *p_bin_file, uint32_t offset, int window)
 {
     int status;
     int file_desc;
-    uint8_t *p_buffer, *p;
-    uint32_t size;
+    uint8_t *p_map, *p_page, *p;
+    uint8_t page_buf[EF_PAGE_SIZE];
+    uint8_t tx_param[4 + EF_WRITE_SIZE];
+    uint8_t *p_skip;
     struct stat file_stat;
-    int file_len;
-    int aligned_file_len;
-    ssize_t read_size;
+    struct timespec ts_start, ts_end;
+    uint32_t file_len;
+    uint32_t aligned_file_len;
+    uint32_t page_offset;
+    uint32_t page_len;
+    uint32_t write_offset;
     uint32_t write_len;
+    uint32_t crc32;
+    uint32_t nb_pages, page, nb_skipped;
+    int crc_supported;
+    double duration;
 
-    TRACE_DBG("file:%s offset:0x%x", p_bin_file, offset);
+    TRACE_DBG("file:%s offset:0x%x window:%d", p_bin_file, offset, window);
 
     if (offset & (EF_PAGE_SIZE - 1))
     {
-        fprintf(stderr, "offset:0x%x must be multiple of EF_PAGE_SIZE (4K)\n");
+        fprintf(stderr, "offset:0x%x must be multiple of EF_PAGE_SIZE (4K)\n", offset);
+        return -1;
+    }
+
+    if ((window < 1) || (window > EF_WRITE_WINDOW_MAX))
+    {
+        fprintf(stderr, "window:%d must be in [1..%d]\n", window, EF_WRITE_WINDOW_MAX);
         return -1;
     }
 
@@ -801,96 +1130,714 @@ int wiced_cmd_write_binary_file_to_flash(char *p_bin_file, uint32_t offset)
         return file_desc;
     }
 
-    status = stat(p_bin_file, &file_stat);
+    status = fstat(file_desc, &file_stat);
     if (status < 0)
     {
         TRACE_ERR("Cannot stat %s file", p_bin_file);
+        close(file_desc);
         return status;
     }
 
     file_len = file_stat.st_size;
     TRACE_DBG("file size:%d", file_len);
+    if (file_len == 0)
+    {
+        close(file_desc);
+        return 0;
+    }
 
     aligned_file_len = file_len + 3;
     aligned_file_len &= ~0x3;
     TRACE_DBG("32 bits 'aligned' file size:%d", aligned_file_len);
 
-    p_buffer = malloc(aligned_file_len);
-    if (p_buffer == NULL)
+    p_map = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, file_desc, 0);
+    close(file_desc);
+    if (p_map == MAP_FAILED)
     {
-        TRACE_ERR("Cannot allocate %d bytes", aligned_file_len);
+        TRACE_ERR("Cannot map %s file", p_bin_file);
         return -1;
     }
-    memset(p_buffer, 0, aligned_file_len);
 
-    read_size = read(file_desc, p_buffer, file_len);
-    if (read_size != file_len)
+    nb_pages = (aligned_file_len + EF_PAGE_SIZE - 1) / EF_PAGE_SIZE;
+    p_skip = calloc(nb_pages, 1);
+    if (p_skip == NULL)
     {
-        TRACE_ERR("Cannot read %s file", p_bin_file);
+        TRACE_ERR("Cannot allocate %d bytes", nb_pages);
+        munmap(p_map, file_len);
         return -1;
     }
 
-    p = p_buffer;
-    while(aligned_file_len)
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    /* First, find the pages which already contain the right data */
+    crc_supported = 1;
+    nb_skipped = 0;
+    for (page = 0; (page < nb_pages) && crc_supported; page++)
     {
-        if ((offset % EF_PAGE_SIZE) == 0)
+        page_offset = page * EF_PAGE_SIZE;
+        p_page = wiced_page_get(p_map, file_len, page_offset, page_buf, &page_len);
+
+        status = wiced_cmd_emb_flash_crc(offset + page_offset, page_len, &crc32);
+        if (status < 0)
         {
-            status = wiced_cmd_emb_flash_erase(offset, EF_PAGE_SIZE);
-            if (status < 0)
+            if (page != 0)
             {
-                TRACE_ERR("Cannot erase flash offset:%x length:%d", offset, EF_PAGE_SIZE);
-                return status;
+                TRACE_ERR("Cannot read flash CRC offset:%x length:%d", offset + page_offset,
+                        page_len);
+                goto write_binary_file_exit;
             }
+            TRACE_INFO("Flash CRC not supported by the device. Write all the pages");
+            crc_supported = 0;
+            break;
         }
-        if (aligned_file_len > 512)
-            write_len = 512;
-        else
-            write_len = aligned_file_len;
+        if (crc32 == wiced_crc32(p_page, page_len))
+        {
+            p_skip[page] = 1;
+            nb_skipped++;
+        }
+    }
+
+    /* Then, Erase and Write the other pages */
+    for (page = 0; page < nb_pages; page++)
+    {
+        if (p_skip[page])
+            continue;
+
+        page_offset = page * EF_PAGE_SIZE;
+        p_page = wiced_page_get(p_map, file_len, page_offset, page_buf, &page_len);
 
-        status = wiced_cmd_emb_flash_write(offset, p, write_len);
+        p = tx_param;
+        UINT32_TO_STREAM(p, offset + page_offset);
+        UINT32_TO_STREAM(p, EF_PAGE_SIZE);
+        status = wiced_cmd_send_async(HCI_PLATFORM_COMMAND_EF_ERASE, tx_param, p - tx_param,
+                window);
         if (status < 0)
         {
-            TRACE_ERR("Cannot write flash offset:%x length:%d", offset, write_len);
-            return status;
+            TRACE_ERR("Cannot erase flash offset:%x length:%d", offset + page_offset,
+                    EF_PAGE_SIZE);
+            goto write_binary_file_exit;
         }
 
+        for (write_offset = 0; write_offset < page_len; write_offset += write_len)
+        {
+            write_len = page_len - write_offset;
+            if (write_len > EF_WRITE_SIZE)
+                write_len = EF_WRITE_SIZE;
+
+            p = tx_param;
+            UINT32_TO_STREAM(p, offset + page_offset + write_offset);
+            memcpy(p, p_page + write_offset, write_len);
+            p += write_len;
+            status = wiced_cmd_send_async(HCI_PLATFORM_COMMAND_EF_WRITE, tx_param, p - tx_param,
+                    window);
+            if (status < 0)
+            {
+                TRACE_ERR("Cannot write flash offset:%x length:%d",
+                        offset + page_offset + write_offset, write_len);
+                goto write_binary_file_exit;
+            }
+        }
+    }
 
-        offset += write_len;
-        p += write_len;
-        aligned_file_len -= write_len;
+    /* Wait for the status of the last commands */
+    status = wiced_cmd_async_wait(0);
+    if (status < 0)
+    {
+        TRACE_ERR("Cannot write flash");
+        goto write_binary_file_exit;
     }
-    free(p_buffer);
 
-    return 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    duration = (double)(ts_end.tv_sec - ts_start.tv_sec) +
+            (double)(ts_end.tv_nsec - ts_start.tv_nsec) / 1000000000.0;
+    printf("Wrote %d bytes (%d/%d pages skipped) in %.2f s: %.3f MB/s\n", file_len,
+            nb_skipped, nb_pages, duration,
+            (duration > 0) ? (double)file_len / (duration * 1024 * 1024) : 0);
+
+write_binary_file_exit:
+    free(p_skip);
+    munmap(p_map, file_len);
+
+    return status;
 }
 
 /*
- * wiced_cmd_send_receive
+ * wiced_queue_init
  */
-static int wiced_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint16_t tx_length,
-        uint8_t *p_rx_data, uint16_t rx_length)
+int wiced_queue_init(wiced_queue_t *p_queue, protocol_conn_t *p_conn, int window)
 {
-    int status;
-    int cpy_len;
-    struct timespec ts;
-
-    TRACE_DBG("opcode:0x%04x tl:%d rl:%d", opcode, tx_length, rx_length);
+    TRACE_DBG("window:%d", window);
 
-    if (wiced_cb.cmd_pending)
+    if ((window < 1) || (window > EF_WRITE_WINDOW_MAX))
     {
-        TRACE_ERR("Wiced Cmd pending");
+        TRACE_ERR("window:%d must be in [1..%d]", window, EF_WRITE_WINDOW_MAX);
         return -1;
     }
 
-    if (p_rx_data != NULL)
-    {
-        wiced_cb.cmd_pending = 1;
-    }
+    memset(p_queue, 0, sizeof(*p_queue));
+    p_queue->p_conn = p_conn;
+    p_queue->window = window;
 
-    wiced_cb.rx_data_len = 0;
+    return 0;
+}
 
-    /* Send the HCI command */
-    status = protocol_send(PROTOCOL_TYPE_WICED, opcode, p_tx_data, tx_length);
+/*
+ * wiced_queue_free
+ */
+void wiced_queue_free(wiced_queue_t *p_queue)
+{
+    wiced_queue_cmd_t *p_cmd;
+
+    loop_timer_stop(&p_queue->timer);
+
+    while ((p_cmd = wiced_queue_list_pop(&p_queue->in_flight)) != NULL)
+        free(p_cmd);
+    while ((p_cmd = wiced_queue_list_pop(&p_queue->pending)) != NULL)
+        free(p_cmd);
+    p_queue->nb_in_flight = 0;
+
+    if (p_queue->p_flash_map != NULL)
+    {
+        munmap(p_queue->p_flash_map, p_queue->flash_file_len);
+        p_queue->p_flash_map = NULL;
+    }
+}
+
+/*
+ * wiced_queue_nvram_write
+ */
+int wiced_queue_nvram_write(wiced_queue_t *p_queue, uint16_t nvram_id, uint8_t *p_data,
+        uint16_t length)
+{
+    uint8_t tx_param[WICED_DATA_SIZE_MAX];
+    uint8_t *p;
+
+    TRACE_DBG("nvram_id:0x%04x length:%d", nvram_id, length);
+
+    if (length > (sizeof(tx_param) - sizeof(uint16_t)))
+    {
+        TRACE_ERR("NVRAM data too big (%d)", length);
+        return -1;
+    }
+
+    p = tx_param;
+    UINT16_TO_STREAM(p, nvram_id);
+    memcpy(p, p_data, length);
+    p += length;
+
+    return wiced_queue_cmd_add(p_queue, HCI_CONTROL_COMMAND_PUSH_NVRAM_DATA, tx_param,
+            p - tx_param, NULL, 0);
+}
+
+/*
+ * wiced_queue_platform_lrac_trace_level_set
+ */
+int wiced_queue_platform_lrac_trace_level_set(wiced_queue_t *p_queue, uint8_t trace_level)
+{
+    uint8_t tx_param[1];
+    uint8_t *p;
+
+    TRACE_DBG("trace_level:%d", trace_level);
+
+    p = tx_param;
+    UINT8_TO_STREAM(p, trace_level);
+
+    return wiced_queue_cmd_add(p_queue, HCI_PLATFORM_COMMAND_LRAC_TRACE_LEVEL, tx_param,
+            p - tx_param, NULL, 0);
+}
+
+/*
+ * wiced_queue_reset
+ */
+int wiced_queue_reset(wiced_queue_t *p_queue)
+{
+    TRACE_DBG("");
+
+    return wiced_queue_cmd_add(p_queue, HCI_CONTROL_COMMAND_RESET, NULL, 0, NULL, 0);
+}
+
+/*
+ * wiced_queue_write_binary_file_to_flash
+ * A CRC command is queued for every page. The Erase and Write commands of a page are queued
+ * when its CRC does not match (see wiced_queue_flash_crc_callback).
+ */
+int wiced_queue_write_binary_file_to_flash(wiced_queue_t *p_queue, char *p_bin_file,
+        uint32_t offset)
+{
+    int status;
+    int file_desc;
+    struct stat file_stat;
+    uint32_t page;
+    uint32_t page_len;
+    uint8_t page_buf[EF_PAGE_SIZE];
+    uint8_t tx_param[8];
+    uint8_t *p;
+
+    TRACE_DBG("file:%s offset:0x%x", p_bin_file, offset);
+
+    if (offset & (EF_PAGE_SIZE - 1))
+    {
+        fprintf(stderr, "offset:0x%x must be multiple of EF_PAGE_SIZE (4K)\n", offset);
+        return -1;
+    }
+
+    if (p_queue->p_flash_map != NULL)
+    {
+        TRACE_ERR("a Binary File is already queued");
+        return -1;
+    }
+
+    file_desc = open(p_bin_file, O_RDONLY);
+    if (file_desc < 0)
+    {
+        TRACE_ERR("Cannot open %s file", p_bin_file);
+        return file_desc;
+    }
+
+    status = fstat(file_desc, &file_stat);
+    if ((status < 0) || (file_stat.st_size == 0))
+    {
+        TRACE_ERR("Cannot stat %s file (or empty file)", p_bin_file);
+        close(file_desc);
+        return -1;
+    }
+
+    p_queue->p_flash_map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, file_desc, 0);
+    close(file_desc);
+    if (p_queue->p_flash_map == MAP_FAILED)
+    {
+        TRACE_ERR("Cannot map %s file", p_bin_file);
+        p_queue->p_flash_map = NULL;
+        return -1;
+    }
+
+    p_queue->flash_file_len = file_stat.st_size;
+    p_queue->flash_offset = offset;
+    p_queue->flash_nb_pages = (((p_queue->flash_file_len + 3) & ~0x3) + EF_PAGE_SIZE - 1) /
+            EF_PAGE_SIZE;
+    p_queue->flash_nb_skipped = 0;
+
+    for (page = 0; page < p_queue->flash_nb_pages; page++)
+    {
+        wiced_page_get(p_queue->p_flash_map, p_queue->flash_file_len, page * EF_PAGE_SIZE,
+                page_buf, &page_len);
+
+        p = tx_param;
+        UINT32_TO_STREAM(p, offset + page * EF_PAGE_SIZE);
+        UINT32_TO_STREAM(p, page_len);
+        status = wiced_queue_cmd_add(p_queue, HCI_PLATFORM_COMMAND_EF_CRC, tx_param,
+                p - tx_param, wiced_queue_flash_crc_callback, page);
+        if (status < 0)
+            return status;
+    }
+
+    return 0;
+}
+
+/*
+ * wiced_queue_start
+ */
+int wiced_queue_start(wiced_queue_t *p_queue)
+{
+    TRACE_DBG("");
+
+    wiced_queue_send(p_queue);
+
+    return p_queue->status;
+}
+
+/*
+ * wiced_queue_event_handler
+ */
+int wiced_queue_event_handler(wiced_queue_t *p_queue, uint16_t opcode, uint8_t *p_data,
+        uint16_t length)
+{
+    wiced_queue_cmd_t *p_cmd;
+    int status;
+
+    switch(opcode)
+    {
+    case HCI_PLATFORM_EVENT_COMMAND_STATUS:
+    case HCI_CONTROL_EVENT_COMMAND_STATUS:
+    case HCI_PLATFORM_EVENT_EF_CRC:
+        break;
+
+    default:
+        return 0;
+    }
+
+    p_cmd = wiced_queue_list_pop(&p_queue->in_flight);
+    if (p_cmd == NULL)
+    {
+        TRACE_ERR("Unexpected status OpCode:0x%x", opcode);
+        return 1;
+    }
+    p_queue->nb_in_flight--;
+
+    TRACE_DBG("Wiced Cmd OpCode:0x%04x Status OpCode:0x%x", p_cmd->opcode, opcode);
+
+    if (p_queue->status == 0)
+    {
+        if (p_cmd->p_callback != NULL)
+        {
+            status = p_cmd->p_callback(p_queue, p_cmd, p_data, length);
+        }
+        else if ((length < 1) || (p_data[0] != 0))
+        {
+            status = (length < 1) ? -1 : (0 - p_data[0]);
+        }
+        else
+        {
+            status = 0;
+        }
+
+        if (status < 0)
+        {
+            TRACE_ERR("Wiced Cmd OpCode:0x%04x failed:%d", p_cmd->opcode, status);
+            p_queue->status = status;
+        }
+    }
+    free(p_cmd);
+
+    wiced_queue_send(p_queue);
+
+    /* Restart the timeout for the next status */
+    if ((p_queue->status == 0) && (p_queue->nb_in_flight > 0))
+        loop_timer_start(&p_queue->timer, WICED_QUEUE_TIMEOUT, wiced_queue_timeout, p_queue);
+    else
+        loop_timer_stop(&p_queue->timer);
+
+    return 1;
+}
+
+/*
+ * wiced_queue_busy
+ */
+int wiced_queue_busy(wiced_queue_t *p_queue)
+{
+    if (p_queue->status != 0)
+        return 0;
+
+    return ((p_queue->nb_in_flight != 0) || (p_queue->pending.p_first != NULL));
+}
+
+/*
+ * wiced_queue_timeout
+ * No status received in time
+ */
+static void wiced_queue_timeout(void *p_opaque)
+{
+    wiced_queue_t *p_queue = p_opaque;
+
+    TRACE_ERR("Command timeout (%d pending)", p_queue->nb_in_flight);
+    if (p_queue->status == 0)
+        p_queue->status = -1;
+}
+
+/*
+ * wiced_queue_cmd_add
+ * Allocate a command and add it at the end of the pending list
+ */
+static int wiced_queue_cmd_add(wiced_queue_t *p_queue, uint16_t opcode, uint8_t *p_data,
+        uint16_t length, wiced_queue_callback_t *p_callback, uint32_t param)
+{
+    return wiced_queue_cmd_add_to_list(&p_queue->pending, opcode, p_data, length, p_callback,
+            param);
+}
+
+/*
+ * wiced_queue_cmd_add_to_list
+ */
+static int wiced_queue_cmd_add_to_list(wiced_queue_list_t *p_list, uint16_t opcode,
+        uint8_t *p_data, uint16_t length, wiced_queue_callback_t *p_callback, uint32_t param)
+{
+    wiced_queue_cmd_t *p_cmd;
+
+    p_cmd = malloc(sizeof(*p_cmd) + length);
+    if (p_cmd == NULL)
+    {
+        TRACE_ERR("Cannot allocate %d bytes", (int)sizeof(*p_cmd) + length);
+        return -1;
+    }
+    p_cmd->p_next = NULL;
+    p_cmd->opcode = opcode;
+    p_cmd->length = length;
+    p_cmd->p_callback = p_callback;
+    p_cmd->param = param;
+    if (length)
+        memcpy(p_cmd->data, p_data, length);
+
+    if (p_list->p_last)
+        p_list->p_last->p_next = p_cmd;
+    else
+        p_list->p_first = p_cmd;
+    p_list->p_last = p_cmd;
+
+    return 0;
+}
+
+/*
+ * wiced_queue_list_pop
+ */
+static wiced_queue_cmd_t *wiced_queue_list_pop(wiced_queue_list_t *p_list)
+{
+    wiced_queue_cmd_t *p_cmd;
+
+    p_cmd = p_list->p_first;
+    if (p_cmd != NULL)
+    {
+        p_list->p_first = p_cmd->p_next;
+        if (p_list->p_first == NULL)
+            p_list->p_last = NULL;
+        p_cmd->p_next = NULL;
+    }
+    return p_cmd;
+}
+
+/*
+ * wiced_queue_send
+ * Send the pending commands (up to 'window' commands waiting for their status)
+ */
+static void wiced_queue_send(wiced_queue_t *p_queue)
+{
+    wiced_queue_cmd_t *p_cmd;
+    int status;
+
+    while ((p_queue->status == 0) &&
+           (p_queue->nb_in_flight < p_queue->window) &&
+           (p_queue->pending.p_first != NULL))
+    {
+        p_cmd = wiced_queue_list_pop(&p_queue->pending);
+
+        status = protocol_conn_send(p_queue->p_conn, PROTOCOL_TYPE_WICED, p_cmd->opcode,
+                p_cmd->data, p_cmd->length);
+        if (status < 0)
+        {
+            TRACE_ERR("protocol_conn_send failed");
+            free(p_cmd);
+            p_queue->status = status;
+            break;
+        }
+
+        if (p_queue->nb_in_flight == 0)
+            loop_timer_start(&p_queue->timer, WICED_QUEUE_TIMEOUT, wiced_queue_timeout, p_queue);
+
+        if (p_queue->in_flight.p_last)
+            p_queue->in_flight.p_last->p_next = p_cmd;
+        else
+            p_queue->in_flight.p_first = p_cmd;
+        p_queue->in_flight.p_last = p_cmd;
+        p_queue->nb_in_flight++;
+    }
+}
+
+/*
+ * wiced_queue_flash_crc_callback
+ * If the page does not contain the right data, queue its Erase and Write commands (before the
+ * other pending commands).
+ */
+static int wiced_queue_flash_crc_callback(wiced_queue_t *p_queue, wiced_queue_cmd_t *p_cmd,
+        uint8_t *p_data, uint16_t length)
+{
+    wiced_queue_list_t page_list = { NULL, NULL };
+    uint8_t page_buf[EF_PAGE_SIZE];
+    uint8_t tx_param[4 + EF_WRITE_SIZE];
+    uint8_t *p_page, *p;
+    uint32_t page_offset;
+    uint32_t page_len;
+    uint32_t write_offset;
+    uint32_t write_len;
+    uint32_t crc32;
+    int status;
+
+    page_offset = p_cmd->param * EF_PAGE_SIZE;
+    p_page = wiced_page_get(p_queue->p_flash_map, p_queue->flash_file_len, page_offset,
+            page_buf, &page_len);
+
+    /* Older FW answer with a regular (1 byte) Command Status */
+    if ((length == (1 + sizeof(uint32_t))) && (p_data[0] == 0))
+    {
+        p = &p_data[1];
+        STREAM_TO_UINT32(crc32, p);
+        if (crc32 == wiced_crc32(p_page, page_len))
+        {
+            p_queue->flash_nb_skipped++;
+            return 0;
+        }
+    }
+
+    p = tx_param;
+    UINT32_TO_STREAM(p, p_queue->flash_offset + page_offset);
+    UINT32_TO_STREAM(p, EF_PAGE_SIZE);
+    status = wiced_queue_cmd_add_to_list(&page_list, HCI_PLATFORM_COMMAND_EF_ERASE, tx_param,
+            p - tx_param, NULL, 0);
+
+    for (write_offset = 0; (write_offset < page_len) && (status == 0); write_offset += write_len)
+    {
+        write_len = page_len - write_offset;
+        if (write_len > EF_WRITE_SIZE)
+            write_len = EF_WRITE_SIZE;
+
+        p = tx_param;
+        UINT32_TO_STREAM(p, p_queue->flash_offset + page_offset + write_offset);
+        memcpy(p, p_page + write_offset, write_len);
+        p += write_len;
+        status = wiced_queue_cmd_add_to_list(&page_list, HCI_PLATFORM_COMMAND_EF_WRITE, tx_param,
+                p - tx_param, NULL, 0);
+    }
+
+    if (page_list.p_first != NULL)
+    {
+        page_list.p_last->p_next = p_queue->pending.p_first;
+        p_queue->pending.p_first = page_list.p_first;
+        if (p_queue->pending.p_last == NULL)
+            p_queue->pending.p_last = page_list.p_last;
+    }
+
+    return status;
+}
+
+/*
+ * wiced_page_get
+ * Return a pointer on a page of the mapped file. The last (partial) page is copied and padded
+ * with zeros up to the next 32 bits boundary.
+ */
+static uint8_t *wiced_page_get(uint8_t *p_map, uint32_t file_len, uint32_t page_offset,
+        uint8_t *p_page_buf, uint32_t *p_page_len)
+{
+    uint32_t len;
+
+    len = file_len - page_offset;
+    if (len >= EF_PAGE_SIZE)
+    {
+        *p_page_len = EF_PAGE_SIZE;
+        return p_map + page_offset;
+    }
+
+    memset(p_page_buf, 0, EF_PAGE_SIZE);
+    memcpy(p_page_buf, p_map + page_offset, len);
+    *p_page_len = (len + 3) & ~0x3;
+    return p_page_buf;
+}
+
+/*
+ * wiced_crc32
+ * CRC32 (IEEE 802.3, reflected) as computed by the device.
+ */
+static uint32_t wiced_crc32(const uint8_t *p_data, uint32_t length)
+{
+    uint32_t crc32 = 0xFFFFFFFF;
+    int bit;
+
+    while (length--)
+    {
+        crc32 ^= *p_data++;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc32 = (crc32 >> 1) ^ (0xEDB88320 & (0 - (crc32 & 1)));
+        }
+    }
+    return crc32 ^ 0xFFFFFFFF;
+}
+
+/*
+ * wiced_cmd_send_async
+ * Send a command without waiting for its status. If 'window' commands are already waiting for
+ * their status, wait for the oldest one first.
+ */
+static int wiced_cmd_send_async(uint16_t opcode, uint8_t *p_tx_data, uint16_t tx_length,
+        int window)
+{
+    int status;
+
+    TRACE_DBG("opcode:0x%04x tl:%d", opcode, tx_length);
+
+    status = wiced_cmd_async_wait(window - 1);
+    if (status < 0)
+        return status;
+
+    wiced_cb.async_pending++;
+
+    status = protocol_send(PROTOCOL_TYPE_WICED, opcode, p_tx_data, tx_length);
+    if (status < 0)
+    {
+        TRACE_ERR("protocol_send failed");
+        wiced_cb.async_pending--;
+        return status;
+    }
+    return 0;
+}
+
+/*
+ * wiced_cmd_async_wait
+ * Wait until at most 'max_pending' commands are waiting for their status. Return the first
+ * error reported by the asynchronous commands (if any).
+ */
+static int wiced_cmd_async_wait(int max_pending)
+{
+    int status = 0;
+    int async_pending;
+
+    while ((wiced_cb.async_pending > max_pending) && (status == 0))
+    {
+        /* The timeout is restarted every time a status is received */
+        async_pending = wiced_cb.async_pending;
+        status = loop_run_until(wiced_cmd_async_received, &async_pending, WICED_CMD_TIMEOUT);
+    }
+    if (status != 0)
+    {
+        TRACE_ERR("Command timeout (%d pending)", wiced_cb.async_pending);
+        wiced_cb.async_pending = 0;
+        status = -1;
+    }
+    else if (wiced_cb.async_status != 0)
+    {
+        TRACE_ERR("failed hci_status:%d", wiced_cb.async_status);
+        status = 0 - wiced_cb.async_status;
+        wiced_cb.async_status = 0;
+        wiced_cb.async_pending = 0;
+    }
+
+    return status;
+}
+
+/*
+ * wiced_cmd_async_received
+ * At least one status received since the wait started
+ */
+static int wiced_cmd_async_received(void *p_opaque)
+{
+    int *p_async_pending = p_opaque;
+
+    return (wiced_cb.async_pending < *p_async_pending);
+}
+
+/*
+ * wiced_cmd_send_receive
+ */
+static int wiced_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint16_t tx_length,
+        uint8_t *p_rx_data, uint16_t rx_length)
+{
+    int status;
+    int cpy_len;
+
+    TRACE_DBG("opcode:0x%04x tl:%d rl:%d", opcode, tx_length, rx_length);
+
+    if (wiced_cb.cmd_pending)
+    {
+        TRACE_ERR("Wiced Cmd pending");
+        return -1;
+    }
+
+    if (p_rx_data != NULL)
+    {
+        wiced_cb.cmd_pending = 1;
+    }
+
+    wiced_cb.rx_data_len = 0;
+
+    /* Send the HCI command */
+    status = protocol_send(PROTOCOL_TYPE_WICED, opcode, p_tx_data, tx_length);
     if (status < 0)
     {
         TRACE_ERR("protocol_send failed");
@@ -900,15 +1847,8 @@ static int wiced_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint16_t
 
     if (p_rx_data != NULL)
     {
-        pthread_mutex_lock(&wiced_cb.mutex);
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += 2;
-        status = 0;
-        while (wiced_cb.cmd_pending && (status == 0))
-        {
-            status = pthread_cond_timedwait(&wiced_cb.cond, &wiced_cb.mutex, &ts);
-        }
-        pthread_mutex_unlock(&wiced_cb.mutex);
+        /* Handle the received data until the status is received */
+        status = loop_run_until(wiced_cmd_status_received, NULL, WICED_CMD_TIMEOUT);
         if (status != 0)
         {
             TRACE_ERR("Command timeout");
@@ -928,9 +1868,13 @@ static int wiced_cmd_send_receive(uint16_t opcode, uint8_t *p_tx_data, uint16_t
             status = wiced_cb.rx_data_len;
         }
     }
-    else
-    {
-        utils_msleep(100);
-    }
     return status;
 }
+
+/*
+ * wiced_cmd_status_received
+ */
+static int wiced_cmd_status_received(void *p_opaque)
+{
+    return (wiced_cb.cmd_pending == 0);
+}
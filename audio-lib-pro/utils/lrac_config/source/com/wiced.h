@@ -35,6 +35,9 @@
 
 #include <stdint.h>
 
+#include "protocol.h"
+#include "loop.h"
+
 typedef struct
 {
     uint8_t     pool_id;                    /**< pool id */
@@ -44,6 +47,37 @@ typedef struct
     uint16_t    total_count;                /**< total number of buffers */
 } wiced_bt_buffer_statistics_t;
 
+/*
+ * Command Queue.
+ * The commands of a Queue are sent on a connection (see protocol_conn_open) without blocking.
+ * Up to 'window' commands are sent without waiting for their status (the status are received
+ * in order). The Queue stops at the first command which fails.
+ */
+typedef struct wiced_queue_cmd wiced_queue_cmd_t;
+
+typedef struct
+{
+    wiced_queue_cmd_t *p_first;
+    wiced_queue_cmd_t *p_last;
+} wiced_queue_list_t;
+
+typedef struct
+{
+    protocol_conn_t *p_conn;
+    int window;
+    wiced_queue_list_t in_flight;       /* Commands waiting for their status */
+    int nb_in_flight;
+    wiced_queue_list_t pending;         /* Commands not sent yet */
+    int status;                         /* 0 or first error */
+    loop_timer_t timer;                 /* Status timeout (restarted at every status) */
+    /* Binary File to Flash */
+    uint8_t *p_flash_map;
+    uint32_t flash_file_len;
+    uint32_t flash_offset;
+    uint32_t flash_nb_pages;
+    uint32_t flash_nb_skipped;
+} wiced_queue_t;
+
 /*
  * wiced_init
  */
@@ -114,7 +148,98 @@ int wiced_cmd_jitter_buffer_target_set(uint8_t jitter_buffer_target);
  */
 int wiced_cmd_elna_gain_set(int8_t elna_gain);
 
+/*
+ * wiced_cmd_hci_ring_read
+ * Read an HCI Ring Buffer (0: current, 1: before the last reset). Returns the event length.
+ */
+int wiced_cmd_hci_ring_read(uint8_t ring_id, uint8_t *p_data, uint16_t max_length);
+
+/*
+ * wiced_cmd_hci_ring_enable
+ * Enable (1) or disable (0) the HCI Ring Buffer of the device (FW built with HCI_RING=1)
+ */
+int wiced_cmd_hci_ring_enable(uint8_t enable);
+
+/*
+ * wiced_cmd_memory_trend_read
+ * Read the Memory (Buffer Pools and Heap) Trend. Returns the event length.
+ */
+int wiced_cmd_memory_trend_read(uint8_t *p_data, uint16_t max_length);
+
+/*
+ * wiced_cmd_nvram_stats_read
+ * Read the NVRAM access statistics (per cached NVRAM Id). Returns the event length.
+ */
+int wiced_cmd_nvram_stats_read(uint8_t *p_data, uint16_t max_length);
+
+/*
+ * wiced_cmd_memory_capture
+ * Start (1) or stop (0) the recording of the Memory Trend samples of the device
+ */
+int wiced_cmd_memory_capture(uint8_t enable);
+
+/*
+ * wiced_cmd_memory_threshold_set
+ * Set the Buffer Pool (in %) and free Heap (in bytes) thresholds of the Memory monitor
+ */
+int wiced_cmd_memory_threshold_set(uint8_t pool_threshold, uint32_t heap_threshold);
+
 /*
  * wiced_cmd_write_binary_file_to_flash
  */
-int wiced_cmd_write_binary_file_to_flash(char *p_bin_file, uint32_t offset);
+int wiced_cmd_write_binary_file_to_flash(char *p_bin_file, uint32_t offset, int window);
+
+/*
+ * wiced_queue_init
+ */
+int wiced_queue_init(wiced_queue_t *p_queue, protocol_conn_t *p_conn, int window);
+
+/*
+ * wiced_queue_free
+ * Free the commands which have not been sent (or not acknowledged)
+ */
+void wiced_queue_free(wiced_queue_t *p_queue);
+
+/*
+ * wiced_queue_nvram_write
+ */
+int wiced_queue_nvram_write(wiced_queue_t *p_queue, uint16_t nvram_id, uint8_t *p_data,
+        uint16_t length);
+
+/*
+ * wiced_queue_platform_lrac_trace_level_set
+ */
+int wiced_queue_platform_lrac_trace_level_set(wiced_queue_t *p_queue, uint8_t trace_level);
+
+/*
+ * wiced_queue_reset
+ */
+int wiced_queue_reset(wiced_queue_t *p_queue);
+
+/*
+ * wiced_queue_write_binary_file_to_flash
+ * Same as wiced_cmd_write_binary_file_to_flash: the pages already containing the right data
+ * are skipped.
+ */
+int wiced_queue_write_binary_file_to_flash(wiced_queue_t *p_queue, char *p_bin_file,
+        uint32_t offset);
+
+/*
+ * wiced_queue_start
+ * Send the first commands. The other ones are sent when the status are received.
+ */
+int wiced_queue_start(wiced_queue_t *p_queue);
+
+/*
+ * wiced_queue_event_handler
+ * Must be called for every WICED event received on the connection of the Queue.
+ */
+int wiced_queue_event_handler(wiced_queue_t *p_queue, uint16_t opcode, uint8_t *p_data,
+        uint16_t length);
+
+/*
+ * wiced_queue_busy
+ * Returns 1 if some commands have not been sent or acknowledged yet. The Queue fails (status
+ * -1) if a status is not received in time.
+ */
+int wiced_queue_busy(wiced_queue_t *p_queue);
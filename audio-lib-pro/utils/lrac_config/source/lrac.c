@@ -31,6 +31,7 @@
  * so agrees to indemnify Cypress against all liability.
  */
 
+#include <stdio.h>
 #include "lrac.h"
 #include "wiced.h"
 
@@ -45,15 +46,34 @@ enum
     WICED_NVRAM_VSID_END                = 0x3FFF
 };
 
-/* From lrac_headset/app_nvram.c */
+/* From app_hci_ring.h */
+#define HCI_RING_NB_ENTRIES_MAX         64
+#define HCI_RING_ENTRY_SIZE             12
+
+/* From app_memory.h/app_memory.c */
+#define MEMORY_POOL_MAX                 8
+#define MEMORY_TREND_NB                 32
+/* Memory Trend event: header, per pool statistics and samples */
+#define MEMORY_TREND_SIZE(nb_pools, nb_samples) (1 + 4 + 1 + 1 + 1 + (nb_pools) * 6 * 2 + \
+                                                 (nb_samples) * (4 + (nb_pools)))
+
+/* From lrac_headset/app_nvram.h */
 enum
 {
-    NVRAM_ID_LRAC_INFO =                WICED_NVRAM_VSID_START + 1,
+    NVRAM_ID_LINK_KEYS =                WICED_NVRAM_VSID_START,
+    NVRAM_ID_LRAC_INFO,
     NVRAM_ID_LOCAL_BDADDR,
     NVRAM_ID_PEER_LRAC_BDADDR,
     NVRAM_ID_SLEEP,
     NVRAM_ID_VOICE_PROMPT_FS,
+    NVRAM_ID_PAIRING_INFO_LRAC,
+    NVRAM_ID_LOCAL_IRK,
+    NVRAM_ID_GFPS_ACCOUNT_KEY,
+    NVRAM_ID_OFU_CHECKPOINT,
 };
+#define NVRAM_CACHE_NB_ID               8
+/* NVRAM Stats event: Nb Entries and, per entry, Id and 5 counters (2 bytes each) */
+#define NVRAM_STATS_SIZE(nb_entries)    (1 + (nb_entries) * 6 * 2)
 
 /*
  * lrac_local_bdaddr_write
@@ -183,3 +203,263 @@ int lrac_sleep_config(uint8_t sleep_enable)
 
     return wiced_cmd_nvram_write(NVRAM_ID_SLEEP, &sleep_enable, 1);
 }
+
+/*
+ * lrac_hci_ring_save
+ * Read an HCI Ring Buffer and save it (raw event) in a file. The file can be decoded with
+ * hci-ring-decode.py.
+ */
+int lrac_hci_ring_save(uint8_t ring_id, char *p_file)
+{
+    int status;
+    uint8_t rx_param[4 + HCI_RING_NB_ENTRIES_MAX * HCI_RING_ENTRY_SIZE];
+    FILE *p_fd;
+
+    TRACE_DBG("ring_id:%d file:%s", ring_id, p_file);
+
+    status = wiced_cmd_hci_ring_read(ring_id, rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+        return status;
+
+    /* Ring Id, Status, Entry Size, Nb Entries */
+    if (rx_param[1] != 0)
+    {
+        TRACE_ERR("HCI Ring %d not available", ring_id);
+        return -1;
+    }
+    TRACE_INFO("HCI Ring %d: %d entries", ring_id, rx_param[3]);
+
+    p_fd = fopen(p_file, "wb");
+    if (p_fd == NULL)
+    {
+        TRACE_ERR("Cannot open %s", p_file);
+        return -1;
+    }
+    if (fwrite(rx_param, 1, status, p_fd) != status)
+    {
+        TRACE_ERR("Cannot write %s", p_file);
+        fclose(p_fd);
+        return -1;
+    }
+    fclose(p_fd);
+
+    return 0;
+}
+
+/*
+ * lrac_nvram_id_get_descr
+ */
+static const char *lrac_nvram_id_get_descr(uint16_t nvram_id)
+{
+    switch(nvram_id)
+    {
+    case NVRAM_ID_LINK_KEYS:            return "LINK_KEYS";
+    case NVRAM_ID_LRAC_INFO:            return "LRAC_INFO";
+    case NVRAM_ID_LOCAL_BDADDR:         return "LOCAL_BDADDR";
+    case NVRAM_ID_PEER_LRAC_BDADDR:     return "PEER_LRAC_BDADDR";
+    case NVRAM_ID_SLEEP:                return "SLEEP";
+    case NVRAM_ID_VOICE_PROMPT_FS:      return "VOICE_PROMPT_FS";
+    case NVRAM_ID_PAIRING_INFO_LRAC:    return "PAIRING_INFO_LRAC";
+    case NVRAM_ID_LOCAL_IRK:            return "LOCAL_IRK";
+    case NVRAM_ID_GFPS_ACCOUNT_KEY:     return "GFPS_ACCOUNT_KEY";
+    case NVRAM_ID_OFU_CHECKPOINT:       return "OFU_CHECKPOINT";
+    default:                            return "Unknown";
+    }
+}
+
+/*
+ * lrac_nvram_stats_print
+ */
+int lrac_nvram_stats_print(void)
+{
+    int status;
+    uint8_t rx_param[NVRAM_STATS_SIZE(NVRAM_CACHE_NB_ID)];
+    uint8_t *p;
+    uint8_t nb_entries;
+    uint16_t nvram_id, nb_write, nb_write_skipped, nb_write_coalesced, nb_read_hit, nb_read_miss;
+    int i;
+
+    status = wiced_cmd_nvram_stats_read(rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+        return status;
+
+    p = rx_param;
+    STREAM_TO_UINT8(nb_entries, p);
+    if (nb_entries == 0)
+        TRACE_INFO("No NVRAM Id accessed");
+    for (i = 0 ; i < nb_entries ; i++)
+    {
+        STREAM_TO_UINT16(nvram_id, p);
+        STREAM_TO_UINT16(nb_write, p);
+        STREAM_TO_UINT16(nb_write_skipped, p);
+        STREAM_TO_UINT16(nb_write_coalesced, p);
+        STREAM_TO_UINT16(nb_read_hit, p);
+        STREAM_TO_UINT16(nb_read_miss, p);
+        TRACE_INFO("NVRAM Id 0x%03X %-18s write:%d skipped:%d coalesced:%d read hit/miss:%d/%d",
+                nvram_id, lrac_nvram_id_get_descr(nvram_id), nb_write, nb_write_skipped,
+                nb_write_coalesced, nb_read_hit, nb_read_miss);
+    }
+
+    return 0;
+}
+
+/*
+ * lrac_memory_trend_read
+ * Read and check the Memory Trend event. Returns its length.
+ */
+static int lrac_memory_trend_read(uint8_t *p_data, uint16_t max_length)
+{
+    int status;
+    uint8_t nb_pools, nb_samples, nb_cfg_pools;
+
+    status = wiced_cmd_memory_trend_read(p_data, max_length);
+    if (status < 0)
+        return status;
+
+    /* Sample Period, Min Free Bytes, Nb Pools, Nb Samples, Nb Configured Pools */
+    if (status < (1 + 4 + 1 + 1 + 1))
+    {
+        TRACE_ERR("wrong Memory Trend received (length:%d)", status);
+        return -1;
+    }
+    nb_pools = p_data[1 + 4];
+    nb_samples = p_data[1 + 4 + 1];
+    nb_cfg_pools = p_data[1 + 4 + 1 + 1];
+    if ((nb_pools > MEMORY_POOL_MAX) || (nb_samples > MEMORY_TREND_NB) ||
+        (nb_cfg_pools > nb_pools) ||
+        (status != MEMORY_TREND_SIZE(nb_pools, nb_samples)))
+    {
+        TRACE_ERR("wrong Memory Trend received (length:%d)", status);
+        return -1;
+    }
+
+    return status;
+}
+
+/*
+ * lrac_memory_trend_print
+ */
+int lrac_memory_trend_print(void)
+{
+    int status;
+    uint8_t rx_param[MEMORY_TREND_SIZE(MEMORY_POOL_MAX, MEMORY_TREND_NB)];
+    uint8_t *p;
+    uint8_t period, nb_pools, nb_samples, nb_cfg_pools;
+    uint32_t min_free_bytes, free_bytes;
+    uint16_t size, total, max, nb_alerts, nb_exhausted, nb_alloc_failed;
+    char line[16 + MEMORY_POOL_MAX * 6];
+    int i, j, len;
+
+    status = lrac_memory_trend_read(rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+        return status;
+
+    p = rx_param;
+    STREAM_TO_UINT8(period, p);
+    STREAM_TO_UINT32(min_free_bytes, p);
+    STREAM_TO_UINT8(nb_pools, p);
+    STREAM_TO_UINT8(nb_samples, p);
+    STREAM_TO_UINT8(nb_cfg_pools, p);
+
+    TRACE_INFO("Min Free Bytes:%d", min_free_bytes);
+    for (i = 0 ; i < nb_pools ; i++)
+    {
+        STREAM_TO_UINT16(size, p);
+        STREAM_TO_UINT16(total, p);
+        STREAM_TO_UINT16(max, p);
+        STREAM_TO_UINT16(nb_alerts, p);
+        STREAM_TO_UINT16(nb_exhausted, p);
+        STREAM_TO_UINT16(nb_alloc_failed, p);
+        TRACE_INFO("Pool %d size:%d\tmax/total: %d/%d alerts:%d exhausted:%d alloc_failed:%d%s",
+                i, size, max, total, nb_alerts, nb_exhausted, nb_alloc_failed,
+                (i < nb_cfg_pools) ? "" : " (runtime pool)");
+    }
+
+    /* One line per sample (oldest first): age, free bytes and buffers allocated per pool */
+    for (i = 0 ; i < nb_samples ; i++)
+    {
+        STREAM_TO_UINT32(free_bytes, p);
+        len = 0;
+        for (j = 0 ; j < nb_pools ; j++)
+        {
+            len += snprintf(&line[len], sizeof(line) - len, " %3d", *p++);
+        }
+        TRACE_INFO("age:%3ds free:%6d pools:%s", (nb_samples - 1 - i) * period, free_bytes, line);
+    }
+
+    return 0;
+}
+
+/*
+ * lrac_memory_trend_save
+ * Read the Memory Trend and save it (raw event) in a file. The files saved after
+ * representative sessions are used by buffer-pool-tune.py.
+ */
+int lrac_memory_trend_save(char *p_file)
+{
+    int status;
+    uint8_t rx_param[MEMORY_TREND_SIZE(MEMORY_POOL_MAX, MEMORY_TREND_NB)];
+    FILE *p_fd;
+
+    TRACE_DBG("file:%s", p_file);
+
+    status = lrac_memory_trend_read(rx_param, (uint16_t)sizeof(rx_param));
+    if (status < 0)
+        return status;
+
+    p_fd = fopen(p_file, "wb");
+    if (p_fd == NULL)
+    {
+        TRACE_ERR("Cannot open %s", p_file);
+        return -1;
+    }
+    if (fwrite(rx_param, 1, status, p_fd) != status)
+    {
+        TRACE_ERR("Cannot write %s", p_file);
+        fclose(p_fd);
+        return -1;
+    }
+    fclose(p_fd);
+
+    return 0;
+}
+
+/*
+ * lrac_local_bdaddr_queue
+ */
+int lrac_local_bdaddr_queue(wiced_queue_t *p_queue, uint8_t *p_bdaddr)
+{
+    return wiced_queue_nvram_write(p_queue, NVRAM_ID_LOCAL_BDADDR, p_bdaddr, BD_ADDR_LEN);
+}
+
+/*
+ * lrac_config_queue
+ */
+int lrac_config_queue(wiced_queue_t *p_queue, uint8_t *p_lrac_config)
+{
+    return wiced_queue_nvram_write(p_queue, NVRAM_ID_LRAC_INFO, p_lrac_config, 2);
+}
+
+/*
+ * lrac_peer_bdaddr_queue
+ */
+int lrac_peer_bdaddr_queue(wiced_queue_t *p_queue, uint8_t *p_bdaddr)
+{
+    return wiced_queue_nvram_write(p_queue, NVRAM_ID_PEER_LRAC_BDADDR, p_bdaddr, BD_ADDR_LEN);
+}
+
+/*
+ * lrac_trace_level_queue
+ */
+int lrac_trace_level_queue(wiced_queue_t *p_queue, uint8_t trace_level)
+{
+    return wiced_queue_platform_lrac_trace_level_set(p_queue, trace_level);
+}
+
+/*
+ * lrac_sleep_config_queue
+ */
+int lrac_sleep_config_queue(wiced_queue_t *p_queue, uint8_t sleep_enable)
+{
+    return wiced_queue_nvram_write(p_queue, NVRAM_ID_SLEEP, &sleep_enable, 1);
+}
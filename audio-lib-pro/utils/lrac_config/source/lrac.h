@@ -35,6 +35,7 @@
 
 #include <stdint.h>
 #include "utils.h"
+#include "wiced.h"
 
 /*
  * lrac_local_bdaddr_write
@@ -90,3 +91,53 @@ int lrac_trace_level_set(uint8_t trace_level);
  * lrac_sleep_config
  */
 int lrac_sleep_config(uint8_t sleep_enable);
+
+/*
+ * lrac_hci_ring_save
+ * Save an HCI Ring Buffer (0: current, 1: before the last reset) in a file
+ */
+int lrac_hci_ring_save(uint8_t ring_id, char *p_file);
+
+/*
+ * lrac_nvram_stats_print
+ * Print the NVRAM access statistics (writes and reads of every cached NVRAM Id)
+ */
+int lrac_nvram_stats_print(void);
+
+/*
+ * lrac_memory_trend_print
+ * Print the Memory (Buffer Pools and Heap) Trend
+ */
+int lrac_memory_trend_print(void);
+
+/*
+ * lrac_memory_trend_save
+ * Save the Memory Trend in a file (see buffer-pool-tune.py)
+ */
+int lrac_memory_trend_save(char *p_file);
+
+/*
+ * lrac_local_bdaddr_queue
+ * Same as lrac_local_bdaddr_write but the command is queued (see wiced_queue_init)
+ */
+int lrac_local_bdaddr_queue(wiced_queue_t *p_queue, uint8_t *p_bdaddr);
+
+/*
+ * lrac_config_queue
+ */
+int lrac_config_queue(wiced_queue_t *p_queue, uint8_t *p_lrac_config);
+
+/*
+ * lrac_peer_bdaddr_queue
+ */
+int lrac_peer_bdaddr_queue(wiced_queue_t *p_queue, uint8_t *p_bdaddr);
+
+/*
+ * lrac_trace_level_queue
+ */
+int lrac_trace_level_queue(wiced_queue_t *p_queue, uint8_t trace_level);
+
+/*
+ * lrac_sleep_config_queue
+ */
+int lrac_sleep_config_queue(wiced_queue_t *p_queue, uint8_t sleep_enable);
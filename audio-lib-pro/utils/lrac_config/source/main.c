@@ -34,7 +34,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
-#include <pthread.h>
 #include <stdlib.h>
 #include <getopt.h>
 #include <libgen.h>
@@ -47,6 +46,9 @@
 #include "hci.h"
 #include "wiced.h"
 #include "lrac.h"
+#include "multi.h"
+#include "loop.h"
+#include "batch.h"
 
 /*
  * Definitions
@@ -107,6 +109,7 @@ char *p_write_binary_file;
 uint8_t write_binary_file_command = 0;
 
 uint32_t flash_offset = 0;
+int flash_window = 4;
 
 int16_t nvwrite_id;
 uint8_t nvwrite_id_command = 0;
@@ -114,6 +117,25 @@ uint8_t nvwrite_id_command = 0;
 uint8_t *p_nvdata = NULL;
 uint32_t nvdata_length = 0;
 
+/* Several devices (configured in parallel) */
+multi_device_param_t multi_devices[MULTI_DEVICE_MAX];
+int nb_multi_devices = 0;
+char *p_devices_file = NULL;
+char *p_rx_capture_file = NULL;
+char *p_rx_bench_file = NULL;
+int wait_duration = 0;
+char *p_batch_file = NULL;
+char *p_hci_ring_file = NULL;
+char *p_hci_ring_prev_file = NULL;
+int hci_ring_enable = -1;
+uint8_t memory_trend_command = 0;
+char *p_memory_trend_file = NULL;
+uint8_t memory_pool_threshold;
+uint32_t memory_heap_threshold;
+uint8_t memory_threshold_command = 0;
+int memory_capture = -1;
+uint8_t nvram_stats_command = 0;
+
 /*
  * hci_event_cback
  *
@@ -167,10 +189,14 @@ void print_usage(char *p_name)
      printf("Utility program to configure LRAC device\n");
      printf("USAGE:     %s [OPTION]... \n", basename(p_name));
      printf("    -help             get option help information\n");
-     printf("    -device dev       UART Port (e.g. COM11 or /dev/ttyS10)\n");
+     printf("    -device dev       UART Port (e.g. COM11 or /dev/ttyS10). Can be repeated to\n");
+     printf("                      configure several devices in parallel\n");
+     printf("    -devices file     Devices to configure in parallel. One device per line:\n");
+     printf("                      port [bdaddr [cfg [peer]]] ('-' to use the command line value)\n");
      printf("    -baudrate rate    UART Baudrate (default is 115200)\n");
      printf("    -flowcontrol f    UART RTS/CTS Flow control (default is 1)\n");
      printf("    -bdaddr addr      Set Local BdAddr (e.g. -bdaddr 001122334455\n");
+     printf("                      (incremented for every device if several devices)\n");
      printf("    -peer addr        Set Peer BdAddr (e.g. -peer 001122334455\n");
      printf("    -config cfg       Set (P)rimary/(S)econdary and (L)eft/(R)ight\n");
      printf("                      (parameter PL, PR, SL or SR\n");
@@ -192,8 +218,23 @@ void print_usage(char *p_name)
      printf("    -elna gain        Set the eLNA Gain [-128..127]\n");
      printf("    -wbftf file       Write Binary File To Flash\n");
      printf("    -foffset offset   Flash Offset (Hexadecimal value)\n");
+     printf("    -fwindow n        Flash Commands sent without waiting for their status [1..16] (default 4)\n");
      printf("    -nvwrite id       Write NVRAM Id in flash (Hexadecimal value)\n");
      printf("    -data XX...       NVRAM Data (see -nvwrite)\n");
+     printf("    -rx_capture file  Write all the received bytes to a file\n");
+     printf("    -wait ms          Handle the received events during ms before exiting\n");
+     printf("    -batch file       Execute the commands of a file ('-' for stdin, 'help' to list\n");
+     printf("                      them) over the same connection\n");
+     printf("    -rx_bench file    Measure the receive parser throughput with a capture file\n");
+     printf("    -hci_ring file    Save the HCI Ring Buffer (last HCI Commands/Events) in a file\n");
+     printf("    -hci_ring_prev file  Same for the HCI Ring Buffer preceding the last reset\n");
+     printf("    -hci_ring_enable 0|1  Disable/Enable the HCI Ring Buffer (FW built with HCI_RING=1)\n");
+     printf("    -mem_capture 0|1  Stop/Start the recording of the Memory trend samples\n");
+     printf("    -mem_trend        Print the Memory (Buffer Pools and Heap) usage trend\n");
+     printf("    -mem_threshold pool,heap  Set the Memory alert thresholds (pool usage in %%,\n");
+     printf("                      free heap in bytes)\n");
+     printf("    -mem_save file    Save the Memory usage (see buffer-pool-tune.py) in a file\n");
+     printf("    -nvram_stats      Print the NVRAM access statistics (writes and reads per Id)\n");
 
      printf("\n");
      printf("Version %s\n", TOOL_VERSION);
@@ -235,7 +276,7 @@ int parse_com_port(char *p_dev_name)
             TRACE_ERR("Use the DeviceManager to force Windows to use a lower number");
         }
         /* Linux/Cygwin device format */
-        p_device = optarg;
+        p_device = p_dev_name;
     }
     return 0;
 }
@@ -259,9 +300,9 @@ int hexachar_to_int(char hex_char)
     return -1;
 }
 /*
- * parse_local_bdaddr
+ * parse_bdaddr
  */
-int parse_local_bdaddr(char *p_bdaddr_string)
+int parse_bdaddr(char *p_bdaddr_string, uint8_t *p_bdaddr)
 {
     int i = 0;
     uint8_t *p = p_bdaddr_string;
@@ -295,8 +336,19 @@ int parse_local_bdaddr(char *p_bdaddr_string)
         p++;
         val |= value;
 
-        local_bdaddr[i++] = val;
+        p_bdaddr[i++] = val;
     }
+    return 0;
+}
+
+/*
+ * parse_local_bdaddr
+ */
+int parse_local_bdaddr(char *p_bdaddr_string)
+{
+    if (parse_bdaddr(p_bdaddr_string, local_bdaddr) < 0)
+        return -1;
+
     local_bdaddr_command = 1;
     TRACE_DBG("BdAddr:%02X:%02X:%02X:%02X:%02X:%02X",
             local_bdaddr[0], local_bdaddr[1], local_bdaddr[2],
@@ -309,40 +361,9 @@ int parse_local_bdaddr(char *p_bdaddr_string)
  */
 int parse_peer_bdaddr(char *p_bdaddr_string)
 {
-    int i = 0;
-    uint8_t *p = p_bdaddr_string;
-    int value;
-    uint8_t val;
-
-
-    if (strlen(p_bdaddr_string) != (BD_ADDR_LEN * 2))
-    {
-        TRACE_ERR("Wrong BdAddr parameter (12 hex expected)");
+    if (parse_bdaddr(p_bdaddr_string, peer_bdaddr) < 0)
         return -1;
-    }
-
-    while(*p)
-    {
-        value = hexachar_to_int(*p);
-        if (value < 0)
-        {
-            TRACE_ERR("Wrong BdAddr parameter (%c)", *p);
-            return -1;
-        }
-        p++;
-        val = value << 4;
 
-        value = hexachar_to_int(*p);
-        if (value < 0)
-        {
-            TRACE_ERR("Wrong BdAddr parameter (%c)", *p);
-            return -1;
-        }
-        p++;
-        val |= value;
-
-        peer_bdaddr[i++] = val;
-    }
     peer_bdaddr_command = 1;
     TRACE_DBG("BdAddr:%02X:%02X:%02X:%02X:%02X:%02X",
             peer_bdaddr[0], peer_bdaddr[1], peer_bdaddr[2],
@@ -351,16 +372,16 @@ int parse_peer_bdaddr(char *p_bdaddr_string)
 }
 
 /*
- * parse_lrac_config
+ * parse_lrac_config_to
  */
-int parse_lrac_config(char *p_config_string)
+int parse_lrac_config_to(char *p_config_string, uint8_t *p_lrac_config)
 {
     if ((p_config_string[0] == 'P') || (p_config_string[0] == 'p'))
-        lrac_config[0] = 0x00;
+        p_lrac_config[0] = 0x00;
     else if ((p_config_string[0] == 'S') || (p_config_string[0] == 's'))
-        lrac_config[0] = 0x01;
+        p_lrac_config[0] = 0x01;
     else if ((p_config_string[0] == 'U') || (p_config_string[0] == 'u'))
-        lrac_config[0] = 0xFF;
+        p_lrac_config[0] = 0xFF;
     else
     {
         fprintf(stderr, "Wrong Primary/Secondary Config (%c)", p_config_string[0]);
@@ -368,21 +389,109 @@ int parse_lrac_config(char *p_config_string)
     }
 
     if ((p_config_string[1] == 'L') || (p_config_string[1] == 'l'))
-        lrac_config[1] = 0x00;
+        p_lrac_config[1] = 0x00;
     else if ((p_config_string[1] == 'R') || (p_config_string[1] == 'r'))
-        lrac_config[1] = 0x01;
+        p_lrac_config[1] = 0x01;
     else if ((p_config_string[1] == 'U') || (p_config_string[1] == 'u'))
-        lrac_config[1] = 0xFF;
+        p_lrac_config[1] = 0xFF;
     else
     {
         fprintf(stderr, "Wrong Left/Right Config (%c)", p_config_string[1]);
         return -1;
     }
+    return 0;
+}
+
+/*
+ * parse_lrac_config
+ */
+int parse_lrac_config(char *p_config_string)
+{
+    if (parse_lrac_config_to(p_config_string, lrac_config) < 0)
+        return -1;
+
     lrac_config_command = 1;
     TRACE_DBG("Config P/S:%d L/R:%d", lrac_config[0], lrac_config[1]);
     return 0;
 }
 
+/*
+ * parse_devices_file
+ * One device per line: port [bdaddr [config [peer_bdaddr]]]. '-' means the value passed in the
+ * command line. Empty lines and lines starting with '#' are ignored.
+ */
+int parse_devices_file(char *p_file)
+{
+    FILE *p_fd;
+    char line[256];
+    char *p_fields[4];
+    int nb_fields;
+    int line_nb = 0;
+    int status = 0;
+    multi_device_param_t *p_dev_param;
+
+    p_fd = fopen(p_file, "r");
+    if (p_fd == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", p_file);
+        return -1;
+    }
+
+    while ((status == 0) && (fgets(line, sizeof(line), p_fd) != NULL))
+    {
+        line_nb++;
+        nb_fields = 0;
+        p_fields[nb_fields] = strtok(line, " \t\r\n");
+        while ((p_fields[nb_fields] != NULL) && (nb_fields < 3))
+        {
+            nb_fields++;
+            p_fields[nb_fields] = strtok(NULL, " \t\r\n");
+        }
+        if (p_fields[nb_fields] != NULL)
+            nb_fields++;
+
+        if ((nb_fields == 0) || (p_fields[0][0] == '#'))
+            continue;
+
+        if (nb_multi_devices >= MULTI_DEVICE_MAX)
+        {
+            fprintf(stderr, "Too many devices (max %d)\n", MULTI_DEVICE_MAX);
+            status = -1;
+            break;
+        }
+        p_dev_param = &multi_devices[nb_multi_devices];
+        memset(p_dev_param, 0, sizeof(*p_dev_param));
+
+        parse_com_port(p_fields[0]);
+        p_dev_param->p_device = strdup(p_device);
+
+        if ((nb_fields > 1) && strcmp(p_fields[1], "-"))
+        {
+            status = parse_bdaddr(p_fields[1], p_dev_param->local_bdaddr);
+            p_dev_param->local_bdaddr_command = 1;
+        }
+        if ((status == 0) && (nb_fields > 2) && strcmp(p_fields[2], "-"))
+        {
+            status = parse_lrac_config_to(p_fields[2], p_dev_param->lrac_config);
+            p_dev_param->lrac_config_command = 1;
+        }
+        if ((status == 0) && (nb_fields > 3) && strcmp(p_fields[3], "-"))
+        {
+            status = parse_bdaddr(p_fields[3], p_dev_param->peer_bdaddr);
+            p_dev_param->peer_bdaddr_command = 1;
+        }
+        if (status < 0)
+        {
+            fprintf(stderr, "%s:%d: wrong device line\n", p_file, line_nb);
+            break;
+        }
+        nb_multi_devices++;
+    }
+
+    fclose(p_fd);
+    return status;
+}
+
 /*
  * string_to_hex
  */
@@ -463,6 +572,7 @@ int parse_cmd_line(int argc, char **argv)
          */
             {"help", no_argument, 0, 'h'},                  /* Help => no parameter */
             {"device", required_argument, 0, 'd'},          /* Device => 1 parameter */
+            {"devices", required_argument, 0, 'y'},         /* Devices File => 1 parameter */
             {"baudrate", required_argument, 0, 'b'},        /* Baudrate => 1 parameter */
             {"flowcontrol", required_argument, 0, 'f'},     /* FlowControl (RTS/CTS) => 1 parameter */
             {"bdaddr", required_argument, 0, 'l'},          /* Local BdAddr => 1 parameter */
@@ -482,8 +592,21 @@ int parse_cmd_line(int argc, char **argv)
             {"elna", required_argument, 0, 'n' },           /* eLNA Gain => 1 parameter */
             {"wbftf", required_argument, 0, 'o' },          /* Write Bin file to Flash => 1 parameter */
             {"foffset", required_argument, 0, 'q' },        /* Flash Offset => 1 parameter */
+            {"fwindow", required_argument, 0, 'x' },        /* Flash Window => 1 parameter */
             {"nvwrite", required_argument, 0, 'r' },        /* NVRAM Write Id => 1 parameter */
             {"data", required_argument, 0, 't' },           /* Data => 1 parameter */
+            {"rx_capture", required_argument, 0, 'z' },     /* RX Capture File => 1 parameter */
+            {"rx_bench", required_argument, 0, 'B' },       /* RX Parser Benchmark => 1 parameter */
+            {"wait", required_argument, 0, 'W' },           /* Wait => 1 parameter */
+            {"batch", required_argument, 0, 'X' },          /* Batch File => 1 parameter */
+            {"hci_ring", required_argument, 0, 'R' },       /* HCI Ring File => 1 parameter */
+            {"hci_ring_prev", required_argument, 0, 'P' },  /* Previous HCI Ring File => 1 parameter */
+            {"hci_ring_enable", required_argument, 0, 'E' },/* HCI Ring Enable => 1 parameter */
+            {"mem_capture", required_argument, 0, 'N' },    /* Memory Trend Capture => 1 parameter */
+            {"mem_trend", no_argument, 0, 'M' },            /* Memory Trend => no parameter */
+            {"mem_threshold", required_argument, 0, 'T' },  /* Memory Thresholds => 1 parameter */
+            {"mem_save", required_argument, 0, 'S' },       /* Memory Trend File => 1 parameter */
+            {"nvram_stats", no_argument, 0, 'V' },          /* NVRAM Statistics => no parameter */
 
             {NULL, 0, NULL, 0}
     };
@@ -500,6 +623,17 @@ int parse_cmd_line(int argc, char **argv)
         {
         case 'd':
             parse_com_port(optarg);
+            if (nb_multi_devices >= MULTI_DEVICE_MAX)
+            {
+                fprintf(stderr, "Too many devices (max %d)\n", MULTI_DEVICE_MAX);
+                return -1;
+            }
+            memset(&multi_devices[nb_multi_devices], 0, sizeof(multi_devices[0]));
+            multi_devices[nb_multi_devices++].p_device = strdup(p_device);
+            break;
+
+        case 'y':
+            p_devices_file = optarg;
             break;
 
         case 'b':
@@ -625,6 +759,15 @@ int parse_cmd_line(int argc, char **argv)
             }
             break;
 
+        case 'x':
+            flash_window = atoi(optarg);
+            if ((flash_window < 1) || (flash_window > 16))
+            {
+                fprintf(stderr, "invalid flash window %s\n", optarg);
+                return -1;
+            }
+            break;
+
         case 'r':
             {
                 char *ptr;
@@ -644,6 +787,82 @@ int parse_cmd_line(int argc, char **argv)
             TRACE_DBG("nvdata_length:%d", nvdata_length);
             break;
 
+        case 'z':
+            p_rx_capture_file = optarg;
+            break;
+
+        case 'B':
+            p_rx_bench_file = optarg;
+            break;
+
+        case 'X':
+            p_batch_file = optarg;
+            break;
+
+        case 'R':
+            p_hci_ring_file = optarg;
+            break;
+
+        case 'P':
+            p_hci_ring_prev_file = optarg;
+            break;
+
+        case 'E':
+            hci_ring_enable = atoi(optarg);
+            if ((hci_ring_enable != 0) && (hci_ring_enable != 1))
+            {
+                fprintf(stderr, "invalid HCI Ring enable %s\n", optarg);
+                return -1;
+            }
+            break;
+
+        case 'N':
+            memory_capture = atoi(optarg);
+            if ((memory_capture != 0) && (memory_capture != 1))
+            {
+                fprintf(stderr, "invalid Memory trend capture %s\n", optarg);
+                return -1;
+            }
+            break;
+
+        case 'M':
+            memory_trend_command = 1;
+            break;
+
+        case 'S':
+            p_memory_trend_file = optarg;
+            break;
+
+        case 'V':
+            nvram_stats_command = 1;
+            break;
+
+        case 'T':
+            {
+                int pool_threshold;
+                unsigned int heap_threshold;
+
+                if ((sscanf(optarg, "%d,%u", &pool_threshold, &heap_threshold) != 2) ||
+                    (pool_threshold <= 0) || (pool_threshold > 100))
+                {
+                    fprintf(stderr, "invalid memory thresholds %s\n", optarg);
+                    return -1;
+                }
+                memory_pool_threshold = (uint8_t)pool_threshold;
+                memory_heap_threshold = heap_threshold;
+                memory_threshold_command = 1;
+            }
+            break;
+
+        case 'W':
+            wait_duration = atoi(optarg);
+            if (wait_duration < 0)
+            {
+                fprintf(stderr, "invalid wait duration %s\n", optarg);
+                return -1;
+            }
+            break;
+
         case 'h':
         default:
             print_usage(argv[0]);
@@ -654,6 +873,110 @@ int parse_cmd_line(int argc, char **argv)
     return 0;
 }
 
+/*
+ * main_multi
+ * Configure several devices in parallel
+ */
+int main_multi(char *p_name)
+{
+    multi_param_t param;
+    multi_device_param_t *p_dev_param;
+    int i, j;
+    int carry;
+
+    if (p_devices_file != NULL)
+    {
+        /* The devices of the file replace the ones of the command line */
+        nb_multi_devices = 0;
+        if (parse_devices_file(p_devices_file) < 0)
+            return -1;
+    }
+
+    if (nb_multi_devices == 0)
+    {
+        TRACE_ERR("No device selected");
+        print_usage(p_name);
+        return -1;
+    }
+
+    if (button_command || audio_insert_command || audio_insert_ext_command ||
+        ble_adv_command || switch_command || buffer_stat_command || fw_spi_logging_command ||
+        jitter_buffer_target_command || elna_gain_command || (p_rx_capture_file != NULL) ||
+        wait_duration || (p_batch_file != NULL) || (p_hci_ring_file != NULL) ||
+        (p_hci_ring_prev_file != NULL) || (hci_ring_enable >= 0) || memory_trend_command ||
+        memory_threshold_command || (memory_capture >= 0) ||
+        (p_memory_trend_file != NULL) || nvram_stats_command)
+    {
+        fprintf(stderr, "Only the bdaddr, peer, config, lrac_trace, sleep, wbftf and nvwrite\n"
+                "options are supported with several devices\n");
+        return -1;
+    }
+
+    if (write_binary_file_command && (flash_offset == 0))
+    {
+        fprintf(stderr, "invalid offset %d\n", flash_offset);
+        print_usage(p_name);
+        return -1;
+    }
+
+    /* The command line values apply to the devices which do not have their own */
+    for (i = 0; i < nb_multi_devices; i++)
+    {
+        p_dev_param = &multi_devices[i];
+        if ((p_dev_param->local_bdaddr_command == 0) && local_bdaddr_command)
+        {
+            /* Local BdAddr + device index */
+            memcpy(p_dev_param->local_bdaddr, local_bdaddr, BD_ADDR_LEN);
+            carry = i;
+            for (j = BD_ADDR_LEN - 1; (j >= 0) && carry; j--)
+            {
+                carry += p_dev_param->local_bdaddr[j];
+                p_dev_param->local_bdaddr[j] = (uint8_t)carry;
+                carry >>= 8;
+            }
+            p_dev_param->local_bdaddr_command = 1;
+        }
+        if ((p_dev_param->peer_bdaddr_command == 0) && peer_bdaddr_command)
+        {
+            memcpy(p_dev_param->peer_bdaddr, peer_bdaddr, BD_ADDR_LEN);
+            p_dev_param->peer_bdaddr_command = 1;
+        }
+        if ((p_dev_param->lrac_config_command == 0) && lrac_config_command)
+        {
+            memcpy(p_dev_param->lrac_config, lrac_config, sizeof(lrac_config));
+            p_dev_param->lrac_config_command = 1;
+        }
+    }
+
+    memset(&param, 0, sizeof(param));
+    param.baudrate = baudrate;
+    param.flow_control = flow_control;
+    param.lrac_trace_level_command = lrac_trace_level_command;
+    param.lrac_trace_level = lrac_trace_level;
+    param.sleep_enable_command = sleep_enable_command;
+    param.sleep_enable = sleep_enable;
+    if (write_binary_file_command)
+        param.p_write_binary_file = p_write_binary_file;
+    param.flash_offset = flash_offset;
+    param.flash_window = flash_window;
+    param.nvwrite_id_command = nvwrite_id_command;
+    param.nvwrite_id = nvwrite_id;
+    param.p_nvdata = p_nvdata;
+    param.nvdata_length = nvdata_length;
+
+    printf("Configure %d devices\n", nb_multi_devices);
+
+    if (multi_run(multi_devices, nb_multi_devices, &param) != 0)
+    {
+        TRACE_ERR("Some devices failed");
+        return -1;
+    }
+
+    TRACE_INFO("Success");
+
+    return 0;
+}
+
 /*
  * Main
  */
@@ -674,6 +997,18 @@ int main(int argc, char *argv[])
         return status;
     }
 
+    /* Receive parser benchmark (no device needed) */
+    if (p_rx_bench_file != NULL)
+    {
+        return protocol_rx_bench(p_rx_bench_file);
+    }
+
+    /* Several devices are configured in parallel */
+    if ((nb_multi_devices > 1) || (p_devices_file != NULL))
+    {
+        return main_multi(argv[0]);
+    }
+
     if (p_device == NULL)
     {
         TRACE_ERR("No device selected");
@@ -682,10 +1017,25 @@ int main(int argc, char *argv[])
     }
 
     /* Initialization */
+    if (loop_init() < 0)
+    {
+        TRACE_ERR("loop_init failed");
+        return -1;
+    }
     protocol_init();
     hci_init();
     wiced_init();
 
+    if (p_rx_capture_file != NULL)
+    {
+        status = protocol_capture_open(p_rx_capture_file);
+        if (status < 0)
+        {
+            TRACE_ERR("protocol_capture_open failed");
+            return status;
+        }
+    }
+
     /* Open the Protocol (Com port). */
     status = protocol_open(p_device, baudrate, flow_control, protocol_cback);
     if (status < 0)
@@ -694,9 +1044,6 @@ int main(int argc, char *argv[])
         return status;
     }
 
-    /* Sleep some time to allow the Serial driver to start */
-    utils_msleep(500);
-
     /* If Change Local BdAddr parameter present */
     if (local_bdaddr_command)
     {
@@ -804,6 +1151,95 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (memory_threshold_command)
+    {
+        printf("Memory thresholds pool:%d%% heap:%d\n", memory_pool_threshold,
+                memory_heap_threshold);
+        status = wiced_cmd_memory_threshold_set(memory_pool_threshold, memory_heap_threshold);
+        if (status < 0)
+        {
+            TRACE_ERR("wiced_cmd_memory_threshold_set failed");
+            return status;
+        }
+    }
+
+    if (memory_capture >= 0)
+    {
+        printf("%s the Memory trend capture\n", memory_capture ? "Start" : "Stop");
+        status = wiced_cmd_memory_capture((uint8_t)memory_capture);
+        if (status < 0)
+        {
+            TRACE_ERR("wiced_cmd_memory_capture failed");
+            return status;
+        }
+    }
+
+    if (memory_trend_command)
+    {
+        printf("Memory Trend\n");
+        status = lrac_memory_trend_print();
+        if (status < 0)
+        {
+            TRACE_ERR("lrac_memory_trend_print failed");
+            return status;
+        }
+    }
+
+    if (p_memory_trend_file != NULL)
+    {
+        printf("Save the Memory usage in %s\n", p_memory_trend_file);
+        status = lrac_memory_trend_save(p_memory_trend_file);
+        if (status < 0)
+        {
+            TRACE_ERR("lrac_memory_trend_save failed");
+            return status;
+        }
+    }
+
+    if (nvram_stats_command)
+    {
+        printf("NVRAM Statistics\n");
+        status = lrac_nvram_stats_print();
+        if (status < 0)
+        {
+            TRACE_ERR("lrac_nvram_stats_print failed");
+            return status;
+        }
+    }
+
+    if (p_hci_ring_prev_file != NULL)
+    {
+        printf("Save the previous HCI Ring in %s\n", p_hci_ring_prev_file);
+        status = lrac_hci_ring_save(1, p_hci_ring_prev_file);
+        if (status < 0)
+        {
+            TRACE_ERR("lrac_hci_ring_save failed");
+            return status;
+        }
+    }
+
+    if (p_hci_ring_file != NULL)
+    {
+        printf("Save the HCI Ring in %s\n", p_hci_ring_file);
+        status = lrac_hci_ring_save(0, p_hci_ring_file);
+        if (status < 0)
+        {
+            TRACE_ERR("lrac_hci_ring_save failed");
+            return status;
+        }
+    }
+
+    if (hci_ring_enable >= 0)
+    {
+        printf("%s the HCI Ring\n", hci_ring_enable ? "Enable" : "Disable");
+        status = wiced_cmd_hci_ring_enable((uint8_t)hci_ring_enable);
+        if (status < 0)
+        {
+            TRACE_ERR("wiced_cmd_hci_ring_enable failed");
+            return status;
+        }
+    }
+
     if (lrac_trace_level_command)
     {
         printf("Set LRAC Trace Level:%d\n", lrac_trace_level);
@@ -874,7 +1310,8 @@ int main(int argc, char *argv[])
         }
         printf("Write Binary File:%s To Flash offset:0x%x\n", p_write_binary_file, flash_offset);
         /* Send the Binary file */
-        status = wiced_cmd_write_binary_file_to_flash(p_write_binary_file, flash_offset);
+        status = wiced_cmd_write_binary_file_to_flash(p_write_binary_file, flash_offset,
+                flash_window);
         if (status < 0)
         {
             TRACE_ERR("wiced_cmd_write_binary_file_to_flash failed");
@@ -907,6 +1344,23 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (p_batch_file != NULL)
+    {
+        status = batch_run(p_batch_file);
+        if (status != 0)
+        {
+            TRACE_ERR("batch_run failed (%d)", status);
+            protocol_close();
+            return -1;
+        }
+    }
+
+    if (wait_duration)
+    {
+        /* Handle (e.g. print) the received events */
+        loop_wait(wait_duration);
+    }
+
     /* Close the Protocol (Com port). */
     status = protocol_close();
     if (status < 0)
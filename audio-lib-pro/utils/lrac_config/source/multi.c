@@ -0,0 +1,270 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "multi.h"
+#include "lrac.h"
+#include "loop.h"
+#include "protocol.h"
+#include "wiced.h"
+
+/*
+ * Definitions
+ */
+typedef struct
+{
+    multi_device_param_t *p_device_param;
+    protocol_conn_t conn;
+    wiced_queue_t queue;
+    int opened;
+    int busy;
+    int status;
+    struct timespec ts_start;
+    double duration;
+} multi_device_t;
+
+/*
+ * Global variables
+ */
+static multi_device_t multi_devices[MULTI_DEVICE_MAX];
+
+/*
+ * Local functions
+ */
+static int multi_device_start(multi_device_t *p_dev, multi_param_t *p_param);
+static void multi_device_result_print(multi_device_t *p_dev);
+static void multi_protocol_cback(void *p_opaque, protocol_event_t event, uint16_t id,
+        uint8_t *p_data, int data_len);
+
+/*
+ * multi_run
+ */
+int multi_run(multi_device_param_t *p_devices, int nb_devices, multi_param_t *p_param)
+{
+    multi_device_t *p_dev;
+    struct timespec ts;
+    int nb_busy;
+    int nb_failed = 0;
+    int i;
+
+    TRACE_DBG("nb_devices:%d", nb_devices);
+
+    if ((nb_devices <= 0) || (nb_devices > MULTI_DEVICE_MAX))
+    {
+        TRACE_ERR("Wrong number of devices:%d (max %d)", nb_devices, MULTI_DEVICE_MAX);
+        return -1;
+    }
+
+    if (loop_init() < 0)
+    {
+        TRACE_ERR("loop_init failed");
+        return -1;
+    }
+
+    /* Open all the devices and send them their first commands */
+    memset(multi_devices, 0, sizeof(multi_devices));
+    for (i = 0; i < nb_devices; i++)
+    {
+        p_dev = &multi_devices[i];
+        p_dev->p_device_param = &p_devices[i];
+        clock_gettime(CLOCK_MONOTONIC, &p_dev->ts_start);
+        p_dev->status = multi_device_start(p_dev, p_param);
+        if (p_dev->status == 0)
+            p_dev->busy = 1;
+    }
+
+    /* Run the Event Loop until all the devices are done */
+    do
+    {
+        nb_busy = 0;
+        for (i = 0; i < nb_devices; i++)
+        {
+            p_dev = &multi_devices[i];
+            if (p_dev->busy == 0)
+                continue;
+
+            if ((p_dev->status == 0) &&
+                (wiced_queue_busy(&p_dev->queue)))
+            {
+                nb_busy++;
+                continue;
+            }
+
+            /* This device is done */
+            p_dev->busy = 0;
+            if (p_dev->status == 0)
+                p_dev->status = p_dev->queue.status;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            p_dev->duration = (double)(ts.tv_sec - p_dev->ts_start.tv_sec) +
+                    (double)(ts.tv_nsec - p_dev->ts_start.tv_nsec) / 1000000000.0;
+            TRACE_INFO("%s done status:%d", p_dev->p_device_param->p_device, p_dev->status);
+        }
+
+        /* The command timeouts are Event Loop timers (see wiced_queue_t) */
+        if (nb_busy)
+            loop_run(-1);
+    } while (nb_busy);
+
+    /* Print the results and close all the devices */
+    printf("%-24s %-8s %8s  %s\n", "Device", "Status", "Time(s)", "Flash");
+    for (i = 0; i < nb_devices; i++)
+    {
+        p_dev = &multi_devices[i];
+        multi_device_result_print(p_dev);
+        if (p_dev->status != 0)
+            nb_failed++;
+
+        wiced_queue_free(&p_dev->queue);
+        if (p_dev->opened)
+            protocol_conn_close(&p_dev->conn);
+    }
+    printf("%d/%d devices configured\n", nb_devices - nb_failed, nb_devices);
+
+    return nb_failed;
+}
+
+/*
+ * multi_device_start
+ * Open a device, queue all its commands and send the first ones
+ */
+static int multi_device_start(multi_device_t *p_dev, multi_param_t *p_param)
+{
+    multi_device_param_t *p_device_param = p_dev->p_device_param;
+    int status;
+
+    TRACE_DBG("device:%s", p_device_param->p_device);
+
+    status = wiced_queue_init(&p_dev->queue, &p_dev->conn, p_param->flash_window);
+    if (status < 0)
+        return status;
+
+    status = protocol_conn_open(&p_dev->conn, p_device_param->p_device, p_param->baudrate,
+            p_param->flow_control, multi_protocol_cback, p_dev);
+    if (status < 0)
+    {
+        TRACE_ERR("protocol_conn_open(%s) failed", p_device_param->p_device);
+        return status;
+    }
+    p_dev->opened = 1;
+
+    /* Same commands, in the same order, as for a single device (see main) */
+    if (p_device_param->local_bdaddr_command)
+        status = lrac_local_bdaddr_queue(&p_dev->queue, p_device_param->local_bdaddr);
+
+    if ((status == 0) && (p_device_param->peer_bdaddr_command))
+        status = lrac_peer_bdaddr_queue(&p_dev->queue, p_device_param->peer_bdaddr);
+
+    if ((status == 0) && (p_device_param->lrac_config_command))
+        status = lrac_config_queue(&p_dev->queue, p_device_param->lrac_config);
+
+    if ((status == 0) && (p_param->lrac_trace_level_command))
+        status = lrac_trace_level_queue(&p_dev->queue, p_param->lrac_trace_level);
+
+    if ((status == 0) && (p_param->sleep_enable_command))
+        status = lrac_sleep_config_queue(&p_dev->queue, p_param->sleep_enable);
+
+    if ((status == 0) && (p_param->p_write_binary_file != NULL))
+        status = wiced_queue_write_binary_file_to_flash(&p_dev->queue,
+                p_param->p_write_binary_file, p_param->flash_offset);
+
+    if ((status == 0) && (p_param->nvwrite_id_command))
+        status = wiced_queue_nvram_write(&p_dev->queue, p_param->nvwrite_id,
+                p_param->p_nvdata, p_param->nvdata_length);
+
+    if ((status == 0) &&
+        (p_device_param->local_bdaddr_command || p_device_param->lrac_config_command))
+        status = wiced_queue_reset(&p_dev->queue);
+
+    if (status < 0)
+    {
+        TRACE_ERR("Cannot queue the commands of %s", p_device_param->p_device);
+        return status;
+    }
+
+    return wiced_queue_start(&p_dev->queue);
+}
+
+/*
+ * multi_device_result_print
+ */
+static void multi_device_result_print(multi_device_t *p_dev)
+{
+    char status_str[16];
+
+    if (p_dev->status == 0)
+        snprintf(status_str, sizeof(status_str), "OK");
+    else
+        snprintf(status_str, sizeof(status_str), "ERR %d", p_dev->status);
+
+    printf("%-24s %-8s %8.2f", p_dev->p_device_param->p_device, status_str, p_dev->duration);
+    if (p_dev->queue.flash_nb_pages)
+    {
+        printf("  %d bytes, %d/%d pages skipped", p_dev->queue.flash_file_len,
+                p_dev->queue.flash_nb_skipped, p_dev->queue.flash_nb_pages);
+    }
+    printf("\n");
+}
+
+/*
+ * multi_protocol_cback
+ */
+static void multi_protocol_cback(void *p_opaque, protocol_event_t event, uint16_t id,
+        uint8_t *p_data, int data_len)
+{
+    multi_device_t *p_dev = p_opaque;
+
+    switch(event)
+    {
+    case PROTOCOL_EVENT_RX_WICED_EVENT:
+        if (wiced_queue_event_handler(&p_dev->queue, id, p_data, data_len) == 0)
+        {
+            TRACE_DBG("%s: Wiced event opcode:0x%04X len:%d", p_dev->p_device_param->p_device,
+                    id, data_len);
+        }
+        break;
+
+    case PROTOCOL_EVENT_DISCONNECT:
+        TRACE_ERR("%s disconnected", p_dev->p_device_param->p_device);
+        if (p_dev->status == 0)
+            p_dev->status = -1;
+        break;
+
+    default:
+        TRACE_DBG("%s: Protocol event:%d len:%d", p_dev->p_device_param->p_device, event,
+                data_len);
+        break;
+    }
+}
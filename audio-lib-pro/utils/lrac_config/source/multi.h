@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "utils.h"
+
+/*
+ * Definitions
+ */
+#define MULTI_DEVICE_MAX                    32
+
+/*
+ * Parameters of one device
+ */
+typedef struct
+{
+    char *p_device;
+    uint8_t local_bdaddr[BD_ADDR_LEN];
+    uint8_t local_bdaddr_command;
+    uint8_t peer_bdaddr[BD_ADDR_LEN];
+    uint8_t peer_bdaddr_command;
+    uint8_t lrac_config[2];
+    uint8_t lrac_config_command;
+} multi_device_param_t;
+
+/*
+ * Parameters common to all the devices
+ */
+typedef struct
+{
+    int baudrate;
+    int flow_control;
+    uint8_t lrac_trace_level_command;
+    uint8_t lrac_trace_level;
+    uint8_t sleep_enable_command;
+    uint8_t sleep_enable;
+    char *p_write_binary_file;
+    uint32_t flash_offset;
+    int flash_window;
+    uint8_t nvwrite_id_command;
+    uint16_t nvwrite_id;
+    uint8_t *p_nvdata;
+    uint32_t nvdata_length;
+} multi_param_t;
+
+/*
+ * multi_run
+ * Open all the devices and send them their commands in parallel (one Event Loop drives all
+ * the serial ports). The result of every device is printed.
+ * Returns the number of devices which failed.
+ */
+int multi_run(multi_device_param_t *p_devices, int nb_devices, multi_param_t *p_param);
@@ -34,7 +34,6 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdint.h>
-#include <pthread.h>
 #include <stdarg.h>
 #include <unistd.h>
 #include <time.h>
@@ -45,7 +44,6 @@
  * Global variables
  */
 trace_level_t trace_level = TRACE_LEVEL_INFO;
-pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
 /*
@@ -55,8 +53,6 @@ void utils_trace_dump(char *prefix, uint8_t *buf, int size)
 {
     int i;
 
-    utils_trace_lock();
-
     for (i = 0; i < size; i++)
     {
         if ((i%16) == 0)
@@ -70,8 +66,6 @@ void utils_trace_dump(char *prefix, uint8_t *buf, int size)
         }
     }
     fputs("\n", stdout);
-
-    utils_trace_unlock();
 }
 
 /*
@@ -100,22 +94,6 @@ void utils_msleep(int duration)
     nanosleep(&sleep_dur, NULL);
 }
 
-/*
- * utils_trace_lock
- */
-void utils_trace_lock(void)
-{
-    pthread_mutex_lock(&trace_mutex);
-}
-
-/*
- * utils_trace_unlock
- */
-void utils_trace_unlock(void)
-{
-    pthread_mutex_unlock(&trace_mutex);
-}
-
 /*
  * trace_level_set
  */
@@ -54,8 +54,6 @@ typedef enum
 
 extern trace_level_t trace_level;
 
-void utils_trace_lock(void);
-void utils_trace_unlock(void);
 void utils_trace_dump(char *prefix, uint8_t *buf, int size);
 
 
@@ -63,10 +61,8 @@ void utils_trace_dump(char *prefix, uint8_t *buf, int size);
     do { \
         if (trace_level >= TRACE_LEVEL_INFO) \
         { \
-            utils_trace_lock();\
             printf("%s: " format, __FUNCTION__, ##__VA_ARGS__); \
             printf("\n"); \
-            utils_trace_unlock();\
         } \
     } while (0)
 
@@ -74,10 +70,8 @@ void utils_trace_dump(char *prefix, uint8_t *buf, int size);
         do { \
             if (trace_level >= TRACE_LEVEL_DEBUG) \
             { \
-                utils_trace_lock();\
                 printf("%s: " format, __FUNCTION__, ##__VA_ARGS__); \
                 printf("\n"); \
-                utils_trace_unlock();\
             } \
         } while (0)
 
@@ -85,19 +79,15 @@ void utils_trace_dump(char *prefix, uint8_t *buf, int size);
         do { \
             if (trace_level >= TRACE_LEVEL_DEBUG_FULL) \
             { \
-                utils_trace_lock();\
                 printf("%s: " format, __FUNCTION__, ##__VA_ARGS__); \
                 printf("\n"); \
-                utils_trace_unlock();\
             } \
         } while (0)
 
 #define TRACE_ERR(format, ...) \
         do { \
-            utils_trace_lock();\
             printf("ERROR %s: " format, __FUNCTION__, ##__VA_ARGS__); \
             printf("\n"); \
-            utils_trace_unlock();\
         } while (0)
 
 #define TRACE_DUMP(a, b, c) \
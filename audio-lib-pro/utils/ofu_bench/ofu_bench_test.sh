@@ -0,0 +1,133 @@
+#!/bin/sh
+#
+# Host test of the Delta and Compressed Downloads:
+# - the Patch generated by ofu-delta.py is sent to the OFU Server (Delta Download command) which
+#   reconstructs the Image from its Active Partition
+# - the stream packaged by ofu-compress.py is sent to the OFU Server (Compressed Download command)
+#   which decompresses the Image
+# - the Image is forwarded to the peer LRAC device while it is received (Fan-out)
+# Usage: ofu_bench_test.sh (after make)
+
+BENCH=./ofu_bench.exe
+SCRIPTS=../lrac_config
+TMP_DIR=$(mktemp -d)
+NB_FAILED=0
+
+trap 'rm -rf $TMP_DIR' EXIT
+
+# expect <0|1> <description> <ofu_bench options>: run ofu_bench and check its exit status
+expect()
+{
+    EXPECTED=$1
+    DESCRIPTION=$2
+    shift 2
+    $BENCH "$@" > $TMP_DIR/bench.log 2>&1
+    STATUS=$?
+    if [ $STATUS -eq $EXPECTED ]; then
+        echo "PASS: $DESCRIPTION"
+    else
+        echo "FAIL: $DESCRIPTION (status:$STATUS expected:$EXPECTED)"
+        cat $TMP_DIR/bench.log
+        NB_FAILED=$((NB_FAILED + 1))
+    fi
+}
+
+# Base Image and New Image: the New Image is the Base Image with inserted, modified and
+# removed parts (as a FW rebuilt after a small change)
+python3 - $TMP_DIR <<'PYTHON'
+import random
+import struct
+import sys
+
+random.seed(1)
+base = bytearray(random.getrandbits(8) for i in range(200000))
+new = bytearray(base)
+new[1000:1000] = bytearray(random.getrandbits(8) for i in range(300))
+new[50000:50100] = bytearray(100)
+del new[120000:125000]
+new[150000:150000] = base[10000:14000]
+new += bytearray(random.getrandbits(8) for i in range(777))
+other = bytearray(base)
+other[190000] ^= 0xFF
+
+# Compressible Image (repeated instruction sequences and an erased area)
+words = [bytearray(random.getrandbits(8) for i in range(random.randint(2, 12))) for j in range(300)]
+code = bytearray()
+while len(code) < 150000:
+    code += random.choice(words)
+code += bytearray([0xFF] * 5000)
+code += bytearray(random.getrandbits(8) for i in range(1000))
+
+# Secure Images: DS prefix, Product, Version, length (without prefix and Signature), Signature
+def secure(major, body, len_error=0):
+    header = b'BRCMcfgD' + struct.pack('<HBBI', 0, major, 0, 16 + len(body) + len_error - 8)
+    return bytearray(header) + body + bytearray(64)
+
+sbase = secure(1, base)
+snew = secure(1, new)
+sold = secure(0, new)
+sbadlen = secure(1, new, 4)
+
+for name, data in (('base', base), ('new', new), ('other', other), ('code', code),
+                   ('sbase', sbase), ('snew', snew), ('sold', sold), ('sbadlen', sbadlen)):
+    with open('%s/%s.bin' % (sys.argv[1], name), 'wb') as f:
+        f.write(data)
+PYTHON
+
+python3 $SCRIPTS/ofu-delta.py -o $TMP_DIR/base.bin -n $TMP_DIR/new.bin -p $TMP_DIR/patch.bin -g \
+        || exit 1
+
+python3 $SCRIPTS/ofu-compress.py -c -i $TMP_DIR/code.bin -o $TMP_DIR/code.ofuz || exit 1
+python3 $SCRIPTS/ofu-compress.py -c -i $TMP_DIR/new.bin -o $TMP_DIR/new.ofuz || exit 1
+python3 $SCRIPTS/ofu-delta.py -o $TMP_DIR/sbase.bin -n $TMP_DIR/snew.bin -p $TMP_DIR/snew.patch -g \
+        || exit 1
+python3 $SCRIPTS/ofu-delta.py -o $TMP_DIR/sbase.bin -n $TMP_DIR/sold.bin -p $TMP_DIR/sold.patch -g \
+        || exit 1
+python3 $SCRIPTS/ofu-compress.py -c -i $TMP_DIR/snew.bin -o $TMP_DIR/snew.ofuz || exit 1
+python3 $SCRIPTS/ofu-compress.py -c -i $TMP_DIR/sbadlen.bin -o $TMP_DIR/sbadlen.ofuz || exit 1
+
+DELTA="-i $TMP_DIR/new.bin -b $TMP_DIR/base.bin -d $TMP_DIR/patch.bin"
+COMPRESSED="-i $TMP_DIR/code.bin -z $TMP_DIR/code.ofuz"
+
+expect 0 "Delta Download over SPP" -t spp $DELTA
+expect 0 "Delta Download over LE" -t ble $DELTA
+expect 0 "Delta Download over LE Stream" -t bles $DELTA
+# Operations split across (many) Data packets
+expect 0 "Delta Download over LE (MTU 23)" -t ble -m 23 $DELTA
+expect 0 "Delta Download over SPP (MTU 100)" -t spp -m 100 $DELTA
+# The Active Partition is not the Base Image of the Patch
+expect 1 "Delta Download refused (other Base Image)" -t spp $DELTA -a $TMP_DIR/other.bin
+expect 0 "Compressed Download over SPP" -t spp $COMPRESSED
+expect 0 "Compressed Download over LE" -t ble $COMPRESSED
+expect 0 "Compressed Download over LE Stream" -t bles $COMPRESSED
+# Groups and Matches split across (many) Data packets
+expect 0 "Compressed Download over LE (MTU 23)" -t ble -m 23 $COMPRESSED
+# Incompressible Image (the stream is longer than the Image)
+expect 0 "Compressed Download of a random Image" -t spp -i $TMP_DIR/new.bin -z $TMP_DIR/new.ofuz
+# Secure upgrade: the header of the reconstructed Image is checked (Product, Version, length)
+expect 0 "Secure Delta Download" -t spp -e -i $TMP_DIR/snew.bin -b $TMP_DIR/sbase.bin \
+        -d $TMP_DIR/snew.patch
+expect 1 "Secure Delta Download refused (older Image)" -t spp -e -i $TMP_DIR/sold.bin \
+        -b $TMP_DIR/sbase.bin -d $TMP_DIR/sold.patch
+expect 0 "Secure Compressed Download" -t bles -e -i $TMP_DIR/snew.bin -z $TMP_DIR/snew.ofuz
+expect 1 "Secure Compressed Download refused (wrong length)" -t bles -e -i $TMP_DIR/sbadlen.bin \
+        -z $TMP_DIR/sbadlen.ofuz
+expect 1 "Secure Compressed Download refused (no header)" -t spp -e -i $TMP_DIR/new.bin \
+        -z $TMP_DIR/new.ofuz
+# Regular Download (non regression)
+expect 0 "Download over SPP" -t spp -i $TMP_DIR/new.bin
+# Fan-out: the device forwards the committed Data to its peer LRAC device. The Phone is slower
+# (LE) or faster (SPP) than the LRAC Link
+expect 0 "Fan-out over SPP" -t spp -f -i $TMP_DIR/new.bin
+expect 0 "Fan-out over LE" -t ble -f -i $TMP_DIR/new.bin
+expect 0 "Fan-out over LE Stream" -t bles -f -i $TMP_DIR/new.bin
+# Packets lost on the LRAC Link (retransmitted Data)
+expect 0 "Fan-out over LE (5% loss)" -t ble -f -p 5 -i $TMP_DIR/new.bin
+expect 0 "Fan-out of a Delta Download" -t bles -f $DELTA
+expect 0 "Fan-out of a Compressed Download" -t bles -f $COMPRESSED
+
+if [ $NB_FAILED -ne 0 ]; then
+    echo "$NB_FAILED test(s) failed"
+    exit 1
+fi
+echo "All tests passed"
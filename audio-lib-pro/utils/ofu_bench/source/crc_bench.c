@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. CRC32 micro-benchmark (host time, not simulated).
+ *
+ *  The CRC32 module is built once per slice (see GNUmakefile). crc32_Update runs from the ROM
+ *  and cannot be built for the host: it is represented by a bitwise implementation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "crc_bench.h"
+
+/*
+ * Definitions
+ */
+/* Minimum measurement time per implementation */
+#define CRC_BENCH_DURATION_NS               (200 * 1000000ULL)
+
+/* Lengths and offsets (unaligned data) of the cross-check */
+#define CRC_BENCH_CHECK_NB                  64
+
+typedef uint32_t (crc_bench_update_t)(uint32_t crc32, const uint8_t *p_data, uint32_t length);
+
+typedef struct
+{
+    const char *p_name;
+    crc_bench_update_t *p_update;
+    uint32_t table_size;                /* Flash used by the tables */
+} crc_bench_impl_t;
+
+/*
+ * Local functions
+ */
+static uint32_t crc_bench_bitwise_update(uint32_t crc32, const uint8_t *p_data, uint32_t length);
+static uint64_t crc_bench_now_ns(void);
+
+/*
+ * External functions (app_ofu_crc32.c built for every slice)
+ */
+uint32_t app_ofu_crc32_update_slice1(uint32_t crc32, const uint8_t *p_data, uint32_t length);
+uint32_t app_ofu_crc32_update_slice4(uint32_t crc32, const uint8_t *p_data, uint32_t length);
+uint32_t app_ofu_crc32_update_slice8(uint32_t crc32, const uint8_t *p_data, uint32_t length);
+
+/*
+ * Global variables
+ */
+static const crc_bench_impl_t crc_bench_impl[] =
+{
+    {"bitwise (crc32_Update)", crc_bench_bitwise_update, 0},
+    {"slice-by-1", app_ofu_crc32_update_slice1, 1 * 1024},
+    {"slice-by-4", app_ofu_crc32_update_slice4, 4 * 1024},
+    {"slice-by-8", app_ofu_crc32_update_slice8, 8 * 1024},
+};
+#define CRC_BENCH_IMPL_NB   (sizeof(crc_bench_impl) / sizeof(crc_bench_impl[0]))
+
+/*
+ * crc_bench_run
+ */
+int crc_bench_run(const uint8_t *p_image, uint32_t image_len)
+{
+    const crc_bench_impl_t *p_impl;
+    uint32_t zlib_crc32;
+    uint32_t value;
+    uint32_t offset;
+    uint32_t length;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint64_t nb_bytes;
+    double ref_rate = 0;
+    double rate;
+    int nb_error = 0;
+    uint32_t i;
+    int j;
+
+    zlib_crc32 = crc32(0, p_image, image_len);
+
+    printf("CRC32 of %d bytes (zlib:0x%08X), host time\n", image_len, zlib_crc32);
+
+    for (i = 0; i < CRC_BENCH_IMPL_NB; i++)
+    {
+        p_impl = &crc_bench_impl[i];
+
+        /* Cross-check: whole Image, then unaligned sub-buffers computed in two parts */
+        value = p_impl->p_update(0xFFFFFFFF, p_image, image_len) ^ 0xFFFFFFFF;
+        if (value != zlib_crc32)
+        {
+            printf("Err: %s CRC32:0x%08X zlib:0x%08X\n", p_impl->p_name, value, zlib_crc32);
+            nb_error++;
+        }
+        for (j = 0; j < CRC_BENCH_CHECK_NB; j++)
+        {
+            offset = rand() % image_len;
+            length = rand() % (image_len - offset + 1);
+            value = p_impl->p_update(0xFFFFFFFF, &p_image[offset], length / 3);
+            value = p_impl->p_update(value, &p_image[offset + length / 3],
+                    length - length / 3) ^ 0xFFFFFFFF;
+            if (value != crc32(0, &p_image[offset], length))
+            {
+                printf("Err: %s offset:%d length:%d CRC32 mismatch\n", p_impl->p_name, offset,
+                        length);
+                nb_error++;
+            }
+        }
+
+        /* Throughput */
+        nb_bytes = 0;
+        start_ns = crc_bench_now_ns();
+        do
+        {
+            value = p_impl->p_update(0xFFFFFFFF, p_image, image_len);
+            nb_bytes += image_len;
+            duration_ns = crc_bench_now_ns() - start_ns;
+        } while (duration_ns < CRC_BENCH_DURATION_NS);
+
+        rate = (double)nb_bytes * 1000.0 / duration_ns;    /* MB/s */
+        if (i == 0)
+        {
+            ref_rate = rate;
+        }
+        printf("%-24s tables:%5d bytes %8.1f MB/s x%.1f %8.1f us per Image\n", p_impl->p_name,
+                p_impl->table_size, rate, rate / ref_rate, image_len / rate);
+    }
+
+    printf("Result:         %s\n", nb_error ? "Failed" : "Verified");
+
+    return nb_error ? -1 : 0;
+}
+
+/*
+ * crc_bench_bitwise_update
+ * Bitwise CRC32 (IEEE 802.3, reflected). No table.
+ */
+static uint32_t crc_bench_bitwise_update(uint32_t crc32, const uint8_t *p_data, uint32_t length)
+{
+    uint32_t i;
+
+    while (length--)
+    {
+        crc32 ^= *p_data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc32 = (crc32 >> 1) ^ (0xEDB88320 & (0 - (crc32 & 1)));
+        }
+    }
+
+    return crc32;
+}
+
+/*
+ * crc_bench_now_ns
+ */
+static uint64_t crc_bench_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
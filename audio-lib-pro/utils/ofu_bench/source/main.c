@@ -0,0 +1,1305 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Measures the OFU download time over simulated SPP, LE and LRAC Links.
+ *  The Phone can also send a Patch (Delta Download) or a compressed Image (Compressed Download).
+ *  The device can forward the Image to its peer LRAC device while it is received (Fan-out).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "wiced.h"
+#include "app_ofu.h"
+#include "app_ofu_srv.h"
+#include "app_ofu_clt.h"
+#include "app_ofu_lrac.h"
+#include "app_ofu_crc32.h"
+#include "app_ofu_ble.h"
+#include "app_lrac.h"
+#include "ota_fw_upgrade.h"
+#include "sim.h"
+#include "stub.h"
+#include "crc_bench.h"
+
+/*
+ * Definitions
+ */
+#define BENCH_IMAGE_SIZE_DEFAULT            (256 * 1024)
+#define BENCH_DS_HEADER_LEN                 (4 * sizeof(uint32_t))
+#define BENCH_TIME_LIMIT_US                 (600 * 1000000ULL)
+/* Phone packet: OFU Header and Payload */
+#define BENCH_PHONE_PACKET_MAX              1024
+/* Package generated by ofu-compress.py: 'OFUZ', Version, Image length, Image CRC32, stream */
+#define BENCH_OFUZ_HEADER_LEN               16
+#define BENCH_OFUZ_VERSION                  2
+
+typedef enum
+{
+    BENCH_TRANSPORT_BLE = 0,
+    BENCH_TRANSPORT_BLE_STREAM,
+    BENCH_TRANSPORT_SPP,
+    BENCH_TRANSPORT_LRAC,
+} bench_transport_t;
+
+typedef enum
+{
+    BENCH_PHONE_STATE_PREPARE = 0,
+    BENCH_PHONE_STATE_IMAGE_INFO,
+    BENCH_PHONE_STATE_DOWNLOAD,
+    BENCH_PHONE_STATE_DATA,
+    BENCH_PHONE_STATE_VERIFY,
+} bench_phone_state_t;
+
+typedef struct
+{
+    const char *p_name;
+    uint16_t mtu;                   /* Transport MTU */
+    uint16_t overhead;              /* Transport header (subtracted from the MTU) */
+    uint32_t latency_us;
+    uint32_t rate_bps;
+    int reliable;
+    uint32_t retx_delay_us;
+    uint8_t window;                 /* Phone Data packets sent without Response (or Credits) */
+    int credits;                    /* Credits returned by batch (instead of a Response per packet) */
+} bench_transport_param_t;
+
+typedef struct
+{
+    bench_transport_t transport;
+    uint16_t mtu;
+    uint8_t window;
+    uint8_t *p_image;
+    uint32_t image_len;
+    uint32_t image_crc32;
+    uint8_t image_major;            /* Version sent in the Image Info */
+    int secure;                     /* Secure upgrade (the device has a Public Key) */
+    uint8_t download_command;       /* Download, Delta or Compressed Download */
+    uint8_t *p_payload;             /* Data sent by the Phone (Image, Patch or compressed Image) */
+    uint32_t payload_len;
+    uint8_t *p_base;                /* Base Image the Patch has been generated from */
+    uint32_t base_len;
+    sim_link_t link_to_device;      /* Phone (or Primary) to the upgraded device */
+    sim_link_t link_to_client;      /* Upgraded device to the Phone (or Primary) */
+    /* Fan-out: the device (Relay OFU Client) forwards the Image to the peer LRAC device */
+    int fanout;
+    sim_link_t link_to_peer;
+    sim_link_t link_from_peer;
+    int phone_verified;
+    /* Phone Client */
+    bench_phone_state_t phone_state;
+    uint32_t phone_offset;
+    uint8_t phone_outstanding;
+    /* Device */
+    uint8_t device_credits;         /* Credits not yet returned to the Phone */
+    /* Peer LRAC device (Fan-out) */
+    uint8_t *p_peer_image;
+    uint32_t peer_len;              /* Image length received in the Download command */
+    uint32_t peer_offset;           /* Data received in sequence */
+    uint64_t peer_data_bytes;       /* Image bytes forwarded (including retransmissions) */
+    uint64_t peer_done_us;
+    int peer_verified;
+    /* Results */
+    uint64_t data_bytes;            /* Image bytes sent (including retransmissions) */
+    uint64_t done_us;
+    int done;
+    int verified;
+} bench_cb_t;
+
+/*
+ * Global variables
+ */
+static bench_cb_t bench_cb;
+
+/* Public Key of a Secure upgrade. Unused: the Signature is not checked on the host */
+static uint8_t bench_ecdsa_public_key[64];
+
+static const bench_transport_param_t bench_transport_param[] =
+{
+    /* LE: ATT Write Request (3 bytes ATT header), Response for every packet */
+    [BENCH_TRANSPORT_BLE] = {"LE", 517, 3, 7500, 700000, 1, 7500, 1, 0},
+    /* LE Stream: ATT Write Without Response, Credits (Notification) returned by batch */
+    [BENCH_TRANSPORT_BLE_STREAM] = {"LE Stream", 517, 3, 7500, 700000, 1, 7500,
+            APP_OFU_BLE_STREAM_CREDITS, 1},
+    /* SPP: OFU Header and Payload Length, Status for every packet (pipelined) */
+    [BENCH_TRANSPORT_SPP] = {"SPP", 1021, 3, 10000, 1000000, 1, 1250, APP_OFU_WINDOW_SIZE, 0},
+    /* LRAC: OFU Client (windowed transfer) on an unreliable Link */
+    [BENCH_TRANSPORT_LRAC] = {"LRAC", 512, 0, 5000, 1000000, 0, 0, 0, 0},
+};
+
+/*
+ * Local functions
+ */
+static void bench_usage(const char *p_name);
+static int bench_image_load(const char *p_file, uint32_t size, int add_header);
+static int bench_file_read(const char *p_file, uint8_t **pp_data, uint32_t *p_len);
+static int bench_delta_load(const char *p_base_file, const char *p_patch_file,
+        const char *p_active_file);
+static int bench_compressed_load(const char *p_package_file);
+static void bench_phone_start(void);
+static void bench_phone_image_info_send(void);
+static void bench_phone_send(uint8_t header, uint8_t *p_data, uint16_t length);
+static void bench_phone_data_send(void);
+static void bench_phone_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+static void bench_device_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+static void bench_srv_callback(app_ofu_event_t event);
+static void bench_lrac_start(void);
+static void bench_lrac_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+static void bench_lrac_callback(app_ofu_event_t event, app_ofu_event_data_t *p_data);
+static void bench_peer_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+static void bench_peer_send(uint8_t status, uint8_t *p_data, uint16_t length);
+static void bench_relay_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+static void bench_done(int verified);
+static void bench_report(void);
+
+/*
+ * main
+ */
+int main(int argc, char **argv)
+{
+    const bench_transport_param_t *p_param;
+    const char *p_image_file = NULL;
+    const char *p_base_file = NULL;
+    const char *p_patch_file = NULL;
+    const char *p_active_file = NULL;
+    const char *p_package_file = NULL;
+    uint32_t image_size = BENCH_IMAGE_SIZE_DEFAULT;
+    int mtu = -1;
+    int latency_ms = -1;
+    int rate_kbps = -1;
+    int loss_percent = 0;
+    int flash_us_per_kb = 2000;
+    uint32_t seed = 1;
+    int crc_bench = 0;
+    int status;
+    int opt;
+
+    bench_cb.transport = BENCH_TRANSPORT_LRAC;
+    bench_cb.image_major = APP_OFU_VERSION_MAJOR;
+    bench_cb.download_command = WICED_OTA_UPGRADE_COMMAND_DOWNLOAD;
+
+    while ((opt = getopt(argc, argv, "i:s:t:m:l:r:p:w:S:V:b:d:a:z:fecvh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            p_image_file = optarg;
+            break;
+        case 's':
+            image_size = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            if (strcmp(optarg, "ble") == 0)
+                bench_cb.transport = BENCH_TRANSPORT_BLE;
+            else if (strcmp(optarg, "bles") == 0)
+                bench_cb.transport = BENCH_TRANSPORT_BLE_STREAM;
+            else if (strcmp(optarg, "spp") == 0)
+                bench_cb.transport = BENCH_TRANSPORT_SPP;
+            else if (strcmp(optarg, "lrac") == 0)
+                bench_cb.transport = BENCH_TRANSPORT_LRAC;
+            else
+            {
+                fprintf(stderr, "Err: unknown transport %s\n", optarg);
+                bench_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm':
+            mtu = atoi(optarg);
+            break;
+        case 'l':
+            latency_ms = atoi(optarg);
+            break;
+        case 'r':
+            rate_kbps = atoi(optarg);
+            break;
+        case 'p':
+            loss_percent = atoi(optarg);
+            break;
+        case 'w':
+            flash_us_per_kb = atoi(optarg);
+            break;
+        case 'S':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'V':
+            bench_cb.image_major = atoi(optarg);
+            break;
+        case 'b':
+            p_base_file = optarg;
+            break;
+        case 'd':
+            p_patch_file = optarg;
+            break;
+        case 'a':
+            p_active_file = optarg;
+            break;
+        case 'z':
+            p_package_file = optarg;
+            break;
+        case 'f':
+            bench_cb.fanout = 1;
+            break;
+        case 'e':
+            bench_cb.secure = 1;
+            p_ecdsa_public_key = bench_ecdsa_public_key;
+            break;
+        case 'c':
+            crc_bench = 1;
+            break;
+        case 'v':
+            stub_verbose = 1;
+            break;
+        case 'h':
+        default:
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* A reliable Link would retransmit forever */
+    if ((loss_percent < 0) || (loss_percent > 90))
+    {
+        fprintf(stderr, "Err: loss must be in [0, 90] percent\n");
+        return 1;
+    }
+    if ((rate_kbps == 0) || (flash_us_per_kb < 0))
+    {
+        fprintf(stderr, "Err: wrong rate or flash write time\n");
+        return 1;
+    }
+
+    p_param = &bench_transport_param[bench_cb.transport];
+    bench_cb.mtu = (mtu > 0) ? mtu : p_param->mtu;
+    if ((bench_cb.mtu <= p_param->overhead) || (bench_cb.mtu > 1021))
+    {
+        fprintf(stderr, "Err: wrong mtu:%d\n", bench_cb.mtu);
+        return 1;
+    }
+    bench_cb.window = p_param->window;
+
+    sim_init(seed);
+    srand(seed);
+    sim_flash.write_us_per_kb = flash_us_per_kb;
+
+    /* The Patch is generated from the files (the Image is used as is) */
+    if ((p_patch_file) &&
+        ((p_image_file == NULL) || (p_base_file == NULL) ||
+         (bench_cb.transport == BENCH_TRANSPORT_LRAC)))
+    {
+        fprintf(stderr, "Err: the Delta Download needs -i, -b and a Phone transport\n");
+        return 1;
+    }
+    if ((p_package_file) &&
+        ((p_image_file == NULL) || (p_patch_file) ||
+         (bench_cb.transport == BENCH_TRANSPORT_LRAC)))
+    {
+        fprintf(stderr, "Err: the Compressed Download needs -i and a Phone transport\n");
+        return 1;
+    }
+    if ((bench_cb.fanout) &&
+        (bench_cb.transport == BENCH_TRANSPORT_LRAC))
+    {
+        fprintf(stderr, "Err: the Fan-out needs a Phone transport\n");
+        return 1;
+    }
+
+    if (bench_image_load(p_image_file, image_size,
+            (p_patch_file == NULL) && (p_package_file == NULL)) != 0)
+    {
+        return 1;
+    }
+    bench_cb.p_payload = bench_cb.p_image;
+    bench_cb.payload_len = bench_cb.image_len;
+
+    if ((p_patch_file) &&
+        (bench_delta_load(p_base_file, p_patch_file, p_active_file) != 0))
+    {
+        return 1;
+    }
+    if ((p_package_file) &&
+        (bench_compressed_load(p_package_file) != 0))
+    {
+        return 1;
+    }
+
+    /* CRC32 micro-benchmark only (no download) */
+    if (crc_bench)
+    {
+        status = crc_bench_run(bench_cb.p_image, bench_cb.image_len);
+        free(bench_cb.p_image);
+        return status ? 1 : 0;
+    }
+
+    /* Links */
+    bench_cb.link_to_device.p_name = "to device";
+    bench_cb.link_to_client.p_name = "to client";
+    bench_cb.link_to_device.latency_us = bench_cb.link_to_client.latency_us =
+            (latency_ms >= 0) ? latency_ms * 1000 : p_param->latency_us;
+    bench_cb.link_to_device.rate_bps = bench_cb.link_to_client.rate_bps =
+            (rate_kbps > 0) ? rate_kbps * 1000 : p_param->rate_bps;
+    bench_cb.link_to_device.loss_percent = bench_cb.link_to_client.loss_percent = loss_percent;
+    bench_cb.link_to_device.reliable = bench_cb.link_to_client.reliable = p_param->reliable;
+    bench_cb.link_to_device.retx_delay_us = bench_cb.link_to_client.retx_delay_us =
+            p_param->retx_delay_us;
+
+    /* Fan-out: LRAC Link (not reliable) between the device and its peer */
+    if (bench_cb.fanout)
+    {
+        p_param = &bench_transport_param[BENCH_TRANSPORT_LRAC];
+        bench_cb.link_to_peer.p_name = "to peer";
+        bench_cb.link_from_peer.p_name = "from peer";
+        bench_cb.link_to_peer.latency_us = bench_cb.link_from_peer.latency_us =
+                p_param->latency_us;
+        bench_cb.link_to_peer.rate_bps = bench_cb.link_from_peer.rate_bps = p_param->rate_bps;
+        bench_cb.link_to_peer.loss_percent = bench_cb.link_from_peer.loss_percent =
+                loss_percent;
+        bench_cb.link_to_peer.p_rx_handler = bench_peer_rx_handler;
+        bench_cb.link_from_peer.p_rx_handler = bench_relay_rx_handler;
+        bench_cb.p_peer_image = malloc(STUB_PARTITION_SIZE);
+        if (bench_cb.p_peer_image == NULL)
+        {
+            fprintf(stderr, "Err: no memory\n");
+            return 1;
+        }
+        memset(bench_cb.p_peer_image, 0xFF, STUB_PARTITION_SIZE);
+    }
+
+    if (bench_cb.transport == BENCH_TRANSPORT_LRAC)
+    {
+        bench_cb.link_to_device.p_rx_handler = bench_lrac_rx_handler;
+        bench_cb.link_to_client.p_rx_handler = bench_lrac_rx_handler;
+        bench_lrac_start();
+    }
+    else
+    {
+        bench_cb.link_to_device.p_rx_handler = bench_device_rx_handler;
+        bench_cb.link_to_client.p_rx_handler = bench_phone_rx_handler;
+        bench_phone_start();
+    }
+
+    sim_run(BENCH_TIME_LIMIT_US);
+
+    bench_report();
+
+    free(bench_cb.p_image);
+    if (bench_cb.p_payload != bench_cb.p_image)
+    {
+        free(bench_cb.p_payload);
+    }
+    free(bench_cb.p_base);
+    free(bench_cb.p_peer_image);
+
+    return bench_cb.verified ? 0 : 1;
+}
+
+/*
+ * bench_usage
+ */
+static void bench_usage(const char *p_name)
+{
+    fprintf(stderr, "Usage: %s [options]\n", p_name);
+    fprintf(stderr, "  -i <file>   FW Image (DS binary). Random Image if not set\n");
+    fprintf(stderr, "  -s <size>   Size of the random Image (default %d)\n",
+            BENCH_IMAGE_SIZE_DEFAULT);
+    fprintf(stderr, "  -t <trans>  Transport: ble, bles (LE Stream), spp or lrac (default lrac)\n");
+    fprintf(stderr, "  -m <mtu>    Transport MTU (default ble/bles:%d spp:%d lrac:%d)\n",
+            bench_transport_param[BENCH_TRANSPORT_BLE].mtu,
+            bench_transport_param[BENCH_TRANSPORT_SPP].mtu,
+            bench_transport_param[BENCH_TRANSPORT_LRAC].mtu);
+    fprintf(stderr, "  -l <ms>     One way Link latency\n");
+    fprintf(stderr, "  -r <kbps>   Link throughput\n");
+    fprintf(stderr, "  -p <loss>   Packet loss in percent (retransmitted by the Link for ble/spp)\n");
+    fprintf(stderr, "  -w <us>     Flash write time per KB (default 2000)\n");
+    fprintf(stderr, "  -S <seed>   Random seed (default 1)\n");
+    fprintf(stderr, "  -V <major>  Image Major version sent by the Phone (default %d)\n",
+            APP_OFU_VERSION_MAJOR);
+    fprintf(stderr, "  -b <file>   Base Image the Patch has been generated from (Delta Download)\n");
+    fprintf(stderr, "  -d <file>   Patch (ofu-delta.py) sent with a Delta Download (needs -i and -b)\n");
+    fprintf(stderr, "  -a <file>   Active Partition of the device (default: Base Image)\n");
+    fprintf(stderr, "  -z <file>   Package (ofu-compress.py) sent with a Compressed Download (needs -i)\n");
+    fprintf(stderr, "  -e          Secure upgrade (the Image header is checked, not the Signature)\n");
+    fprintf(stderr, "  -f          Fan-out: the device forwards the Image to its peer LRAC device\n");
+    fprintf(stderr, "  -c          CRC32 benchmark (every slice) on the Image, no download\n");
+    fprintf(stderr, "  -v          Verbose (OFU traces)\n");
+}
+
+/*
+ * bench_image_load
+ * Load (or generate) the Image and write it in the simulated Active Partition
+ */
+static int bench_image_load(const char *p_file, uint32_t size, int add_header)
+{
+    FILE *p_fd;
+    struct stat file_stat;
+    uint8_t *p;
+    uint32_t i;
+
+    if (p_file)
+    {
+        if (stat(p_file, &file_stat) != 0)
+        {
+            fprintf(stderr, "Err: cannot stat %s\n", p_file);
+            return -1;
+        }
+        size = file_stat.st_size;
+    }
+
+    /* Add a DS Header if the Image does not have one */
+    bench_cb.p_image = malloc(size + BENCH_DS_HEADER_LEN);
+    if (bench_cb.p_image == NULL)
+    {
+        fprintf(stderr, "Err: no memory\n");
+        return -1;
+    }
+    p = &bench_cb.p_image[BENCH_DS_HEADER_LEN];
+
+    if (p_file)
+    {
+        p_fd = fopen(p_file, "rb");
+        if ((p_fd == NULL) ||
+            (fread(p, 1, size, p_fd) != size))
+        {
+            fprintf(stderr, "Err: cannot read %s\n", p_file);
+            if (p_fd)
+                fclose(p_fd);
+            return -1;
+        }
+        fclose(p_fd);
+    }
+    else
+    {
+        for (i = 0; i < size; i++)
+        {
+            p[i] = rand();
+        }
+    }
+
+    if ((add_header == 0) ||
+        ((size >= DS_IMAGE_PREFIX_LEN) &&
+         (memcmp(p, ds_image_prefix, DS_IMAGE_PREFIX_LEN) == 0)))
+    {
+        memmove(bench_cb.p_image, p, size);
+        bench_cb.image_len = size;
+    }
+    else
+    {
+        p = bench_cb.p_image;
+        ARRAY_TO_STREAM(p, ds_image_prefix, DS_IMAGE_PREFIX_LEN);
+        if (bench_cb.secure)
+        {
+            /* Secure Image: Product, Version and length (without prefix and Signature) */
+            UINT16_TO_STREAM(p, APP_OFU_PRODUCT_ID);
+            UINT8_TO_STREAM(p, bench_cb.image_major);
+            UINT8_TO_STREAM(p, 0);
+            UINT32_TO_STREAM(p, size + BENCH_DS_HEADER_LEN - DS_IMAGE_PREFIX_LEN - SIGNATURE_LEN);
+        }
+        else
+        {
+            UINT32_TO_STREAM(p, 0);
+            UINT32_TO_STREAM(p, size);
+        }
+        bench_cb.image_len = size + BENCH_DS_HEADER_LEN;
+    }
+
+    if (bench_cb.image_len > STUB_PARTITION_SIZE)
+    {
+        fprintf(stderr, "Err: Image too big:%d (max %d)\n", bench_cb.image_len,
+                STUB_PARTITION_SIZE);
+        return -1;
+    }
+    memcpy(stub_flash.active, bench_cb.p_image, bench_cb.image_len);
+
+    bench_cb.image_crc32 = app_ofu_crc32_update(APP_OFU_CRC32_INIT, bench_cb.p_image,
+            bench_cb.image_len) ^ 0xFFFFFFFF;
+
+    return 0;
+}
+
+/*
+ * bench_file_read
+ */
+static int bench_file_read(const char *p_file, uint8_t **pp_data, uint32_t *p_len)
+{
+    FILE *p_fd;
+    struct stat file_stat;
+
+    if (stat(p_file, &file_stat) != 0)
+    {
+        fprintf(stderr, "Err: cannot stat %s\n", p_file);
+        return -1;
+    }
+
+    *p_len = file_stat.st_size;
+    *pp_data = malloc(*p_len + 1);
+    if (*pp_data == NULL)
+    {
+        fprintf(stderr, "Err: no memory\n");
+        return -1;
+    }
+
+    p_fd = fopen(p_file, "rb");
+    if ((p_fd == NULL) ||
+        (fread(*pp_data, 1, *p_len, p_fd) != *p_len))
+    {
+        fprintf(stderr, "Err: cannot read %s\n", p_file);
+        if (p_fd)
+            fclose(p_fd);
+        free(*pp_data);
+        *pp_data = NULL;
+        return -1;
+    }
+    fclose(p_fd);
+
+    return 0;
+}
+
+/*
+ * bench_delta_load
+ * The Phone sends the Patch. The device reconstructs the Image from its Active Partition
+ */
+static int bench_delta_load(const char *p_base_file, const char *p_patch_file,
+        const char *p_active_file)
+{
+    uint8_t *p_active;
+    uint32_t active_len;
+
+    if ((bench_file_read(p_base_file, &bench_cb.p_base, &bench_cb.base_len) != 0) ||
+        (bench_file_read(p_patch_file, &bench_cb.p_payload, &bench_cb.payload_len) != 0))
+    {
+        return -1;
+    }
+    bench_cb.download_command = APP_OFU_COMMAND_DOWNLOAD_DELTA;
+
+    /* Active Partition different from the Base Image (the Patch must be refused) */
+    if (p_active_file)
+    {
+        if (bench_file_read(p_active_file, &p_active, &active_len) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        p_active = bench_cb.p_base;
+        active_len = bench_cb.base_len;
+    }
+
+    if (active_len > STUB_PARTITION_SIZE)
+    {
+        fprintf(stderr, "Err: Active Partition too big:%d (max %d)\n", active_len,
+                STUB_PARTITION_SIZE);
+        return -1;
+    }
+    memset(stub_flash.active, 0xFF, STUB_PARTITION_SIZE);
+    memcpy(stub_flash.active, p_active, active_len);
+
+    if (p_active != bench_cb.p_base)
+    {
+        free(p_active);
+    }
+
+    return 0;
+}
+
+/*
+ * bench_compressed_load
+ * The Phone sends the compressed stream of the package. The device decompresses it
+ */
+static int bench_compressed_load(const char *p_package_file)
+{
+    uint8_t *p_package;
+    uint32_t package_len;
+    uint8_t *p;
+    uint32_t version;
+    uint32_t image_len;
+    uint32_t image_crc32;
+
+    if (bench_file_read(p_package_file, &p_package, &package_len) != 0)
+    {
+        return -1;
+    }
+
+    p = p_package;
+    if ((package_len < BENCH_OFUZ_HEADER_LEN) ||
+        (memcmp(p, "OFUZ", 4) != 0))
+    {
+        fprintf(stderr, "Err: %s is not an OFU compressed package\n", p_package_file);
+        free(p_package);
+        return -1;
+    }
+    p += 4;
+    STREAM_TO_UINT32(version, p);
+    STREAM_TO_UINT32(image_len, p);
+    STREAM_TO_UINT32(image_crc32, p);
+
+    /* The package must be generated from the Image (with the Window of the decompressor) */
+    if ((version != BENCH_OFUZ_VERSION) ||
+        (image_len != bench_cb.image_len) ||
+        (image_crc32 != bench_cb.image_crc32))
+    {
+        fprintf(stderr, "Err: package version:%d len:%d CRC32:0x%08X does not match the Image\n",
+                version, image_len, image_crc32);
+        free(p_package);
+        return -1;
+    }
+
+    /* Data packets contain the compressed stream only */
+    bench_cb.payload_len = package_len - BENCH_OFUZ_HEADER_LEN;
+    bench_cb.p_payload = malloc(bench_cb.payload_len + 1);
+    if (bench_cb.p_payload == NULL)
+    {
+        fprintf(stderr, "Err: no memory\n");
+        free(p_package);
+        return -1;
+    }
+    memcpy(bench_cb.p_payload, p, bench_cb.payload_len);
+    free(p_package);
+
+    bench_cb.download_command = APP_OFU_COMMAND_DOWNLOAD_COMPRESSED;
+
+    return 0;
+}
+
+/*
+ * bench_phone_start
+ * The Phone (OFU Client) downloads the Image to the device over SPP or LE
+ */
+static void bench_phone_start(void)
+{
+    app_ofu_srv_init();
+
+    /* The Relay OFU Client forwards the Image to the peer LRAC device */
+    if (bench_cb.fanout)
+    {
+        app_ofu_lrac_init(bench_lrac_callback);
+        app_ofu_clt_init();
+    }
+
+    bench_cb.phone_state = BENCH_PHONE_STATE_PREPARE;
+    bench_phone_send(APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND,
+            WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD), NULL, 0);
+}
+
+/*
+ * bench_phone_image_info_send
+ * The device checks the Image before it is downloaded
+ */
+static void bench_phone_image_info_send(void)
+{
+    uint8_t tx_data[APP_OFU_IMAGE_INFO_LEN];
+    uint8_t *p = tx_data;
+
+    UINT32_TO_STREAM(p, bench_cb.image_len);
+    UINT16_TO_STREAM(p, APP_OFU_PRODUCT_ID);
+    UINT8_TO_STREAM(p, bench_cb.image_major);
+    UINT8_TO_STREAM(p, 0);
+    UINT32_TO_STREAM(p, bench_cb.image_crc32);
+    UINT8_TO_STREAM(p, bench_cb.secure ? APP_OFU_IMAGE_SIGNATURE_ECDSA_P256 :
+            APP_OFU_IMAGE_SIGNATURE_NONE);
+
+    bench_cb.phone_state = BENCH_PHONE_STATE_IMAGE_INFO;
+    bench_phone_send(APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, APP_OFU_COMMAND_IMAGE_INFO),
+            tx_data, p - tx_data);
+}
+
+/*
+ * bench_phone_send
+ */
+static void bench_phone_send(uint8_t header, uint8_t *p_data, uint16_t length)
+{
+    uint8_t tx_data[BENCH_PHONE_PACKET_MAX];
+    uint8_t *p = tx_data;
+
+    UINT8_TO_STREAM(p, header);
+    if (length)
+    {
+        ARRAY_TO_STREAM(p, p_data, length);
+    }
+    sim_link_send(&bench_cb.link_to_device, tx_data, p - tx_data);
+}
+
+/*
+ * bench_phone_data_send
+ * Send Data packets until the window is full
+ */
+static void bench_phone_data_send(void)
+{
+    const bench_transport_param_t *p_param = &bench_transport_param[bench_cb.transport];
+    uint8_t tx_data[sizeof(uint32_t)];
+    uint8_t *p = tx_data;
+    uint32_t length;
+
+    while ((bench_cb.phone_offset < bench_cb.payload_len) &&
+           (bench_cb.phone_outstanding < bench_cb.window))
+    {
+        length = bench_cb.payload_len - bench_cb.phone_offset;
+        if (length > bench_cb.mtu - p_param->overhead)
+        {
+            length = bench_cb.mtu - p_param->overhead;
+        }
+        bench_phone_send(APP_OFU_HDR_SET(APP_OFU_DATA, 0),
+                &bench_cb.p_payload[bench_cb.phone_offset], length);
+        bench_cb.phone_offset += length;
+        bench_cb.phone_outstanding++;
+        bench_cb.data_bytes += length;
+    }
+
+    /*
+     * All the Data acknowledged. Verify the Image. The Write Without Response are handled before
+     * the Verify command (same ATT bearer), no need to wait for the last Credits
+     */
+    if ((bench_cb.phone_offset >= bench_cb.payload_len) &&
+        ((bench_cb.phone_outstanding == 0) || (p_param->credits)))
+    {
+        UINT32_TO_STREAM(p, bench_cb.image_crc32);
+        bench_cb.phone_state = BENCH_PHONE_STATE_VERIFY;
+        bench_phone_send(APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND,
+                WICED_OTA_UPGRADE_COMMAND_VERIFY), tx_data, p - tx_data);
+    }
+}
+
+/*
+ * bench_phone_rx_handler
+ * The Phone receives a Response (Status) or Credits (2 bytes) from the device
+ */
+static void bench_phone_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    uint8_t tx_data[3 * sizeof(uint32_t)];
+    uint8_t *p = tx_data;
+    uint8_t status;
+
+    if (bench_cb.done)
+    {
+        return;
+    }
+
+    /* Credits (LE Stream) */
+    if (length == 2)
+    {
+        bench_cb.phone_outstanding -= p_data[1];
+        if (bench_cb.phone_state == BENCH_PHONE_STATE_DATA)
+        {
+            bench_phone_data_send();
+        }
+        return;
+    }
+
+    status = APP_OFU_HDR_STS_GET(p_data[0]);
+
+    switch (bench_cb.phone_state)
+    {
+    case BENCH_PHONE_STATE_PREPARE:
+        if (status != WICED_OTA_UPGRADE_STATUS_OK)
+        {
+            break;
+        }
+        bench_phone_image_info_send();
+        return;
+
+    case BENCH_PHONE_STATE_IMAGE_INFO:
+        if (status != WICED_OTA_UPGRADE_STATUS_OK)
+        {
+            break;
+        }
+        UINT32_TO_STREAM(p, bench_cb.image_len);
+        if (bench_cb.download_command == APP_OFU_COMMAND_DOWNLOAD_DELTA)
+        {
+            UINT32_TO_STREAM(p, bench_cb.base_len);
+            UINT32_TO_STREAM(p, app_ofu_crc32_update(APP_OFU_CRC32_INIT, bench_cb.p_base,
+                    bench_cb.base_len) ^ 0xFFFFFFFF);
+        }
+        bench_cb.phone_state = BENCH_PHONE_STATE_DOWNLOAD;
+        bench_phone_send(APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, bench_cb.download_command),
+                tx_data, p - tx_data);
+        return;
+
+    case BENCH_PHONE_STATE_DOWNLOAD:
+        if (status != WICED_OTA_UPGRADE_STATUS_OK)
+        {
+            break;
+        }
+        bench_cb.phone_state = BENCH_PHONE_STATE_DATA;
+        bench_phone_data_send();
+        return;
+
+    case BENCH_PHONE_STATE_DATA:
+        if ((status != WICED_OTA_UPGRADE_STATUS_CONTINUE) &&
+            (status != WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            break;
+        }
+        bench_cb.phone_outstanding--;
+        bench_phone_data_send();
+        return;
+
+    case BENCH_PHONE_STATE_VERIFY:
+        /* Fan-out: wait until the peer LRAC device verifies the Image too */
+        if ((bench_cb.fanout) &&
+            (status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            bench_cb.phone_verified = 1;
+            if (bench_cb.peer_verified)
+            {
+                bench_done(1);
+            }
+            return;
+        }
+        bench_done(status == WICED_OTA_UPGRADE_STATUS_OK);
+        return;
+    }
+
+    fprintf(stderr, "Err: state:%d status:%d\n", bench_cb.phone_state, status);
+    bench_done(0);
+}
+
+/*
+ * bench_device_rx_handler
+ * The device receives an OFU packet from the Phone (as the SPP and LE OFU transports do)
+ */
+static void bench_device_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    uint8_t header;
+    uint8_t status;
+    uint8_t credits[2];
+
+    STREAM_TO_UINT8(header, p_data);
+    length--;
+
+    if (APP_OFU_HDR_TYPE_GET(header) == APP_OFU_CONTROL_COMMAND)
+    {
+        status = app_ofu_srv_command_handler(header, p_data, length, bench_srv_callback);
+        /* Forward the Image to the peer LRAC Device while it is received (as SPP and LE do) */
+        if ((bench_cb.fanout) &&
+            (APP_OFU_HDR_CMD_GET(header) == WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD) &&
+            (status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            app_ofu_lrac_fanout_prepare();
+        }
+    }
+    else
+    {
+        status = app_ofu_srv_data_handler(p_data, length, bench_srv_callback);
+
+        /* No Response for Write Without Response. Credits are returned by batch */
+        if ((bench_transport_param[bench_cb.transport].credits) &&
+            ((status == WICED_OTA_UPGRADE_STATUS_OK) ||
+             (status == WICED_OTA_UPGRADE_STATUS_CONTINUE)))
+        {
+            bench_cb.device_credits++;
+            if (bench_cb.device_credits >= (bench_cb.window / 2))
+            {
+                credits[0] = 0;
+                credits[1] = bench_cb.device_credits;
+                bench_cb.device_credits = 0;
+                sim_link_send(&bench_cb.link_to_client, credits, sizeof(credits));
+            }
+            return;
+        }
+    }
+
+    header = APP_OFU_HDR_SET(APP_OFU_EVENT, status);
+    sim_link_send(&bench_cb.link_to_client, &header, sizeof(header));
+}
+
+/*
+ * bench_srv_callback
+ */
+static void bench_srv_callback(app_ofu_event_t event)
+{
+    if (event == APP_OFU_EVENT_ABORTED)
+    {
+        fprintf(stderr, "Err: OFU Server Aborted\n");
+    }
+}
+
+/*
+ * bench_lrac_start
+ * The Primary (OFU Client) upgrades the peer LRAC device (OFU Server)
+ */
+static void bench_lrac_start(void)
+{
+    wiced_result_t status;
+
+    app_ofu_lrac_init(bench_lrac_callback);
+    app_ofu_srv_init();
+    app_ofu_clt_init();
+
+    status = app_ofu_lrac_start(bench_cb.mtu);
+    if (status != WICED_BT_SUCCESS)
+    {
+        fprintf(stderr, "Err: app_ofu_lrac_start failed status:%d\n", status);
+        bench_done(0);
+    }
+}
+
+/*
+ * bench_lrac_rx_handler
+ */
+static void bench_lrac_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    if (bench_cb.done)
+    {
+        return;
+    }
+    app_ofu_lrac_rx_handler(p_data, length);
+}
+
+/*
+ * bench_lrac_callback
+ */
+static void bench_lrac_callback(app_ofu_event_t event, app_ofu_event_data_t *p_data)
+{
+    if (p_data->started.transport != APP_OFU_TRANSPORT_LRAC_CLIENT)
+    {
+        return;
+    }
+
+    if (event == APP_OFU_EVENT_COMPLETED)
+    {
+        /* Fan-out: the Phone must verify the Image too */
+        if (bench_cb.fanout)
+        {
+            bench_cb.peer_verified = 1;
+            bench_cb.peer_done_us = sim_now_us();
+            if (bench_cb.phone_verified == 0)
+            {
+                return;
+            }
+        }
+        bench_done(1);
+    }
+    else if (event == APP_OFU_EVENT_ABORTED)
+    {
+        fprintf(stderr, "Err: OFU Client Aborted\n");
+        bench_done(0);
+    }
+}
+
+/*
+ * bench_peer_rx_handler
+ * The peer LRAC device receives an OFU packet from the Relay OFU Client (Fan-out). It only
+ * acknowledges the Data received in sequence and checks the CRC32 (no Flash)
+ */
+static void bench_peer_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    uint8_t rsp_data[2];
+    uint8_t ack_data[sizeof(uint32_t)];
+    uint8_t *p = ack_data;
+    uint8_t header;
+    uint16_t payload_len;
+    uint32_t offset;
+    uint32_t crc32;
+
+    if (bench_cb.done)
+    {
+        return;
+    }
+
+    STREAM_TO_UINT8(header, p_data);
+    STREAM_TO_UINT16(payload_len, p_data);
+    if (payload_len != (length - 3))
+    {
+        fprintf(stderr, "Err: peer received a wrong payload_len:%d\n", payload_len);
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_BAD_PARAM, NULL, 0);
+        return;
+    }
+
+    if (APP_OFU_HDR_TYPE_GET(header) == APP_OFU_DATA_WINDOW)
+    {
+        STREAM_TO_UINT32(offset, p_data);
+        payload_len -= sizeof(uint32_t);
+        if ((offset + payload_len) > bench_cb.peer_len)
+        {
+            fprintf(stderr, "Err: peer received too much data offset:%d len:%d\n", offset,
+                    payload_len);
+            bench_peer_send(WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE, NULL, 0);
+            return;
+        }
+        /* Data received out of sequence is dropped */
+        if (offset == bench_cb.peer_offset)
+        {
+            memcpy(&bench_cb.p_peer_image[offset], p_data, payload_len);
+            bench_cb.peer_offset += payload_len;
+        }
+        UINT32_TO_STREAM(p, bench_cb.peer_offset);
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_CONTINUE, ack_data, p - ack_data);
+        return;
+    }
+
+    if (APP_OFU_HDR_TYPE_GET(header) != APP_OFU_CONTROL_COMMAND)
+    {
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_UNSUPPORTED_COMMAND, NULL, 0);
+        return;
+    }
+
+    switch (APP_OFU_HDR_CMD_GET(header))
+    {
+    case WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD:
+        /* Windowed transfer, no Resume */
+        rsp_data[0] = APP_OFU_WINDOW_SIZE;
+        rsp_data[1] = 0;
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_OK, rsp_data, sizeof(rsp_data));
+        break;
+
+    case WICED_OTA_UPGRADE_COMMAND_DOWNLOAD:
+        STREAM_TO_UINT32(bench_cb.peer_len, p_data);
+        bench_cb.peer_offset = 0;
+        if (bench_cb.peer_len > STUB_PARTITION_SIZE)
+        {
+            bench_peer_send(WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE, NULL, 0);
+            break;
+        }
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_OK, NULL, 0);
+        break;
+
+    case WICED_OTA_UPGRADE_COMMAND_VERIFY:
+        STREAM_TO_UINT32(crc32, p_data);
+        if ((bench_cb.peer_offset != bench_cb.peer_len) ||
+            (crc32 != (app_ofu_crc32_update(APP_OFU_CRC32_INIT, bench_cb.p_peer_image,
+                    bench_cb.peer_len) ^ 0xFFFFFFFF)))
+        {
+            bench_peer_send(WICED_OTA_UPGRADE_STATUS_VERIFICATION_FAILED, NULL, 0);
+            break;
+        }
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_OK, NULL, 0);
+        break;
+
+    default:
+        bench_peer_send(WICED_OTA_UPGRADE_STATUS_UNSUPPORTED_COMMAND, NULL, 0);
+        break;
+    }
+}
+
+/*
+ * bench_peer_send
+ * The peer LRAC device sends an OFU Event to the Relay OFU Client
+ */
+static void bench_peer_send(uint8_t status, uint8_t *p_data, uint16_t length)
+{
+    uint8_t tx_data[1 + sizeof(uint32_t)];
+    uint8_t *p = tx_data;
+
+    UINT8_TO_STREAM(p, APP_OFU_HDR_SET(APP_OFU_EVENT, status));
+    if (length)
+    {
+        ARRAY_TO_STREAM(p, p_data, length);
+    }
+    sim_link_send(&bench_cb.link_from_peer, tx_data, p - tx_data);
+}
+
+/*
+ * bench_relay_rx_handler
+ * The device (Relay OFU Client) receives an OFU Event from its peer LRAC device
+ */
+static void bench_relay_rx_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    if (bench_cb.done)
+    {
+        return;
+    }
+    app_ofu_lrac_rx_handler(p_data, length);
+}
+
+/*
+ * app_lrac_send_ofu
+ * The first byte is reserved for the LRAC Opcode
+ */
+wiced_result_t app_lrac_send_ofu(uint8_t *p_data, uint16_t length)
+{
+    uint8_t type;
+
+    p_data++;
+    length--;
+
+    type = APP_OFU_HDR_TYPE_GET(p_data[0]);
+
+    /* Fan-out: the Relay OFU Client forwards the Image to the peer */
+    if (bench_cb.fanout)
+    {
+        if (type == APP_OFU_DATA_WINDOW)
+        {
+            bench_cb.peer_data_bytes += length - 3 - sizeof(uint32_t);
+        }
+        sim_link_send(&bench_cb.link_to_peer, p_data, length);
+        return WICED_BT_SUCCESS;
+    }
+
+    if (type == APP_OFU_EVENT)
+    {
+        sim_link_send(&bench_cb.link_to_client, p_data, length);
+    }
+    else
+    {
+        /* Header and Payload length */
+        if (type == APP_OFU_DATA)
+        {
+            bench_cb.data_bytes += length - 3;
+        }
+        else if (type == APP_OFU_DATA_WINDOW)
+        {
+            bench_cb.data_bytes += length - 3 - sizeof(uint32_t);
+        }
+        sim_link_send(&bench_cb.link_to_device, p_data, length);
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_lrac_is_connected
+ */
+wiced_bool_t app_lrac_is_connected(void)
+{
+    return WICED_TRUE;
+}
+
+/*
+ * bench_done
+ */
+static void bench_done(int verified)
+{
+    if (bench_cb.done)
+    {
+        return;
+    }
+    bench_cb.done = 1;
+    bench_cb.done_us = sim_now_us();
+
+    /* The Download Partition must contain the Image */
+    bench_cb.verified = verified &&
+            (memcmp(stub_flash.download, bench_cb.p_image, bench_cb.image_len) == 0);
+
+    /* Fan-out: the peer LRAC device must have received the Image */
+    if ((bench_cb.fanout) &&
+        (bench_cb.verified))
+    {
+        bench_cb.verified = (bench_cb.peer_len == bench_cb.image_len) &&
+                (memcmp(bench_cb.p_peer_image, bench_cb.p_image, bench_cb.image_len) == 0);
+    }
+    sim_stop();
+}
+
+/*
+ * bench_report
+ */
+static void bench_report(void)
+{
+    const bench_transport_param_t *p_param = &bench_transport_param[bench_cb.transport];
+    app_ofu_srv_stats_t stats;
+    double duration_s;
+
+    app_ofu_srv_stats_get(&stats);
+
+    printf("Transport:      %s MTU:%d latency:%d ms rate:%d kbps loss:%d%%\n",
+            p_param->p_name, bench_cb.mtu, bench_cb.link_to_device.latency_us / 1000,
+            bench_cb.link_to_device.rate_bps / 1000, bench_cb.link_to_device.loss_percent);
+    printf("Image:          %d bytes CRC32:0x%08X\n", bench_cb.image_len, bench_cb.image_crc32);
+    if (bench_cb.download_command == APP_OFU_COMMAND_DOWNLOAD_DELTA)
+    {
+        printf("Patch:          %d bytes (%.1f%% of the Image) Base Image:%d bytes\n",
+                bench_cb.payload_len, 100.0 * bench_cb.payload_len / bench_cb.image_len,
+                bench_cb.base_len);
+    }
+    else if (bench_cb.download_command == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED)
+    {
+        printf("Compressed:     %d bytes (%.1f%% of the Image)\n", bench_cb.payload_len,
+                100.0 * bench_cb.payload_len / bench_cb.image_len);
+    }
+
+    if (bench_cb.done == 0)
+    {
+        printf("Result:         Timeout (%llu s)\n",
+                (unsigned long long)(BENCH_TIME_LIMIT_US / 1000000));
+        return;
+    }
+    printf("Result:         %s\n", bench_cb.verified ? "Verified" : "Failed");
+
+    duration_s = bench_cb.done_us / 1000000.0;
+    printf("Time to verify: %.3f s\n", duration_s);
+    if ((bench_cb.verified) &&
+        (duration_s > 0))
+    {
+        printf("Throughput:     %.0f bytes/s\n", bench_cb.image_len / duration_s);
+    }
+    printf("Data sent:      %llu bytes (%llu retransmitted)\n",
+            (unsigned long long)bench_cb.data_bytes,
+            (unsigned long long)(bench_cb.data_bytes > bench_cb.payload_len ?
+                    bench_cb.data_bytes - bench_cb.payload_len : 0));
+    printf("Packets:        to device:%d (%s:%d) to client:%d (%s:%d)\n",
+            bench_cb.link_to_device.nb_packets,
+            bench_cb.link_to_device.reliable ? "retransmitted" : "lost",
+            bench_cb.link_to_device.nb_lost,
+            bench_cb.link_to_client.nb_packets,
+            bench_cb.link_to_client.reliable ? "retransmitted" : "lost",
+            bench_cb.link_to_client.nb_lost);
+    printf("Overhead:       %.1f%% (bytes on the Links / Image length)\n",
+            100.0 * (bench_cb.link_to_device.nb_bytes + bench_cb.link_to_client.nb_bytes) /
+            bench_cb.image_len - 100.0);
+    printf("Flash:          %d writes %.3f s\n", sim_flash.nb_write,
+            sim_flash.write_time_us / 1000000.0);
+    if (stub_flash.nb_bad_access)
+    {
+        printf("Flash:          %d accesses not multiple of 4 bytes\n",
+                stub_flash.nb_bad_access);
+    }
+    printf("Commit:         nb:%d latency max:%d us avg:%d us\n", stats.nb_commit,
+            stats.commit_latency_max,
+            stats.nb_commit ? stats.commit_latency_total / stats.nb_commit : 0);
+    printf("Stall:          nb:%d max:%d us total:%d us\n", stats.nb_stall,
+            stats.stall_time_max, stats.stall_time_total);
+    if (bench_cb.fanout)
+    {
+        printf("Fan-out:        peer %s at %.3f s, %llu bytes forwarded (%llu retransmitted)\n",
+                bench_cb.peer_verified ? "verified" : "not verified",
+                bench_cb.peer_done_us / 1000000.0,
+                (unsigned long long)bench_cb.peer_data_bytes,
+                (unsigned long long)(bench_cb.peer_data_bytes > bench_cb.image_len ?
+                        bench_cb.peer_data_bytes - bench_cb.image_len : 0));
+        printf("Fan-out:        packets to peer:%d (lost:%d) from peer:%d (lost:%d)\n",
+                bench_cb.link_to_peer.nb_packets, bench_cb.link_to_peer.nb_lost,
+                bench_cb.link_from_peer.nb_packets, bench_cb.link_from_peer.nb_lost);
+    }
+}
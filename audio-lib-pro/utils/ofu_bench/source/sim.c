@@ -0,0 +1,222 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Discrete event simulator (simulated time, Links and Flash).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+/*
+ * Definitions
+ */
+typedef struct sim_event
+{
+    struct sim_event *p_next;
+    uint64_t time_us;
+    sim_event_handler_t *p_handler;
+    void *p_opaque;
+    uint32_t param;
+    uint16_t length;
+    uint8_t data[];
+} sim_event_t;
+
+typedef struct
+{
+    uint64_t now_us;
+    sim_event_t *p_events;          /* Ordered by time (and by scheduling order) */
+    int stop;
+    uint32_t random;
+} sim_cb_t;
+
+/*
+ * Global variables
+ */
+static sim_cb_t sim_cb;
+sim_flash_t sim_flash;
+
+/*
+ * sim_init
+ */
+void sim_init(uint32_t seed)
+{
+    sim_event_t *p_event;
+
+    while (sim_cb.p_events)
+    {
+        p_event = sim_cb.p_events;
+        sim_cb.p_events = p_event->p_next;
+        free(p_event);
+    }
+    memset(&sim_cb, 0, sizeof(sim_cb));
+    sim_cb.random = seed ? seed : 1;
+}
+
+/*
+ * sim_now_us
+ */
+uint64_t sim_now_us(void)
+{
+    return sim_cb.now_us;
+}
+
+/*
+ * sim_busy
+ */
+void sim_busy(uint64_t duration_us)
+{
+    sim_cb.now_us += duration_us;
+}
+
+/*
+ * sim_schedule
+ */
+void sim_schedule(uint64_t delay_us, sim_event_handler_t *p_handler, void *p_opaque,
+        uint32_t param, uint8_t *p_data, uint16_t length)
+{
+    sim_event_t *p_event;
+    sim_event_t **pp;
+
+    p_event = malloc(sizeof(*p_event) + length);
+    if (p_event == NULL)
+    {
+        fprintf(stderr, "Err: sim_schedule no memory\n");
+        exit(1);
+    }
+    p_event->time_us = sim_cb.now_us + delay_us;
+    p_event->p_handler = p_handler;
+    p_event->p_opaque = p_opaque;
+    p_event->param = param;
+    p_event->length = length;
+    if (length)
+    {
+        memcpy(p_event->data, p_data, length);
+    }
+
+    /* Insert after the events scheduled at the same time (keep the order) */
+    pp = &sim_cb.p_events;
+    while ((*pp) && ((*pp)->time_us <= p_event->time_us))
+    {
+        pp = &(*pp)->p_next;
+    }
+    p_event->p_next = *pp;
+    *pp = p_event;
+}
+
+/*
+ * sim_run
+ */
+void sim_run(uint64_t time_limit_us)
+{
+    sim_event_t *p_event;
+
+    sim_cb.stop = 0;
+
+    while ((sim_cb.p_events) && (sim_cb.stop == 0))
+    {
+        p_event = sim_cb.p_events;
+        sim_cb.p_events = p_event->p_next;
+
+        /* The CPU may have been busy after the event time */
+        if (p_event->time_us > sim_cb.now_us)
+        {
+            sim_cb.now_us = p_event->time_us;
+        }
+        if (sim_cb.now_us > time_limit_us)
+        {
+            free(p_event);
+            break;
+        }
+
+        p_event->p_handler(p_event->p_opaque, p_event->param, p_event->data, p_event->length);
+        free(p_event);
+    }
+}
+
+/*
+ * sim_stop
+ */
+void sim_stop(void)
+{
+    sim_cb.stop = 1;
+}
+
+/*
+ * sim_random_percent
+ * Linear congruential generator (reproducible runs for a given seed)
+ */
+uint32_t sim_random_percent(void)
+{
+    sim_cb.random = sim_cb.random * 1103515245 + 12345;
+    return ((sim_cb.random >> 16) & 0x7FFF) % 100;
+}
+
+/*
+ * sim_link_send
+ */
+int sim_link_send(sim_link_t *p_link, uint8_t *p_data, uint16_t length)
+{
+    uint64_t start_us;
+    uint64_t tx_time_us;
+
+    p_link->nb_packets++;
+    p_link->nb_bytes += length;
+
+    /* Packets are serialized on the Link */
+    start_us = sim_cb.now_us;
+    if (p_link->busy_until_us > start_us)
+    {
+        start_us = p_link->busy_until_us;
+    }
+    tx_time_us = ((uint64_t)length * 8 * 1000000) / p_link->rate_bps;
+
+    /* Lost packets are retransmitted by a reliable Link (delayed) */
+    while ((p_link->loss_percent) && (sim_random_percent() < p_link->loss_percent))
+    {
+        p_link->nb_lost++;
+        if (p_link->reliable == 0)
+        {
+            p_link->busy_until_us = start_us + tx_time_us;
+            return 0;
+        }
+        start_us += tx_time_us + p_link->retx_delay_us;
+    }
+    p_link->busy_until_us = start_us + tx_time_us;
+
+    sim_schedule(p_link->busy_until_us + p_link->latency_us - sim_cb.now_us,
+            p_link->p_rx_handler, p_link, 0, p_data, length);
+
+    return 1;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Discrete event simulator (simulated time, Links and Flash).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Definitions
+ */
+typedef void (sim_event_handler_t)(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length);
+
+/* Link model */
+typedef struct
+{
+    const char *p_name;
+    uint32_t latency_us;            /* One way latency */
+    uint32_t rate_bps;              /* Throughput (bits per second) */
+    uint32_t loss_percent;          /* Packets lost */
+    int reliable;                   /* Lost packets are retransmitted by the Link Layer */
+    uint32_t retx_delay_us;         /* Link Layer retransmission delay (reliable Link) */
+    sim_event_handler_t *p_rx_handler;
+    /* Statistics */
+    uint32_t nb_packets;
+    uint32_t nb_lost;               /* Lost (unreliable Link) or retransmitted (reliable Link) */
+    uint64_t nb_bytes;
+    /* Internal */
+    uint64_t busy_until_us;
+} sim_link_t;
+
+/* Flash model */
+typedef struct
+{
+    uint32_t write_us_per_kb;       /* Time the CPU is busy while writing 1 KB in Flash */
+    uint32_t nb_write;
+    uint64_t write_time_us;
+} sim_flash_t;
+
+/*
+ * sim_init
+ */
+void sim_init(uint32_t seed);
+
+/*
+ * sim_now_us
+ * Current simulated time
+ */
+uint64_t sim_now_us(void);
+
+/*
+ * sim_busy
+ * The (simulated) CPU is busy for duration_us
+ */
+void sim_busy(uint64_t duration_us);
+
+/*
+ * sim_schedule
+ * Schedule an event. The data (if any) is copied
+ */
+void sim_schedule(uint64_t delay_us, sim_event_handler_t *p_handler, void *p_opaque,
+        uint32_t param, uint8_t *p_data, uint16_t length);
+
+/*
+ * sim_run
+ * Handle the events until there is none or until the stop condition is set or the time limit
+ */
+void sim_run(uint64_t time_limit_us);
+
+/*
+ * sim_stop
+ */
+void sim_stop(void);
+
+/*
+ * sim_link_send
+ * Send a packet on a Link. Returns 0 if the packet is lost
+ */
+int sim_link_send(sim_link_t *p_link, uint8_t *p_data, uint16_t length);
+
+/*
+ * sim_random
+ * Returns a random number in [0, 99]
+ */
+uint32_t sim_random_percent(void);
+
+/* Flash model used by the FW Upgrade API */
+extern sim_flash_t sim_flash;
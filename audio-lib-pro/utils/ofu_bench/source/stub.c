@@ -0,0 +1,338 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Host implementation of the WICED API used by the OFU modules.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "wiced.h"
+#include "wiced_timer.h"
+#include "clock_timer.h"
+#include "ota_fw_upgrade.h"
+#include "wiced_firmware_upgrade.h"
+#include "app_nvram.h"
+#include "app_ofu_crc32.h"
+#include "sim.h"
+#include "stub.h"
+
+/*
+ * Global variables
+ */
+int stub_verbose;
+stub_flash_t stub_flash;
+
+ota_fw_upgrade_state_t ota_fw_upgrade_state;
+void *p_ecdsa_public_key = NULL;
+const uint8_t ds_image_prefix[DS_IMAGE_PREFIX_LEN] = {'B', 'R', 'C', 'M', 'c', 'f', 'g', 'D'};
+
+static app_nvram_ofu_checkpoint_t stub_checkpoint;
+static int stub_checkpoint_valid;
+
+/*
+ * bench_trace
+ */
+void bench_trace(const char *p_format, ...)
+{
+    va_list args;
+
+    if (stub_verbose == 0)
+    {
+        return;
+    }
+
+    printf("[%10.3f ms] ", sim_now_us() / 1000.0);
+    va_start(args, p_format);
+    vprintf(p_format, args);
+    va_end(args);
+}
+
+/*
+ * clock_SystemTimeMicroseconds64
+ */
+uint64_t clock_SystemTimeMicroseconds64(void)
+{
+    return sim_now_us();
+}
+
+/*
+ * stub_serialized_handler
+ */
+static void stub_serialized_handler(void *p_opaque, uint32_t param, uint8_t *p_data,
+        uint16_t length)
+{
+    wiced_app_event_serialize_t *p_fn = (wiced_app_event_serialize_t *)p_opaque;
+    void *p_fn_data;
+
+    memcpy(&p_fn_data, p_data, sizeof(p_fn_data));
+    p_fn(p_fn_data);
+}
+
+/*
+ * wiced_app_event_serialize
+ */
+wiced_result_t wiced_app_event_serialize(wiced_app_event_serialize_t *p_fn, void *p_data)
+{
+    sim_schedule(0, stub_serialized_handler, (void *)p_fn, 0, (uint8_t *)&p_data,
+            sizeof(p_data));
+    return WICED_SUCCESS;
+}
+
+/*
+ * stub_timer_handler
+ */
+static void stub_timer_handler(void *p_opaque, uint32_t generation, uint8_t *p_data,
+        uint16_t length)
+{
+    wiced_timer_t *p_timer = (wiced_timer_t *)p_opaque;
+
+    /* The timer has been stopped (or restarted) */
+    if ((p_timer->in_use == WICED_FALSE) ||
+        (p_timer->generation != generation))
+    {
+        return;
+    }
+    p_timer->in_use = WICED_FALSE;
+    p_timer->p_callback(p_timer->param);
+}
+
+/*
+ * wiced_init_timer
+ */
+wiced_result_t wiced_init_timer(wiced_timer_t *p_timer, wiced_timer_callback_t *p_cb,
+        uint32_t cb_params, wiced_timer_type_t timer_type)
+{
+    memset(p_timer, 0, sizeof(*p_timer));
+    p_timer->p_callback = p_cb;
+    p_timer->param = cb_params;
+    p_timer->type = timer_type;
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * wiced_start_timer
+ */
+wiced_result_t wiced_start_timer(wiced_timer_t *p_timer, uint32_t timeout)
+{
+    uint64_t timeout_us;
+
+    if ((p_timer->type == WICED_SECONDS_TIMER) ||
+        (p_timer->type == WICED_SECONDS_PERIODIC_TIMER))
+    {
+        timeout_us = (uint64_t)timeout * 1000000;
+    }
+    else
+    {
+        timeout_us = (uint64_t)timeout * 1000;
+    }
+
+    p_timer->in_use = WICED_TRUE;
+    p_timer->generation++;
+    sim_schedule(timeout_us, stub_timer_handler, p_timer, p_timer->generation, NULL, 0);
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * wiced_stop_timer
+ */
+wiced_result_t wiced_stop_timer(wiced_timer_t *p_timer)
+{
+    p_timer->in_use = WICED_FALSE;
+    p_timer->generation++;
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * wiced_is_timer_in_use
+ */
+wiced_bool_t wiced_is_timer_in_use(wiced_timer_t *p_timer)
+{
+    return p_timer->in_use;
+}
+
+/*
+ * wiced_ota_fw_upgrade_init
+ */
+wiced_bool_t wiced_ota_fw_upgrade_init(void *p_public_key, void *p_status_callback,
+        void *p_data_callback)
+{
+    return WICED_TRUE;
+}
+
+/*
+ * ota_fw_upgrade_verify
+ * Compute the CRC32 of the Download Partition (as the OTA FW Upgrade library does)
+ */
+int32_t ota_fw_upgrade_verify(void)
+{
+    uint32_t crc32;
+
+    if (ota_fw_upgrade_state.total_len > STUB_PARTITION_SIZE)
+    {
+        return WICED_FALSE;
+    }
+    crc32 = app_ofu_crc32_update(APP_OFU_CRC32_INIT, stub_flash.download,
+            ota_fw_upgrade_state.total_len) ^ 0xFFFFFFFF;
+
+    return (crc32 == ota_fw_upgrade_state.crc32);
+}
+
+/*
+ * ota_sec_fw_upgrade_verify
+ */
+int32_t ota_sec_fw_upgrade_verify(void)
+{
+    /* The Signature is not checked on the host (the tool compares the Download Partition) */
+    return (ota_fw_upgrade_state.total_len <= STUB_PARTITION_SIZE);
+}
+
+/*
+ * wiced_firmware_upgrade_init_nv_locations
+ */
+wiced_bool_t wiced_firmware_upgrade_init_nv_locations(void)
+{
+    return WICED_TRUE;
+}
+
+/*
+ * stub_flash_access_check
+ * The Flash must be accessed with lengths multiple of 4 bytes
+ */
+static int stub_flash_access_check(uint32_t offset, uint32_t length)
+{
+    if ((length & 0x3) ||
+        (offset + length > STUB_PARTITION_SIZE))
+    {
+        stub_flash.nb_bad_access++;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * wiced_firmware_upgrade_store_to_nv
+ */
+uint32_t wiced_firmware_upgrade_store_to_nv(uint32_t offset, uint8_t *p_data, uint32_t length)
+{
+    uint64_t write_time_us;
+
+    if (stub_flash_access_check(offset, length) == 0)
+    {
+        return 0;
+    }
+    memcpy(&stub_flash.download[offset], p_data, length);
+
+    /* The CPU is busy while the Flash is written */
+    write_time_us = ((uint64_t)length * sim_flash.write_us_per_kb) / 1024;
+    sim_flash.nb_write++;
+    sim_flash.write_time_us += write_time_us;
+    sim_busy(write_time_us);
+
+    return length;
+}
+
+/*
+ * wiced_firmware_upgrade_retrieve_from_nv
+ */
+uint32_t wiced_firmware_upgrade_retrieve_from_nv(uint32_t offset, uint8_t *p_data,
+        uint32_t length)
+{
+    if (stub_flash_access_check(offset, length) == 0)
+    {
+        return 0;
+    }
+    memcpy(p_data, &stub_flash.download[offset], length);
+    return length;
+}
+
+/*
+ * wiced_firmware_upgrade_retrieve_from_active_ds
+ */
+uint32_t wiced_firmware_upgrade_retrieve_from_active_ds(uint32_t offset, uint8_t *p_data,
+        uint32_t length)
+{
+    if (stub_flash_access_check(offset, length) == 0)
+    {
+        return 0;
+    }
+    memcpy(p_data, &stub_flash.active[offset], length);
+    return length;
+}
+
+/*
+ * wiced_firmware_upgrade_finish
+ */
+void wiced_firmware_upgrade_finish(void)
+{
+    stub_flash.finished = 1;
+}
+
+/*
+ * app_nvram_ofu_checkpoint_get
+ */
+wiced_result_t app_nvram_ofu_checkpoint_get(app_nvram_ofu_checkpoint_t *p_checkpoint)
+{
+    if (stub_checkpoint_valid == 0)
+    {
+        return WICED_BT_ERROR;
+    }
+    memcpy(p_checkpoint, &stub_checkpoint, sizeof(*p_checkpoint));
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_nvram_ofu_checkpoint_set
+ */
+wiced_result_t app_nvram_ofu_checkpoint_set(app_nvram_ofu_checkpoint_t *p_checkpoint)
+{
+    memcpy(&stub_checkpoint, p_checkpoint, sizeof(stub_checkpoint));
+    stub_checkpoint_valid = 1;
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_nvram_ofu_checkpoint_delete
+ */
+void app_nvram_ofu_checkpoint_delete(void)
+{
+    stub_checkpoint_valid = 0;
+}
+
+/*
+ * app_nvram_cache_flush
+ */
+wiced_result_t app_nvram_cache_flush(void)
+{
+    return WICED_BT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Host implementation of the WICED API used by the OFU modules.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Definitions
+ */
+/* FW image cannot be bigger than half of the Flash's size */
+#define STUB_PARTITION_SIZE                 (512 * 1024)
+
+/* Simulated Flash partitions */
+typedef struct
+{
+    uint8_t active[STUB_PARTITION_SIZE];    /* Active Partition (read by the OFU Client) */
+    uint8_t download[STUB_PARTITION_SIZE];  /* Download Partition (written by the OFU Server) */
+    uint32_t nb_bad_access;                 /* Accesses not multiple of 4 bytes */
+    int finished;                           /* wiced_firmware_upgrade_finish called */
+} stub_flash_t;
+
+extern stub_flash_t stub_flash;
+
+/* Print the traces of the OFU modules */
+extern int stub_verbose;
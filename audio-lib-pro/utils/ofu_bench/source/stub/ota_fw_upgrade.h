@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Host version of the OTA FW Upgrade library state.
+ */
+
+#pragma once
+
+#include "wiced.h"
+#include "wiced_bt_ota_firmware_upgrade.h"
+
+#define OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT 512
+#define DS_IMAGE_PREFIX_LEN                 8
+#define SIGNATURE_LEN                       64
+
+typedef struct
+{
+    uint32_t total_len;
+    uint32_t crc32;
+} ota_fw_upgrade_state_t;
+
+extern ota_fw_upgrade_state_t ota_fw_upgrade_state;
+extern void *p_ecdsa_public_key;
+extern const uint8_t ds_image_prefix[DS_IMAGE_PREFIX_LEN];
+
+wiced_bool_t wiced_ota_fw_upgrade_init(void *p_public_key, void *p_status_callback,
+        void *p_data_callback);
+int32_t ota_fw_upgrade_verify(void);
+int32_t ota_sec_fw_upgrade_verify(void);
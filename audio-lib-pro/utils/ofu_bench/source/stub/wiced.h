@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Host version of the WICED types and macros used by the OFU modules.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint32_t wiced_bool_t;
+typedef int wiced_result_t;
+
+#define WICED_TRUE                          1
+#define WICED_FALSE                         0
+
+#define WICED_SUCCESS                       0
+#define WICED_BT_SUCCESS                    0
+#define WICED_BT_PENDING                    0x8001
+#define WICED_BT_BUSY                       0x8002
+#define WICED_BT_NO_RESOURCES               0x8003
+#define WICED_BT_ERROR                      0x8005
+#define WICED_BT_BADARG                     0x8006
+
+#define UNUSED_VARIABLE(x)                  (void)(x)
+
+#define UINT8_TO_STREAM(p, u8)   {*(p)++ = (uint8_t)(u8);}
+#define UINT16_TO_STREAM(p, u16) {*(p)++ = (uint8_t)(u16); *(p)++ = (uint8_t)((u16) >> 8);}
+#define UINT32_TO_STREAM(p, u32) {*(p)++ = (uint8_t)(u32); *(p)++ = (uint8_t)((u32) >> 8); \
+                                  *(p)++ = (uint8_t)((u32) >> 16); *(p)++ = (uint8_t)((u32) >> 24);}
+#define ARRAY_TO_STREAM(p, a, len) {memcpy((p), (a), (len)); (p) += (len);}
+
+#define STREAM_TO_UINT8(u8, p)   {u8 = (uint8_t)(*(p)); (p) += 1;}
+#define STREAM_TO_UINT16(u16, p) {u16 = ((uint16_t)(*(p)) + (((uint16_t)(*((p) + 1))) << 8)); \
+                                  (p) += 2;}
+#define STREAM_TO_UINT32(u32, p) {u32 = (((uint32_t)(*(p))) + ((((uint32_t)(*((p) + 1)))) << 8) + \
+                                  ((((uint32_t)(*((p) + 2)))) << 16) + \
+                                  ((((uint32_t)(*((p) + 3)))) << 24)); (p) += 4;}
+
+typedef int (wiced_app_event_serialize_t)(void *p_data);
+
+/*
+ * wiced_app_event_serialize
+ * The function is called once the current (simulated) event is handled
+ */
+wiced_result_t wiced_app_event_serialize(wiced_app_event_serialize_t *p_fn, void *p_data);
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *  OFU Bench. Host version of the WICED OTA FW Upgrade definitions.
+ */
+
+#pragma once
+
+#include "wiced.h"
+
+#define WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD      1
+#define WICED_OTA_UPGRADE_COMMAND_DOWNLOAD              2
+#define WICED_OTA_UPGRADE_COMMAND_VERIFY                3
+#define WICED_OTA_UPGRADE_COMMAND_FINISH                4
+#define WICED_OTA_UPGRADE_COMMAND_GET_STATUS            5
+#define WICED_OTA_UPGRADE_COMMAND_CLEAR_STATUS          6
+#define WICED_OTA_UPGRADE_COMMAND_ABORT                 7
+
+#define WICED_OTA_UPGRADE_STATUS_OK                     0
+#define WICED_OTA_UPGRADE_STATUS_UNSUPPORTED_COMMAND    1
+#define WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE          2
+#define WICED_OTA_UPGRADE_STATUS_VERIFICATION_FAILED    3
+#define WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE          4
+#define WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE     5
+#define WICED_OTA_UPGRADE_STATUS_MORE_DATA              6
+#define WICED_OTA_UPGRADE_STATUS_INVALID_APPID          7
+#define WICED_OTA_UPGRADE_STATUS_INVALID_VERSION        8
+#define WICED_OTA_UPGRADE_STATUS_CONTINUE               9
+#define WICED_OTA_UPGRADE_STATUS_BAD_PARAM              10
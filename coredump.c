@@ -34,6 +34,9 @@
 #include <stdint.h>
 #include "wiced_bt_trace.h"
 #include "wiced_hal_nvram.h"
+#ifdef APP_HCI_RING
+#include "app_hci_ring.h"
+#endif
 
 #define COREDUMP_CPU_REGS_NVRAM_ID           (0x200 - 1)
 #define COREDUMP_CPU_REGS_EXT_NVRAM_ID       (0x200 - 2)
@@ -88,6 +91,7 @@ void coredump_read(void)
     coredump_cpu_regs_extended_t cpu_regs_extended;
     uint8_t nb_read;
     wiced_result_t status;
+    wiced_bool_t coredump_found = WICED_FALSE;
 
     nb_read = mpaf_cfa_ConfigVSRead(COREDUMP_CPU_REGS_NVRAM_ID, sizeof(cpu_regs),
             (uint8_t *)&cpu_regs);
@@ -97,6 +101,7 @@ void coredump_read(void)
     }
     else
     {
+        coredump_found = WICED_TRUE;
         WICED_BT_TRACE("CoreDump CPU Registers:\n");
         WICED_BT_TRACE("PC:0x%08X SP:0x%08X LR:0x%08X\n",
                 cpu_regs.pc, cpu_regs.sp, cpu_regs.lr);
@@ -127,6 +132,7 @@ void coredump_read(void)
     }
     else
     {
+        coredump_found = WICED_TRUE;
         WICED_BT_TRACE("CoreDump CPU Registers Extended:\n");
 
         WICED_BT_TRACE("MPC:0x%08X MSP:0x%08X MLR:0x%08X MXPSR:0x%08X\n",
@@ -155,6 +161,14 @@ void coredump_read(void)
          */
         coredump_erase(COREDUMP_CPU_REGS_EXT_NVRAM_ID);
     }
+
+#ifdef APP_HCI_RING
+    /* HCI Commands/Events exchanged before the crash */
+    if (coredump_found)
+    {
+        app_hci_ring_dump(APP_HCI_RING_PREVIOUS);
+    }
+#endif
 }
 
 /*
@@ -53,6 +53,67 @@
 #define APP_OFU_CONTROL_COMMAND             1
 #define APP_OFU_DATA                        2
 #define APP_OFU_EVENT                       3
+#define APP_OFU_DATA_WINDOW                 4   /* Data with Image Offset (Windowed transfer) */
+
+/* Maximum number of Windowed Data packets which can be sent without being acknowledged */
+#define APP_OFU_WINDOW_SIZE                 4
+
+/* FW image cannot be bigger than half of the Flash's size */
+#define APP_OFU_IMAGE_LEN_MAX               (512 * 1024)
+
+/*
+ * Resume Command (in addition to the WICED_OTA_UPGRADE_COMMAND_XXX commands).
+ * Parameter: Image length (4 bytes, as for the Download command).
+ * Response: Offset (4 bytes) and running CRC32 (4 bytes) of the Data already committed.
+ */
+#define APP_OFU_COMMAND_RESUME              8
+
+/*
+ * Delta Download Command (in addition to the WICED_OTA_UPGRADE_COMMAND_XXX commands).
+ * Parameters: New Image length (4 bytes), Base Image length (4 bytes) and Base Image CRC32
+ * (4 bytes). The Base Image is the beginning of the Active Partition of the OFU Server.
+ * The Data packets which follow contain a Patch stream (see app_ofu_delta.h) instead of the Image.
+ */
+#define APP_OFU_COMMAND_DOWNLOAD_DELTA      9
+
+/*
+ * Compressed Download Command (in addition to the WICED_OTA_UPGRADE_COMMAND_XXX commands).
+ * Parameter: Image length (4 bytes, length of the decompressed Image).
+ * The Data packets which follow contain a compressed stream (see app_ofu_lz.h) instead of the
+ * Image.
+ */
+#define APP_OFU_COMMAND_DOWNLOAD_COMPRESSED 10
+
+/*
+ * Image Info Command (in addition to the WICED_OTA_UPGRADE_COMMAND_XXX commands). Optional, sent
+ * between the Prepare Download and the Download (or Resume) commands.
+ * Parameters: Image length (4 bytes), Product ID (2 bytes), Major (1 byte) and Minor (1 byte)
+ * Version, CRC32 of the Image (4 bytes) and Signature type (1 byte).
+ * The OFU Server rejects an Image which does not fit in the Download Partition
+ * (INVALID_IMAGE_SIZE), built for another Product (INVALID_APPID), older than the running FW
+ * (INVALID_VERSION) or not signed while a Secure upgrade is required (INVALID_IMAGE).
+ * The Download command must then use the same Image length and the Verify command the same CRC32.
+ */
+#define APP_OFU_COMMAND_IMAGE_INFO          11
+#define APP_OFU_IMAGE_INFO_LEN              13
+
+#define APP_OFU_IMAGE_SIGNATURE_NONE        0
+#define APP_OFU_IMAGE_SIGNATURE_ECDSA_P256  1
+
+/* Product ID (0: not checked) and Version of the running FW (set by the makefile) */
+#ifndef APP_OFU_PRODUCT_ID
+#define APP_OFU_PRODUCT_ID                  0
+#endif
+#ifndef APP_OFU_VERSION_MAJOR
+#define APP_OFU_VERSION_MAJOR               1
+#endif
+#ifndef APP_OFU_VERSION_MINOR
+#define APP_OFU_VERSION_MINOR               0
+#endif
+
+/* Features supported by the peer OFU Server (sent in the Prepare Download Response over LRAC) */
+#define APP_OFU_FEATURE_RESUME              0x01
+#define APP_OFU_FEATURES                    (APP_OFU_FEATURE_RESUME)
 
 #define APP_OFU_HDR_TYPE_GET(a)             (a >> 4)
 #define APP_OFU_HDR_CMD_GET(a)              (a & 0x0F)
@@ -35,15 +35,33 @@
 #ifdef OTA_FW_UPGRADE
 #include "wiced.h"
 #include "wiced_bt_l2c.h"
+#include "wiced_bt_ble.h"
 #include "wiced_bt_ota_firmware_upgrade.h"
+#include "wiced_timer.h"
 #include "app_ofu.h"
 #include "app_ofu_ble.h"
 #include "app_ofu_srv.h"
+#include "app_ofu_lrac.h"
 #include "app_trace.h"
 
 /*
  * Definitions
  */
+/* Retry to send the Credits (no buffer available) */
+#define APP_OFU_BLE_STREAM_RETRY_TIMEOUT    10  /* ms */
+
+/* Data Length Extension (maximum LE Data PDU) */
+#define APP_OFU_BLE_DLE_TX_OCTETS           251
+#define APP_OFU_BLE_DLE_TX_TIME             2120
+
+typedef struct
+{
+    wiced_bool_t enabled;           /* Image received on the Stream characteristic */
+    uint16_t config_descriptor;
+    uint8_t credits;                /* Credits to send to the Client */
+    wiced_timer_t retry_timer;
+} app_ofu_ble_stream_t;
+
 typedef struct
 {
     app_ofu_callback_t *p_callback;
@@ -52,13 +70,19 @@ typedef struct
     uint16_t config_descriptor;
     uint8_t connected;
     uint8_t ofu_started;
+    app_ofu_ble_stream_t stream;
 } app_ofu_ble_cb_t;
 
 /*
  * Local functions
  */
 static void app_ofu_ble_app_callback(app_ofu_event_t event);
-static wiced_result_t app_ofu_ble_send_status(uint8_t status);
+static wiced_result_t app_ofu_ble_send_status(uint8_t status, uint8_t *p_data, uint16_t length);
+static void app_ofu_ble_stream_start(void);
+static void app_ofu_ble_stream_stop(void);
+static void app_ofu_ble_stream_data_handler(uint8_t *p_data, uint16_t length);
+static void app_ofu_ble_stream_credits_send(void);
+static void app_ofu_ble_stream_retry_timer_callback(uint32_t param);
 
 /*
  * Global variables
@@ -78,6 +102,9 @@ wiced_result_t app_ofu_ble_init(app_ofu_callback_t *p_callback)
 
     app_ofu_ble_cb.p_callback = p_callback;
 
+    wiced_init_timer(&app_ofu_ble_cb.stream.retry_timer, app_ofu_ble_stream_retry_timer_callback,
+            0, WICED_MILLI_SECONDS_TIMER);
+
     return WICED_BT_SUCCESS;
 }
 
@@ -102,10 +129,17 @@ static void app_ofu_ble_app_callback(app_ofu_event_t event)
         event_data.started.transport = APP_OFU_TRANSPORT_BLE_SERVER;
         /* Change the LE Connection interval to increase throughput (reduce Upgrade duration) */
         wiced_bt_l2cap_update_ble_conn_params(app_ofu_ble_cb.bdaddr, 6, 6, 0, 200);
+        /* Use the largest LE Data PDUs (if supported by both Controllers) */
+        if (wiced_bt_ble_set_data_packet_length(app_ofu_ble_cb.bdaddr,
+                APP_OFU_BLE_DLE_TX_OCTETS, APP_OFU_BLE_DLE_TX_TIME) != WICED_BT_SUCCESS)
+        {
+            APP_OFU_TRACE_DBG("Data Length Extension not supported\n");
+        }
         break;
 
     case APP_OFU_EVENT_COMPLETED:
         app_ofu_ble_cb.ofu_started = WICED_FALSE;
+        app_ofu_ble_stream_stop();
         event_data.completed.transport = APP_OFU_TRANSPORT_BLE_SERVER;
         /* Change the LE Connection interval to default (reduce power consumed) */
         wiced_bt_l2cap_update_ble_conn_params(app_ofu_ble_cb.bdaddr, 40, 60, 0, 500);
@@ -113,6 +147,7 @@ static void app_ofu_ble_app_callback(app_ofu_event_t event)
 
     case APP_OFU_EVENT_ABORTED:
         app_ofu_ble_cb.ofu_started = WICED_FALSE;
+        app_ofu_ble_stream_stop();
         event_data.aborted.transport = APP_OFU_TRANSPORT_BLE_SERVER;
         /* Change the LE Connection interval to default (reduce power consumed) */
         wiced_bt_l2cap_update_ble_conn_params(app_ofu_ble_cb.bdaddr, 40, 60, 0, 500);
@@ -149,6 +184,8 @@ void app_ofu_ble_connection_down(uint16_t conn_id)
     app_ofu_ble_cb.connected = WICED_FALSE;
     app_ofu_ble_cb.conn_id = 0;
     app_ofu_ble_cb.config_descriptor = 0;
+    app_ofu_ble_stream_stop();
+    app_ofu_ble_cb.stream.config_descriptor = 0;
 
     /* If LE disconnected during OFU, send an Abort message to the application */
     if (app_ofu_ble_cb.ofu_started)
@@ -186,6 +223,26 @@ wiced_bt_gatt_status_t app_ofu_ble_read_handler(uint16_t conn_id,
             *p_read_data->p_val_len = 2;
         }
         return WICED_BT_GATT_SUCCESS;
+
+    case HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR:
+        if (p_read_data->offset >= 2)
+            return WICED_BT_GATT_INVALID_OFFSET;
+
+        if (*p_read_data->p_val_len < 2)
+            return WICED_BT_GATT_INVALID_ATTR_LEN;
+
+        if (p_read_data->offset == 1)
+        {
+            p_read_data->p_val[0] = app_ofu_ble_cb.stream.config_descriptor >> 8;
+            *p_read_data->p_val_len = 1;
+        }
+        else
+        {
+            p_read_data->p_val[0] = app_ofu_ble_cb.stream.config_descriptor & 0xff;
+            p_read_data->p_val[1] = app_ofu_ble_cb.stream.config_descriptor >> 8;
+            *p_read_data->p_val_len = 2;
+        }
+        return WICED_BT_GATT_SUCCESS;
     }
     return WICED_BT_GATT_INVALID_HANDLE;
 }
@@ -201,6 +258,10 @@ wiced_bt_gatt_status_t app_ofu_ble_write_handler(uint16_t conn_id,
     uint8_t header;
     uint8_t *p;
     uint16_t length;
+    uint32_t offset;
+    uint32_t crc32;
+    uint8_t rsp_data[2 * sizeof(uint32_t)];
+    uint8_t *p_rsp = rsp_data;
 
     p = p_write_data->p_val;
     length = p_write_data->val_len;
@@ -218,12 +279,35 @@ wiced_bt_gatt_status_t app_ofu_ble_write_handler(uint16_t conn_id,
         length--;
         /* Handle the OFU Command */
         srv_status = app_ofu_srv_command_handler(header, p, length, app_ofu_ble_app_callback);
+        /* Forward the Image to the peer LRAC Device while it is received */
+        if ((APP_OFU_HDR_CMD_GET(header) == WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD) &&
+            (srv_status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            app_ofu_lrac_fanout_prepare();
+        }
+        /* Tell the Client where to Resume the download */
+        if ((APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_RESUME) &&
+            (srv_status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            app_ofu_srv_resume_info_get(&offset, &crc32);
+            UINT32_TO_STREAM(p_rsp, offset);
+            UINT32_TO_STREAM(p_rsp, crc32);
+        }
         /* Sends Status */
-        app_ofu_ble_send_status(srv_status);
+        app_ofu_ble_send_status(srv_status, rsp_data, p_rsp - rsp_data);
         if (srv_status != WICED_OTA_UPGRADE_STATUS_OK)
         {
+            app_ofu_ble_stream_stop();
             return WICED_BT_GATT_ERROR;
         }
+        /* The Data can be streamed once the download is started */
+        if ((APP_OFU_HDR_CMD_GET(header) == WICED_OTA_UPGRADE_COMMAND_DOWNLOAD) ||
+            (APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_RESUME) ||
+            (APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_DOWNLOAD_DELTA) ||
+            (APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED))
+        {
+            app_ofu_ble_stream_start();
+        }
         break;
 
     case HANDLE_OTA_FW_UPGRADE_CLIENT_CONFIGURATION_DESCRIPTOR:
@@ -245,6 +329,21 @@ wiced_bt_gatt_status_t app_ofu_ble_write_handler(uint16_t conn_id,
         }
         break;
 
+    case HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR:
+        if (length != 2)
+        {
+            APP_TRACE_ERR("wrong stream client config len:%d\n", length);
+            return WICED_BT_GATT_INVALID_ATTR_LEN;
+        }
+        STREAM_TO_UINT16(app_ofu_ble_cb.stream.config_descriptor, p);
+        APP_OFU_TRACE_DBG("Stream CCC:0x%x\n", app_ofu_ble_cb.stream.config_descriptor);
+        break;
+
+    case HANDLE_APP_OFU_BLE_STREAM:
+        /* Write Without Response: errors are reported with a Status on the Control Point */
+        app_ofu_ble_stream_data_handler(p, length);
+        break;
+
     default:
         APP_TRACE_ERR("invalid handle:0x%x\n", p_write_data->handle);
         return WICED_BT_GATT_INVALID_HANDLE;
@@ -256,17 +355,31 @@ wiced_bt_gatt_status_t app_ofu_ble_write_handler(uint16_t conn_id,
  * app_ofu_ble_send_status
  * Send OFU Status (to OFU client)
  */
-static wiced_result_t app_ofu_ble_send_status(uint8_t status)
+static wiced_result_t app_ofu_ble_send_status(uint8_t status, uint8_t *p_data, uint16_t length)
 {
+    uint8_t tx_data[1 + 2 * sizeof(uint32_t)];
+    uint8_t *p = tx_data;
+
+    /* The Status may be followed by parameters (e.g. Resume offset) */
+    if (length > (sizeof(tx_data) - 1))
+    {
+        length = sizeof(tx_data) - 1;
+    }
+    UINT8_TO_STREAM(p, status);
+    if (length && p_data)
+    {
+        ARRAY_TO_STREAM(p, p_data, length);
+    }
+
     if (app_ofu_ble_cb.config_descriptor & GATT_CLIENT_CONFIG_INDICATION)
     {
         return wiced_bt_gatt_send_indication(app_ofu_ble_cb.conn_id,
-                HANDLE_OTA_FW_UPGRADE_CONTROL_POINT, 1, &status);
+                HANDLE_OTA_FW_UPGRADE_CONTROL_POINT, p - tx_data, tx_data);
     }
     else if (app_ofu_ble_cb.config_descriptor & GATT_CLIENT_CONFIG_NOTIFICATION)
     {
         return wiced_bt_gatt_send_notification(app_ofu_ble_cb.conn_id,
-                HANDLE_OTA_FW_UPGRADE_CONTROL_POINT, 1, &status);
+                HANDLE_OTA_FW_UPGRADE_CONTROL_POINT, p - tx_data, tx_data);
     }
     else
     {
@@ -274,4 +387,98 @@ static wiced_result_t app_ofu_ble_send_status(uint8_t status)
     }
     return WICED_BT_GATT_ERROR;
 }
+
+/*
+ * app_ofu_ble_stream_start
+ * Grant the initial Credits if the Client enabled the Stream Notifications
+ */
+static void app_ofu_ble_stream_start(void)
+{
+    if ((app_ofu_ble_cb.stream.config_descriptor & GATT_CLIENT_CONFIG_NOTIFICATION) == 0)
+    {
+        /* The Client uses the Data characteristic (Write Request) */
+        return;
+    }
+
+    APP_OFU_TRACE_DBG("credits:%d\n", APP_OFU_BLE_STREAM_CREDITS);
+
+    wiced_stop_timer(&app_ofu_ble_cb.stream.retry_timer);
+    app_ofu_ble_cb.stream.enabled = WICED_TRUE;
+    app_ofu_ble_cb.stream.credits = APP_OFU_BLE_STREAM_CREDITS;
+    app_ofu_ble_stream_credits_send();
+}
+
+/*
+ * app_ofu_ble_stream_stop
+ */
+static void app_ofu_ble_stream_stop(void)
+{
+    app_ofu_ble_cb.stream.enabled = WICED_FALSE;
+    app_ofu_ble_cb.stream.credits = 0;
+    wiced_stop_timer(&app_ofu_ble_cb.stream.retry_timer);
+}
+
+/*
+ * app_ofu_ble_stream_data_handler
+ * Handle Data received on the Stream characteristic (Write Without Response)
+ */
+static void app_ofu_ble_stream_data_handler(uint8_t *p_data, uint16_t length)
+{
+    uint8_t srv_status;
+
+    if (app_ofu_ble_cb.stream.enabled == WICED_FALSE)
+    {
+        APP_TRACE_ERR("Stream not started len:%d\n", length);
+        return;
+    }
+
+    srv_status = app_ofu_srv_data_handler(p_data, length, app_ofu_ble_app_callback);
+    if ((srv_status != WICED_OTA_UPGRADE_STATUS_OK) &&
+        (srv_status != WICED_OTA_UPGRADE_STATUS_CONTINUE))
+    {
+        /* No more Credits. The Client has to Resume (or restart) the download */
+        APP_TRACE_ERR("srv_status:%d\n", srv_status);
+        app_ofu_ble_stream_stop();
+        app_ofu_ble_send_status(srv_status, NULL, 0);
+        return;
+    }
+
+    /* The Data is handled (its buffer is freed). Give the Credits back by batch */
+    app_ofu_ble_cb.stream.credits++;
+    if ((app_ofu_ble_cb.stream.credits >= (APP_OFU_BLE_STREAM_CREDITS / 2)) &&
+        (wiced_is_timer_in_use(&app_ofu_ble_cb.stream.retry_timer) == WICED_FALSE))
+    {
+        app_ofu_ble_stream_credits_send();
+    }
+}
+
+/*
+ * app_ofu_ble_stream_credits_send
+ */
+static void app_ofu_ble_stream_credits_send(void)
+{
+    wiced_bt_gatt_status_t status;
+
+    status = wiced_bt_gatt_send_notification(app_ofu_ble_cb.conn_id, HANDLE_APP_OFU_BLE_STREAM,
+            sizeof(app_ofu_ble_cb.stream.credits), &app_ofu_ble_cb.stream.credits);
+    if (status != WICED_BT_GATT_SUCCESS)
+    {
+        /* No buffer. The Client may wait for these Credits: retry later */
+        wiced_start_timer(&app_ofu_ble_cb.stream.retry_timer, APP_OFU_BLE_STREAM_RETRY_TIMEOUT);
+        return;
+    }
+    app_ofu_ble_cb.stream.credits = 0;
+}
+
+/*
+ * app_ofu_ble_stream_retry_timer_callback
+ */
+static void app_ofu_ble_stream_retry_timer_callback(uint32_t param)
+{
+    if ((app_ofu_ble_cb.stream.enabled) &&
+        (app_ofu_ble_cb.stream.credits))
+    {
+        app_ofu_ble_stream_credits_send();
+    }
+}
 #endif
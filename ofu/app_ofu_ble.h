@@ -38,6 +38,25 @@
 #include "app_ofu.h"
 #include <wiced_bt_gatt.h>
 
+/*
+ * Definitions
+ */
+/*
+ * OFU Stream characteristic (in the OTA FW Upgrade Service). The Image is written with Write
+ * Without Response (instead of one Write Request per Data packet). The device grants Credits
+ * (Notification on this characteristic, 1 byte) and every Write consumes one Credit.
+ */
+#define HANDLE_APP_OFU_BLE_CHARACTERISTIC_STREAM                    0xff10
+#define HANDLE_APP_OFU_BLE_STREAM                                   0xff11
+#define HANDLE_APP_OFU_BLE_STREAM_CLIENT_CONFIGURATION_DESCRIPTOR   0xff12
+
+/* UUID: 5c1fa7e2-8c0f-4c7e-9b3a-6f2d1e8b4a37 */
+#define UUID_APP_OFU_BLE_CHARACTERISTIC_STREAM  0x37, 0x4a, 0x8b, 0x1e, 0x2d, 0x6f, 0x3a, 0x9b, \
+                                                0x7e, 0x4c, 0x0f, 0x8c, 0xe2, 0xa7, 0x1f, 0x5c
+
+/* Number of Write Without Response the Client can send before waiting for Credits */
+#define APP_OFU_BLE_STREAM_CREDITS              4
+
 /*
  * app_ofu_init
  */
@@ -35,6 +35,7 @@
 #ifdef OTA_FW_UPGRADE
 #include "app_ofu.h"
 #include "app_ofu_clt.h"
+#include "app_ofu_crc32.h"
 #include "app_lrac.h"
 #include "app_trace.h"
 #include <wiced_bt_ota_firmware_upgrade.h>
@@ -45,12 +46,14 @@
  * Definitions
  */
 #define APP_OFU_CLT_REQ_TIMER_DURATION      5   /* OFU Request Timeout */
+#define APP_OFU_CLT_RETX_MAX                3   /* Max Retransmissions on Request Timeout */
 
 typedef enum
 {
     APP_OFU_CLT_STATE_IDLE = 0,
     APP_OFU_CLT_STATE_PREPARING,
     APP_OFU_CLT_STATE_CONFIGURING,
+    APP_OFU_CLT_STATE_RESUMING,
     APP_OFU_CLT_STATE_DATA_TRANSFER,
     APP_OFU_CLT_STATE_VERIFYING,
     APP_OFU_CLT_STATE_ABORTING,
@@ -60,9 +63,19 @@ typedef struct
 {
     app_ota_clt_state_t state;
     uint32_t active_ds_length;
-    uint32_t current_offset;
+    uint32_t current_offset;        /* Offset of the next Data to send */
     uint16_t mtu;
     uint32_t crc32;
+    uint32_t crc_offset;            /* Data already included in the CRC */
+    uint8_t window_size;            /* 0 if the peer does not support Windowed transfer */
+    uint8_t peer_features;          /* APP_OFU_FEATURE_XXX supported by the peer */
+    uint32_t acked_offset;          /* Data acknowledged by the peer (Windowed transfer) */
+    uint32_t fast_retx_offset;      /* Offset of the last fast retransmission */
+    uint8_t retx_count;
+    wiced_bool_t fanout;            /* Forward the Image received by the local OFU Server */
+    uint32_t available_len;         /* Image Data committed by the local OFU Server (Fan-out) */
+    wiced_bool_t fanout_verified;   /* Image verified by the local OFU Server (Fan-out) */
+    wiced_bool_t waiting;           /* Waiting for the local OFU Server (Fan-out) */
 #ifdef APP_OFU_DEBUG
     int nb_tx_data_packet;
 #endif
@@ -80,13 +93,23 @@ static const uint8_t ds_image_prefix[8] = {'B', 'R', 'C', 'M', 'c', 'f', 'g', 'D
 /*
  * Local functions
  */
-static void app_ofu_clt_configure(app_ofu_clt_app_callback_t *p_app_callback,
+static void app_ofu_clt_configure(uint8_t command, app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback);
+static wiced_result_t app_ofu_clt_resume(uint8_t *p_data, uint16_t length);
+static wiced_result_t app_ofu_clt_image_crc32_get(uint32_t length, uint32_t *p_crc32);
 static void app_ofu_clt_download(app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback);
+static void app_ofu_clt_download_window(app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback);
+static wiced_result_t app_ofu_clt_window_ack(uint32_t next_offset);
+static void app_ofu_clt_verify(app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback);
 static void app_ofu_clt_abort(app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback);
 static wiced_result_t app_ofu_clt_active_partition_info_get(void);
+static uint32_t app_ofu_clt_image_read(uint32_t offset, uint8_t *p_data, uint32_t length);
+static uint32_t app_ofu_clt_image_available(void);
+static wiced_bool_t app_ofu_clt_fanout_wait(void);
 static uint32_t app_ofu_clt_crc32_update(uint32_t crc32, uint8_t *p_data, uint16_t length);
 static void app_ofu_clt_req_timer_start(app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback);
@@ -96,7 +119,6 @@ static void app_ofu_clt_req_timeout(uint32_t param);
 /*
  * External functions
  */
-uint32_t crc32_Update(uint32_t crc, uint8_t *buf, uint16_t len);
 extern uint32_t wiced_firmware_upgrade_retrieve_from_active_ds(uint32_t offset, uint8_t *data,
         uint32_t length);
 
@@ -142,6 +164,14 @@ wiced_result_t app_ofu_clt_start(uint16_t mtu, app_ofu_clt_app_callback_t *p_app
     app_ofu_clt_cb.mtu = mtu - 4;
     app_ofu_clt_cb.mtu &= ~0x3;
 
+    /* Stop-and-Wait transfer until the peer tells it supports Windowed transfer */
+    app_ofu_clt_cb.window_size = 0;
+    app_ofu_clt_cb.peer_features = 0;
+
+    /* Send the local Active Partition (unless a Fan-out is started) */
+    app_ofu_clt_cb.fanout = WICED_FALSE;
+    app_ofu_clt_cb.waiting = WICED_FALSE;
+
     header = APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD);
     status = p_send_callback(header, NULL, 0);
     if (status == WICED_BT_SUCCESS)
@@ -162,14 +192,94 @@ wiced_result_t app_ofu_clt_start(uint16_t mtu, app_ofu_clt_app_callback_t *p_app
     return status;
 }
 
+/*
+ * app_ofu_clt_fanout_start
+ */
+wiced_result_t app_ofu_clt_fanout_start(uint16_t mtu, uint32_t image_len,
+        app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback)
+{
+    wiced_result_t status;
+
+    APP_OFU_TRACE_DBG("image_len:%d\n", image_len);
+
+    status = app_ofu_clt_start(mtu, p_app_callback, p_send_callback);
+    if (status == WICED_BT_SUCCESS)
+    {
+        app_ofu_clt_cb.fanout = WICED_TRUE;
+        app_ofu_clt_cb.fanout_verified = WICED_FALSE;
+        app_ofu_clt_cb.active_ds_length = image_len;
+        app_ofu_clt_cb.available_len = 0;
+    }
+
+    return status;
+}
+
+/*
+ * app_ofu_clt_fanout_data
+ */
+void app_ofu_clt_fanout_data(uint32_t available_len)
+{
+    if (app_ofu_clt_cb.fanout == WICED_FALSE)
+    {
+        return;
+    }
+
+    app_ofu_clt_cb.available_len = available_len;
+
+    if (app_ofu_clt_cb.waiting)
+    {
+        app_ofu_clt_cb.waiting = WICED_FALSE;
+        app_ofu_clt_download(app_ofu_clt_cb.p_app_callback, app_ofu_clt_cb.p_send_callback);
+    }
+}
+
+/*
+ * app_ofu_clt_fanout_verified
+ */
+void app_ofu_clt_fanout_verified(void)
+{
+    if (app_ofu_clt_cb.fanout == WICED_FALSE)
+    {
+        return;
+    }
+
+    app_ofu_clt_cb.fanout_verified = WICED_TRUE;
+
+    if (app_ofu_clt_cb.waiting)
+    {
+        app_ofu_clt_cb.waiting = WICED_FALSE;
+        app_ofu_clt_download(app_ofu_clt_cb.p_app_callback, app_ofu_clt_cb.p_send_callback);
+    }
+}
+
+/*
+ * app_ofu_clt_fanout_abort
+ */
+void app_ofu_clt_fanout_abort(void)
+{
+    if ((app_ofu_clt_cb.fanout == WICED_FALSE) ||
+        (app_ofu_clt_cb.state == APP_OFU_CLT_STATE_IDLE) ||
+        (app_ofu_clt_cb.state == APP_OFU_CLT_STATE_ABORTING))
+    {
+        return;
+    }
+
+    app_ofu_clt_cb.waiting = WICED_FALSE;
+    app_ofu_clt_abort(app_ofu_clt_cb.p_app_callback, app_ofu_clt_cb.p_send_callback);
+}
+
 /*
  * app_ofu_clt_rx_handler
  * This function is used handle Rx data (as OFU Client)
  */
-void app_ofu_clt_rx_handler(uint8_t header, app_ofu_clt_app_callback_t *p_app_callback,
+void app_ofu_clt_rx_handler(uint8_t header, uint8_t *p_data, uint16_t length,
+        app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback)
 {
     uint8_t rcv_status;
+    uint8_t window_size;
+    uint32_t next_offset;
 
     rcv_status = APP_OFU_HDR_STS_GET(header);
     APP_OFU_TRACE_DBG("rcv_status:%d state:%d\n", rcv_status, app_ofu_clt_cb.state);
@@ -188,7 +298,51 @@ void app_ofu_clt_rx_handler(uint8_t header, app_ofu_clt_app_callback_t *p_app_ca
             app_ofu_clt_abort(p_app_callback, p_send_callback);
             return;
         }
-        app_ofu_clt_configure(p_app_callback, p_send_callback);
+        /* Peer (Server) supporting Windowed transfer send its Window size */
+        if (length >= sizeof(uint8_t))
+        {
+            STREAM_TO_UINT8(window_size, p_data);
+            if (window_size > APP_OFU_WINDOW_SIZE)
+            {
+                window_size = APP_OFU_WINDOW_SIZE;
+            }
+            app_ofu_clt_cb.window_size = window_size;
+            length--;
+        }
+        if (length >= sizeof(uint8_t))
+        {
+            STREAM_TO_UINT8(app_ofu_clt_cb.peer_features, p_data);
+        }
+        APP_OFU_TRACE_DBG("window_size:%d peer_features:0x%x\n", app_ofu_clt_cb.window_size,
+                app_ofu_clt_cb.peer_features);
+        /* Try to Resume a previous (interrupted) download if the peer supports it */
+        if (app_ofu_clt_cb.peer_features & APP_OFU_FEATURE_RESUME)
+        {
+            app_ofu_clt_configure(APP_OFU_COMMAND_RESUME, p_app_callback, p_send_callback);
+        }
+        else
+        {
+            app_ofu_clt_configure(WICED_OTA_UPGRADE_COMMAND_DOWNLOAD, p_app_callback,
+                    p_send_callback);
+        }
+        break;
+
+    case APP_OFU_CLT_STATE_RESUMING:
+        if (rcv_status != WICED_OTA_UPGRADE_STATUS_OK)
+        {
+            APP_TRACE_ERR("Peer OFU LRAC Server rejected OFU Resume Cmd (status:%d)\n",
+                    rcv_status);
+            app_ofu_clt_abort(p_app_callback, p_send_callback);
+            return;
+        }
+        if (app_ofu_clt_resume(p_data, length) != WICED_BT_SUCCESS)
+        {
+            /* Cannot Resume, restart the download from the beginning */
+            app_ofu_clt_configure(WICED_OTA_UPGRADE_COMMAND_DOWNLOAD, p_app_callback,
+                    p_send_callback);
+            return;
+        }
+        app_ofu_clt_download(p_app_callback, p_send_callback);
         break;
 
     case APP_OFU_CLT_STATE_CONFIGURING:
@@ -210,10 +364,32 @@ void app_ofu_clt_rx_handler(uint8_t header, app_ofu_clt_app_callback_t *p_app_ca
             app_ofu_clt_abort(p_app_callback, p_send_callback);
             return;
         }
+        if (app_ofu_clt_cb.window_size)
+        {
+            /* Extract the Cumulative Acknowledgement */
+            if (length < sizeof(uint32_t))
+            {
+                APP_TRACE_ERR("No Acknowledgement offset\n");
+                app_ofu_clt_abort(p_app_callback, p_send_callback);
+                return;
+            }
+            STREAM_TO_UINT32(next_offset, p_data);
+            if (app_ofu_clt_window_ack(next_offset) != WICED_BT_SUCCESS)
+            {
+                app_ofu_clt_abort(p_app_callback, p_send_callback);
+                return;
+            }
+        }
         app_ofu_clt_download(p_app_callback, p_send_callback);
         break;
 
     case APP_OFU_CLT_STATE_VERIFYING:
+        /* Ignore the Acknowledgement of a retransmitted (duplicated) Data */
+        if ((app_ofu_clt_cb.window_size) &&
+            (rcv_status == WICED_OTA_UPGRADE_STATUS_CONTINUE))
+        {
+            break;
+        }
         /* Stop the Request timer */
         app_ofu_clt_req_timer_stop();
 
@@ -246,8 +422,9 @@ void app_ofu_clt_rx_handler(uint8_t header, app_ofu_clt_app_callback_t *p_app_ca
 
 /*
  * app_ofu_clt_send_configure_send
+ * Send the Download (or Resume) command
  */
-static void app_ofu_clt_configure(app_ofu_clt_app_callback_t *p_app_callback,
+static void app_ofu_clt_configure(uint8_t command, app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback)
 {
     wiced_result_t status;
@@ -255,20 +432,31 @@ static void app_ofu_clt_configure(app_ofu_clt_app_callback_t *p_app_callback,
     uint8_t tx_data[sizeof(uint32_t)];
     uint8_t *p;
 
-    status = app_ofu_clt_active_partition_info_get();
-    if (status != WICED_BT_SUCCESS)
+    /* The length of the Image forwarded (Fan-out) is given by the local OFU Server */
+    if (app_ofu_clt_cb.fanout == WICED_FALSE)
     {
-        APP_TRACE_ERR("app_ofu_clt_active_partition_info_get failed\n");
-        app_ofu_clt_abort(p_app_callback, p_send_callback);
-        return;
+        status = app_ofu_clt_active_partition_info_get();
+        if (status != WICED_BT_SUCCESS)
+        {
+            APP_TRACE_ERR("app_ofu_clt_active_partition_info_get failed\n");
+            app_ofu_clt_abort(p_app_callback, p_send_callback);
+            return;
+        }
     }
 
-    app_ofu_clt_cb.state = APP_OFU_CLT_STATE_CONFIGURING;
+    if (command == APP_OFU_COMMAND_RESUME)
+    {
+        app_ofu_clt_cb.state = APP_OFU_CLT_STATE_RESUMING;
+    }
+    else
+    {
+        app_ofu_clt_cb.state = APP_OFU_CLT_STATE_CONFIGURING;
+    }
     p = tx_data;
     UINT32_TO_STREAM(p, app_ofu_clt_cb.active_ds_length);
 
     /* Send Configure Command to peer LRAC device */
-    header = APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, WICED_OTA_UPGRADE_COMMAND_DOWNLOAD);
+    header = APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, command);
     status = p_send_callback(header, tx_data, p - tx_data);
     if (status != WICED_BT_SUCCESS)
     {
@@ -280,7 +468,98 @@ static void app_ofu_clt_configure(app_ofu_clt_app_callback_t *p_app_callback,
     app_ofu_clt_req_timer_start(p_app_callback, p_send_callback);
 
     app_ofu_clt_cb.current_offset = 0;
-    app_ofu_clt_cb.crc32 = 0xFFFFFFFF;
+    app_ofu_clt_cb.crc32 = APP_OFU_CRC32_INIT;
+    app_ofu_clt_cb.crc_offset = 0;
+    app_ofu_clt_cb.acked_offset = 0;
+    app_ofu_clt_cb.fast_retx_offset = 0xFFFFFFFF;
+    app_ofu_clt_cb.retx_count = 0;
+}
+
+/*
+ * app_ofu_clt_resume
+ * Handle the Resume Response. The download can be resumed only if the Data already committed by
+ * the peer matches the local image.
+ */
+static wiced_result_t app_ofu_clt_resume(uint8_t *p_data, uint16_t length)
+{
+    uint32_t offset;
+    uint32_t peer_crc32;
+    uint32_t crc32;
+
+    if (length < (2 * sizeof(uint32_t)))
+    {
+        APP_TRACE_ERR("Bad Resume Response length:%d\n", length);
+        return WICED_BT_ERROR;
+    }
+
+    STREAM_TO_UINT32(offset, p_data);
+    STREAM_TO_UINT32(peer_crc32, p_data);
+
+    /* Nothing to resume */
+    if (offset == 0)
+    {
+        return WICED_BT_SUCCESS;
+    }
+
+    if ((offset >= app_ofu_clt_cb.active_ds_length) ||
+        (offset > app_ofu_clt_image_available()))
+    {
+        APP_TRACE_ERR("Bad Resume offset:%d\n", offset);
+        return WICED_BT_ERROR;
+    }
+
+    if ((app_ofu_clt_image_crc32_get(offset, &crc32) != WICED_BT_SUCCESS) ||
+        (crc32 != peer_crc32))
+    {
+        APP_TRACE_ERR("Peer image does not match. Restart download\n");
+        return WICED_BT_ERROR;
+    }
+
+    APP_OFU_TRACE_DBG("Resume from offset:%d/%d\n", offset, app_ofu_clt_cb.active_ds_length);
+
+    app_ofu_clt_cb.current_offset = offset;
+    app_ofu_clt_cb.acked_offset = offset;
+    app_ofu_clt_cb.crc_offset = offset;
+    app_ofu_clt_cb.crc32 = crc32;
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_ofu_clt_image_crc32_get
+ * Compute the running CRC32 (not finalized) of the beginning of the local image
+ */
+static wiced_result_t app_ofu_clt_image_crc32_get(uint32_t length, uint32_t *p_crc32)
+{
+    uint8_t data[256];
+    uint32_t offset = 0;
+    uint32_t bytes_to_read;
+    uint32_t read_length;
+    uint32_t crc32 = APP_OFU_CRC32_INIT;
+
+    while (offset < length)
+    {
+        bytes_to_read = length - offset;
+        if (bytes_to_read > sizeof(data))
+        {
+            bytes_to_read = sizeof(data);
+        }
+
+        /* The NVRAM Read must be a multiple of 4 bytes */
+        read_length = app_ofu_clt_image_read(offset, data, (bytes_to_read + 3) & 0xFFFC);
+        if (read_length != ((bytes_to_read + 3) & 0xFFFC))
+        {
+            APP_TRACE_ERR("app_ofu_clt_image_read failed\n");
+            return WICED_BT_ERROR;
+        }
+
+        crc32 = app_ofu_clt_crc32_update(crc32, data, bytes_to_read);
+        offset += bytes_to_read;
+    }
+
+    *p_crc32 = crc32;
+
+    return WICED_BT_SUCCESS;
 }
 
 /*
@@ -292,12 +571,23 @@ static void app_ofu_clt_download(app_ofu_clt_app_callback_t *p_app_callback,
     wiced_result_t status;
     uint8_t header;
     uint8_t tx_data[1021];
-    uint8_t *p;
     uint32_t bytes_to_send;
     uint32_t read_length;
     uint32_t bytes_to_read;
 
-    bytes_to_send = app_ofu_clt_cb.active_ds_length - app_ofu_clt_cb.current_offset;
+    if (app_ofu_clt_cb.window_size)
+    {
+        app_ofu_clt_download_window(p_app_callback, p_send_callback);
+        return;
+    }
+
+    /* Fan-out: wait until the local OFU Server commits (or verifies) the Image */
+    if (app_ofu_clt_fanout_wait())
+    {
+        return;
+    }
+
+    bytes_to_send = app_ofu_clt_image_available() - app_ofu_clt_cb.current_offset;
     if (bytes_to_send > app_ofu_clt_cb.mtu)
     {
         bytes_to_send = app_ofu_clt_cb.mtu;
@@ -311,12 +601,12 @@ static void app_ofu_clt_download(app_ofu_clt_app_callback_t *p_app_callback,
         bytes_to_read = bytes_to_send + 3;
         bytes_to_read &= 0xFFFC;
 
-        read_length = wiced_firmware_upgrade_retrieve_from_active_ds(
-                app_ofu_clt_cb.current_offset, tx_data, bytes_to_read);
+        read_length = app_ofu_clt_image_read(app_ofu_clt_cb.current_offset, tx_data,
+                bytes_to_read);
         if ((read_length == 0) ||
             (read_length != bytes_to_read))
         {
-            APP_TRACE_ERR("wiced_firmware_upgrade_retrieve_from_active_ds failed\n");
+            APP_TRACE_ERR("app_ofu_clt_image_read failed\n");
             app_ofu_clt_abort(p_app_callback, p_send_callback);
             return;
         }
@@ -344,26 +634,185 @@ static void app_ofu_clt_download(app_ofu_clt_app_callback_t *p_app_callback,
     }
     else
     {
-        app_ofu_clt_cb.state = APP_OFU_CLT_STATE_VERIFYING;
+        app_ofu_clt_verify(p_app_callback, p_send_callback);
+    }
+}
 
-        app_ofu_clt_cb.crc32 ^= 0xFFFFFFFF;
-        p = tx_data;
-        UINT32_TO_STREAM(p, app_ofu_clt_cb.crc32);
+/*
+ * app_ofu_clt_download_window
+ * Windowed transfer: send Data until the window is full. Every Data packet contains its offset
+ * in the image and the peer acknowledges the Data received in sequence.
+ */
+static void app_ofu_clt_download_window(app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback)
+{
+    wiced_result_t status;
+    uint8_t header;
+    uint8_t tx_data[1021];
+    uint8_t *p;
+    uint16_t chunk_size;
+    uint32_t nb_in_flight;
+    uint32_t bytes_to_send;
+    uint32_t read_length;
+    uint32_t bytes_to_read;
+    uint32_t crc_len;
 
-        APP_OFU_TRACE_DBG("Send Verify cmd CRC32:0x%X\n", app_ofu_clt_cb.crc32);
+    /* All the Data acknowledged */
+    if (app_ofu_clt_cb.acked_offset >= app_ofu_clt_cb.active_ds_length)
+    {
+        /* Fan-out: wait until the local OFU Server verifies the Image */
+        if (app_ofu_clt_fanout_wait())
+        {
+            return;
+        }
+        app_ofu_clt_verify(p_app_callback, p_send_callback);
+        return;
+    }
 
-        /* Send Data to peer LRAC device */
-        header = APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, WICED_OTA_UPGRADE_COMMAND_VERIFY);
-        status = p_send_callback(header, tx_data, p - tx_data);
-        if (status == WICED_BT_SUCCESS)
+    app_ofu_clt_cb.state = APP_OFU_CLT_STATE_DATA_TRANSFER;
+
+    /* The Image offset is added to every Data packet */
+    chunk_size = app_ofu_clt_cb.mtu - sizeof(uint32_t);
+
+    while (app_ofu_clt_cb.current_offset < app_ofu_clt_image_available())
+    {
+        nb_in_flight = app_ofu_clt_cb.current_offset - app_ofu_clt_cb.acked_offset;
+        nb_in_flight = (nb_in_flight + chunk_size - 1) / chunk_size;
+        if (nb_in_flight >= app_ofu_clt_cb.window_size)
         {
-            /* Start a Request timer */
-            app_ofu_clt_req_timer_start(p_app_callback, p_send_callback);
+            break;
         }
-        else
+
+        /* Fan-out: do not send the Data not yet committed by the local OFU Server */
+        bytes_to_send = app_ofu_clt_image_available() - app_ofu_clt_cb.current_offset;
+        if (bytes_to_send > chunk_size)
         {
+            bytes_to_send = chunk_size;
+        }
+
+        /* The NVRAM Read must be a multiple of 4 bytes */
+        bytes_to_read = bytes_to_send + 3;
+        bytes_to_read &= 0xFFFC;
+
+        p = tx_data;
+        UINT32_TO_STREAM(p, app_ofu_clt_cb.current_offset);
+
+        read_length = app_ofu_clt_image_read(app_ofu_clt_cb.current_offset, p, bytes_to_read);
+        if ((read_length == 0) ||
+            (read_length != bytes_to_read))
+        {
+            APP_TRACE_ERR("app_ofu_clt_image_read failed\n");
             app_ofu_clt_abort(p_app_callback, p_send_callback);
+            return;
+        }
+
+        /*
+         * Update CRC on the fly (retransmitted Data is already included). The retransmitted
+         * packets may not start on the same offsets (Fan-out packets end on committed Data)
+         */
+        if ((app_ofu_clt_cb.current_offset <= app_ofu_clt_cb.crc_offset) &&
+            ((app_ofu_clt_cb.current_offset + bytes_to_send) > app_ofu_clt_cb.crc_offset))
+        {
+            crc_len = app_ofu_clt_cb.current_offset + bytes_to_send - app_ofu_clt_cb.crc_offset;
+            app_ofu_clt_cb.crc32 = app_ofu_clt_crc32_update(app_ofu_clt_cb.crc32,
+                    p + (app_ofu_clt_cb.crc_offset - app_ofu_clt_cb.current_offset), crc_len);
+            app_ofu_clt_cb.crc_offset += crc_len;
+        }
+
+        /* Send Data to peer LRAC device */
+        header = APP_OFU_HDR_SET(APP_OFU_DATA_WINDOW, 0);
+        status = p_send_callback(header, tx_data, sizeof(uint32_t) + bytes_to_send);
+        if (status != WICED_BT_SUCCESS)
+        {
+            if (nb_in_flight == 0)
+            {
+                app_ofu_clt_abort(p_app_callback, p_send_callback);
+                return;
+            }
+            /* No Tx buffer available. Wait for the next Acknowledgement */
+            break;
         }
+        app_ofu_clt_cb.current_offset += bytes_to_send;
+    }
+
+    APP_OFU_TRACE_DBG("progress:%d/%d sent:%d\n", app_ofu_clt_cb.acked_offset,
+            app_ofu_clt_cb.active_ds_length, app_ofu_clt_cb.current_offset);
+
+    /* Fan-out: nothing in flight, wait until the local OFU Server commits more Data */
+    if ((app_ofu_clt_cb.current_offset == app_ofu_clt_cb.acked_offset) &&
+        (app_ofu_clt_fanout_wait()))
+    {
+        return;
+    }
+
+    /* Start a Request timer */
+    app_ofu_clt_req_timer_start(p_app_callback, p_send_callback);
+}
+
+/*
+ * app_ofu_clt_window_ack
+ * Handle a Cumulative Acknowledgement (offset of the next Data expected by the peer)
+ */
+static wiced_result_t app_ofu_clt_window_ack(uint32_t next_offset)
+{
+    if (next_offset > app_ofu_clt_cb.current_offset)
+    {
+        APP_TRACE_ERR("Wrong Acknowledgement offset:%d sent:%d\n", next_offset,
+                app_ofu_clt_cb.current_offset);
+        return WICED_BT_ERROR;
+    }
+
+    if (next_offset > app_ofu_clt_cb.acked_offset)
+    {
+        app_ofu_clt_cb.acked_offset = next_offset;
+        app_ofu_clt_cb.retx_count = 0;
+    }
+    else if ((next_offset == app_ofu_clt_cb.acked_offset) &&
+             (app_ofu_clt_cb.current_offset > app_ofu_clt_cb.acked_offset) &&
+             (app_ofu_clt_cb.fast_retx_offset != app_ofu_clt_cb.acked_offset))
+    {
+        /*
+         * Duplicated Acknowledgement: the peer received Data out of sequence (and ignored it).
+         * Retransmit (once) from the first missing byte.
+         */
+        APP_TRACE_ERR("Data lost. Retransmit from offset:%d\n", app_ofu_clt_cb.acked_offset);
+        app_ofu_clt_cb.fast_retx_offset = app_ofu_clt_cb.acked_offset;
+        app_ofu_clt_cb.current_offset = app_ofu_clt_cb.acked_offset;
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_ofu_clt_verify
+ */
+static void app_ofu_clt_verify(app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback)
+{
+    wiced_result_t status;
+    uint8_t header;
+    uint8_t tx_data[sizeof(uint32_t)];
+    uint8_t *p;
+
+    app_ofu_clt_cb.state = APP_OFU_CLT_STATE_VERIFYING;
+
+    app_ofu_clt_cb.crc32 ^= 0xFFFFFFFF;
+    p = tx_data;
+    UINT32_TO_STREAM(p, app_ofu_clt_cb.crc32);
+
+    APP_OFU_TRACE_DBG("Send Verify cmd CRC32:0x%X\n", app_ofu_clt_cb.crc32);
+
+    /* Send Data to peer LRAC device */
+    header = APP_OFU_HDR_SET(APP_OFU_CONTROL_COMMAND, WICED_OTA_UPGRADE_COMMAND_VERIFY);
+    status = p_send_callback(header, tx_data, p - tx_data);
+    if (status == WICED_BT_SUCCESS)
+    {
+        /* Start a Request timer */
+        app_ofu_clt_req_timer_start(p_app_callback, p_send_callback);
+    }
+    else
+    {
+        app_ofu_clt_abort(p_app_callback, p_send_callback);
     }
 }
 
@@ -440,8 +889,7 @@ static wiced_result_t app_ofu_clt_active_partition_info_get(void)
 
     /* Read Real DS Section size */
     STREAM_TO_UINT32(u32, p);
-    /* FW image cannot be bigger than half of the Flash's size */
-    if (u32 > (512 * 1024))
+    if (u32 > APP_OFU_IMAGE_LEN_MAX)
     {
         APP_TRACE_ERR("Wrong size:%d\n", u32);
         return WICED_BT_ERROR;
@@ -454,12 +902,67 @@ static wiced_result_t app_ofu_clt_active_partition_info_get(void)
     return WICED_BT_SUCCESS;
 }
 
+/*
+ * app_ofu_clt_image_read
+ * Read the Image to send: the local Active Partition or, for a Fan-out, the Image received by
+ * the local OFU Server (in the Download Partition)
+ */
+static uint32_t app_ofu_clt_image_read(uint32_t offset, uint8_t *p_data, uint32_t length)
+{
+    if (app_ofu_clt_cb.fanout)
+    {
+        return wiced_firmware_upgrade_retrieve_from_nv(offset, p_data, length);
+    }
+    return wiced_firmware_upgrade_retrieve_from_active_ds(offset, p_data, length);
+}
+
+/*
+ * app_ofu_clt_image_available
+ * Length of the Image which can be sent
+ */
+static uint32_t app_ofu_clt_image_available(void)
+{
+    if (app_ofu_clt_cb.fanout)
+    {
+        return app_ofu_clt_cb.available_len;
+    }
+    return app_ofu_clt_cb.active_ds_length;
+}
+
+/*
+ * app_ofu_clt_fanout_wait
+ * Check if the Fan-out must wait for the local OFU Server: all the Data committed has been sent
+ * or all the Image has been sent but the local OFU Server did not verify it yet.
+ * The transfer is resumed by app_ofu_clt_fanout_data or app_ofu_clt_fanout_verified.
+ */
+static wiced_bool_t app_ofu_clt_fanout_wait(void)
+{
+    if ((app_ofu_clt_cb.fanout == WICED_FALSE) ||
+        (app_ofu_clt_cb.current_offset < app_ofu_clt_cb.available_len))
+    {
+        return WICED_FALSE;
+    }
+
+    if ((app_ofu_clt_cb.current_offset >= app_ofu_clt_cb.active_ds_length) &&
+        (app_ofu_clt_cb.fanout_verified))
+    {
+        return WICED_FALSE;
+    }
+
+    /* No Request pending. The peer is not expected to answer */
+    app_ofu_clt_req_timer_stop();
+    app_ofu_clt_cb.state = APP_OFU_CLT_STATE_DATA_TRANSFER;
+    app_ofu_clt_cb.waiting = WICED_TRUE;
+
+    return WICED_TRUE;
+}
+
 /*
  * app_ofu_clt_crc32_update
  */
 static uint32_t app_ofu_clt_crc32_update(uint32_t crc32, uint8_t *p_data, uint16_t length)
 {
-    return crc32_Update(crc32, p_data, length);
+    return app_ofu_crc32_update(crc32, p_data, length);
 }
 
 /*
@@ -496,6 +999,22 @@ static void app_ofu_clt_req_timeout(uint32_t param)
 
     APP_TRACE_ERR("\n");
 
+    /* Windowed transfer: retransmit from the last acknowledged offset */
+    if ((app_ofu_clt_cb.state == APP_OFU_CLT_STATE_DATA_TRANSFER) &&
+        (app_ofu_clt_cb.window_size) &&
+        (app_ofu_clt_cb.retx_count < APP_OFU_CLT_RETX_MAX) &&
+        (app_ofu_clt_cb.p_app_callback) &&
+        (app_ofu_clt_cb.p_send_callback))
+    {
+        app_ofu_clt_cb.retx_count++;
+        APP_TRACE_ERR("Retransmit from offset:%d retx_count:%d\n", app_ofu_clt_cb.acked_offset,
+                app_ofu_clt_cb.retx_count);
+        app_ofu_clt_cb.current_offset = app_ofu_clt_cb.acked_offset;
+        app_ofu_clt_download_window(app_ofu_clt_cb.p_app_callback,
+                app_ofu_clt_cb.p_send_callback);
+        return;
+    }
+
     if (app_ofu_clt_cb.p_app_callback)
     {
         /* Tell the application OFU is Aborted */
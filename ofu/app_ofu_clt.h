@@ -62,5 +62,33 @@ wiced_result_t app_ofu_clt_start(uint16_t mtu, app_ofu_clt_app_callback_t *p_app
  * app_ofu_clt_rx_handler
  * This function is used handle Rx data (as OFU Client)
  */
-void app_ofu_clt_rx_handler(uint8_t header, app_ofu_clt_app_callback_t *p_app_callback,
+void app_ofu_clt_rx_handler(uint8_t header, uint8_t *p_data, uint16_t length,
+        app_ofu_clt_app_callback_t *p_app_callback,
         app_ofu_clt_send_callback_t *p_send_callback);
+
+/*
+ * app_ofu_clt_fanout_start
+ * Start OFU (as Client) to forward the Image received by the local OFU Server (Fan-out).
+ * The Image is sent as soon as it is committed by the local OFU Server
+ */
+wiced_result_t app_ofu_clt_fanout_start(uint16_t mtu, uint32_t image_len,
+        app_ofu_clt_app_callback_t *p_app_callback,
+        app_ofu_clt_send_callback_t *p_send_callback);
+
+/*
+ * app_ofu_clt_fanout_data
+ * Length of the Image committed by the local OFU Server (Fan-out)
+ */
+void app_ofu_clt_fanout_data(uint32_t available_len);
+
+/*
+ * app_ofu_clt_fanout_verified
+ * The Image has been verified by the local OFU Server. The peer can verify it (Fan-out)
+ */
+void app_ofu_clt_fanout_verified(void);
+
+/*
+ * app_ofu_clt_fanout_abort
+ * The local OFU Server aborted the download (Fan-out)
+ */
+void app_ofu_clt_fanout_abort(void);
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *
+ *  OFU (OTA FW Upgrade) CRC32 implementation.
+ */
+
+#pragma once
+
+#include "wiced.h"
+
+/*
+ * Definitions
+ */
+/*
+ * Number of bytes processed per iteration (1, 4 or 8). Every slice needs a 1 KB table (in Flash):
+ * 1: 1 KB (byte per byte), 4: 4 KB, 8: 8 KB (fastest)
+ */
+#ifndef APP_OFU_CRC32_SLICE
+#define APP_OFU_CRC32_SLICE             4
+#endif
+
+/* Initial value of a running CRC32 */
+#define APP_OFU_CRC32_INIT              0xFFFFFFFF
+
+/*
+ * app_ofu_crc32_update
+ * Update a running CRC32 (IEEE 802.3, reflected). The running CRC32 must be initialized with
+ * APP_OFU_CRC32_INIT and finalized by XOR-ing it with 0xFFFFFFFF (same as crc32_Update).
+ */
+uint32_t app_ofu_crc32_update(uint32_t crc32, const uint8_t *p_data, uint32_t length);
@@ -0,0 +1,468 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *
+ *  OFU (OTA FW Upgrade) Delta (differential) image implementation.
+ *  The new Image is reconstructed from the Active Partition (Base Image) and a Patch stream
+ *  received, in sequence, in the OFU Data packets.
+ *  The CRC32 of the Base Image is computed in background (one block per application event) while
+ *  the Patch is received. The download is aborted as soon as it does not match.
+ */
+#ifdef OTA_FW_UPGRADE
+#include <string.h>
+#include "app_ofu.h"
+#include "app_ofu_delta.h"
+#include "app_ofu_crc32.h"
+#include "app_trace.h"
+#include <wiced_bt_ota_firmware_upgrade.h>
+
+/*
+ * Definitions
+ */
+/* Size of the buffer used to read the Base Image (must be a multiple of 4) */
+#define APP_OFU_DELTA_READ_SIZE             128
+
+/* Base Image bytes checked (CRC32) per application event */
+#define APP_OFU_DELTA_CHECK_BLOCK_SIZE      4096
+
+typedef enum
+{
+    APP_OFU_DELTA_STATE_OP = 0,             /* Waiting for an Operation */
+    APP_OFU_DELTA_STATE_PARAM,              /* Receiving the Operation parameters */
+    APP_OFU_DELTA_STATE_LITERAL,            /* Receiving Literal data */
+} app_ofu_delta_state_t;
+
+typedef enum
+{
+    APP_OFU_DELTA_CHECK_IDLE = 0,
+    APP_OFU_DELTA_CHECK_IN_PROGRESS,        /* CRC32 of the Base Image being computed */
+    APP_OFU_DELTA_CHECK_OK,
+    APP_OFU_DELTA_CHECK_FAILED,             /* Base Image read failed or CRC32 mismatch */
+} app_ofu_delta_check_state_t;
+
+typedef struct
+{
+    app_ofu_delta_state_t state;
+    uint32_t base_len;
+    uint8_t op;
+    uint8_t param[sizeof(uint32_t) + sizeof(uint16_t)];
+    uint8_t param_len;                      /* Parameters received */
+    uint8_t param_needed;                   /* Parameters of the current operation */
+    uint16_t literal_len;                   /* Literal data remaining */
+    app_ofu_delta_check_state_t check_state;
+    wiced_bool_t check_scheduled;
+    uint32_t check_offset;                  /* Base Image bytes already checked */
+    uint32_t check_crc32;                   /* Running CRC32 of the Base Image */
+    uint32_t base_crc32;                    /* Expected CRC32 of the Base Image */
+} app_ofu_delta_cb_t;
+
+/*
+ * Global variables
+ */
+static app_ofu_delta_cb_t app_ofu_delta_cb;
+
+/*
+ * Local functions
+ */
+static uint8_t app_ofu_delta_param_handler(app_ofu_delta_write_t *p_write);
+static uint8_t app_ofu_delta_copy(uint32_t offset, uint16_t length,
+        app_ofu_delta_write_t *p_write);
+static wiced_result_t app_ofu_delta_base_read(uint32_t offset, uint8_t *p_data,
+        uint16_t length);
+static void app_ofu_delta_check_block(void);
+static int app_ofu_delta_check_serialized(void *p_data);
+
+/*
+ * External functions
+ */
+extern uint32_t wiced_firmware_upgrade_retrieve_from_active_ds(uint32_t offset, uint8_t *data,
+        uint32_t length);
+
+/*
+ * app_ofu_delta_start
+ */
+wiced_result_t app_ofu_delta_start(uint32_t base_len, uint32_t base_crc32)
+{
+    /* A check of the previous download may still be scheduled */
+    wiced_bool_t check_scheduled = app_ofu_delta_cb.check_scheduled;
+
+    memset(&app_ofu_delta_cb, 0, sizeof(app_ofu_delta_cb));
+    app_ofu_delta_cb.check_scheduled = check_scheduled;
+
+    if ((base_len == 0) ||
+        (base_len > APP_OFU_IMAGE_LEN_MAX))
+    {
+        APP_TRACE_ERR("Wrong Base length:%d\n", base_len);
+        return WICED_BT_BADARG;
+    }
+
+    app_ofu_delta_cb.base_len = base_len;
+    app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_OP;
+
+    /* The Patch can be applied only on the Base Image it has been generated from */
+    app_ofu_delta_cb.base_crc32 = base_crc32;
+    app_ofu_delta_cb.check_crc32 = APP_OFU_CRC32_INIT;
+    app_ofu_delta_cb.check_state = APP_OFU_DELTA_CHECK_IN_PROGRESS;
+    if (app_ofu_delta_cb.check_scheduled == WICED_FALSE)
+    {
+        if (wiced_app_event_serialize(&app_ofu_delta_check_serialized, NULL) != WICED_SUCCESS)
+        {
+            /* Check the whole Base Image now */
+            return (app_ofu_delta_base_check(WICED_TRUE) == WICED_OTA_UPGRADE_STATUS_OK) ?
+                    WICED_BT_SUCCESS : WICED_BT_ERROR;
+        }
+        app_ofu_delta_cb.check_scheduled = WICED_TRUE;
+    }
+
+    return WICED_BT_SUCCESS;
+}
+
+/*
+ * app_ofu_delta_stop
+ */
+void app_ofu_delta_stop(void)
+{
+    app_ofu_delta_cb.check_state = APP_OFU_DELTA_CHECK_IDLE;
+}
+
+/*
+ * app_ofu_delta_base_check
+ */
+uint8_t app_ofu_delta_base_check(wiced_bool_t complete)
+{
+    if (complete)
+    {
+        while (app_ofu_delta_cb.check_state == APP_OFU_DELTA_CHECK_IN_PROGRESS)
+        {
+            app_ofu_delta_check_block();
+        }
+    }
+
+    switch (app_ofu_delta_cb.check_state)
+    {
+    case APP_OFU_DELTA_CHECK_IN_PROGRESS:
+        return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+
+    case APP_OFU_DELTA_CHECK_OK:
+        return WICED_OTA_UPGRADE_STATUS_OK;
+
+    case APP_OFU_DELTA_CHECK_FAILED:
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+
+    default:
+        return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
+    }
+}
+
+/*
+ * app_ofu_delta_check_serialized
+ * Check the next block of the Base Image (once per application event)
+ */
+static int app_ofu_delta_check_serialized(void *p_data)
+{
+    app_ofu_delta_cb.check_scheduled = WICED_FALSE;
+
+    /* The check may have been completed (Verify) or stopped (abort) in the meantime */
+    if (app_ofu_delta_cb.check_state != APP_OFU_DELTA_CHECK_IN_PROGRESS)
+    {
+        return 0;
+    }
+
+    app_ofu_delta_check_block();
+
+    if (app_ofu_delta_cb.check_state == APP_OFU_DELTA_CHECK_IN_PROGRESS)
+    {
+        if (wiced_app_event_serialize(&app_ofu_delta_check_serialized, NULL) == WICED_SUCCESS)
+        {
+            app_ofu_delta_cb.check_scheduled = WICED_TRUE;
+        }
+        /* Otherwise, the check will be completed by the Verify command */
+    }
+
+    return 0;
+}
+
+/*
+ * app_ofu_delta_check_block
+ * Update the CRC32 of the Base Image with the next block
+ */
+static void app_ofu_delta_check_block(void)
+{
+    uint8_t data[APP_OFU_DELTA_READ_SIZE];
+    uint32_t end_offset;
+    uint16_t length;
+
+    end_offset = app_ofu_delta_cb.check_offset + APP_OFU_DELTA_CHECK_BLOCK_SIZE;
+    if (end_offset > app_ofu_delta_cb.base_len)
+    {
+        end_offset = app_ofu_delta_cb.base_len;
+    }
+
+    for ( ; app_ofu_delta_cb.check_offset < end_offset; app_ofu_delta_cb.check_offset += length)
+    {
+        length = sizeof(data);
+        if (length > (end_offset - app_ofu_delta_cb.check_offset))
+        {
+            length = end_offset - app_ofu_delta_cb.check_offset;
+        }
+        if (app_ofu_delta_base_read(app_ofu_delta_cb.check_offset, data, length) !=
+                WICED_BT_SUCCESS)
+        {
+            app_ofu_delta_cb.check_state = APP_OFU_DELTA_CHECK_FAILED;
+            return;
+        }
+        app_ofu_delta_cb.check_crc32 = app_ofu_crc32_update(app_ofu_delta_cb.check_crc32, data,
+                length);
+    }
+
+    if (app_ofu_delta_cb.check_offset < app_ofu_delta_cb.base_len)
+    {
+        return;
+    }
+
+    if ((app_ofu_delta_cb.check_crc32 ^ 0xFFFFFFFF) != app_ofu_delta_cb.base_crc32)
+    {
+        APP_TRACE_ERR("Base Image CRC32:0x%x expected:0x%x\n",
+                app_ofu_delta_cb.check_crc32 ^ 0xFFFFFFFF, app_ofu_delta_cb.base_crc32);
+        app_ofu_delta_cb.check_state = APP_OFU_DELTA_CHECK_FAILED;
+        return;
+    }
+
+    app_ofu_delta_cb.check_state = APP_OFU_DELTA_CHECK_OK;
+}
+
+/*
+ * app_ofu_delta_data_handler
+ * The operations may be split in several Data packets
+ */
+uint8_t app_ofu_delta_data_handler(uint8_t *p_data, uint16_t length,
+        app_ofu_delta_write_t *p_write)
+{
+    uint8_t status;
+    uint16_t bytes_to_copy;
+
+    /* The Base Image check (in progress) failed: the Client must fallback to a regular Download */
+    if (app_ofu_delta_cb.check_state == APP_OFU_DELTA_CHECK_FAILED)
+    {
+        APP_TRACE_ERR("Patch does not apply to the Active Partition\n");
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    while (length)
+    {
+        switch(app_ofu_delta_cb.state)
+        {
+        case APP_OFU_DELTA_STATE_OP:
+            STREAM_TO_UINT8(app_ofu_delta_cb.op, p_data);
+            length--;
+            app_ofu_delta_cb.param_len = 0;
+            if (app_ofu_delta_cb.op == APP_OFU_DELTA_OP_COPY)
+            {
+                app_ofu_delta_cb.param_needed = sizeof(uint32_t) + sizeof(uint16_t);
+            }
+            else if (app_ofu_delta_cb.op == APP_OFU_DELTA_OP_LITERAL)
+            {
+                app_ofu_delta_cb.param_needed = sizeof(uint16_t);
+            }
+            else
+            {
+                APP_TRACE_ERR("Unknown op:%d\n", app_ofu_delta_cb.op);
+                return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+            }
+            app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_PARAM;
+            break;
+
+        case APP_OFU_DELTA_STATE_PARAM:
+            bytes_to_copy = app_ofu_delta_cb.param_needed - app_ofu_delta_cb.param_len;
+            if (bytes_to_copy > length)
+            {
+                bytes_to_copy = length;
+            }
+            memcpy(&app_ofu_delta_cb.param[app_ofu_delta_cb.param_len], p_data, bytes_to_copy);
+            app_ofu_delta_cb.param_len += bytes_to_copy;
+            p_data += bytes_to_copy;
+            length -= bytes_to_copy;
+
+            if (app_ofu_delta_cb.param_len == app_ofu_delta_cb.param_needed)
+            {
+                status = app_ofu_delta_param_handler(p_write);
+                if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+                {
+                    return status;
+                }
+            }
+            break;
+
+        case APP_OFU_DELTA_STATE_LITERAL:
+            bytes_to_copy = app_ofu_delta_cb.literal_len;
+            if (bytes_to_copy > length)
+            {
+                bytes_to_copy = length;
+            }
+            status = p_write(p_data, bytes_to_copy);
+            if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+            {
+                return status;
+            }
+            app_ofu_delta_cb.literal_len -= bytes_to_copy;
+            p_data += bytes_to_copy;
+            length -= bytes_to_copy;
+
+            if (app_ofu_delta_cb.literal_len == 0)
+            {
+                app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_OP;
+            }
+            break;
+
+        default:
+            return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
+        }
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_delta_param_handler
+ * Execute an operation once all its parameters are received
+ */
+static uint8_t app_ofu_delta_param_handler(app_ofu_delta_write_t *p_write)
+{
+    uint8_t *p = app_ofu_delta_cb.param;
+    uint32_t offset;
+    uint16_t length;
+
+    if (app_ofu_delta_cb.op == APP_OFU_DELTA_OP_COPY)
+    {
+        STREAM_TO_UINT32(offset, p);
+        STREAM_TO_UINT16(length, p);
+        app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_OP;
+        return app_ofu_delta_copy(offset, length, p_write);
+    }
+
+    /* Literal */
+    STREAM_TO_UINT16(length, p);
+    app_ofu_delta_cb.literal_len = length;
+    if (length == 0)
+    {
+        app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_OP;
+    }
+    else
+    {
+        app_ofu_delta_cb.state = APP_OFU_DELTA_STATE_LITERAL;
+    }
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_delta_copy
+ * Copy a part of the Base Image in the new Image
+ */
+static uint8_t app_ofu_delta_copy(uint32_t offset, uint16_t length,
+        app_ofu_delta_write_t *p_write)
+{
+    uint8_t data[APP_OFU_DELTA_READ_SIZE];
+    uint16_t bytes_to_copy;
+    uint8_t status;
+
+    if ((length > APP_OFU_DELTA_COPY_MAX) ||
+        (offset > app_ofu_delta_cb.base_len) ||
+        (length > (app_ofu_delta_cb.base_len - offset)))
+    {
+        APP_TRACE_ERR("Bad Copy offset:%d length:%d\n", offset, length);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    while (length)
+    {
+        bytes_to_copy = length;
+        if (bytes_to_copy > sizeof(data))
+        {
+            bytes_to_copy = sizeof(data);
+        }
+        if (app_ofu_delta_base_read(offset, data, bytes_to_copy) != WICED_BT_SUCCESS)
+        {
+            return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+        }
+        status = p_write(data, bytes_to_copy);
+        if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+        {
+            return status;
+        }
+        offset += bytes_to_copy;
+        length -= bytes_to_copy;
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_delta_base_read
+ * Read the Base Image (Active Partition) at any offset.
+ * The NVRAM Read must be 4 bytes aligned and a multiple of 4 bytes
+ */
+static wiced_result_t app_ofu_delta_base_read(uint32_t offset, uint8_t *p_data,
+        uint16_t length)
+{
+    uint8_t data[APP_OFU_DELTA_READ_SIZE + sizeof(uint32_t)];
+    uint32_t aligned_offset;
+    uint32_t bytes_to_read;
+    uint32_t read_length;
+    uint16_t bytes_to_copy;
+
+    while (length)
+    {
+        aligned_offset = offset & ~0x3;
+        bytes_to_copy = length;
+        if (bytes_to_copy > APP_OFU_DELTA_READ_SIZE)
+        {
+            bytes_to_copy = APP_OFU_DELTA_READ_SIZE;
+        }
+        bytes_to_read = ((offset - aligned_offset) + bytes_to_copy + 3) & ~0x3;
+
+        read_length = wiced_firmware_upgrade_retrieve_from_active_ds(aligned_offset, data,
+                bytes_to_read);
+        if (read_length != bytes_to_read)
+        {
+            APP_TRACE_ERR("wiced_firmware_upgrade_retrieve_from_active_ds failed\n");
+            return WICED_BT_ERROR;
+        }
+        memcpy(p_data, &data[offset - aligned_offset], bytes_to_copy);
+
+        p_data += bytes_to_copy;
+        offset += bytes_to_copy;
+        length -= bytes_to_copy;
+    }
+
+    return WICED_BT_SUCCESS;
+}
+#endif /* OTA_FW_UPGRADE */
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *
+ *  OFU (OTA FW Upgrade) Delta (differential) image implementation.
+ */
+
+#pragma once
+
+#include "wiced.h"
+
+/*
+ * Definitions
+ */
+/*
+ * Patch stream format (Little Endian). Sequence of operations:
+ * COPY:    APP_OFU_DELTA_OP_COPY, Base Offset (4 bytes), Length (2 bytes)
+ *          Copy Length bytes of the Base Image (Length must not exceed APP_OFU_DELTA_COPY_MAX)
+ * LITERAL: APP_OFU_DELTA_OP_LITERAL, Length (2 bytes), Data (Length bytes)
+ */
+#define APP_OFU_DELTA_OP_COPY               0x01
+#define APP_OFU_DELTA_OP_LITERAL            0x02
+
+#define APP_OFU_DELTA_COPY_MAX              4096
+
+/* Callback function used to write the reconstructed Image (returns an OTA Upgrade status) */
+typedef uint8_t (app_ofu_delta_write_t)(uint8_t *p_data, uint32_t length);
+
+/*
+ * app_ofu_delta_start
+ * Initialize the Patch decoder and start the check of the Base Image (CRC32 computed in
+ * background)
+ */
+wiced_result_t app_ofu_delta_start(uint32_t base_len, uint32_t base_crc32);
+
+/*
+ * app_ofu_delta_stop
+ * Stop the check of the Base Image (download aborted)
+ */
+void app_ofu_delta_stop(void);
+
+/*
+ * app_ofu_delta_base_check
+ * Returns the result of the Base Image check: WICED_OTA_UPGRADE_STATUS_OK (the Patch applies),
+ * WICED_OTA_UPGRADE_STATUS_CONTINUE (check in progress) or an error status.
+ * If complete is set, the check is completed first.
+ */
+uint8_t app_ofu_delta_base_check(wiced_bool_t complete);
+
+/*
+ * app_ofu_delta_data_handler
+ * Decode a part of the Patch stream. The reconstructed Image is written with p_write.
+ * Returns WICED_OTA_UPGRADE_STATUS_CONTINUE or an error status
+ */
+uint8_t app_ofu_delta_data_handler(uint8_t *p_data, uint16_t length,
+        app_ofu_delta_write_t *p_write);
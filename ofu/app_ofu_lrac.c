@@ -46,9 +46,12 @@
 /*
  * Definitions
  */
+#define APP_OFU_LRAC_FANOUT_MTU             512
+
 typedef struct
 {
     app_ofu_callback_t *p_callback;
+    wiced_bool_t fanout;            /* Image received from the phone forwarded to the peer */
 } app_ofu_lrac_cb_t;
 
 /*
@@ -57,15 +60,16 @@ typedef struct
 static app_ofu_lrac_cb_t app_ofu_lrac_cb;
 
 #ifdef APP_OFU_DEBUG
-static const char *app_ofu_type[4] =
+static const char *app_ofu_type[5] =
 {
         "Unknown",
         "CMD",
         "DATA",
         "EVENT",
+        "DATA_WINDOW",
 };
 
-static const char *app_ofu_type_cmd[8] =
+static const char *app_ofu_type_cmd[12] =
 {
         "Unknown",
         "Prepare",
@@ -75,6 +79,10 @@ static const char *app_ofu_type_cmd[8] =
         "GetSts(Unused)",
         "ClrSts(Unused)",
         "Abort",
+        "Resume",
+        "DeltaDownload",
+        "CompDownload",
+        "ImageInfo",
 };
 #endif /* APP_OFU_DEBUG */
 /*
@@ -84,6 +92,8 @@ static wiced_result_t app_ofu_lrac_send(uint8_t header, uint8_t *p_data, uint16_
 static void app_ofu_lrac_server_callback(app_ofu_event_t event);
 static void app_ofu_lrac_client_callback(app_ofu_event_t event);
 static void app_ofu_lrac_app_callback(app_ofu_event_t event, app_ofu_transport_t transport);
+static void app_ofu_lrac_relay_callback(app_ofu_srv_relay_event_t event, uint32_t offset,
+        uint32_t length);
 #ifdef APP_OFU_DEBUG
 static void app_ofu_lrac_dbg_trace(uint8_t header, uint8_t *p_data, uint16_t length);
 #endif
@@ -113,6 +123,11 @@ void app_ofu_lrac_rx_handler(uint8_t *p_data, uint16_t length)
     uint8_t type;
     uint16_t payload_len;
     uint8_t server_status;
+    uint32_t offset;
+    uint32_t next_offset;
+    uint32_t crc32;
+    uint8_t rsp_data[2 * sizeof(uint32_t)];
+    uint8_t *p_rsp = rsp_data;
 
     if (length == 0)
     {
@@ -133,7 +148,8 @@ void app_ofu_lrac_rx_handler(uint8_t *p_data, uint16_t length)
 
     /* If this is either a Command or Data */
     if ((type == APP_OFU_CONTROL_COMMAND) ||
-        (type == APP_OFU_DATA))
+        (type == APP_OFU_DATA) ||
+        (type == APP_OFU_DATA_WINDOW))
     {
         /* Extract Payload Length */
         STREAM_TO_UINT16(payload_len, p_data);
@@ -149,19 +165,52 @@ void app_ofu_lrac_rx_handler(uint8_t *p_data, uint16_t length)
         case APP_OFU_CONTROL_COMMAND:
             server_status = app_ofu_srv_command_handler(header, p_data, length,
                     app_ofu_lrac_server_callback);
+            if (server_status != WICED_OTA_UPGRADE_STATUS_OK)
+            {
+                break;
+            }
+            /* Tell the Client that Windowed transfer (and Resume) is supported */
+            if (APP_OFU_HDR_CMD_GET(header) == WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD)
+            {
+                UINT8_TO_STREAM(p_rsp, APP_OFU_WINDOW_SIZE);
+                UINT8_TO_STREAM(p_rsp, APP_OFU_FEATURES);
+            }
+            /* Tell the Client where to Resume the download */
+            else if (APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_RESUME)
+            {
+                app_ofu_srv_resume_info_get(&offset, &crc32);
+                UINT32_TO_STREAM(p_rsp, offset);
+                UINT32_TO_STREAM(p_rsp, crc32);
+            }
             break;
 
         case APP_OFU_DATA:
             server_status = app_ofu_srv_data_handler(p_data, length, app_ofu_lrac_server_callback);
             break;
+
+        case APP_OFU_DATA_WINDOW:
+            if (length < sizeof(uint32_t))
+            {
+                APP_TRACE_ERR("wrong length:%d\n", length);
+                return;
+            }
+            STREAM_TO_UINT32(offset, p_data);
+            length -= sizeof(uint32_t);
+            server_status = app_ofu_srv_data_window_handler(offset, p_data, length,
+                    app_ofu_lrac_server_callback, &next_offset);
+            /* Cumulative Acknowledgement */
+            UINT32_TO_STREAM(p_rsp, next_offset);
+            break;
         }
 
         /* Send Response to Peer device in every case */
-        app_ofu_lrac_send(APP_OFU_HDR_SET(APP_OFU_EVENT, server_status), NULL, 0);
+        app_ofu_lrac_send(APP_OFU_HDR_SET(APP_OFU_EVENT, server_status), rsp_data,
+                p_rsp - rsp_data);
     }
     else if (type == APP_OFU_EVENT)
     {
-        app_ofu_clt_rx_handler(header, app_ofu_lrac_client_callback, app_ofu_lrac_send);
+        app_ofu_clt_rx_handler(header, p_data, length, app_ofu_lrac_client_callback,
+                app_ofu_lrac_send);
     }
     else
     {
@@ -184,6 +233,15 @@ static void app_ofu_lrac_server_callback(app_ofu_event_t event)
  */
 static void app_ofu_lrac_client_callback(app_ofu_event_t event)
 {
+    /* Fan-out done. The local device can Reboot (on the new FW) */
+    if ((app_ofu_lrac_cb.fanout) &&
+        ((event == APP_OFU_EVENT_COMPLETED) || (event == APP_OFU_EVENT_ABORTED)))
+    {
+        APP_OFU_TRACE_DBG("Fan-out %s\n", event == APP_OFU_EVENT_COMPLETED ? "Completed" : "Aborted");
+        app_ofu_lrac_cb.fanout = WICED_FALSE;
+        app_ofu_srv_reset_hold(WICED_FALSE);
+    }
+
     app_ofu_lrac_app_callback(event, APP_OFU_TRANSPORT_LRAC_CLIENT);
 }
 
@@ -249,6 +307,7 @@ static wiced_result_t app_ofu_lrac_send(uint8_t header, uint8_t *p_data, uint16_
     {
     case APP_OFU_CONTROL_COMMAND:
     case APP_OFU_DATA:
+    case APP_OFU_DATA_WINDOW:
         /* Write the Payload length */
         UINT16_TO_STREAM(p, length);
         if (length && p_data)
@@ -259,7 +318,12 @@ static wiced_result_t app_ofu_lrac_send(uint8_t header, uint8_t *p_data, uint16_
         break;
 
     case APP_OFU_EVENT:
-        /* No Payload length for Event packets */
+        /* No Payload length for Event packets (optional parameters follow the header) */
+        if (length && p_data)
+        {
+            memcpy(p, p_data, length);
+            p += length;
+        }
         break;
 
     default:
@@ -284,6 +348,71 @@ wiced_result_t app_ofu_lrac_start(uint16_t mtu)
     return app_ofu_clt_start(mtu, app_ofu_lrac_client_callback, app_ofu_lrac_send);
 }
 
+/*
+ * app_ofu_lrac_fanout_prepare
+ * This function is called when the phone starts OFU (over SPP or LE). If the peer LRAC Device
+ * is connected, the Image is forwarded to it while it is received (Fan-out).
+ */
+void app_ofu_lrac_fanout_prepare(void)
+{
+    if (app_lrac_is_connected() == WICED_FALSE)
+    {
+        return;
+    }
+
+    app_ofu_srv_relay_register(app_ofu_lrac_relay_callback);
+}
+
+/*
+ * app_ofu_lrac_relay_callback
+ * This function handles the local OFU Server events during a Fan-out
+ */
+static void app_ofu_lrac_relay_callback(app_ofu_srv_relay_event_t event, uint32_t offset,
+        uint32_t length)
+{
+    wiced_result_t status;
+
+    switch(event)
+    {
+    case APP_OFU_SRV_RELAY_COMMITTED:
+        /* Start the Fan-out once the Image length is known (first block committed) */
+        if (app_ofu_lrac_cb.fanout == WICED_FALSE)
+        {
+            status = app_ofu_clt_fanout_start(APP_OFU_LRAC_FANOUT_MTU, length,
+                    app_ofu_lrac_client_callback, app_ofu_lrac_send);
+            if (status != WICED_BT_SUCCESS)
+            {
+                /* The peer will be upgraded once the local device Reboots */
+                APP_TRACE_ERR("app_ofu_clt_fanout_start failed status:%d\n", status);
+                app_ofu_srv_relay_register(NULL);
+                return;
+            }
+            app_ofu_lrac_cb.fanout = WICED_TRUE;
+            /* Do not Reboot before the peer is upgraded */
+            app_ofu_srv_reset_hold(WICED_TRUE);
+        }
+        app_ofu_clt_fanout_data(offset);
+        break;
+
+    case APP_OFU_SRV_RELAY_VERIFIED:
+        if (app_ofu_lrac_cb.fanout)
+        {
+            app_ofu_clt_fanout_verified();
+        }
+        break;
+
+    case APP_OFU_SRV_RELAY_ABORTED:
+        if (app_ofu_lrac_cb.fanout)
+        {
+            app_ofu_clt_fanout_abort();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
 #ifdef APP_OFU_DEBUG
 /*
  * app_ofu_lrac_dbg_trace
@@ -298,7 +427,7 @@ static void app_ofu_lrac_dbg_trace(uint8_t header, uint8_t *p_data, uint16_t len
     /* Get Packet type from Header */
     type = APP_OFU_HDR_TYPE_GET(header);
 
-    if (type > APP_OFU_EVENT)
+    if (type > APP_OFU_DATA_WINDOW)
         p_type = app_ofu_type[0];
     else
         p_type = app_ofu_type[type];
@@ -306,7 +435,7 @@ static void app_ofu_lrac_dbg_trace(uint8_t header, uint8_t *p_data, uint16_t len
     if (type == APP_OFU_CONTROL_COMMAND)
     {
         param = APP_OFU_HDR_CMD_GET(header);
-        if (param > WICED_OTA_UPGRADE_COMMAND_ABORT)
+        if (param > APP_OFU_COMMAND_IMAGE_INFO)
             p_param = app_ofu_type_cmd[0];
         else
             p_param = app_ofu_type_cmd[param];
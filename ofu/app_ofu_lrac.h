@@ -51,3 +51,9 @@ wiced_result_t app_ofu_lrac_start(uint16_t mtu);
  * app_ofu_lrac_rx_handler
  */
 void app_ofu_lrac_rx_handler(uint8_t *p_data, uint16_t length);
+
+/*
+ * app_ofu_lrac_fanout_prepare
+ * Forward the Image received from the phone to the peer LRAC Device (if connected)
+ */
+void app_ofu_lrac_fanout_prepare(void);
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *
+ *  OFU (OTA FW Upgrade) Compressed image implementation.
+ *  Small window LZSS decompressor. The compressed stream is received, in sequence, in the OFU
+ *  Data packets and the decompressed Image is written through a callback function.
+ */
+#ifdef OTA_FW_UPGRADE
+#include <string.h>
+#include "app_ofu.h"
+#include "app_ofu_lz.h"
+#include "app_trace.h"
+#include <wiced_bt_ota_firmware_upgrade.h>
+
+/*
+ * Definitions
+ */
+#define APP_OFU_LZ_WINDOW_MASK              (APP_OFU_LZ_WINDOW_SIZE - 1)
+
+/* Decompressed data is written when the Window may be overwritten by the next Match */
+#define APP_OFU_LZ_FLUSH_THRESHOLD          (APP_OFU_LZ_WINDOW_SIZE - APP_OFU_LZ_MATCH_MAX)
+
+typedef struct
+{
+    uint32_t position;                      /* Number of bytes decompressed */
+    uint32_t flushed;                       /* Number of bytes written */
+    uint8_t flags;
+    uint8_t nb_flags;                       /* Number of Flags remaining in the group */
+    wiced_bool_t match_pending;             /* First byte of a Match received */
+    uint8_t match_byte;
+    uint8_t window[APP_OFU_LZ_WINDOW_SIZE];
+} app_ofu_lz_cb_t;
+
+/*
+ * Global variables
+ */
+static app_ofu_lz_cb_t app_ofu_lz_cb;
+
+/*
+ * Local functions
+ */
+static uint8_t app_ofu_lz_match(uint16_t token);
+static uint8_t app_ofu_lz_flush(app_ofu_lz_write_t *p_write);
+
+/*
+ * app_ofu_lz_start
+ */
+void app_ofu_lz_start(void)
+{
+    app_ofu_lz_cb.position = 0;
+    app_ofu_lz_cb.flushed = 0;
+    app_ofu_lz_cb.nb_flags = 0;
+    app_ofu_lz_cb.match_pending = WICED_FALSE;
+}
+
+/*
+ * app_ofu_lz_data_handler
+ * The groups and the Matches may be split in several Data packets
+ */
+uint8_t app_ofu_lz_data_handler(uint8_t *p_data, uint16_t length, app_ofu_lz_write_t *p_write)
+{
+    uint8_t status;
+    uint8_t byte;
+
+    while (length)
+    {
+        byte = *p_data++;
+        length--;
+
+        /* Flags byte */
+        if (app_ofu_lz_cb.nb_flags == 0)
+        {
+            app_ofu_lz_cb.flags = byte;
+            app_ofu_lz_cb.nb_flags = 8;
+            continue;
+        }
+
+        if (app_ofu_lz_cb.flags & 0x01)
+        {
+            /* Literal */
+            app_ofu_lz_cb.window[app_ofu_lz_cb.position & APP_OFU_LZ_WINDOW_MASK] = byte;
+            app_ofu_lz_cb.position++;
+        }
+        else if (app_ofu_lz_cb.match_pending == WICED_FALSE)
+        {
+            /* First byte of a Match */
+            app_ofu_lz_cb.match_byte = byte;
+            app_ofu_lz_cb.match_pending = WICED_TRUE;
+            continue;
+        }
+        else
+        {
+            app_ofu_lz_cb.match_pending = WICED_FALSE;
+            status = app_ofu_lz_match(app_ofu_lz_cb.match_byte | ((uint16_t)byte << 8));
+            if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+            {
+                return status;
+            }
+        }
+
+        app_ofu_lz_cb.flags >>= 1;
+        app_ofu_lz_cb.nb_flags--;
+
+        if ((app_ofu_lz_cb.position - app_ofu_lz_cb.flushed) >= APP_OFU_LZ_FLUSH_THRESHOLD)
+        {
+            status = app_ofu_lz_flush(p_write);
+            if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+            {
+                return status;
+            }
+        }
+    }
+
+    /* Write the Data decompressed from this packet */
+    return app_ofu_lz_flush(p_write);
+}
+
+/*
+ * app_ofu_lz_match
+ * Copy a Match from the Window (the source and destination may overlap)
+ */
+static uint8_t app_ofu_lz_match(uint16_t token)
+{
+    uint32_t offset;
+    uint32_t length;
+
+    offset = (token & ((1 << APP_OFU_LZ_OFFSET_BITS) - 1)) + 1;
+    length = (token >> APP_OFU_LZ_OFFSET_BITS) + APP_OFU_LZ_MATCH_MIN;
+
+    if (offset > app_ofu_lz_cb.position)
+    {
+        APP_TRACE_ERR("Bad Match offset:%d position:%d\n", offset, app_ofu_lz_cb.position);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    while (length--)
+    {
+        app_ofu_lz_cb.window[app_ofu_lz_cb.position & APP_OFU_LZ_WINDOW_MASK] =
+                app_ofu_lz_cb.window[(app_ofu_lz_cb.position - offset) & APP_OFU_LZ_WINDOW_MASK];
+        app_ofu_lz_cb.position++;
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_lz_flush
+ * Write the decompressed Data not yet written (which may wrap around the end of the Window)
+ */
+static uint8_t app_ofu_lz_flush(app_ofu_lz_write_t *p_write)
+{
+    uint32_t start;
+    uint32_t length;
+    uint8_t status;
+
+    while (app_ofu_lz_cb.flushed != app_ofu_lz_cb.position)
+    {
+        start = app_ofu_lz_cb.flushed & APP_OFU_LZ_WINDOW_MASK;
+        length = app_ofu_lz_cb.position - app_ofu_lz_cb.flushed;
+        if (length > (APP_OFU_LZ_WINDOW_SIZE - start))
+        {
+            length = APP_OFU_LZ_WINDOW_SIZE - start;
+        }
+        status = p_write(&app_ofu_lz_cb.window[start], length);
+        if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+        {
+            return status;
+        }
+        app_ofu_lz_cb.flushed += length;
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+#endif /* OTA_FW_UPGRADE */
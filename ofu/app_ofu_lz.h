@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016-2024, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ *
+ *
+ *  OFU (OTA FW Upgrade) Compressed image implementation.
+ */
+
+#pragma once
+
+#include "wiced.h"
+
+/*
+ * Definitions
+ */
+/*
+ * Compressed stream format (LZSS). Sequence of groups made of one Flags byte followed by up to
+ * 8 items. Each Flag (LSB first) gives the type of the corresponding item:
+ * 1: Literal. One byte copied as is in the Image.
+ * 0: Match. Two bytes (Little Endian): Offset - 1 (bits 0-11) and Length - 3 (bits 12-15).
+ *    Copy Length bytes located Offset bytes before the current position in the Image.
+ * A 4 KB Window (instead of 1 KB with 6 bits Length) saves 45% instead of 37% of an ARM .text
+ * section (ofu-compress.py -b). It is allocated in RAM next to the OFU Server Staging buffers.
+ */
+#define APP_OFU_LZ_OFFSET_BITS              12
+#define APP_OFU_LZ_LENGTH_BITS              4
+#define APP_OFU_LZ_MATCH_MIN                3
+#define APP_OFU_LZ_MATCH_MAX                (APP_OFU_LZ_MATCH_MIN + (1 << APP_OFU_LZ_LENGTH_BITS) - 1)
+
+/* The Window contains the last bytes decompressed (it is the only buffer used) */
+#define APP_OFU_LZ_WINDOW_SIZE              (1 << APP_OFU_LZ_OFFSET_BITS)
+
+/* Callback function used to write the decompressed Image (returns an OTA Upgrade status) */
+typedef uint8_t (app_ofu_lz_write_t)(uint8_t *p_data, uint32_t length);
+
+/*
+ * app_ofu_lz_start
+ * Initialize the decompressor
+ */
+void app_ofu_lz_start(void);
+
+/*
+ * app_ofu_lz_data_handler
+ * Decompress a part of the compressed stream. The Image is written with p_write.
+ * Returns WICED_OTA_UPGRADE_STATUS_CONTINUE or an error status
+ */
+uint8_t app_ofu_lz_data_handler(uint8_t *p_data, uint16_t length, app_ofu_lz_write_t *p_write);
@@ -41,6 +41,7 @@ typedef uint8_t BD_ADDR[BD_ADDR_LEN];
 #include "app_ofu.h"
 #include "app_ofu_spp.h"
 #include "app_ofu_srv.h"
+#include "app_ofu_lrac.h"
 #include "app_trace.h"
 #include <wiced_bt_ota_firmware_upgrade.h>
 
@@ -65,7 +66,8 @@ static void app_ofu_spp_app_callback(app_ofu_event_t event);
 static void app_ofu_spp_connection_up_callback(uint16_t handle, uint8_t *bda);
 static void app_ofu_spp_connection_down_callback(uint16_t handle);
 static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_data, uint32_t length);
-static wiced_result_t app_ofu_spp_send_status(uint16_t handle, uint8_t evt_status);
+static wiced_result_t app_ofu_spp_send_status(uint16_t handle, uint8_t evt_status,
+        uint8_t *p_data, uint16_t length);
 
 /*
  * Global variables
@@ -192,6 +194,10 @@ static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_dat
     uint8_t srv_status;
     uint8_t header;
     uint16_t payload_len;
+    uint32_t offset;
+    uint32_t crc32;
+    uint8_t rsp_data[2 * sizeof(uint32_t)];
+    uint8_t *p_rsp = rsp_data;
 
     /* Extract Packet Header */
     STREAM_TO_UINT8(header, p_data);
@@ -205,7 +211,7 @@ static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_dat
         APP_TRACE_ERR("wrong payload_len:%d length:%d\n", payload_len, length);
 
         /* Send response to SPP Client */
-        app_ofu_spp_send_status(handle, WICED_OTA_UPGRADE_STATUS_BAD_PARAM);
+        app_ofu_spp_send_status(handle, WICED_OTA_UPGRADE_STATUS_BAD_PARAM, NULL, 0);
 
         return WICED_TRUE;
     }
@@ -217,6 +223,20 @@ static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_dat
     {
     case APP_OFU_CONTROL_COMMAND:
         srv_status = app_ofu_srv_command_handler(header, p_data, length, app_ofu_spp_app_callback);
+        /* Forward the Image to the peer LRAC Device while it is received */
+        if ((APP_OFU_HDR_CMD_GET(header) == WICED_OTA_UPGRADE_COMMAND_PREPARE_DOWNLOAD) &&
+            (srv_status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            app_ofu_lrac_fanout_prepare();
+        }
+        /* Tell the Client where to Resume the download */
+        if ((APP_OFU_HDR_CMD_GET(header) == APP_OFU_COMMAND_RESUME) &&
+            (srv_status == WICED_OTA_UPGRADE_STATUS_OK))
+        {
+            app_ofu_srv_resume_info_get(&offset, &crc32);
+            UINT32_TO_STREAM(p_rsp, offset);
+            UINT32_TO_STREAM(p_rsp, crc32);
+        }
         break;
 
     case APP_OFU_DATA:
@@ -229,7 +249,7 @@ static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_dat
     }
 
     /* Send response to SPP Client */
-    app_ofu_spp_send_status(handle, srv_status);
+    app_ofu_spp_send_status(handle, srv_status, rsp_data, p_rsp - rsp_data);
 
 
     return WICED_TRUE;
@@ -238,9 +258,10 @@ static wiced_bool_t app_ofu_spp_rx_data_callback(uint16_t handle, uint8_t *p_dat
 /*
  * app_ofu_spp_send_status
  */
-static wiced_result_t app_ofu_spp_send_status(uint16_t handle, uint8_t evt_status)
+static wiced_result_t app_ofu_spp_send_status(uint16_t handle, uint8_t evt_status,
+        uint8_t *p_data, uint16_t length)
 {
-    uint8_t tx_data[3];
+    uint8_t tx_data[3 + 2 * sizeof(uint32_t)];
     uint8_t *p;
     wiced_bool_t rv;
 
@@ -258,7 +279,17 @@ static wiced_result_t app_ofu_spp_send_status(uint16_t handle, uint8_t evt_statu
     UINT8_TO_STREAM(p, APP_OFU_HDR_SET(APP_OFU_EVENT, evt_status));
 
     /* Write the Event Payload Length */
-    UINT16_TO_STREAM(p, 0);
+    if (length > (sizeof(tx_data) - 3))
+    {
+        length = sizeof(tx_data) - 3;
+    }
+    UINT16_TO_STREAM(p, length);
+
+    /* Write the Event Payload */
+    if (length && p_data)
+    {
+        ARRAY_TO_STREAM(p, p_data, length);
+    }
 
     /* Send the Event message over SPP */
     rv = wiced_bt_spp_send_session_data(handle, tx_data, p - tx_data);
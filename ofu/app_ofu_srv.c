@@ -36,16 +36,37 @@
 #include <string.h>
 #include "app_ofu.h"
 #include "app_ofu_srv.h"
+#include "app_ofu_crc32.h"
+#include "app_ofu_delta.h"
+#include "app_ofu_lz.h"
 #include "p_256_ecc_pp.h"
 #include "sha256.h"
 #include "app_trace.h"
+#include "app_nvram.h"
 #include <ota_fw_upgrade.h>
 #include <wiced_firmware_upgrade.h>
 #include <wiced_timer.h>
+#include "clock_timer.h"
 
 /*
  * Definitions
  */
+/*
+ * Number of Staging buffers (1 or 2). With 2 buffers, a full buffer is committed (written in
+ * Flash) once the current application event is handled while the next Data is received in the
+ * other buffer. With 1 buffer, a full buffer is committed before the next Data is received.
+ * The second buffer costs OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT bytes of RAM (see ofu_bench).
+ */
+#ifndef APP_OFU_SRV_STAGING_NB
+#define APP_OFU_SRV_STAGING_NB              2
+#endif
+
+/* Header of a Secure Image: DS prefix, Product ID, Major, Minor and length */
+#define APP_OFU_SRV_IMAGE_HEADER_LEN        (DS_IMAGE_PREFIX_LEN + 2 + 1 + 1 + 4)
+
+/* Maximum time (seconds) the Reboot can be delayed (once the new Image is verified) */
+#define APP_OFU_SRV_RESET_HOLD_MAX          60
+
 typedef enum
 {
     APP_OFU_SRV_STATE_IDLE = 0,
@@ -55,18 +76,48 @@ typedef enum
     APP_OFU_SRV_STATE_ABORTED,
 } app_ota_srv_state_t;
 
+typedef enum
+{
+    APP_OFU_SRV_IMAGE_RAW = 0,              /* Data packets contain the Image */
+    APP_OFU_SRV_IMAGE_DELTA,                /* Data packets contain a Patch stream */
+    APP_OFU_SRV_IMAGE_COMPRESSED,           /* Data packets contain a compressed stream */
+} app_ofu_srv_image_format_t;
+
+/* Image Info (pre-flight validation) */
+typedef struct
+{
+    wiced_bool_t    valid;                  /* Image Info command received and accepted */
+    uint32_t        len;
+    uint32_t        crc32;
+} app_ofu_srv_image_info_t;
+
 typedef struct
 {
     app_ota_srv_state_t state;
     uint16_t        current_offset;          /* Offset in the image to store the data */
     int32_t         current_block_offset;
     int32_t         total_offset;
+    uint32_t        download_len;           /* Image length received in Download/Resume */
+    uint32_t        committed_crc32;        /* Running CRC32 of the committed data */
+    app_ofu_srv_image_format_t image_format;
+    app_ofu_srv_image_info_t image_info;
+    app_ofu_srv_app_callback_t *p_decoder_app_callback;
 #ifdef APP_OFU_DEBUG
-    uint32_t        recv_crc32;
     int             nb_rx_data_packet;
+    int             nb_rx_data_dropped;
 #endif
     wiced_timer_t   reset_timer;
-    uint8_t         read_buffer[OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT];
+    uint8_t         fill_buffer;            /* Staging buffer being filled */
+    wiced_bool_t    commit_pending;         /* The other Staging buffer waits to be committed */
+    wiced_bool_t    commit_scheduled;
+    uint32_t        commit_len;
+    uint64_t        commit_request_time;    /* Time (us) the pending buffer has been filled */
+    app_ofu_srv_app_callback_t *p_commit_app_callback;
+    app_ofu_srv_stats_t stats;
+    app_ofu_srv_relay_callback_t *p_relay_callback;
+    wiced_bool_t    reset_hold;
+    uint8_t         reset_hold_duration;
+    uint8_t         read_buffer[APP_OFU_SRV_STAGING_NB][OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT];
 } app_ofu_srv_cb_t;
 
 /*
@@ -74,22 +125,34 @@ typedef struct
  */
 static app_ofu_srv_cb_t app_ofu_srv_cb;
 
-/*
- * External definitions
- */
-#ifdef APP_OFU_DEBUG
-uint32_t crc32_Update(uint32_t crc, uint8_t *p_buf, uint16_t len);
-#endif
-
 /*
  * Local functions
  */
 static int32_t app_ofu_srv_verify_secure(int32_t total_len);
 static void app_ofu_srv_abort(app_ofu_srv_app_callback_t *p_callback);
 static void app_ofu_srv_reset_timeout(uint32_t param);
-#ifdef APP_OFU_DEBUG
-static uint32_t app_ofu_srv_crc32_update(uint32_t crc32, uint8_t *p_data, uint16_t length);
+static uint8_t app_ofu_srv_download_start(uint8_t command, uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_app_callback);
+static void app_ofu_srv_checkpoint_save(void);
+static uint32_t app_ofu_srv_image_crc32_get(void);
+static uint8_t app_ofu_srv_image_info(uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_app_callback);
+static uint8_t app_ofu_srv_image_check(uint16_t product_id, uint8_t major, uint8_t minor);
+#ifndef CYW20706A2
+static uint8_t app_ofu_srv_image_header_check(uint8_t *p_header, uint32_t *p_total_len);
 #endif
+static uint8_t app_ofu_srv_image_write(uint8_t *p_data, uint32_t length,
+        app_ofu_srv_app_callback_t *p_app_callback);
+static uint8_t app_ofu_srv_decoder_write(uint8_t *p_data, uint32_t length);
+static uint32_t app_ofu_srv_received_offset(void);
+static uint8_t app_ofu_srv_commit_request(app_ofu_srv_app_callback_t *p_app_callback);
+static uint8_t app_ofu_srv_commit_stall(void);
+static int app_ofu_srv_commit_serialized(void *p_data);
+static uint8_t app_ofu_srv_commit_flush(void);
+static uint8_t app_ofu_srv_commit(void);
+static wiced_bool_t app_ofu_srv_commit_verify(uint8_t *p_buffer, uint32_t offset,
+        uint32_t length);
+static uint32_t app_ofu_srv_crc32_update(uint32_t crc32, uint8_t *p_data, uint16_t length);
 /*
  * app_ofu_srv_init
  */
@@ -134,8 +197,12 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
         APP_OFU_TRACE_DBG("Cmd: PrepareDownload\n");
 #ifdef APP_OFU_DEBUG
         app_ofu_srv_cb.nb_rx_data_packet = 0;
+        app_ofu_srv_cb.nb_rx_data_dropped = 0;
 #endif
         app_ofu_srv_cb.state = APP_OFU_SRV_STATE_READY_FOR_DOWNLOAD;
+        app_ofu_srv_cb.image_info.valid = WICED_FALSE;
+        /* The transport registers a Relay (if needed) once the command is handled */
+        app_ofu_srv_cb.p_relay_callback = NULL;
         /* Tell the app that OFU is Started */
         p_app_callback(APP_OFU_EVENT_STARTED);
         return WICED_OTA_UPGRADE_STATUS_OK;
@@ -152,48 +219,16 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
         return WICED_OTA_UPGRADE_STATUS_OK;
 
     case APP_OFU_SRV_STATE_READY_FOR_DOWNLOAD:
-        if (command == WICED_OTA_UPGRADE_COMMAND_DOWNLOAD)
+        if ((command == WICED_OTA_UPGRADE_COMMAND_DOWNLOAD) ||
+            (command == APP_OFU_COMMAND_RESUME) ||
+            (command == APP_OFU_COMMAND_DOWNLOAD_DELTA) ||
+            (command == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED))
         {
-            APP_OFU_TRACE_DBG("Cmd: Download\n");
-            /* command to start upgrade should be accompanied by 4 bytes with the image size */
-            if (length < 4)
-            {
-                APP_TRACE_ERR("Bad Download len:%d\n", length);
-                app_ofu_srv_abort(p_app_callback);
-                return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
-            }
-
-            /* Extract Download file size */
-            STREAM_TO_UINT32(ota_fw_upgrade_state.total_len, p_data);
-            APP_OFU_TRACE_DBG("Download len:%d\n", ota_fw_upgrade_state.total_len);
-
-            if (!wiced_firmware_upgrade_init_nv_locations())
-            {
-                APP_TRACE_ERR("failed init nv locations\n");
-                app_ofu_srv_abort(p_app_callback);
-                return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
-            }
-
-            app_ofu_srv_cb.state                = APP_OFU_SRV_STATE_DATA_TRANSFER;
-            app_ofu_srv_cb.current_offset       = 0;
-            app_ofu_srv_cb.current_block_offset = 0;
-            app_ofu_srv_cb.total_offset         = 0;
-
-#ifdef APP_OFU_DEBUG
-            app_ofu_srv_cb.recv_crc32           = 0xFFFFFFFF;
-#endif
-
-#if ( defined(CYW20719B0) || defined(CYW20719B1) || defined(CYW20721B1) || defined(CYW20721B2) )
-            /*
-             * if we are using Secure version the total length comes in the beginning of the image,
-             * do not use the one from the downloader.
-             */
-            if (p_ecdsa_public_key != NULL)
-            {
-                ota_fw_upgrade_state.total_len = 0;
-            }
-#endif
-            return WICED_OTA_UPGRADE_STATUS_OK;
+            return app_ofu_srv_download_start(command, p_data, length, p_app_callback);
+        }
+        else if (command == APP_OFU_COMMAND_IMAGE_INFO)
+        {
+            return app_ofu_srv_image_info(p_data, length, p_app_callback);
         }
         else
         {
@@ -206,6 +241,13 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
     case APP_OFU_SRV_STATE_DATA_TRANSFER:
         if (command == WICED_OTA_UPGRADE_COMMAND_VERIFY)
         {
+            /* Write the last Staging buffer (if not yet committed) */
+            value = app_ofu_srv_commit_flush();
+            if (value != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+            {
+                return value;
+            }
+
             /* command to perform verification */
             if (ota_fw_upgrade_state.total_len != app_ofu_srv_cb.total_offset)
             {
@@ -215,6 +257,15 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
                 return WICED_OTA_UPGRADE_STATUS_VERIFICATION_FAILED;
             }
 
+            /* The Patch must have been applied on the Base Image it has been generated from */
+            if ((app_ofu_srv_cb.image_format == APP_OFU_SRV_IMAGE_DELTA) &&
+                (app_ofu_delta_base_check(WICED_TRUE) != WICED_OTA_UPGRADE_STATUS_OK))
+            {
+                APP_TRACE_ERR("Patch does not apply to the Active Partition\n");
+                app_ofu_srv_abort(p_app_callback);
+                return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+            }
+
             /* For none-secure case the command should have 4 bytes CRC32 */
             if (p_ecdsa_public_key == NULL)
             {
@@ -225,7 +276,27 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
                     return WICED_OTA_UPGRADE_STATUS_BAD_PARAM;
                 }
                 STREAM_TO_UINT32(ota_fw_upgrade_state.crc32, p_data);
-                verified = ota_fw_upgrade_verify();
+                if ((app_ofu_srv_cb.image_info.valid) &&
+                    (app_ofu_srv_cb.image_info.crc32 != ota_fw_upgrade_state.crc32))
+                {
+                    APP_TRACE_ERR("CRC32:0x%x does not match Image Info CRC32:0x%x\n",
+                            ota_fw_upgrade_state.crc32, app_ofu_srv_cb.image_info.crc32);
+                    app_nvram_ofu_checkpoint_delete();
+                    app_ofu_srv_abort(p_app_callback);
+                    return WICED_OTA_UPGRADE_STATUS_VERIFICATION_FAILED;
+                }
+                /* The CRC32 of the received data is already known (no need to read the Flash) */
+                if ((app_ofu_srv_cb.committed_crc32 ^ 0xFFFFFFFF) != ota_fw_upgrade_state.crc32)
+                {
+                    APP_TRACE_ERR("Bad CRC32:0x%x expected:0x%x\n",
+                            app_ofu_srv_cb.committed_crc32 ^ 0xFFFFFFFF,
+                            ota_fw_upgrade_state.crc32);
+                    verified = WICED_FALSE;
+                }
+                else
+                {
+                    verified = ota_fw_upgrade_verify();
+                }
             }
             else
             {
@@ -233,6 +304,9 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
                 verified = ota_sec_fw_upgrade_verify();
             }
 
+            /* The downloaded image cannot be resumed anymore (either bad or complete) */
+            app_nvram_ofu_checkpoint_delete();
+
             if (!verified)
             {
                 APP_TRACE_ERR("Verify failed\n");
@@ -241,9 +315,19 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
             }
 
             APP_OFU_TRACE_DBG("Verify success\n");
+            APP_OFU_TRACE_DBG("nb_commit:%d latency max:%dus total:%dus nb_stall:%d max:%dus total:%dus\n",
+                    app_ofu_srv_cb.stats.nb_commit, app_ofu_srv_cb.stats.commit_latency_max,
+                    app_ofu_srv_cb.stats.commit_latency_total, app_ofu_srv_cb.stats.nb_stall,
+                    app_ofu_srv_cb.stats.stall_time_max, app_ofu_srv_cb.stats.stall_time_total);
             app_ofu_srv_cb.state = APP_OFU_SRV_STATE_VERIFIED;
 
+            if (app_ofu_srv_cb.p_relay_callback != NULL)
+            {
+                app_ofu_srv_cb.p_relay_callback(APP_OFU_SRV_RELAY_VERIFIED, 0, 0);
+            }
+
             APP_OFU_TRACE_DBG("Starting Reset timer\n");
+            app_ofu_srv_cb.reset_hold_duration = 0;
             wiced_start_timer(&app_ofu_srv_cb.reset_timer, 1);
 
             /* Tell the app that OFU is Complete */
@@ -251,6 +335,14 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
             app_ofu_srv_cb.state = APP_OFU_SRV_STATE_IDLE;
             return WICED_OTA_UPGRADE_STATUS_OK;
         }
+        else if ((command == WICED_OTA_UPGRADE_COMMAND_DOWNLOAD) ||
+                 (command == APP_OFU_COMMAND_RESUME) ||
+                 (command == APP_OFU_COMMAND_DOWNLOAD_DELTA) ||
+                 (command == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED))
+        {
+            /* The Client restarts the download (e.g. Resume refused by the Client) */
+            return app_ofu_srv_download_start(command, p_data, length, p_app_callback);
+        }
         else
         {
             APP_TRACE_ERR("Unexpected command%d state:%d\n", command, app_ofu_srv_cb.state);
@@ -268,35 +360,335 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
 }
 
 /*
- * app_ofu_srv_data_handler
+ * app_ofu_srv_download_start
+ * Handle the Download, Resume, Delta Download and Compressed Download commands. The Resume command continues the
+ * download from the last committed block if the checkpoint saved in NVRAM matches the image length
+ * and the Image CRC32 given by the Image Info (otherwise the download restarts from the beginning
+ * of the image). Without Image Info (on both downloads), the Client checks the CRC32 of the
+ * committed data returned in the Resume Response.
+ * For the Delta Download command, the Base Image (in the Active Partition) is checked in
+ * background while the Patch is received. The download is aborted (the Client must fallback to a
+ * regular Download) if it is not the one the Patch has been generated from.
  */
-uint8_t app_ofu_srv_data_handler(uint8_t *p_data, uint16_t length,
+static uint8_t app_ofu_srv_download_start(uint8_t command, uint8_t *p_data, uint16_t length,
         app_ofu_srv_app_callback_t *p_app_callback)
 {
-    uint8_t *p;
-    int bytes_to_copy;
-    uint16_t payload_len;
-    uint32_t nb_wrote;
+    app_nvram_ofu_checkpoint_t checkpoint;
+    wiced_result_t status;
+    uint32_t base_len;
+    uint32_t base_crc32;
 
-#ifndef CYW20706A2
-    uint16_t image_product_id;
-    uint8_t  image_major, image_minor;
+    APP_OFU_TRACE_DBG("Cmd: %s\n",
+            command == APP_OFU_COMMAND_RESUME ? "Resume" :
+            command == APP_OFU_COMMAND_DOWNLOAD_DELTA ? "DeltaDownload" :
+            command == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED ? "CompDownload" : "Download");
+
+    /* command to start upgrade should be accompanied by 4 bytes with the image size */
+    if (length < 4)
+    {
+        APP_TRACE_ERR("Bad Download len:%d\n", length);
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    /* Extract Download file size */
+    STREAM_TO_UINT32(app_ofu_srv_cb.download_len, p_data);
+    ota_fw_upgrade_state.total_len = app_ofu_srv_cb.download_len;
+    APP_OFU_TRACE_DBG("Download len:%d\n", ota_fw_upgrade_state.total_len);
+
+    /* Reject the Image before any Data is transferred */
+    if (app_ofu_srv_cb.download_len > APP_OFU_IMAGE_LEN_MAX)
+    {
+        APP_TRACE_ERR("Image too big len:%d\n", app_ofu_srv_cb.download_len);
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
+    }
+    if ((app_ofu_srv_cb.image_info.valid) &&
+        (app_ofu_srv_cb.download_len != app_ofu_srv_cb.image_info.len))
+    {
+        APP_TRACE_ERR("len:%d does not match Image Info len:%d\n", app_ofu_srv_cb.download_len,
+                app_ofu_srv_cb.image_info.len);
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
+    }
+
+    app_ofu_srv_cb.image_format = APP_OFU_SRV_IMAGE_RAW;
+    if (command == APP_OFU_COMMAND_DOWNLOAD_DELTA)
+    {
+        /* Delta Download is followed by the Base Image length and CRC32 */
+        if (length < (3 * sizeof(uint32_t)))
+        {
+            APP_TRACE_ERR("Bad Delta Download len:%d\n", length);
+            app_ofu_srv_abort(p_app_callback);
+            return WICED_OTA_UPGRADE_STATUS_BAD_PARAM;
+        }
+        STREAM_TO_UINT32(base_len, p_data);
+        STREAM_TO_UINT32(base_crc32, p_data);
+        if (app_ofu_delta_start(base_len, base_crc32) != WICED_BT_SUCCESS)
+        {
+            /* The Client must fallback to a regular Download */
+            APP_TRACE_ERR("Delta Download refused\n");
+            app_ofu_srv_abort(p_app_callback);
+            return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+        }
+        app_ofu_srv_cb.image_format = APP_OFU_SRV_IMAGE_DELTA;
+    }
+    else if (command == APP_OFU_COMMAND_DOWNLOAD_COMPRESSED)
+    {
+        app_ofu_lz_start();
+        app_ofu_srv_cb.image_format = APP_OFU_SRV_IMAGE_COMPRESSED;
+    }
+
+    if (!wiced_firmware_upgrade_init_nv_locations())
+    {
+        APP_TRACE_ERR("failed init nv locations\n");
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    app_ofu_srv_cb.state                = APP_OFU_SRV_STATE_DATA_TRANSFER;
+    app_ofu_srv_cb.current_offset       = 0;
+    app_ofu_srv_cb.current_block_offset = 0;
+    app_ofu_srv_cb.total_offset         = 0;
+    app_ofu_srv_cb.fill_buffer          = 0;
+    app_ofu_srv_cb.commit_pending       = WICED_FALSE;
+
+    /* The Data already forwarded by the Relay (if any) is not valid anymore */
+    if (app_ofu_srv_cb.p_relay_callback != NULL)
+    {
+        app_ofu_srv_cb.p_relay_callback(APP_OFU_SRV_RELAY_ABORTED, 0, 0);
+    }
+    memset(&app_ofu_srv_cb.stats, 0, sizeof(app_ofu_srv_cb.stats));
+    app_ofu_srv_cb.committed_crc32      = APP_OFU_CRC32_INIT;
+
+#if ( defined(CYW20719B0) || defined(CYW20719B1) || defined(CYW20721B1) || defined(CYW20721B2) )
+    /*
+     * if we are using Secure version the total length comes in the beginning of the image,
+     * do not use the one from the downloader.
+     */
+    if ((p_ecdsa_public_key != NULL) &&
+        (app_ofu_srv_cb.image_format == APP_OFU_SRV_IMAGE_RAW))
+    {
+        ota_fw_upgrade_state.total_len = 0;
+    }
 #endif
 
+    if (command == APP_OFU_COMMAND_RESUME)
+    {
+        status = app_nvram_ofu_checkpoint_get(&checkpoint);
+        if ((status == WICED_BT_SUCCESS) &&
+            (checkpoint.download_len == app_ofu_srv_cb.download_len) &&
+            (checkpoint.image_crc32 == app_ofu_srv_image_crc32_get()) &&
+            (checkpoint.offset < checkpoint.total_len) &&
+            ((checkpoint.offset % OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT) == 0))
+        {
+            APP_OFU_TRACE_DBG("Resume from offset:%d/%d\n", checkpoint.offset,
+                    checkpoint.total_len);
+            ota_fw_upgrade_state.total_len  = checkpoint.total_len;
+            app_ofu_srv_cb.total_offset     = checkpoint.offset;
+            app_ofu_srv_cb.committed_crc32  = checkpoint.crc32;
+        }
+        else
+        {
+            APP_OFU_TRACE_DBG("No valid checkpoint. Resume from offset 0\n");
+        }
+    }
+
+    /* Previous download (if any) cannot be resumed anymore */
+    if (app_ofu_srv_cb.total_offset == 0)
+    {
+        app_nvram_ofu_checkpoint_delete();
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_OK;
+}
+
+/*
+ * app_ofu_srv_image_info
+ * Handle the Image Info command. The Image is validated before it is downloaded.
+ */
+static uint8_t app_ofu_srv_image_info(uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_app_callback)
+{
+    uint32_t image_len;
+    uint16_t product_id;
+    uint8_t major;
+    uint8_t minor;
+    uint32_t crc32;
+    uint8_t signature;
+    uint8_t status;
+
+    if (length < APP_OFU_IMAGE_INFO_LEN)
+    {
+        APP_TRACE_ERR("Bad Image Info len:%d\n", length);
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_BAD_PARAM;
+    }
+
+    STREAM_TO_UINT32(image_len, p_data);
+    STREAM_TO_UINT16(product_id, p_data);
+    STREAM_TO_UINT8(major, p_data);
+    STREAM_TO_UINT8(minor, p_data);
+    STREAM_TO_UINT32(crc32, p_data);
+    STREAM_TO_UINT8(signature, p_data);
+
+    APP_OFU_TRACE_DBG("Image Info len:%d Product:0x%x %d.%d CRC32:0x%x signature:%d\n",
+            image_len, product_id, major, minor, crc32, signature);
+
+    if ((image_len == 0) ||
+        (image_len > APP_OFU_IMAGE_LEN_MAX))
+    {
+        APP_TRACE_ERR("Wrong Image len:%d\n", image_len);
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
+    }
+
+    status = app_ofu_srv_image_check(product_id, major, minor);
+    if (status != WICED_OTA_UPGRADE_STATUS_OK)
+    {
+        app_ofu_srv_abort(p_app_callback);
+        return status;
+    }
+
+    /* A Secure upgrade requires a signed Image */
+    if ((p_ecdsa_public_key != NULL) &&
+        (signature != APP_OFU_IMAGE_SIGNATURE_ECDSA_P256))
+    {
+        APP_TRACE_ERR("Image not signed\n");
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+
+    app_ofu_srv_cb.image_info.valid = WICED_TRUE;
+    app_ofu_srv_cb.image_info.len = image_len;
+    app_ofu_srv_cb.image_info.crc32 = crc32;
+
+    return WICED_OTA_UPGRADE_STATUS_OK;
+}
+
+/*
+ * app_ofu_srv_image_check
+ * Check that the Image is built for this Product and is not older than the running FW
+ */
+static uint8_t app_ofu_srv_image_check(uint16_t product_id, uint8_t major, uint8_t minor)
+{
+    if ((APP_OFU_PRODUCT_ID != 0) &&
+        (product_id != APP_OFU_PRODUCT_ID))
+    {
+        APP_TRACE_ERR("Wrong Product:0x%x expected:0x%x\n", product_id, APP_OFU_PRODUCT_ID);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_APPID;
+    }
+
+    if (major < APP_OFU_VERSION_MAJOR)
+    {
+        APP_TRACE_ERR("Version %d.%d older than %d.%d\n", major, minor, APP_OFU_VERSION_MAJOR,
+                APP_OFU_VERSION_MINOR);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_VERSION;
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_OK;
+}
+
+/*
+ * app_ofu_srv_resume_info_get
+ */
+void app_ofu_srv_resume_info_get(uint32_t *p_offset, uint32_t *p_crc32)
+{
+    *p_offset = app_ofu_srv_cb.total_offset;
+    *p_crc32 = app_ofu_srv_cb.committed_crc32;
+}
+
+/*
+ * app_ofu_srv_checkpoint_save
+ * Save the download progress (called every time a block is committed)
+ */
+static void app_ofu_srv_checkpoint_save(void)
+{
+    app_nvram_ofu_checkpoint_t checkpoint;
+
+    /* Last block. The checkpoint will be deleted by the Verify command */
+    if (app_ofu_srv_cb.total_offset >= ota_fw_upgrade_state.total_len)
+    {
+        return;
+    }
+
+    /*
+     * The Patch decoder and decompressor states are not saved. A Delta or Compressed Download
+     * cannot be resumed
+     */
+    if (app_ofu_srv_cb.image_format != APP_OFU_SRV_IMAGE_RAW)
+    {
+        return;
+    }
+
+    checkpoint.download_len = app_ofu_srv_cb.download_len;
+    checkpoint.total_len    = ota_fw_upgrade_state.total_len;
+    checkpoint.offset       = app_ofu_srv_cb.total_offset;
+    checkpoint.crc32        = app_ofu_srv_cb.committed_crc32;
+    checkpoint.image_crc32  = app_ofu_srv_image_crc32_get();
+
+    if (app_nvram_ofu_checkpoint_set(&checkpoint) != WICED_BT_SUCCESS)
+    {
+        APP_TRACE_ERR("app_nvram_ofu_checkpoint_set failed\n");
+    }
+}
+
+/*
+ * app_ofu_srv_image_crc32_get
+ * CRC32 of the Image given by the Image Info (0 if the Client did not send it)
+ */
+static uint32_t app_ofu_srv_image_crc32_get(void)
+{
+    if (app_ofu_srv_cb.image_info.valid == WICED_FALSE)
+    {
+        return 0;
+    }
+    return app_ofu_srv_cb.image_info.crc32;
+}
+
+/*
+ * app_ofu_srv_data_handler
+ */
+uint8_t app_ofu_srv_data_handler(uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_app_callback)
+{
+    uint8_t status;
+
 #ifdef APP_OFU_DEBUG
     app_ofu_srv_cb.nb_rx_data_packet++;
     APP_OFU_TRACE_DBG("length:%d data:[%02X..%02X] nb_rx_data_packet:%d\n",
             length, p_data[0], p_data[length - 1], app_ofu_srv_cb.nb_rx_data_packet);
 #endif
 
-    p = p_data;
-
     if (app_ofu_srv_cb.state != APP_OFU_SRV_STATE_DATA_TRANSFER)
     {
         app_ofu_srv_abort(p_app_callback);
         return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
     }
 
+    /*
+     * Delta Download: reconstruct the Image from the Active Partition and the Patch.
+     * Compressed Download: decompress the Image.
+     */
+    if (app_ofu_srv_cb.image_format != APP_OFU_SRV_IMAGE_RAW)
+    {
+        app_ofu_srv_cb.p_decoder_app_callback = p_app_callback;
+        if (app_ofu_srv_cb.image_format == APP_OFU_SRV_IMAGE_DELTA)
+        {
+            status = app_ofu_delta_data_handler(p_data, length, app_ofu_srv_decoder_write);
+        }
+        else
+        {
+            status = app_ofu_lz_data_handler(p_data, length, app_ofu_srv_decoder_write);
+        }
+        if ((status != WICED_OTA_UPGRADE_STATUS_CONTINUE) &&
+            (app_ofu_srv_cb.state != APP_OFU_SRV_STATE_ABORTED))
+        {
+            app_ofu_srv_abort(p_app_callback);
+        }
+        return status;
+    }
+
 /* Image prefixes are not supported on 20706 */
 #ifndef CYW20706A2
     /* For the Secure upgrade, verify the Product info */
@@ -307,58 +699,99 @@ uint8_t app_ofu_srv_data_handler(uint8_t *p_data, uint16_t length,
          * the length. Following check is for the FW2 */
         if (ota_fw_upgrade_state.total_len == 0)
         {
-            if (memcmp(p, ds_image_prefix, sizeof(ds_image_prefix)) != 0)
+            if (length < APP_OFU_SRV_IMAGE_HEADER_LEN)
             {
-                APP_TRACE_ERR("Bad data start\n");
+                APP_TRACE_ERR("Bad data start len:%d\n", length);
                 app_ofu_srv_abort(p_app_callback);
                 return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
             }
-            p += sizeof(ds_image_prefix);
-            STREAM_TO_UINT16(image_product_id, p);
-            UNUSED_VARIABLE(image_product_id);
-            STREAM_TO_UINT8(image_major, p);
-            UNUSED_VARIABLE(image_major);
-            STREAM_TO_UINT8(image_minor, p);
-            UNUSED_VARIABLE(image_minor);
-
-            /* length store in the image does not include size of ds_image_prefix */
-            STREAM_TO_UINT32(ota_fw_upgrade_state.total_len, p);
-            ota_fw_upgrade_state.total_len += DS_IMAGE_PREFIX_LEN + SIGNATURE_LEN;
-
-            /*
-             * ToDo validate flash size
-             * ToDo validate that product is the same as stored and major is >= the one that stored
-             */
-            APP_OFU_TRACE_DBG("Image for Product 0x%x %d.%d len:%d\n",
-                    image_product_id, image_major, image_minor, ota_fw_upgrade_state.total_len);
+            status = app_ofu_srv_image_header_check(p_data, &ota_fw_upgrade_state.total_len);
+            if (status != WICED_OTA_UPGRADE_STATUS_OK)
+            {
+                app_ofu_srv_abort(p_app_callback);
+                return status;
+            }
         }
     }
-    else
 #endif
+
+    return app_ofu_srv_image_write(p_data, length, p_app_callback);
+}
+
+#ifndef CYW20706A2
+/*
+ * app_ofu_srv_image_header_check
+ * Parse the header of a Secure Image. Same checks as the Image Info (for the Clients which do
+ * not send it): the Image must fit in the Download Partition and match the Product and Version.
+ */
+static uint8_t app_ofu_srv_image_header_check(uint8_t *p_header, uint32_t *p_total_len)
+{
+    uint8_t *p = p_header;
+    uint16_t image_product_id;
+    uint8_t image_major, image_minor;
+    uint32_t total_len;
+
+    if (memcmp(p, ds_image_prefix, sizeof(ds_image_prefix)) != 0)
     {
-#ifdef APP_OFU_DEBUG
-        /* For testing calculate received CRC32 of the received data */
-        app_ofu_srv_cb.recv_crc32 = app_ofu_srv_crc32_update(app_ofu_srv_cb.recv_crc32, p_data,
-                length);
-#endif
+        APP_TRACE_ERR("Bad data start\n");
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE;
+    }
+    p += sizeof(ds_image_prefix);
+    STREAM_TO_UINT16(image_product_id, p);
+    STREAM_TO_UINT8(image_major, p);
+    STREAM_TO_UINT8(image_minor, p);
+
+    /* length store in the image does not include size of ds_image_prefix */
+    STREAM_TO_UINT32(total_len, p);
+    total_len += DS_IMAGE_PREFIX_LEN + SIGNATURE_LEN;
+
+    APP_OFU_TRACE_DBG("Image for Product 0x%x %d.%d len:%d\n",
+            image_product_id, image_major, image_minor, total_len);
+
+    if (total_len > APP_OFU_IMAGE_LEN_MAX)
+    {
+        APP_TRACE_ERR("Image too big len:%d\n", total_len);
+        return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
     }
 
-    p = p_data;
+    *p_total_len = total_len;
+
+    return app_ofu_srv_image_check(image_product_id, image_major, image_minor);
+}
+#endif
+
+/*
+ * app_ofu_srv_decoder_write
+ * Write the Image reconstructed by the Patch decoder or by the decompressor
+ */
+static uint8_t app_ofu_srv_decoder_write(uint8_t *p_data, uint32_t length)
+{
+    return app_ofu_srv_image_write(p_data, length, app_ofu_srv_cb.p_decoder_app_callback);
+}
+
+/*
+ * app_ofu_srv_image_write
+ * Copy Image data in the Staging buffers. A full buffer is committed in the Download Partition
+ */
+static uint8_t app_ofu_srv_image_write(uint8_t *p_data, uint32_t length,
+        app_ofu_srv_app_callback_t *p_app_callback)
+{
+    uint8_t *p = p_data;
+    uint32_t bytes_to_copy;
+    uint8_t status;
+#ifndef CYW20706A2
+    uint32_t header_total_len;
+#endif
 
     while (length)
     {
-        if ((app_ofu_srv_cb.current_block_offset + length) < OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT)
+        bytes_to_copy = OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT - app_ofu_srv_cb.current_block_offset;
+        if (bytes_to_copy > length)
         {
             bytes_to_copy = length;
         }
-        else
-        {
-            bytes_to_copy = OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT;
-            bytes_to_copy -= app_ofu_srv_cb.current_block_offset;
-        }
 
-        if ((app_ofu_srv_cb.total_offset + app_ofu_srv_cb.current_block_offset + bytes_to_copy >
-                ota_fw_upgrade_state.total_len))
+        if ((app_ofu_srv_received_offset() + bytes_to_copy) > ota_fw_upgrade_state.total_len)
         {
             APP_TRACE_ERR("Too much data. size of the image %d offset %d, block offset %d len rcvd %d\n",
                     ota_fw_upgrade_state.total_len, app_ofu_srv_cb.total_offset,
@@ -366,50 +799,274 @@ uint8_t app_ofu_srv_data_handler(uint8_t *p_data, uint16_t length,
             return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
         }
 
-        memcpy(&(app_ofu_srv_cb.read_buffer[app_ofu_srv_cb.current_block_offset]), p, bytes_to_copy);
+        memcpy(&app_ofu_srv_cb.read_buffer[app_ofu_srv_cb.fill_buffer][app_ofu_srv_cb.current_block_offset],
+                p, bytes_to_copy);
         app_ofu_srv_cb.current_block_offset += bytes_to_copy;
 
-        if ((app_ofu_srv_cb.current_block_offset == OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT) ||
-            (app_ofu_srv_cb.total_offset + app_ofu_srv_cb.current_block_offset == ota_fw_upgrade_state.total_len))
+#ifndef CYW20706A2
+        /*
+         * Delta and Compressed Downloads: the Secure Image header is checked once it is
+         * reconstructed (in the first Staging buffer). Its length must match the Download command.
+         */
+        if ((p_ecdsa_public_key != NULL) &&
+            (app_ofu_srv_cb.image_format != APP_OFU_SRV_IMAGE_RAW) &&
+            (app_ofu_srv_cb.total_offset == 0) &&
+            (app_ofu_srv_cb.commit_pending == WICED_FALSE) &&
+            (app_ofu_srv_cb.current_block_offset >= APP_OFU_SRV_IMAGE_HEADER_LEN) &&
+            ((app_ofu_srv_cb.current_block_offset - bytes_to_copy) < APP_OFU_SRV_IMAGE_HEADER_LEN))
         {
-            APP_OFU_TRACE_DBG("write offset:0x%x\n", app_ofu_srv_cb.total_offset);
-
-            /* write should be on the word boundary and in full words, we may write a bit more */
-            nb_wrote = wiced_firmware_upgrade_store_to_nv(app_ofu_srv_cb.total_offset,
-                    app_ofu_srv_cb.read_buffer,
-                    (app_ofu_srv_cb.current_block_offset + 3) & 0xFFFFFFFC);
-            if (nb_wrote != ((app_ofu_srv_cb.current_block_offset + 3) & 0xFFFFFFFC))
+            status = app_ofu_srv_image_header_check(
+                    app_ofu_srv_cb.read_buffer[app_ofu_srv_cb.fill_buffer], &header_total_len);
+            if (status != WICED_OTA_UPGRADE_STATUS_OK)
             {
-                APP_TRACE_ERR("wiced_firmware_upgrade_store_to_nv failed\n");
-                app_ofu_srv_abort(p_app_callback);
-                return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
+                return status;
             }
-            app_ofu_srv_cb.total_offset += app_ofu_srv_cb.current_block_offset;
-            app_ofu_srv_cb.current_block_offset = 0;
-
-#ifdef APP_OFU_DEBUG
-            APP_OFU_TRACE_DBG("progress:%d/%d\n", app_ofu_srv_cb.total_offset,
-                    ota_fw_upgrade_state.total_len);
+            if (header_total_len != ota_fw_upgrade_state.total_len)
+            {
+                APP_TRACE_ERR("Image header len:%d does not match len:%d\n", header_total_len,
+                        ota_fw_upgrade_state.total_len);
+                return WICED_OTA_UPGRADE_STATUS_INVALID_IMAGE_SIZE;
+            }
+        }
 #endif
 
-#ifdef APP_OFU_DEBUG
-            if (app_ofu_srv_cb.total_offset == ota_fw_upgrade_state.total_len)
+        if ((app_ofu_srv_cb.current_block_offset == OTA_FW_UPGRADE_CHUNK_SIZE_TO_COMMIT) ||
+            (app_ofu_srv_received_offset() == ota_fw_upgrade_state.total_len))
+        {
+            status = app_ofu_srv_commit_request(p_app_callback);
+            if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
             {
-                app_ofu_srv_cb.recv_crc32 = app_ofu_srv_cb.recv_crc32 ^ 0xFFFFFFFF;
-                APP_OFU_TRACE_DBG("last OFU chunk received. Calculated CRC:%X\n",
-                        app_ofu_srv_cb.recv_crc32);
+                return status;
             }
-#endif
         }
 
         length -= bytes_to_copy;
         p += bytes_to_copy;
+    }
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_srv_received_offset
+ * Offset of the next expected byte of the Image (committed or staged Data)
+ */
+static uint32_t app_ofu_srv_received_offset(void)
+{
+    uint32_t offset;
+
+    offset = app_ofu_srv_cb.total_offset + app_ofu_srv_cb.current_block_offset;
+    if (app_ofu_srv_cb.commit_pending)
+    {
+        offset += app_ofu_srv_cb.commit_len;
+    }
+    return offset;
+}
+
+/*
+ * app_ofu_srv_commit_request
+ * The Staging buffer being filled is full. Switch to the other buffer and schedule the commit
+ */
+static uint8_t app_ofu_srv_commit_request(app_ofu_srv_app_callback_t *p_app_callback)
+{
+    uint8_t status;
+
+    /* The other buffer is not committed yet. The reception stalls until it is */
+    if (app_ofu_srv_cb.commit_pending)
+    {
+        status = app_ofu_srv_commit_stall();
+        if (status != WICED_OTA_UPGRADE_STATUS_CONTINUE)
+        {
+            return status;
+        }
+    }
+
+    app_ofu_srv_cb.commit_pending = WICED_TRUE;
+    app_ofu_srv_cb.commit_len = app_ofu_srv_cb.current_block_offset;
+    app_ofu_srv_cb.commit_request_time = clock_SystemTimeMicroseconds64();
+    app_ofu_srv_cb.p_commit_app_callback = p_app_callback;
+    app_ofu_srv_cb.fill_buffer = (app_ofu_srv_cb.fill_buffer + 1) % APP_OFU_SRV_STAGING_NB;
+    app_ofu_srv_cb.current_block_offset = 0;
+
+#if (APP_OFU_SRV_STAGING_NB == 1)
+    /* Single Staging buffer. The reception stalls until it is committed */
+    return app_ofu_srv_commit_stall();
+#endif
+
+    /* Commit the buffer once the current application event is handled */
+    if (app_ofu_srv_cb.commit_scheduled == WICED_FALSE)
+    {
+        if (wiced_app_event_serialize(&app_ofu_srv_commit_serialized, NULL) != WICED_SUCCESS)
+        {
+            return app_ofu_srv_commit();
+        }
+        app_ofu_srv_cb.commit_scheduled = WICED_TRUE;
+    }
+
+    return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+}
+
+/*
+ * app_ofu_srv_commit_stall
+ * Commit the pending Staging buffer while the reception waits (counted as a stall)
+ */
+static uint8_t app_ofu_srv_commit_stall(void)
+{
+    uint64_t stall_start_time;
+    uint32_t stall_time;
+    uint8_t status;
+
+    stall_start_time = clock_SystemTimeMicroseconds64();
+    status = app_ofu_srv_commit();
+    stall_time = (uint32_t)(clock_SystemTimeMicroseconds64() - stall_start_time);
+    app_ofu_srv_cb.stats.nb_stall++;
+    app_ofu_srv_cb.stats.stall_time_total += stall_time;
+    if (stall_time > app_ofu_srv_cb.stats.stall_time_max)
+    {
+        app_ofu_srv_cb.stats.stall_time_max = stall_time;
+    }
+    return status;
+}
+
+/*
+ * app_ofu_srv_commit_serialized
+ */
+static int app_ofu_srv_commit_serialized(void *p_data)
+{
+    app_ofu_srv_cb.commit_scheduled = WICED_FALSE;
+
+    /* The commit may have been done (stall) or discarded (abort) in the meantime */
+    app_ofu_srv_commit_flush();
 
-        /* APP_OFU_TRACE_DBG("remaining len: %d \n", length); */
+    return 0;
+}
+
+/*
+ * app_ofu_srv_commit_flush
+ * Commit the pending Staging buffer (if any)
+ */
+static uint8_t app_ofu_srv_commit_flush(void)
+{
+    if ((app_ofu_srv_cb.commit_pending == WICED_FALSE) ||
+        (app_ofu_srv_cb.state != APP_OFU_SRV_STATE_DATA_TRANSFER))
+    {
+        return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+    }
+
+    return app_ofu_srv_commit();
+}
+
+/*
+ * app_ofu_srv_commit
+ * Write the pending Staging buffer in the Download Partition
+ */
+static uint8_t app_ofu_srv_commit(void)
+{
+    uint8_t *p_buffer = app_ofu_srv_cb.read_buffer[(app_ofu_srv_cb.fill_buffer + 1) %
+            APP_OFU_SRV_STAGING_NB];
+    uint32_t length = app_ofu_srv_cb.commit_len;
+    uint32_t nb_wrote;
+    uint32_t latency;
+
+    APP_OFU_TRACE_DBG("write offset:0x%x\n", app_ofu_srv_cb.total_offset);
+
+    app_ofu_srv_cb.commit_pending = WICED_FALSE;
+
+    /* write should be on the word boundary and in full words, we may write a bit more */
+    nb_wrote = wiced_firmware_upgrade_store_to_nv(app_ofu_srv_cb.total_offset, p_buffer,
+            (length + 3) & 0xFFFFFFFC);
+    if (nb_wrote != ((length + 3) & 0xFFFFFFFC))
+    {
+        APP_TRACE_ERR("wiced_firmware_upgrade_store_to_nv failed\n");
+        app_ofu_srv_abort(app_ofu_srv_cb.p_commit_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
+    }
+    /* Check that the block has been correctly written in Flash */
+    if (app_ofu_srv_commit_verify(p_buffer, app_ofu_srv_cb.total_offset, length) == WICED_FALSE)
+    {
+        APP_TRACE_ERR("Block at offset:0x%x corrupted in Flash\n", app_ofu_srv_cb.total_offset);
+        app_ofu_srv_abort(app_ofu_srv_cb.p_commit_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_VERIFICATION_FAILED;
     }
+    app_ofu_srv_cb.committed_crc32 = app_ofu_srv_crc32_update(app_ofu_srv_cb.committed_crc32,
+            p_buffer, length);
+    app_ofu_srv_cb.total_offset += length;
+
+    /* Save the progress to be able to Resume the download */
+    app_ofu_srv_checkpoint_save();
+
+    /* The Relay can forward the committed Data */
+    if (app_ofu_srv_cb.p_relay_callback != NULL)
+    {
+        app_ofu_srv_cb.p_relay_callback(APP_OFU_SRV_RELAY_COMMITTED, app_ofu_srv_cb.total_offset,
+                ota_fw_upgrade_state.total_len);
+    }
+
+    latency = (uint32_t)(clock_SystemTimeMicroseconds64() - app_ofu_srv_cb.commit_request_time);
+    app_ofu_srv_cb.stats.nb_commit++;
+    app_ofu_srv_cb.stats.commit_latency_total += latency;
+    if (latency > app_ofu_srv_cb.stats.commit_latency_max)
+    {
+        app_ofu_srv_cb.stats.commit_latency_max = latency;
+    }
+
+#ifdef APP_OFU_DEBUG
+    APP_OFU_TRACE_DBG("progress:%d/%d latency:%dus\n", app_ofu_srv_cb.total_offset,
+            ota_fw_upgrade_state.total_len, latency);
+    if (app_ofu_srv_cb.total_offset == ota_fw_upgrade_state.total_len)
+    {
+        APP_OFU_TRACE_DBG("last OFU chunk received. Calculated CRC:%X\n",
+                app_ofu_srv_cb.committed_crc32 ^ 0xFFFFFFFF);
+    }
+#endif
+
     return WICED_OTA_UPGRADE_STATUS_CONTINUE;
 }
 
+/*
+ * app_ofu_srv_stats_get
+ */
+void app_ofu_srv_stats_get(app_ofu_srv_stats_t *p_stats)
+{
+    memcpy(p_stats, &app_ofu_srv_cb.stats, sizeof(*p_stats));
+}
+
+/*
+ * app_ofu_srv_data_window_handler
+ * Data which is not received in sequence (lost or duplicated packet) is ignored. The Client will
+ * retransmit it from the acknowledged offset.
+ */
+uint8_t app_ofu_srv_data_window_handler(uint32_t offset, uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_app_callback, uint32_t *p_next_offset)
+{
+    uint32_t expected_offset;
+    uint8_t status;
+
+    expected_offset = app_ofu_srv_received_offset();
+    *p_next_offset = expected_offset;
+
+    if (app_ofu_srv_cb.state != APP_OFU_SRV_STATE_DATA_TRANSFER)
+    {
+        app_ofu_srv_abort(p_app_callback);
+        return WICED_OTA_UPGRADE_STATUS_ILLEGAL_STATE;
+    }
+
+    if (offset != expected_offset)
+    {
+#ifdef APP_OFU_DEBUG
+        app_ofu_srv_cb.nb_rx_data_dropped++;
+        APP_OFU_TRACE_DBG("Out of sequence offset:%d expected:%d nb_rx_data_dropped:%d\n",
+                offset, expected_offset, app_ofu_srv_cb.nb_rx_data_dropped);
+#endif
+        return WICED_OTA_UPGRADE_STATUS_CONTINUE;
+    }
+
+    status = app_ofu_srv_data_handler(p_data, length, p_app_callback);
+
+    *p_next_offset = app_ofu_srv_received_offset();
+
+    return status;
+}
+
 /*
  * app_ofu_srv_abort
  */
@@ -417,6 +1074,17 @@ static void app_ofu_srv_abort(app_ofu_srv_app_callback_t *p_app_callback)
 {
     app_ofu_srv_cb.state = APP_OFU_SRV_STATE_ABORTED;
 
+    /* Discard the pending Staging buffer */
+    app_ofu_srv_cb.commit_pending = WICED_FALSE;
+
+    /* Stop the Base Image check (Delta Download) */
+    app_ofu_delta_stop();
+
+    if (app_ofu_srv_cb.p_relay_callback != NULL)
+    {
+        app_ofu_srv_cb.p_relay_callback(APP_OFU_SRV_RELAY_ABORTED, 0, 0);
+    }
+
     /* Tell the app that OFU is Aborted */
     p_app_callback(APP_OFU_EVENT_ABORTED);
 }
@@ -426,17 +1094,78 @@ static void app_ofu_srv_abort(app_ofu_srv_app_callback_t *p_app_callback)
  */
 static void app_ofu_srv_reset_timeout(uint32_t param)
 {
+    /* The Reboot is delayed (e.g. the Relay did not complete yet) */
+    if ((app_ofu_srv_cb.reset_hold) &&
+        (app_ofu_srv_cb.reset_hold_duration < APP_OFU_SRV_RESET_HOLD_MAX))
+    {
+        app_ofu_srv_cb.reset_hold_duration++;
+        wiced_start_timer(&app_ofu_srv_cb.reset_timer, 1);
+        return;
+    }
+
     APP_TRACE_DBG("Configure the Flash to boot on the new FW and Reboot\n");
+    app_nvram_cache_flush();
     wiced_firmware_upgrade_finish();
 }
 
-#ifdef APP_OFU_DEBUG
+/*
+ * app_ofu_srv_relay_register
+ */
+void app_ofu_srv_relay_register(app_ofu_srv_relay_callback_t *p_callback)
+{
+    app_ofu_srv_cb.p_relay_callback = p_callback;
+}
+
+/*
+ * app_ofu_srv_reset_hold
+ */
+void app_ofu_srv_reset_hold(wiced_bool_t hold)
+{
+    app_ofu_srv_cb.reset_hold = hold;
+}
+
+/*
+ * app_ofu_srv_commit_verify
+ * Read back a block written in Flash and compare its CRC32 with the one of the received data
+ */
+static wiced_bool_t app_ofu_srv_commit_verify(uint8_t *p_buffer, uint32_t offset,
+        uint32_t length)
+{
+    uint8_t data[256];
+    uint32_t crc32_written;
+    uint32_t crc32_read = APP_OFU_CRC32_INIT;
+    uint32_t bytes_to_read;
+    uint32_t read_length;
+    uint32_t i;
+
+    crc32_written = app_ofu_srv_crc32_update(APP_OFU_CRC32_INIT, p_buffer, length);
+
+    for (i = 0; i < length; i += bytes_to_read)
+    {
+        bytes_to_read = length - i;
+        if (bytes_to_read > sizeof(data))
+        {
+            bytes_to_read = sizeof(data);
+        }
+        /* The NVRAM Read must be a multiple of 4 bytes */
+        read_length = wiced_firmware_upgrade_retrieve_from_nv(offset + i, data,
+                (bytes_to_read + 3) & 0xFFFFFFFC);
+        if (read_length != ((bytes_to_read + 3) & 0xFFFFFFFC))
+        {
+            APP_TRACE_ERR("wiced_firmware_upgrade_retrieve_from_nv failed\n");
+            return WICED_FALSE;
+        }
+        crc32_read = app_ofu_srv_crc32_update(crc32_read, data, bytes_to_read);
+    }
+
+    return (crc32_read == crc32_written);
+}
+
 /*
  * app_ofu_srv_crc32_update
  */
 static uint32_t app_ofu_srv_crc32_update(uint32_t crc32, uint8_t *p_data, uint16_t length)
 {
-    return crc32_Update(crc32, p_data, length);
+    return app_ofu_crc32_update(crc32, p_data, length);
 }
 #endif
-#endif
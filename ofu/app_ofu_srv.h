@@ -43,6 +43,28 @@
 /* Callback function to send OFU Events (Started/Completed/Aborted) to application */
 typedef void (app_ofu_srv_app_callback_t)(app_ofu_event_t event);
 
+/* Events sent to the Relay (which forwards the Image to another device while it is received) */
+typedef enum
+{
+    APP_OFU_SRV_RELAY_COMMITTED = 0,        /* Image data committed (offset and Image length) */
+    APP_OFU_SRV_RELAY_VERIFIED,             /* Image verified */
+    APP_OFU_SRV_RELAY_ABORTED,              /* Download aborted */
+} app_ofu_srv_relay_event_t;
+
+typedef void (app_ofu_srv_relay_callback_t)(app_ofu_srv_relay_event_t event, uint32_t offset,
+        uint32_t length);
+
+/* Flash commit statistics of the current (or last) download */
+typedef struct
+{
+    uint16_t nb_commit;                     /* Number of chunks committed */
+    uint16_t nb_stall;                      /* Number of times the reception waited for a commit */
+    uint32_t commit_latency_max;            /* Time (us) from chunk received to chunk committed */
+    uint32_t commit_latency_total;
+    uint32_t stall_time_max;                /* Time (us) the reception waited for a commit */
+    uint32_t stall_time_total;
+} app_ofu_srv_stats_t;
+
 /*
  * app_ofu_srv_init
  */
@@ -59,3 +81,37 @@ uint8_t app_ofu_srv_command_handler(uint8_t header, uint8_t *p_data, uint16_t le
  */
 uint8_t app_ofu_srv_data_handler(uint8_t *p_data, uint16_t length,
         app_ofu_srv_app_callback_t *p_callback);
+
+/*
+ * app_ofu_srv_resume_info_get
+ * Get the Offset and running CRC32 (not finalized) of the Data already committed.
+ * Used to build the Response of the Resume command
+ */
+void app_ofu_srv_resume_info_get(uint32_t *p_offset, uint32_t *p_crc32);
+
+/*
+ * app_ofu_srv_data_window_handler
+ * Handle Data received with its offset in the image (Windowed transfer).
+ * p_next_offset returns the offset of the next expected byte (cumulative acknowledgement)
+ */
+uint8_t app_ofu_srv_data_window_handler(uint32_t offset, uint8_t *p_data, uint16_t length,
+        app_ofu_srv_app_callback_t *p_callback, uint32_t *p_next_offset);
+
+/*
+ * app_ofu_srv_stats_get
+ * Get the Flash commit statistics
+ */
+void app_ofu_srv_stats_get(app_ofu_srv_stats_t *p_stats);
+
+/*
+ * app_ofu_srv_relay_register
+ * Register a Relay for the current download (the registration is cleared by the next
+ * Prepare Download command). The committed Image can be read in the Download Partition.
+ */
+void app_ofu_srv_relay_register(app_ofu_srv_relay_callback_t *p_callback);
+
+/*
+ * app_ofu_srv_reset_hold
+ * Delay (or allow) the Reboot which follows a successful Verify (e.g. while the Relay ends)
+ */
+void app_ofu_srv_reset_hold(wiced_bool_t hold);
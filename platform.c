@@ -54,6 +54,11 @@
 #include "wiced_bt_dev.h"
 #include "wiced_hal_eflash.h"
 #include "app_audio_insert.h"
+#include "app_nvram.h"
+#if defined(VOICE_PROMPT) && defined(OTA_FW_UPGRADE)
+#include "app_ofu.h"
+#include "app_ofu_crc32.h"
+#endif
 #include "bt_hs_spk_button.h"
 #include "bt_hs_spk_handsfree_utils.h"
 #include "bt_hs_spk_audio.h"
@@ -148,6 +153,11 @@ static char *platform_state_get_descr(platform_global_state_t state);
 
 static void platform_vsc_cmd_cplt_callback(
         wiced_bt_dev_vendor_specific_command_complete_params_t *p_cmd_cplt_param);
+static void platform_nvram_stats_send(void);
+static void platform_hci_tx_stats_send(void);
+#if defined(VOICE_PROMPT) && defined(OTA_FW_UPGRADE)
+static void platform_ef_crc_send(uint32_t offset, uint32_t length, wiced_bool_t valid);
+#endif
 
 #ifdef CYW9BT_AUDIO
 static wiced_bool_t platform_vse_callback (uint8_t len, uint8_t *p);
@@ -175,6 +185,30 @@ static wiced_led_config_t platform_evb1_led_config[] =
 };
 #endif
 
+/* Platform Group Commands handled by platform_handle_hci_command */
+static const uint16_t platform_hci_commands[] =
+{
+    HCI_PLATFORM_COMMAND_BUTTON,
+    HCI_PLATFORM_COMMAND_AUDIO_INSERT,
+    HCI_PLATFORM_COMMAND_BLE_ADV,
+    HCI_PLATFORM_COMMAND_LRAC_SWITCH,
+    HCI_PLATFORM_COMMAND_LRAC_TRACE_LEVEL,
+    HCI_PLATFORM_COMMAND_VSC_WRAPPER,
+    HCI_PLATFORM_COMMAND_AP_CONN_CHECK,
+    HCI_PLATFORM_COMMAND_JITTER_TARGET_SET,
+    HCI_PLATFORM_COMMAND_ELNA_GAIN_SET,
+#ifdef VOICE_PROMPT
+    HCI_PLATFORM_COMMAND_EF_ERASE,
+    HCI_PLATFORM_COMMAND_EF_WRITE,
+#ifdef OTA_FW_UPGRADE
+    HCI_PLATFORM_COMMAND_EF_CRC,
+#endif
+#endif
+    HCI_PLATFORM_COMMAND_AUDIO_INSERT_EXT,
+    HCI_PLATFORM_COMMAND_NVRAM_STATS,
+    HCI_PLATFORM_COMMAND_HCI_TX_STATS,
+};
+
 // variables used for button manager
 static button_manager_t platform_evb1_button_manager;
 
@@ -568,11 +602,20 @@ const platform_button_id_mapping_t platform_button_id_mapping[] =
 wiced_result_t platform_init(void)
 {
     wiced_result_t status = WICED_BT_SUCCESS;
+    uint8_t i;
 
     memset(&platform_cb, 0, sizeof(platform_cb));
 
     platform_cb.lrac_role = WICED_BT_LRAC_ROLE_UNKNOWN;
 
+    /* Unknown Platform OpCodes are rejected by platform_handle_hci_command */
+    for (i = 0 ; i < (sizeof(platform_hci_commands) / sizeof(platform_hci_commands[0])) ; i++)
+    {
+        app_hci_cmd_handler_register(platform_hci_commands[i], platform_hci_commands[i],
+                platform_handle_hci_command);
+    }
+    app_hci_cmd_group_handler_register(HCI_PLATFORM_GROUP, platform_handle_hci_command);
+
 #ifdef PLATFORM_DEBUG
     APP_TRACE_DBG("PLATFORM_DEBUG defined. Call wiced_platform_debug_enable()\n");
     wiced_platform_debug_enable();
@@ -1055,7 +1098,7 @@ void platform_handle_hci_command(uint16_t cmd_opcode, uint8_t* p_data, uint32_t
         {
             APP_TRACE_ERR("wiced_bt_dev_vendor_specific_command failed %d\n", status);
             wiced_hci_status = 1;
-            wiced_transport_send_data(HCI_PLATFORM_EVENT_VSC_CMD_CPLT, &wiced_hci_status,
+            app_hci_send(HCI_PLATFORM_EVENT_VSC_CMD_CPLT, &wiced_hci_status,
                     sizeof(wiced_hci_status));
         }
         break;
@@ -1108,19 +1151,150 @@ void platform_handle_hci_command(uint16_t cmd_opcode, uint8_t* p_data, uint32_t
         else
             wiced_hci_status = 1;
         break;
+
+#ifdef OTA_FW_UPGRADE
+    case HCI_PLATFORM_COMMAND_EF_CRC:/* Embedded Flash CRC32 */
+        send_cmd_status = 0;
+        if (data_len < 2 * sizeof(uint32_t))
+        {
+            APP_TRACE_ERR("Embedded Flash CRC bad length:%d\n", data_len);
+            platform_ef_crc_send(0, 0, WICED_FALSE);
+            break;
+        }
+        STREAM_TO_UINT32(offset, p_data);
+        STREAM_TO_UINT32(length, p_data);
+        platform_ef_crc_send(offset, length, WICED_TRUE);
+        break;
+#endif
 #endif
 
+    case HCI_PLATFORM_COMMAND_NVRAM_STATS:
+        send_cmd_status = 0;
+        platform_nvram_stats_send();
+        break;
+
+    case HCI_PLATFORM_COMMAND_HCI_TX_STATS:
+        send_cmd_status = 0;
+        platform_hci_tx_stats_send();
+        break;
+
     default:
         break;
     }
 
     if (send_cmd_status)
     {
-        wiced_transport_send_data(HCI_PLATFORM_EVENT_COMMAND_STATUS,
+        app_hci_send(HCI_PLATFORM_EVENT_COMMAND_STATUS,
                 &wiced_hci_status, sizeof(wiced_hci_status));
     }
 }
 
+/*
+ * platform_nvram_stats_send
+ * Event format: Nb Entries (1 byte) followed by, for each entry:
+ *               NVRAM Id, Nb Write, Nb Write Skipped, Nb Write Coalesced, Nb Read Hit,
+ *               Nb Read Miss (2 bytes each)
+ */
+static void platform_nvram_stats_send(void)
+{
+    app_nvram_stats_t stats[APP_NVRAM_CACHE_NB_ID];
+    uint8_t tx_buf[1 + APP_NVRAM_CACHE_NB_ID * 6 * sizeof(uint16_t)];
+    uint8_t *p = tx_buf;
+    uint8_t nb_entries;
+    uint8_t i;
+
+    nb_entries = app_nvram_stats_get(stats, APP_NVRAM_CACHE_NB_ID);
+
+    UINT8_TO_STREAM(p, nb_entries);
+    for (i = 0; i < nb_entries; i++)
+    {
+        UINT16_TO_STREAM(p, stats[i].nvram_id);
+        UINT16_TO_STREAM(p, stats[i].nb_write);
+        UINT16_TO_STREAM(p, stats[i].nb_write_skipped);
+        UINT16_TO_STREAM(p, stats[i].nb_write_coalesced);
+        UINT16_TO_STREAM(p, stats[i].nb_read_hit);
+        UINT16_TO_STREAM(p, stats[i].nb_read_miss);
+    }
+
+    app_hci_send(HCI_PLATFORM_EVENT_NVRAM_STATS, tx_buf, (uint16_t)(p - tx_buf));
+}
+
+/*
+ * platform_hci_tx_stats_send
+ * Event format: Nb Packet, Nb Burst, Nb Direct, Nb No Buffer, Nb Error (4 bytes each),
+ *               Max Burst Packets, Max Burst Bytes (2 bytes each),
+ *               Nb In Flight, Max In Flight (1 byte each)
+ */
+static void platform_hci_tx_stats_send(void)
+{
+    app_hci_tx_stats_t stats;
+    uint8_t tx_buf[5 * sizeof(uint32_t) + 2 * sizeof(uint16_t) + 2];
+    uint8_t *p = tx_buf;
+
+    app_hci_tx_stats_get(&stats);
+
+    UINT32_TO_STREAM(p, stats.nb_packet);
+    UINT32_TO_STREAM(p, stats.nb_burst);
+    UINT32_TO_STREAM(p, stats.nb_direct);
+    UINT32_TO_STREAM(p, stats.nb_no_buffer);
+    UINT32_TO_STREAM(p, stats.nb_error);
+    UINT16_TO_STREAM(p, stats.max_burst_packets);
+    UINT16_TO_STREAM(p, stats.max_burst_bytes);
+    UINT8_TO_STREAM(p, stats.nb_in_flight);
+    UINT8_TO_STREAM(p, stats.max_in_flight);
+
+    app_hci_send(HCI_PLATFORM_EVENT_HCI_TX_STATS, tx_buf, (uint16_t)(p - tx_buf));
+}
+
+#if defined(VOICE_PROMPT) && defined(OTA_FW_UPGRADE)
+/*
+ * platform_ef_crc_send
+ * Read back an Embedded Flash area and send its CRC32 (same as the OFU one). This allows the
+ * Host to skip the pages which already contain the data it is about to write.
+ * The area is limited to the size of an OFU Partition (the read blocks the application).
+ * Event format: Status (1 byte), CRC32 (4 bytes)
+ */
+static void platform_ef_crc_send(uint32_t offset, uint32_t length, wiced_bool_t valid)
+{
+    uint8_t read_buf[256];
+    uint8_t tx_buf[1 + sizeof(uint32_t)];
+    uint8_t *p = tx_buf;
+    uint32_t crc32 = APP_OFU_CRC32_INIT;
+    uint32_t read_len;
+    uint8_t hci_status = 0;
+
+    APP_TRACE_DBG("Embedded Flash CRC offset:0x%x length:0x%x\n", offset, length);
+
+    if ((valid == WICED_FALSE) ||
+        (length > APP_OFU_IMAGE_LEN_MAX) ||
+        (offset + length < offset))
+    {
+        APP_TRACE_ERR("Embedded Flash CRC refused offset:0x%x length:0x%x\n", offset, length);
+        hci_status = 1;
+        length = 0;
+    }
+
+    while (length)
+    {
+        read_len = (length > sizeof(read_buf)) ? sizeof(read_buf) : length;
+        if (wiced_hal_eflash_read(offset, read_buf, read_len) != WICED_SUCCESS)
+        {
+            APP_TRACE_ERR("wiced_hal_eflash_read failed offset:0x%x\n", offset);
+            hci_status = 1;
+            break;
+        }
+        crc32 = app_ofu_crc32_update(crc32, read_buf, read_len);
+        offset += read_len;
+        length -= read_len;
+    }
+
+    UINT8_TO_STREAM(p, hci_status);
+    UINT32_TO_STREAM(p, crc32 ^ 0xFFFFFFFF);
+
+    app_hci_send(HCI_PLATFORM_EVENT_EF_CRC, tx_buf, (uint16_t)(p - tx_buf));
+}
+#endif
+
 /*
  * platform_vsc_cmd_cplt_callback
  */
@@ -1133,7 +1307,7 @@ static void platform_vsc_cmd_cplt_callback(
     APP_TRACE_DBG("opcode:0x%04X hci_status:%d len:%d\n", p_cmd_cplt_param->opcode,
             p_cmd_cplt_param->p_param_buf[0], p_cmd_cplt_param->param_len);
 
-    wiced_transport_send_data(HCI_PLATFORM_EVENT_VSC_CMD_CPLT,
+    app_hci_send(HCI_PLATFORM_EVENT_VSC_CMD_CPLT,
             p_cmd_cplt_param->p_param_buf, p_cmd_cplt_param->param_len);
 }
 
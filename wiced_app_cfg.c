@@ -51,6 +51,7 @@
 #include "app_handsfree.h"
 #ifdef APP_OFU_SUPPORT
 #include "ofu/app_ofu_spp.h"
+#include "ofu/app_ofu_ble.h"
 #endif
 #ifdef APP_TPUT_SPP
 #include "app_tput_spp.h"
@@ -61,8 +62,11 @@ enum
 {
 #ifdef APP_OFU_SUPPORT
     OFU_SPP_RFCOMM_PORT_COUNT = 1,
+    /* One Large Buffer per LE OFU Stream credit (Write Without Response not yet handled) */
+    OFU_BLE_STREAM_BUF_COUNT = APP_OFU_BLE_STREAM_CREDITS,
 #else
     OFU_SPP_RFCOMM_PORT_COUNT = 0,
+    OFU_BLE_STREAM_BUF_COUNT = 0,
 #endif
 };
 
@@ -159,9 +163,9 @@ const wiced_bt_cfg_settings_t wiced_bt_cfg_settings =
         .appearance                     = APPEARANCE_GENERIC_TAG,                                      /**< GATT appearance (see gatt_appearance_e) */
         .client_max_links               = 0,                                                           /**< Client config: maximum number of servers that local client can connect to  */
         .server_max_links               = 2,                                                           /**< Server config: maximum number of remote clients connections allowed by the local */
-        .max_attr_len                   = 360,                                                         /**< Maximum attribute length; gki_cfg must have a corresponding buffer pool that can hold this length */
+        .max_attr_len                   = 512,                                                         /**< Maximum attribute length; gki_cfg must have a corresponding buffer pool that can hold this length */
 #if !defined(CYW20706A2)
-        .max_mtu_size                   = 365                                                          /**< Maximum MTU size for GATT connections, should be between 23 and (max_attr_len + 5) */
+        .max_mtu_size                   = 517                                                          /**< Maximum MTU size for GATT connections, should be between 23 and (max_attr_len + 5) */
 #endif
     },
 
@@ -207,7 +211,7 @@ const wiced_bt_cfg_settings_t wiced_bt_cfg_settings =
     .addr_resolution_db_size            = 5,                                                           /**< LE Address Resolution DB settings - effective only for pre 4.2 controller*/
 
 #ifdef CYW20706A2
-    .max_mtu_size                       = 365,                                                         /**< Maximum MTU size for GATT connections, should be between 23 and (max_attr_len + 5) */
+    .max_mtu_size                       = 517,                                                         /**< Maximum MTU size for GATT connections, should be between 23 and (max_attr_len + 5) */
     .max_pwr_db_val                     = 12                                                           /**< Max. power level of the device */
 #else
     /* Maximum number of buffer pools */
@@ -414,6 +418,8 @@ const uint16_t lrac_sdp_db_size = sizeof(lrac_sdp_db);
  *
  * Pools must be ordered in increasing buf_size.
  * If a pool runs out of buffers, the next  pool will be used
+ * The buf_count can be tuned from the usage measured on the device (see buffer-pool-tune.py
+ * in lrac_config)
  *****************************************************************************/
 const wiced_bt_cfg_buf_pool_t wiced_app_cfg_buf_pools[] =
 {
@@ -421,9 +427,9 @@ const wiced_bt_cfg_buf_pool_t wiced_app_cfg_buf_pools[] =
     { 64,       20  },      /* Small Buffer Pool */
     { 272,      6   },      /* Medium Buffer Pool (used for HCI & RFCOMM control messages, min recommended size is 360) */
 #ifdef APP_TPUT_SPP
-    { 1056,     15   },     /* Large Buffer Pool  (used for HCI ACL messages) */
+    { 1056,     15 + OFU_BLE_STREAM_BUF_COUNT },    /* Large Buffer Pool  (used for HCI ACL messages and LE OFU Stream writes) */
 #else
-    { 1056,     6   },      /* Large Buffer Pool  (used for HCI ACL messages) */
+    { 1056,     6 + OFU_BLE_STREAM_BUF_COUNT },     /* Large Buffer Pool  (used for HCI ACL messages and LE OFU Stream writes) */
 #endif
     { 1056,     1   },      /* Extra Large Buffer Pool - Used for avdt media packets and miscellaneous (if not needed, set buf_count to 0) */
 };